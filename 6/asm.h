@@ -1,9 +1,18 @@
 #define Maxarg 4                /* maximum number of args an insn can have */
-#define Maxuse (2*Maxarg)       /* maximum number of registers an insn can use or def */
-#define Maxdef (2*Maxarg)       /* maximum number of registers an insn can use or def */
+#define Nintarg 6               /* number of integer registers used to pass args */
+#define Nfltarg 8               /* number of float registers used to pass args */
+#define Maxuse (2*Maxarg + Nintarg + Nfltarg) /* maximum number of registers an insn can use or def */
+#define Maxdef (2*Maxarg + Nclobber) /* maximum number of registers an insn can use or def */
 #define Wordsz 4                /* the size of a "natural int" */
 #define Ptrsz 8                 /* the size of a machine word (ie, pointer size) */
-#define Nsaved 13               /* number of registers saved in the ABI */
+#define Nsaved 5                /* number of registers saved in the ABI */
+#define Nclobber 24             /* number of registers a call may trash */
+#define Northogonal 32          /* number of non-aliasing registers */
+#define Lsrathresh 4096         /* vregs in a function before we switch to linear scan */
+#define Blitsse 32              /* bytes in a blit before we copy with sse moves */
+#define Blitrep 256             /* bytes in a blit before we copy with rep movs */
+#define Jtabmin 4               /* match keys before we consider a jump table */
+#define Jtabspread 3            /* table slots we'll spend per match key */
 
 typedef size_t regid;
 
@@ -13,6 +22,13 @@ typedef struct Func Func;
 typedef struct Blob Blob;
 typedef struct Isel Isel;
 typedef struct Asmbb Asmbb;
+typedef struct Argcc Argcc;
+typedef struct Remapping Remapping;
+typedef struct Reloc Reloc;
+typedef struct Sym Sym;
+typedef struct Objsec Objsec;
+typedef struct Obj Obj;
+typedef struct Jtab Jtab;
 
 typedef enum {
 #define Insn(val, fmt, use, def) val,
@@ -48,6 +64,24 @@ typedef enum {
     Nmode,
 } Mode;
 
+/* sections of the object file */
+typedef enum {
+    Sectext,
+    Secdata,
+    Secrodata,
+    Nsec
+} Sec;
+
+/* relocation kinds. Values are the ELF x86-64 ones */
+typedef enum {
+    Rel64 = 1,          /* R_X86_64_64 */
+    Relpc32 = 2,        /* R_X86_64_PC32 */
+    Relplt32 = 4,       /* R_X86_64_PLT32 */
+    Rel32 = 10,         /* R_X86_64_32 */
+    Rel32s = 11,        /* R_X86_64_32S */
+    Relpc8 = 0x100,     /* short branch; never leaves the assembler */
+} Reltype;
+
 typedef enum {
     Classbad,
     Classint,
@@ -86,6 +120,8 @@ struct Insn {
     AsmOp op;
     Loc *args[Maxarg];
     size_t nargs;
+    Reg argregs[Nintarg + Nfltarg]; /* registers carrying args into a call */
+    size_t nargregs;
 };
 
 struct Func {
@@ -95,9 +131,72 @@ struct Func {
     Type *type;   /* type of function */
     Htab *stkoff; /* Loc* -> int stackoff map */
     Node *ret;    /* return value */
+    Node **args;  /* arguments, including the hidden return pointer */
+    size_t nargs;
+    int regcc;    /* are args passed in registers? */
     Cfg  *cfg;    /* flow graph */
 };
 
+/* a spilled register, and the one standing in for it */
+struct Remapping {
+    regid oldreg;
+    Loc *newreg;
+};
+
+/* a field in a section that refers to a symbol */
+struct Reloc {
+    size_t off;         /* offset of the field */
+    char *sym;          /* symbol it refers to */
+    long addend;
+    Reltype type;
+};
+
+struct Sym {
+    char *name;
+    int defined;
+    int global;
+    Sec sec;            /* section it is defined in */
+    size_t off;         /* offset within that section */
+    size_t idx;         /* index in the output symtab */
+};
+
+struct Objsec {
+    char *buf;
+    size_t len;
+    size_t cap;
+    Reloc **rel;
+    size_t nrel;
+};
+
+/* object file output state */
+struct Obj {
+    FILE *asmfd;        /* textual asm goes here, if non-null */
+    int bin;            /* do we build an object file? */
+    Sec cur;            /* section being written */
+    Objsec sec[Nsec];
+    Htab *syms;         /* name => Sym* */
+    Sym **sym;          /* in order of first mention */
+    size_t nsym;
+    /* .text is assembled a function at a time, so that branches can be sized */
+    Insn **text;
+    size_t ntext;
+};
+
+/* a jump table, written to .rodata after its function */
+struct Jtab {
+    char *lbl;          /* label of the table */
+    char **targ;        /* label of each entry */
+    size_t ntarg;
+};
+
+/* argument classification state, walked in
+ * the same order by caller and callee */
+struct Argcc {
+    int regcc;  /* do we pass args in registers at all? */
+    int nint;   /* integer arg registers handed out */
+    int nflt;   /* float arg registers handed out */
+};
+
 struct Asmbb {
     int id;       /* unique identifier */
     char **lbls;  /* list of BB labels */
@@ -123,6 +222,8 @@ struct Isel {
     Asmbb *curbb;
 
     Node *ret;          /* we store the return into here */
+    Jtab **jtab;        /* jump tables used by the function */
+    size_t njtab;
     Htab *spillslots;   /* reg id  => int stkoff */
     Htab *reglocs;      /* decl id => Loc *reg */
     Htab *stkoff;       /* decl id => int stkoff */
@@ -130,14 +231,15 @@ struct Isel {
 
     /* increased when we spill */
     Loc *stksz;
-    Loc *calleesave[Nsaved];
 
     /* register allocator state */
     Bitset *prepainted; /* locations that need to be a specific colour */
     Bitset *initial;    /* initial set of locations used by this fn */
 
-    size_t *gbits;      /* igraph matrix repr */
-    Bitset **gadj;      /* igraph adj set repr */
+    Htab *gedges;       /* igraph edge set, keyed by (lo << 32 | hi) */
+    regid **gadj;       /* igraph adj list repr */
+    size_t *ngadj;
+    size_t ngraph;      /* number of nodes gadj is sized for */
     int *degree;        /* degree of nodes */
     Loc **aliasmap;     /* mapping of aliases */
 
@@ -181,12 +283,29 @@ struct Isel {
 };
 
 /* entry points */
-void genblob(FILE *fd, Node *blob, Htab *globls, Htab *strtab);
-void genasm(FILE *fd, Func *fn, Htab *globls, Htab *strtab);
-void genstrings(FILE *fd, Htab *strtab);
-void gen(Node *file, char *out);
+void genblob(Obj *o, Node *blob, Htab *globls, Htab *strtab);
+void genasm(Obj *o, Func *fn, Htab *globls, Htab *strtab);
+void genstrings(Obj *o, Htab *strtab);
+void gen(Node *file, char *objfile, char *asmfile);
+
+/* object file output */
+Obj *mkobj(FILE *asmfd, int bin);
+void objsec(Obj *o, Sec s);
+void objlbl(Obj *o, char *lbl, int global);
+void objinsn(Obj *o, Insn *insn);
+void objbytes(Obj *o, char *p, size_t sz);
+void objint(Obj *o, uint64_t v, size_t sz);
+void objaddr(Obj *o, char *lbl, long off);
+void objpad(Obj *o, size_t sz);
+void objwrite(Obj *o, FILE *fd);
+Sym *getsym(Obj *o, char *name);
+void secput(Objsec *s, void *p, size_t sz);
+int iscomment(Insn *insn);
+void assemble(Obj *o);
+void resolvetext(Obj *o);
 
 /* location generation */
+extern Arena fnarena; /* released once each function is written out */
 extern size_t maxregid;
 extern Loc **locmap; /* mapping from reg id => Loc * */
 
@@ -196,6 +315,8 @@ Loc *loclbl(Node *lbl);
 Loc *locstrlbl(char *lbl);
 Loc *locreg(Mode m);
 Loc *locphysreg(Reg r);
+void resetregs(void);
+void resetlbls(void);
 Loc *locmem(long disp, Loc *base, Loc *idx, Mode mode);
 Loc *locmeml(char *disp, Loc *base, Loc *idx, Mode mode);
 Loc *locmems(long disp, Loc *base, Loc *idx, int scale, Mode mode);
@@ -206,6 +327,7 @@ Loc *coreg(Reg r, Mode m);
 
 void locprint(FILE *fd, Loc *l, char spec);
 void iprintf(FILE *fd, Insn *insn);
+int finalinsn(Insn *insn);
 
 /* emitting instructions */
 Insn *mkinsn(AsmOp op, ...);
@@ -214,8 +336,24 @@ Insn *mkinsn(AsmOp op, ...);
 extern char *regnames[]; /* name table */
 extern Mode regmodes[];  /* mode table */
 extern size_t modesize[]; /* mode size table */
+extern Reg regmap[Northogonal][Nmode]; /* colour => register, by mode */
+extern int colourmap[Nreg];   /* register => colour */
+extern char *ralgo;      /* register allocator: "colour", "linear" or NULL for auto */
+extern int optlevel;     /* 0 goes straight from the flow graph to isel */
 void regalloc(Isel *s);
+void lsregalloc(Isel *s);
 Rclass rclass(Loc *l);
+size_t uses(Insn *insn, regid *u);
+size_t defs(Insn *insn, regid *d);
+void liveness(Isel *s);
+Loc *spillslot(Isel *s, regid reg);
+void addspill(Isel *s, Loc *l);
+void updatelocs(Isel *s, Insn *insn, Remapping *use, size_t nuse, Remapping *def, size_t ndef);
+void delnops(Isel *s);
+
+/* peephole optimization */
+void peep(Isel *s, int allocated);
+void peepstats(FILE *fd);
 
 
 /* useful functions */
@@ -225,6 +363,8 @@ int stacktype(Type *t);
 int floattype(Type *t);
 int stacknode(Node *n);
 int floatnode(Node *n);
+int isregcc(Type *fn);
+size_t classify(Argcc *cc, Type *t, Reg *r, Mode *m);
 void breakhere();
 void dumpasm(Isel *s, FILE *fd);
 
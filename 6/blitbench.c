@@ -0,0 +1,130 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Times the ways blit() can copy a fixed size aggregate:
+ * straight line 8 byte moves through a general register,
+ * straight line 16 byte movdqu through %xmm15, rep movsq,
+ * and the rep movsb that every blit used to be. Each copy
+ * is written out the way isel emits it for that size,
+ * so the numbers say where Blitsse and Blitrep belong.
+ *
+ *   make blitbench && ./blitbench [ncopies]
+ */
+
+typedef void (*Copyfn)(char *dst, char *src);
+
+#define GPR(n) \
+    static void gpr##n(char *dst, char *src) \
+    { \
+        __asm__ volatile( \
+            ".set .Loff, 0\n" \
+            ".rept %c2/8\n" \
+            "movq .Loff(%1),%%rax\n" \
+            "movq %%rax,.Loff(%0)\n" \
+            ".set .Loff, .Loff+8\n" \
+            ".endr\n" \
+            :: "r"(dst), "r"(src), "i"(n) : "rax", "memory"); \
+    }
+
+#define SSE(n) \
+    static void sse##n(char *dst, char *src) \
+    { \
+        __asm__ volatile( \
+            ".set .Loff, 0\n" \
+            ".rept %c2/16\n" \
+            "movdqu .Loff(%1),%%xmm15\n" \
+            "movdqu %%xmm15,.Loff(%0)\n" \
+            ".set .Loff, .Loff+16\n" \
+            ".endr\n" \
+            ".if %c2 %% 16\n" \
+            "movq .Loff(%1),%%rax\n" \
+            "movq %%rax,.Loff(%0)\n" \
+            ".endif\n" \
+            :: "r"(dst), "r"(src), "i"(n) : "rax", "xmm15", "memory"); \
+    }
+
+#define REPQ(n) \
+    static void repq##n(char *dst, char *src) \
+    { \
+        __asm__ volatile( \
+            "movq %2,%%rcx\n" \
+            "rep movsq\n" \
+            : "+D"(dst), "+S"(src) : "i"(n/8) : "rcx", "memory"); \
+    }
+
+#define REPB(n) \
+    static void repb##n(char *dst, char *src) \
+    { \
+        __asm__ volatile( \
+            "movq %2,%%rcx\n" \
+            "rep movsb\n" \
+            : "+D"(dst), "+S"(src) : "i"(n) : "rcx", "memory"); \
+    }
+
+#define SIZE(n) GPR(n) SSE(n) REPQ(n) REPB(n)
+
+SIZE(8)
+SIZE(16)
+SIZE(24)
+SIZE(32)
+SIZE(48)
+SIZE(64)
+SIZE(128)
+SIZE(256)
+SIZE(512)
+SIZE(1024)
+
+#define ROW(n) {n, {gpr##n, sse##n, repq##n, repb##n}}
+
+static struct {
+    size_t sz;
+    Copyfn fn[4];
+} sizes[] = {
+    ROW(8), ROW(16), ROW(24), ROW(32), ROW(48),
+    ROW(64), ROW(128), ROW(256), ROW(512), ROW(1024),
+};
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+/* copies around a small ring of buffers, like a call site would */
+static double bench(Copyfn fn, char *buf, size_t sz, size_t n)
+{
+    size_t i, nslot;
+    double t;
+
+    nslot = 4096/sz + 2;
+    t = now();
+    for (i = 0; i < n; i++)
+        fn(buf + ((i + 1) % nslot)*sz, buf + (i % nslot)*sz);
+    return (now() - t)/n;
+}
+
+int main(int argc, char **argv)
+{
+    size_t i, j, n;
+    char *buf;
+
+    n = 10000000;
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 0);
+    buf = calloc(8192, 1);
+    printf("bytes   gpr ns  sse ns  movsq ns  movsb ns\n");
+    for (i = 0; i < sizeof sizes/sizeof sizes[0]; i++) {
+        printf("%5zd", sizes[i].sz);
+        for (j = 0; j < 4; j++)
+            printf("  %8.2f", bench(sizes[i].fn[j], buf, sizes[i].sz, n));
+        printf("\n");
+    }
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,736 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "parse.h"
+#include "opt.h"
+#include "asm.h"
+
+/*
+ * An x86-64 encoder for the instructions that isel
+ * produces. Each instruction is encoded into a small
+ * buffer, along with the fixups for any symbols that
+ * it refers to. Branches to labels within the text are
+ * encoded short where they reach, and long otherwise.
+ */
+
+#define Maxfix 2
+
+typedef struct Enc Enc;
+struct Enc {
+    uint8_t buf[32];
+    size_t len;
+    Reloc fix[Maxfix];
+    size_t nfix;
+};
+
+/* hardware register numbers */
+static int regnum[Nreg] = {
+    [Ral] = 0,  [Rcl] = 1,  [Rdl] = 2,  [Rbl] = 3,
+    [Rspl] = 4, [Rbpl] = 5, [Rsil] = 6, [Rdil] = 7,
+    [Rr8b] = 8, [Rr9b] = 9, [Rr10b] = 10, [Rr11b] = 11,
+    [Rr12b] = 12, [Rr13b] = 13, [Rr14b] = 14, [Rr15b] = 15,
+    [Rah] = 4,  [Rch] = 5,  [Rdh] = 6,  [Rbh] = 7,
+
+    [Rax] = 0,  [Rcx] = 1,  [Rdx] = 2,  [Rbx] = 3,
+    [Rsp] = 4,  [Rbp] = 5,  [Rsi] = 6,  [Rdi] = 7,
+    [Rr8w] = 8, [Rr9w] = 9, [Rr10w] = 10, [Rr11w] = 11,
+    [Rr12w] = 12, [Rr13w] = 13, [Rr14w] = 14, [Rr15w] = 15,
+
+    [Reax] = 0, [Recx] = 1, [Redx] = 2, [Rebx] = 3,
+    [Resp] = 4, [Rebp] = 5, [Resi] = 6, [Redi] = 7,
+    [Rr8d] = 8, [Rr9d] = 9, [Rr10d] = 10, [Rr11d] = 11,
+    [Rr12d] = 12, [Rr13d] = 13, [Rr14d] = 14, [Rr15d] = 15,
+
+    [Rrax] = 0, [Rrcx] = 1, [Rrdx] = 2, [Rrbx] = 3,
+    [Rrsp] = 4, [Rrbp] = 5, [Rrsi] = 6, [Rrdi] = 7,
+    [Rr8] = 8,  [Rr9] = 9,  [Rr10] = 10, [Rr11] = 11,
+    [Rr12] = 12, [Rr13] = 13, [Rr14] = 14, [Rr15] = 15,
+
+    [Rxmm0f] = 0, [Rxmm1f] = 1, [Rxmm2f] = 2, [Rxmm3f] = 3,
+    [Rxmm4f] = 4, [Rxmm5f] = 5, [Rxmm6f] = 6, [Rxmm7f] = 7,
+    [Rxmm8f] = 8, [Rxmm9f] = 9, [Rxmm10f] = 10, [Rxmm11f] = 11,
+    [Rxmm12f] = 12, [Rxmm13f] = 13, [Rxmm14f] = 14, [Rxmm15f] = 15,
+
+    [Rxmm0d] = 0, [Rxmm1d] = 1, [Rxmm2d] = 2, [Rxmm3d] = 3,
+    [Rxmm4d] = 4, [Rxmm5d] = 5, [Rxmm6d] = 6, [Rxmm7d] = 7,
+    [Rxmm8d] = 8, [Rxmm9d] = 9, [Rxmm10d] = 10, [Rxmm11d] = 11,
+    [Rxmm12d] = 12, [Rxmm13d] = 13, [Rxmm14d] = 14, [Rxmm15d] = 15,
+};
+
+/* condition codes, for jcc and setcc */
+static int condcode[] = {
+    [Ijz] = 0x4, [Ijnz] = 0x5, [Ijl] = 0xc, [Ijle] = 0xe,
+    [Ijg] = 0xf, [Ijge] = 0xd, [Ijb] = 0x2, [Ijbe] = 0x6,
+    [Ija] = 0x7, [Ijae] = 0x3,
+    [Isetz] = 0x4, [Isetnz] = 0x5, [Isetl] = 0xc, [Isetle] = 0xe,
+    [Isetg] = 0xf, [Isetge] = 0xd, [Isetb] = 0x2, [Isetbe] = 0x6,
+    [Iseta] = 0x7, [Isetae] = 0x3,
+};
+
+/* the ALU group: the /digit for the immediate forms */
+static int aluext[] = {
+    [Iadd] = 0, [Ior] = 1, [Iand] = 4, [Isub] = 5, [Ixor] = 6, [Icmp] = 7,
+};
+
+/* and for the unary group and shifts */
+static int grpext[] = {
+    [Inot] = 2, [Ineg] = 3, [Imul] = 4, [Iimul_r] = 5, [Iimulw] = 5, [Idiv] = 6, [Iidiv] = 7,
+    [Ishl] = 4, [Ishr] = 5, [Isar] = 7,
+};
+
+static int isreg(Loc *l) { return l->type == Locreg; }
+static int ismem(Loc *l) { return l->type == Locmem || l->type == Locmeml; }
+static int isimm(Loc *l) { return l->type == Loclit || l->type == Loclitl; }
+
+static int rn(Loc *l)
+{
+    assert(l->type == Locreg);
+    if (l->reg.colour == Rnone)
+        die("Unallocated register P.%zd in encoder", l->reg.id);
+    return regnum[l->reg.colour];
+}
+
+static int ishighbyte(Loc *l)
+{
+    return l && l->type == Locreg && l->reg.colour >= Rah && l->reg.colour <= Rbh;
+}
+
+/* spl, bpl, sil and dil are only reachable with a rex prefix */
+static int needsrex(Loc *l)
+{
+    if (!l || l->type != Locreg)
+        return 0;
+    switch (l->reg.colour) {
+        case Rspl: case Rbpl: case Rsil: case Rdil:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int fits8(long v)
+{
+    return v >= -128 && v <= 127;
+}
+
+static int fits32(long v)
+{
+    return v >= INT32_MIN && v <= INT32_MAX;
+}
+
+static int isimm8(Loc *l)
+{
+    return l->type == Loclit && fits8(l->lit);
+}
+
+static void b(Enc *e, uint8_t v)
+{
+    assert(e->len < sizeof e->buf);
+    e->buf[e->len++] = v;
+}
+
+static void le(Enc *e, uint64_t v, size_t sz)
+{
+    size_t i;
+
+    for (i = 0; i < sz; i++)
+        b(e, v >> (8*i));
+}
+
+static void fix(Enc *e, char *sym, long addend, Reltype t)
+{
+    Reloc *r;
+
+    assert(e->nfix < Maxfix);
+    r = &e->fix[e->nfix++];
+    r->off = e->len;
+    r->sym = sym;
+    r->addend = addend;
+    r->type = t;
+}
+
+static void imm(Enc *e, Loc *l, size_t sz, Mode m)
+{
+    if (l->type == Loclitl) {
+        assert(sz == 4);
+        fix(e, l->lbl, 0, m == ModeQ ? Rel32s : Rel32);
+        le(e, 0, 4);
+    } else {
+        if (sz == 4 && m == ModeQ && !fits32(l->lit))
+            die("Immediate %ld out of range", l->lit);
+        le(e, l->lit, sz);
+    }
+}
+
+/*
+ * Emits a full instruction:
+ *      [66] [pfx] [rex] op modrm [sib] [disp] [imm]
+ * 'r' is the register in the reg field, or null if
+ * the reg field holds the opcode extension 'ext'.
+ * 'm' is the operand size, and 'rm' is the register
+ * or memory operand.
+ */
+static void emitrm(Enc *e, Mode m, int pfx, uint8_t *op, size_t nop,
+                   Loc *r, int ext, Loc *rm, Loc *im, size_t immsz)
+{
+    int reg, base, idx, rex, mod, scale;
+    long disp;
+    char *lbl;
+    size_t i;
+
+    reg = r ? rn(r) : ext;
+    base = -1;
+    idx = -1;
+    if (isreg(rm)) {
+        base = rn(rm);
+    } else {
+        if (rm->mem.base && rm->mem.base->reg.colour != Rrip)
+            base = rn(rm->mem.base);
+        if (rm->mem.idx)
+            idx = rn(rm->mem.idx);
+    }
+
+    if (m == ModeW)
+        b(e, 0x66);
+    if (pfx)
+        b(e, pfx);
+    rex = 0x40;
+    if (m == ModeQ)
+        rex |= 0x8;
+    if (reg & 8)
+        rex |= 0x4;
+    if (idx >= 0 && idx & 8)
+        rex |= 0x2;
+    if (base >= 0 && base & 8)
+        rex |= 0x1;
+    if (rex != 0x40 || needsrex(r) || needsrex(rm)) {
+        /* with a rex prefix, the high byte encodings mean spl and friends */
+        if (ishighbyte(r) || ishighbyte(rm))
+            die("Can't encode a high byte register with a rex prefix");
+        b(e, rex);
+    }
+    for (i = 0; i < nop; i++)
+        b(e, op[i]);
+
+    if (isreg(rm)) {
+        b(e, 0xc0 | (reg & 7) << 3 | (base & 7));
+    } else {
+        lbl = NULL;
+        disp = 0;
+        if (rm->type == Locmem)
+            disp = rm->mem.constdisp;
+        else
+            lbl = rm->mem.lbldisp;
+
+        scale = 0;
+        switch (rm->mem.scale) {
+            case 0: case 1: scale = 0; break;
+            case 2: scale = 1; break;
+            case 4: scale = 2; break;
+            case 8: scale = 3; break;
+            default: die("Bad scale %d", rm->mem.scale); break;
+        }
+
+        if (rm->mem.base && rm->mem.base->reg.colour == Rrip) {
+            /* disp32(%rip) */
+            if (idx >= 0)
+                die("Can't index off %%rip");
+            b(e, (reg & 7) << 3 | 0x5);
+            if (lbl)
+                fix(e, lbl, -(4 + immsz), Relpc32);
+            le(e, disp, 4);
+        } else if (base < 0) {
+            /* absolute disp32, through a sib with no base */
+            b(e, (reg & 7) << 3 | 0x4);
+            b(e, scale << 6 | (idx >= 0 ? idx & 7 : 0x4) << 3 | 0x5);
+            if (lbl)
+                fix(e, lbl, 0, Rel32s);
+            le(e, disp, 4);
+        } else {
+            if (lbl)
+                mod = 2;
+            else if (disp == 0 && (base & 7) != 5)
+                mod = 0;
+            else if (fits8(disp))
+                mod = 1;
+            else
+                mod = 2;
+            if (idx >= 0 || (base & 7) == 4) {
+                b(e, mod << 6 | (reg & 7) << 3 | 0x4);
+                b(e, scale << 6 | (idx >= 0 ? idx & 7 : 0x4) << 3 | (base & 7));
+            } else {
+                b(e, mod << 6 | (reg & 7) << 3 | (base & 7));
+            }
+            if (lbl)
+                fix(e, lbl, 0, Rel32s);
+            if (mod == 1)
+                le(e, disp, 1);
+            else if (mod == 2)
+                le(e, disp, 4);
+        }
+    }
+    if (im)
+        imm(e, im, immsz, m);
+}
+
+static void op1(Enc *e, Mode m, int pfx, uint8_t op, Loc *r, int ext, Loc *rm, Loc *im, size_t immsz)
+{
+    emitrm(e, m, pfx, &op, 1, r, ext, rm, im, immsz);
+}
+
+static void op2(Enc *e, Mode m, int pfx, uint8_t op, Loc *r, Loc *rm)
+{
+    uint8_t o[2] = {0x0f, op};
+
+    emitrm(e, m, pfx, o, 2, r, 0, rm, NULL, 0);
+}
+
+static size_t immsize(Mode m)
+{
+    return m == ModeB ? 1 : m == ModeW ? 2 : 4;
+}
+
+/* operand size prefixes for the forms that implicitly use %al, %ax, ... */
+static void accpfx(Enc *e, Mode m)
+{
+    if (m == ModeW)
+        b(e, 0x66);
+    if (m == ModeQ)
+        b(e, 0x48);
+}
+
+static void alu(Enc *e, Insn *insn)
+{
+    Loc *src, *dst;
+    int n;
+    Mode m;
+
+    src = insn->args[0];
+    dst = insn->args[1];
+    m = src->mode;
+    n = aluext[insn->op];
+    if (isimm(src)) {
+        if (isreg(dst) && rn(dst) == 0 && (m == ModeB || !isimm8(src))) {
+            /* the short forms for the accumulator */
+            accpfx(e, m);
+            b(e, n*8 + (m == ModeB ? 4 : 5));
+            imm(e, src, immsize(m), m);
+        } else if (m == ModeB) {
+            op1(e, m, 0, 0x80, NULL, n, dst, src, 1);
+        } else if (isimm8(src)) {
+            op1(e, m, 0, 0x83, NULL, n, dst, src, 1);
+        } else {
+            op1(e, m, 0, 0x81, NULL, n, dst, src, immsize(m));
+        }
+    } else if (isreg(src)) {
+        op1(e, m, 0, n*8 + (m == ModeB ? 0 : 1), src, 0, dst, NULL, 0);
+    } else {
+        op1(e, m, 0, n*8 + (m == ModeB ? 2 : 3), dst, 0, src, NULL, 0);
+    }
+}
+
+static void test(Enc *e, Insn *insn)
+{
+    Loc *src, *dst;
+    Mode m;
+
+    src = insn->args[0];
+    dst = insn->args[1];
+    m = src->mode;
+    if (isimm(src) && isreg(dst) && rn(dst) == 0) {
+        accpfx(e, m);
+        b(e, m == ModeB ? 0xa8 : 0xa9);
+        imm(e, src, immsize(m), m);
+    } else if (isimm(src)) {
+        op1(e, m, 0, m == ModeB ? 0xf6 : 0xf7, NULL, 0, dst, src, immsize(m));
+    } else if (isreg(src)) {
+        op1(e, m, 0, m == ModeB ? 0x84 : 0x85, src, 0, dst, NULL, 0);
+    } else {
+        op1(e, m, 0, m == ModeB ? 0x84 : 0x85, dst, 0, src, NULL, 0);
+    }
+}
+
+static void mov(Enc *e, Insn *insn)
+{
+    Loc *src, *dst;
+    Mode m;
+
+    src = insn->args[0];
+    dst = insn->args[1];
+    m = src->mode;
+    if (isimm(src)) {
+        if (m == ModeQ && isreg(dst) && src->type == Loclit && !fits32(src->lit)) {
+            /* movabs */
+            b(e, 0x48 | (rn(dst) >> 3));
+            b(e, 0xb8 + (rn(dst) & 7));
+            le(e, src->lit, 8);
+        } else if (m != ModeQ && isreg(dst)) {
+            /* the short form, with the register in the opcode */
+            if (m == ModeW)
+                b(e, 0x66);
+            if (rn(dst) & 8 || needsrex(dst))
+                b(e, 0x40 | (rn(dst) >> 3));
+            b(e, (m == ModeB ? 0xb0 : 0xb8) + (rn(dst) & 7));
+            imm(e, src, immsize(m), m);
+        } else {
+            op1(e, m, 0, m == ModeB ? 0xc6 : 0xc7, NULL, 0, dst, src, immsize(m));
+        }
+    } else if (isreg(src)) {
+        op1(e, m, 0, m == ModeB ? 0x88 : 0x89, src, 0, dst, NULL, 0);
+    } else {
+        op1(e, m, 0, m == ModeB ? 0x8a : 0x8b, dst, 0, src, NULL, 0);
+    }
+}
+
+static void movx(Enc *e, Insn *insn)
+{
+    Loc *src, *dst;
+    int sx;
+
+    src = insn->args[0];
+    dst = insn->args[1];
+    sx = insn->op == Imovsx;
+    if (!isreg(dst))
+        die("Extending move to non-register");
+    switch (src->mode) {
+        case ModeB: op2(e, dst->mode, 0, sx ? 0xbe : 0xb6, dst, src); break;
+        case ModeW: op2(e, dst->mode, 0, sx ? 0xbf : 0xb7, dst, src); break;
+        case ModeL:
+            if (sx) {
+                op1(e, dst->mode, 0, 0x63, dst, 0, src, NULL, 0);
+            } else {
+                /* plain movl zero extends */
+                op1(e, ModeL, 0, 0x8b, coreg(dst->reg.colour, ModeL), 0, src, NULL, 0);
+            }
+            break;
+        default:
+            die("Bad mode for extending move");
+            break;
+    }
+}
+
+/* the prefix that picks single or double precision */
+static int fltpfx(Mode m)
+{
+    return m == ModeF ? 0xf3 : 0xf2;
+}
+
+static void branch(Enc *e, Insn *insn, int isshort)
+{
+    Loc *l;
+
+    l = insn->args[0];
+    if (l->type != Loclbl) {
+        if (insn->op != Ijmp)
+            die("Conditional jump to non-label");
+        op1(e, ModeNone, 0, 0xff, NULL, 4, l, NULL, 0);
+        return;
+    }
+    if (isshort) {
+        b(e, insn->op == Ijmp ? 0xeb : 0x70 + condcode[insn->op]);
+        fix(e, l->lbl, -1, Relpc8);
+        le(e, 0, 1);
+    } else {
+        if (insn->op == Ijmp) {
+            b(e, 0xe9);
+        } else {
+            b(e, 0x0f);
+            b(e, 0x80 + condcode[insn->op]);
+        }
+        fix(e, l->lbl, -4, Relpc32);
+        le(e, 0, 4);
+    }
+}
+
+static void encode(Enc *e, Insn *insn, int isshort)
+{
+    Loc **a;
+    Mode m;
+
+    e->len = 0;
+    e->nfix = 0;
+    a = insn->args;
+    switch (insn->op) {
+        case Imov:      mov(e, insn);   break;
+        case Imovzx:
+        case Imovsx:    movx(e, insn);  break;
+        case Ilea:      op1(e, a[1]->mode, 0, 0x8d, a[1], 0, a[0], NULL, 0);       break;
+        case Iadd: case Isub: case Iand: case Ior: case Ixor: case Icmp:
+            alu(e, insn);
+            break;
+        case Itest:     test(e, insn);  break;
+        case Iimul:
+            m = a[0]->mode;
+            if (isimm8(a[0]))
+                op1(e, m, 0, 0x6b, a[1], 0, a[1], a[0], 1);
+            else if (isimm(a[0]))
+                op1(e, m, 0, 0x69, a[1], 0, a[1], a[0], immsize(m));
+            else
+                op2(e, m, 0, 0xaf, a[1], a[0]);
+            break;
+        case Iimul_r: case Iimulw: case Imul: case Idiv: case Iidiv:
+        case Ineg: case Inot:
+            m = a[0]->mode;
+            op1(e, m, 0, m == ModeB ? 0xf6 : 0xf7, NULL, grpext[insn->op], a[0], NULL, 0);
+            break;
+        case Ishl: case Ishr: case Isar:
+            m = a[1]->mode;
+            if (a[0]->type == Loclit && a[0]->lit == 1)
+                op1(e, m, 0, m == ModeB ? 0xd0 : 0xd1, NULL, grpext[insn->op], a[1], NULL, 0);
+            else if (isimm(a[0]))
+                op1(e, m, 0, m == ModeB ? 0xc0 : 0xc1, NULL, grpext[insn->op], a[1], a[0], 1);
+            else if (rn(a[0]) == 1)
+                op1(e, m, 0, m == ModeB ? 0xd2 : 0xd3, NULL, grpext[insn->op], a[1], NULL, 0);
+            else
+                die("Shift count must be in %%cl");
+            break;
+        case Ipush:
+        case Ipop:
+            if (rn(a[0]) & 8)
+                b(e, 0x41);
+            b(e, (insn->op == Ipush ? 0x50 : 0x58) + (rn(a[0]) & 7));
+            break;
+        case Isetz: case Isetnz: case Isetl: case Isetle: case Isetg:
+        case Isetge: case Isetb: case Isetbe: case Iseta: case Isetae:
+            op2(e, ModeB, 0, 0x90 + condcode[insn->op], NULL, a[0]);
+            break;
+        case Irepmovsb: b(e, 0xf3); b(e, 0xa4);                 break;
+        case Irepmovsw: b(e, 0x66); b(e, 0xf3); b(e, 0xa5);     break;
+        case Irepmovsl: b(e, 0xf3); b(e, 0xa5);                 break;
+        case Irepmovsq: b(e, 0xf3); b(e, 0x48); b(e, 0xa5);     break;
+
+        /* floating point */
+        case Imovs:
+            m = a[0]->mode;
+            if (ismem(a[1]))
+                op2(e, ModeNone, fltpfx(m), 0x11, a[0], a[1]);
+            else
+                op2(e, ModeNone, fltpfx(m), 0x10, a[1], a[0]);
+            break;
+        case Imovdqu:
+            if (ismem(a[1]))
+                op2(e, ModeNone, 0xf3, 0x7f, a[0], a[1]);
+            else
+                op2(e, ModeNone, 0xf3, 0x6f, a[1], a[0]);
+            break;
+        case Iadds: op2(e, ModeNone, fltpfx(a[0]->mode), 0x58, a[1], a[0]);    break;
+        case Isubs: op2(e, ModeNone, fltpfx(a[0]->mode), 0x5c, a[1], a[0]);    break;
+        case Imuls: op2(e, ModeNone, fltpfx(a[0]->mode), 0x59, a[1], a[0]);    break;
+        case Idivs: op2(e, ModeNone, fltpfx(a[0]->mode), 0x5e, a[1], a[0]);    break;
+        /* the double precision forms take a 66 prefix, which ModeW gives us */
+        case Icomis:
+            op2(e, a[0]->mode == ModeD ? ModeW : ModeNone, 0, 0x2f, a[1], a[0]);
+            break;
+        case Ixorp:
+            op2(e, a[0]->mode == ModeD ? ModeW : ModeNone, 0, 0x57, a[1], a[0]);
+            break;
+        case Icvttsd2si:
+            op2(e, a[1]->mode == ModeQ ? ModeQ : ModeNone, fltpfx(a[0]->mode), 0x2c, a[1], a[0]);
+            break;
+        case Icvttsi2sd:
+            op2(e, a[0]->mode == ModeQ ? ModeQ : ModeNone, fltpfx(a[1]->mode), 0x2a, a[1], a[0]);
+            break;
+
+        /* control flow */
+        case Icall:
+            if (a[0]->type == Loclbl || (a[0]->type == Locmeml && !a[0]->mem.base)) {
+                b(e, 0xe8);
+                fix(e, a[0]->type == Loclbl ? a[0]->lbl : a[0]->mem.lbldisp, -4, Relplt32);
+                le(e, 0, 4);
+                break;
+            }
+            /* fallthrough */
+        case Icallind:
+            op1(e, ModeNone, 0, 0xff, NULL, 2, a[0], NULL, 0);
+            break;
+        case Ijmpind:
+            op1(e, ModeNone, 0, 0xff, NULL, 4, a[0], NULL, 0);
+            break;
+        case Ijmp: case Ijz: case Ijnz: case Ijl: case Ijle: case Ijg:
+        case Ijge: case Ijb: case Ijbe: case Ija: case Ijae:
+            branch(e, insn, isshort);
+            break;
+        case Iret:
+            b(e, 0xc3);
+            break;
+        case Ilbl:
+            break;
+        default:
+            die("Can't encode insn %d", insn->op);
+            break;
+    }
+}
+
+/* the bb comments in the instruction stream are Ilbl too */
+int iscomment(Insn *insn)
+{
+    return insn->op == Ilbl && insn->args[0]->lbl[0] == '\n';
+}
+
+static int isjmp(Insn *insn)
+{
+    switch (insn->op) {
+        case Ijmp: case Ijz: case Ijnz: case Ijl: case Ijle: case Ijg:
+        case Ijge: case Ijb: case Ijbe: case Ija: case Ijae:
+            return insn->args[0]->type == Loclbl;
+        default:
+            return 0;
+    }
+}
+
+static void patch(Objsec *s, size_t off, long v, size_t sz)
+{
+    size_t i;
+
+    for (i = 0; i < sz; i++)
+        s->buf[off + i] = v >> (8*i);
+}
+
+/*
+ * Lays out and encodes the text accumulated since the
+ * last call, which is one function's worth. Branches
+ * to labels in it start out short, and are grown
+ * until every one of them reaches its target; growing
+ * only ever moves code apart, so this terminates.
+ * References to text that comes later are left as
+ * relocations for resolvetext() to patch.
+ */
+void assemble(Obj *o)
+{
+    size_t i, j, pos, base, *off, *sz, *tgt;
+    Objsec *text;
+    char *isshort;
+    Htab *lblidx;
+    int changed;
+    Reloc *r;
+    Insn *insn;
+    Sym *s;
+    long d;
+    Enc e;
+
+    if (!o->ntext)
+        return;
+    text = &o->sec[Sectext];
+    base = text->len;
+    lblidx = mkht(strhash, streq);
+    for (i = 0; i < o->ntext; i++)
+        if (o->text[i]->op == Ilbl && !iscomment(o->text[i]))
+            htput(lblidx, o->text[i]->args[0]->lbl, (void*)(i + 1));
+
+    off = zalloc((o->ntext + 1) * sizeof(size_t));
+    sz = zalloc(o->ntext * sizeof(size_t));
+    tgt = zalloc(o->ntext * sizeof(size_t));
+    isshort = zalloc(o->ntext);
+    for (i = 0; i < o->ntext; i++) {
+        insn = o->text[i];
+        if (isjmp(insn))
+            tgt[i] = (size_t)htget(lblidx, insn->args[0]->lbl);
+        isshort[i] = tgt[i] != 0;
+        encode(&e, insn, isshort[i]);
+        sz[i] = e.len;
+    }
+
+    do {
+        pos = base;
+        for (i = 0; i < o->ntext; i++) {
+            off[i] = pos;
+            pos += sz[i];
+        }
+        off[i] = pos;
+        changed = 0;
+        for (i = 0; i < o->ntext; i++) {
+            if (!isshort[i])
+                continue;
+            d = (long)off[tgt[i] - 1] - (long)(off[i] + sz[i]);
+            if (!fits8(d)) {
+                isshort[i] = 0;
+                encode(&e, o->text[i], 0);
+                sz[i] = e.len;
+                changed = 1;
+            }
+        }
+    } while (changed);
+
+    for (i = 0; i < o->ntext; i++) {
+        insn = o->text[i];
+        if (insn->op != Ilbl || iscomment(insn))
+            continue;
+        s = getsym(o, insn->args[0]->lbl);
+        if (s->defined)
+            die("Symbol %s defined twice", s->name);
+        s->defined = 1;
+        s->sec = Sectext;
+        s->off = off[i];
+    }
+
+    for (i = 0; i < o->ntext; i++) {
+        encode(&e, o->text[i], isshort[i]);
+        assert(e.len == sz[i]);
+        secput(text, e.buf, e.len);
+        for (j = 0; j < e.nfix; j++) {
+            s = getsym(o, e.fix[j].sym);
+            pos = off[i] + e.fix[j].off;
+            switch (e.fix[j].type) {
+                case Relpc8:
+                    patch(text, pos, s->off + e.fix[j].addend - pos, 1);
+                    continue;
+                case Relpc32:
+                case Relplt32:
+                    /* pc relative references within the text need no relocation */
+                    if (s->defined && s->sec == Sectext) {
+                        patch(text, pos, s->off + e.fix[j].addend - pos, 4);
+                        continue;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            r = zalloc(sizeof(Reloc));
+            *r = e.fix[j];
+            /* the label it came from goes away with the function */
+            r->sym = s->name;
+            r->off = pos;
+            lappend(&text->rel, &text->nrel, r);
+        }
+    }
+    lfree(&o->text, &o->ntext);
+    free(off);
+    free(sz);
+    free(tgt);
+    free(isshort);
+    htfree(lblidx);
+}
+
+/*
+ * Patches pc relative references to text that was
+ * defined after the function referring to it, once
+ * all of the text has been assembled.
+ */
+void resolvetext(Obj *o)
+{
+    Objsec *text;
+    Reloc **rel;
+    size_t i, nrel;
+    Reloc *r;
+    Sym *s;
+
+    text = &o->sec[Sectext];
+    rel = NULL;
+    nrel = 0;
+    for (i = 0; i < text->nrel; i++) {
+        r = text->rel[i];
+        s = getsym(o, r->sym);
+        if ((r->type == Relpc32 || r->type == Relplt32) && s->defined && s->sec == Sectext) {
+            patch(text, r->off, s->off + r->addend - r->off, 4);
+            free(r);
+        } else {
+            lappend(&rel, &nrel, r);
+        }
+    }
+    free(text->rel);
+    text->rel = rel;
+    text->nrel = nrel;
+}
@@ -35,7 +35,7 @@ char* modenames[] = {
 
 /* forward decls */
 Loc *selexpr(Isel *s, Node *n);
-static size_t writeblob(FILE *fd, Htab *globls, Htab *strtab, Node *blob);
+static size_t writeblob(Obj *o, Htab *globls, Htab *strtab, Node *blob);
 
 /* used to decide which operator is appropriate
  * for implementing various conditional operators */
@@ -147,11 +147,12 @@ static Insn *mkinsnv(AsmOp op, va_list ap)
     int n;
 
     n = 0;
-    i = malloc(sizeof(Insn));
+    i = aalloc(&fnarena, sizeof(Insn));
     i->op = op;
     while ((l = va_arg(ap, Loc*)) != NULL)
         i->args[n++] = l;
     i->nargs = n;
+    i->nargregs = 0;
     return i;
 }
 
@@ -291,6 +292,37 @@ static void selcjmp(Isel *s, Node *n, Node **args)
     g(s, Ijmp, l2, NULL);
 }
 
+/*
+ * Jumps through a table of labels, indexed by args[0].
+ * simp() has already checked the index against the
+ * table size, so the index only needs widening; the
+ * table itself is written out after the function.
+ */
+static void seljtab(Isel *s, Node *n, Node **args)
+{
+    char buf[128];
+    Loc *a, *idx;
+    Jtab *t;
+    size_t i;
+
+    a = inr(s, selexpr(s, args[0]));
+    if (a->mode == ModeQ) {
+        idx = a;
+    } else {
+        idx = locreg(ModeQ);
+        g(s, Imovzx, a, idx, NULL);
+    }
+
+    t = aalloc(&fnarena, sizeof(Jtab));
+    t->lbl = astrdup(&fnarena, genlblstr(buf, sizeof buf));
+    t->ntarg = n->expr.nargs - 1;
+    t->targ = aalloc(&fnarena, t->ntarg*sizeof(char*));
+    for (i = 0; i < t->ntarg; i++)
+        t->targ[i] = loclbl(args[i + 1])->lbl;
+    lappend(&s->jtab, &s->njtab, t);
+    g(s, Ijmpind, locmemls(t->lbl, NULL, idx, 8, ModeQ), NULL);
+}
+
 static Loc *binop(Isel *s, AsmOp op, Node *x, Node *y)
 {
     Loc *a, *b;
@@ -368,15 +400,52 @@ static Loc *memloc(Isel *s, Node *e, Mode m)
     return l;
 }
 
+/* copies sz bytes with moves through a register, widest first */
+static void blitmov(Isel *s, Loc *dp, Loc *sp, size_t dstoff, size_t srcoff, size_t sz)
+{
+    Mode modes[] = {ModeQ, ModeL, ModeW, ModeB};
+    size_t i, off, n;
+    Loc *tmp, *xmm;
+
+    off = 0;
+    if (sz >= Blitsse) {
+        xmm = locphysreg(Rxmm15d);
+        for (; sz - off >= 16; off += 16) {
+            g(s, Imovdqu, locmem(srcoff + off, sp, NULL, ModeD), xmm, NULL);
+            g(s, Imovdqu, xmm, locmem(dstoff + off, dp, NULL, ModeD), NULL);
+        }
+    }
+    for (i = 0; i < sizeof modes/sizeof modes[0]; i++) {
+        n = modesize[modes[i]];
+        for (; sz - off >= n; off += n) {
+            tmp = locreg(modes[i]);
+            g(s, Imov, locmem(srcoff + off, sp, NULL, modes[i]), tmp, NULL);
+            g(s, Imov, tmp, locmem(dstoff + off, dp, NULL, modes[i]), NULL);
+        }
+    }
+}
+
+/*
+ * Small copies are done inline, so that they don't tie up
+ * %rcx, %rsi, and %rdi, nor pay for starting up a rep movs.
+ * blitbench times the choices.
+ */
 static void blit(Isel *s, Loc *to, Loc *from, size_t dstoff, size_t srcoff, size_t sz)
 {
     Loc *sp, *dp, *len; /* pointers to src, dst */
 
-    len = loclit(sz, ModeQ);
     sp = inr(s, from);
     dp = inr(s, to);
+    if (sz <= Blitrep) {
+        blitmov(s, dp, sp, dstoff, srcoff, sz);
+        return;
+    }
 
     /* length to blit */
+    if (sz % 8 == 0)
+        len = loclit(sz / 8, ModeQ);
+    else
+        len = loclit(sz, ModeQ);
     g(s, Imov, len, locphysreg(Rrcx), NULL);
     /* source address with offset */
     if (srcoff)
@@ -388,26 +457,35 @@ static void blit(Isel *s, Loc *to, Loc *from, size_t dstoff, size_t srcoff, size
         g(s, Ilea, locmem(dstoff, dp, NULL, ModeQ), locphysreg(Rrdi), NULL);
     else
         g(s, Imov, dp, locphysreg(Rrdi), NULL);
-    g(s, Irepmovsb, NULL);
+    if (sz % 8 == 0)
+        g(s, Irepmovsq, NULL);
+    else
+        g(s, Irepmovsb, NULL);
 }
 
-static int isfunc(Isel *s, Node *n)
+static Node *fndecl(Isel *s, Node *n)
 {
     Node *d;
 
     if (exprop(n) != Ovar)
-        return 0;
+        return NULL;
     if (!hthas(s->globls, n))
-        return 0;
+        return NULL;
     d = decls[n->expr.did];
-    if (d && d->decl.isconst)
-        return tybase(decltype(d))->type == Tyfunc;
-    return 0;
+    if (d && d->decl.isconst && tybase(decltype(d))->type == Tyfunc)
+        return d;
+    return NULL;
 }
 
-static void call(Isel *s, Node *n)
+static int isfunc(Isel *s, Node *n)
+{
+    return fndecl(s, n) != NULL;
+}
+
+static void call(Isel *s, Node *n, Reg *argregs, size_t nargregs)
 {
     AsmOp op;
+    Insn *i;
     Loc *f;
 
     if (isfunc(s, n)) {
@@ -418,6 +496,10 @@ static void call(Isel *s, Node *n)
         f = selexpr(s, n);
     }
     g(s, op, f, NULL);
+    /* the arg registers need to stay live up to the call */
+    i = s->curbb->il[s->curbb->ni - 1];
+    memcpy(i->argregs, argregs, nargregs*sizeof(Reg));
+    i->nargregs = nargregs;
 }
 
 static Loc *gencall(Isel *s, Node *n)
@@ -425,8 +507,15 @@ static Loc *gencall(Isel *s, Node *n)
     Loc *src, *dst, *arg;  /* values we reduced */
     Loc *retloc, *rsp, *ret;       /* hard-coded registers */
     Loc *stkbump;        /* calculated stack offset */
+    Loc *regval[Nintarg + Nfltarg]; /* values bound for arg registers */
+    Reg argreg[Nintarg + Nfltarg];
+    Mode argmode[Nintarg + Nfltarg];
+    size_t *nreg;        /* number of registers each arg takes */
+    size_t nargreg;
+    Argcc cc;
+    Node *d;
     int argsz, argoff;
-    size_t i;
+    size_t i, j, k;
 
     rsp = locphysreg(Rrsp);
     if (tybase(exprtype(n))->type == Tyvoid) {
@@ -442,7 +531,17 @@ static Loc *gencall(Isel *s, Node *n)
         retloc = coreg(Rrax, mode(n));
         ret = locreg(mode(n));
     }
+
+    /* Functions written in assembly are declared $stkcc, and
+     * expect their args on the stack, so they get the old convention. */
+    d = fndecl(s, n->expr.args[0]);
+    cc.regcc = isregcc(exprtype(n->expr.args[0])) && !(d && d->decl.isstkcc);
+    cc.nint = 0;
+    cc.nflt = 0;
+
     argsz = 0;
+    nargreg = 0;
+    nreg = zalloc(n->expr.nargs * sizeof(size_t));
     /* Have to calculate the amount to bump the stack
      * pointer by in one pass first, otherwise if we push
      * one at a time, we evaluate the args in reverse order.
@@ -450,6 +549,10 @@ static Loc *gencall(Isel *s, Node *n)
      *
      * Skip the first operand, since it's the function itself */
     for (i = 1; i < n->expr.nargs; i++) {
+        nreg[i] = classify(&cc, exprtype(n->expr.args[i]), &argreg[nargreg], &argmode[nargreg]);
+        nargreg += nreg[i];
+        if (nreg[i])
+            continue;
         argsz = align(argsz, min(size(n->expr.args[i]), Ptrsz));
         argsz += size(n->expr.args[i]);
     }
@@ -458,23 +561,45 @@ static Loc *gencall(Isel *s, Node *n)
     if (argsz)
         g(s, Isub, stkbump, rsp, NULL);
 
-    /* Now, we can evaluate the arguments */
+    /* Now, we can evaluate the arguments. Values going into
+     * registers are held in temporaries until every arg has
+     * been evaluated, since evaluating an arg may make a call. */
     argoff = 0;
+    k = 0;
     for (i = 1; i < n->expr.nargs; i++) {
         arg = selexpr(s, n->expr.args[i]);
-        argoff = align(argoff, min(size(n->expr.args[i]), Ptrsz));
-        if (stacknode(n->expr.args[i])) {
+        if (nreg[i] && stacknode(n->expr.args[i])) {
+            src = locreg(ModeQ);
+            g(s, Ilea, arg, src, NULL);
+            for (j = 0; j < nreg[i]; j++, k++) {
+                regval[k] = locreg(argmode[k]);
+                load(s, locmem(j*Ptrsz, src, NULL, argmode[k]), regval[k]);
+            }
+        } else if (nreg[i]) {
+            regval[k++] = inri(s, arg);
+        } else if (stacknode(n->expr.args[i])) {
+            argoff = align(argoff, min(size(n->expr.args[i]), Ptrsz));
             src = locreg(ModeQ);
             g(s, Ilea, arg, src, NULL);
             blit(s, rsp, src, argoff, 0, size(n->expr.args[i]));
+            argoff += size(n->expr.args[i]);
         } else {
+            argoff = align(argoff, min(size(n->expr.args[i]), Ptrsz));
             dst = locmem(argoff, rsp, NULL, arg->mode);
             arg = inri(s, arg);
             stor(s, arg, dst);
+            argoff += size(n->expr.args[i]);
         }
-        argoff += size(n->expr.args[i]);
     }
-    call(s, n->expr.args[0]);
+    for (k = 0; k < nargreg; k++) {
+        argreg[k] = coreg(argreg[k], argmode[k])->reg.colour;
+        if (isfloatmode(argmode[k]))
+            g(s, Imovs, regval[k], locphysreg(argreg[k]), NULL);
+        else
+            g(s, Imov, regval[k], locphysreg(argreg[k]), NULL);
+    }
+    free(nreg);
+    call(s, n->expr.args[0], argreg, nargreg);
     if (argsz)
         g(s, Iadd, stkbump, rsp, NULL);
     if (retloc) {
@@ -486,6 +611,234 @@ static Loc *gencall(Isel *s, Node *n)
     return ret;
 }
 
+/* 2^p / d: the low 64 bits of the quotient, and the remainder */
+static uvlong pow2div(int p, uvlong d, uvlong *rem)
+{
+    uvlong q, r;
+    int i;
+
+    q = 0;
+    r = 0;
+    for (i = p; i >= 0; i--) {
+        r = r << 1 | (i == p);
+        q <<= 1;
+        if (r >= d) {
+            r -= d;
+            q |= 1;
+        }
+    }
+    *rem = r;
+    return q;
+}
+
+/*
+ * The signed magic number for dividing n bit values by
+ * d, from Hacker's Delight: the quotient is the high half
+ * of x*m, corrected by x if m has the wrong sign, shifted
+ * right by *shift, plus one if that is negative.
+ */
+static uvlong smagic(vlong d, int n, int *shift)
+{
+    uvlong ad, anc, delta, q1, r1, q2, r2, t, two, mask;
+    int p;
+
+    mask = n == 64 ? ~0ULL : (1ULL << n) - 1;
+    two = 1ULL << (n - 1);
+    ad = d < 0 ? -(uvlong)d : (uvlong)d;
+    t = two + (d < 0);
+    anc = t - 1 - t % ad;
+    p = n - 1;
+    q1 = two / anc;
+    r1 = two - q1*anc;
+    q2 = two / ad;
+    r2 = two - q2*ad;
+    do {
+        p++;
+        q1 = 2*q1 & mask;
+        r1 = 2*r1;
+        if (r1 >= anc) {
+            q1 = (q1 + 1) & mask;
+            r1 -= anc;
+        }
+        q2 = 2*q2 & mask;
+        r2 = 2*r2;
+        if (r2 >= ad) {
+            q2 = (q2 + 1) & mask;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    *shift = p - n;
+    if (d < 0)
+        return -(q2 + 1) & mask;
+    return (q2 + 1) & mask;
+}
+
+/* a literal, or a register holding it if it won't fit in an imm32 */
+static Loc *immval(Isel *s, vlong v, Mode m)
+{
+    Loc *l;
+
+    l = loclit(v, m);
+    if (m == ModeQ && (v < INT32_MIN || v > INT32_MAX))
+        l = inr(s, l);
+    return l;
+}
+
+static Loc *copyof(Isel *s, Loc *a)
+{
+    Loc *r;
+
+    r = locreg(a->mode);
+    g(s, Imov, a, r, NULL);
+    return r;
+}
+
+/* the high half of x*m, signed or not */
+static Loc *mulhi(Isel *s, Loc *x, uvlong m, int sgn)
+{
+    Loc *eax, *edx;
+
+    eax = coreg(Reax, x->mode);
+    edx = coreg(Redx, x->mode);
+    g(s, Imov, loclit(m, x->mode), eax, NULL);
+    g(s, sgn ? Iimulw : Imul, x, NULL);
+    return copyof(s, edx);
+}
+
+static Loc *udivconst(Isel *s, Loc *x, uvlong d, int n)
+{
+    uvlong m, rem;
+    int l;
+    Loc *q, *t;
+
+    for (l = 0; l < n && (1ULL << l) < d; l++)
+        /* nothing */;
+    if (d == 1ULL << l) {
+        q = copyof(s, x);
+        if (l)
+            g(s, Ishr, loclit(l, ModeB), q, NULL);
+        return q;
+    }
+    /* a magic number that fits in n bits, if there is one */
+    m = pow2div(n + l - 1, d, &rem) + 1;
+    if (d - rem <= 1ULL << (l - 1)) {
+        q = mulhi(s, x, m, 0);
+        if (l > 1)
+            g(s, Ishr, loclit(l - 1, ModeB), q, NULL);
+        return q;
+    }
+    /* otherwise, we need n + 1 bits, with the top one added in by hand */
+    m = pow2div(n + l, d, &rem) + 1;
+    if (n < 64)
+        m &= (1ULL << n) - 1;
+    t = mulhi(s, x, m, 0);
+    q = copyof(s, x);
+    g(s, Isub, t, q, NULL);
+    g(s, Ishr, loclit(1, ModeB), q, NULL);
+    g(s, Iadd, t, q, NULL);
+    if (l > 1)
+        g(s, Ishr, loclit(l - 1, ModeB), q, NULL);
+    return q;
+}
+
+static Loc *sdivconst(Isel *s, Loc *x, vlong d, int n)
+{
+    uvlong ad, m;
+    int k, shift;
+    Loc *q, *t;
+
+    ad = d < 0 ? -(uvlong)d : (uvlong)d;
+    for (k = 0; k < n && (1ULL << k) < ad; k++)
+        /* nothing */;
+    if (ad == 1ULL << k) {
+        /* shifts round down, so bias negative values to round to zero */
+        q = copyof(s, x);
+        if (k) {
+            g(s, Isar, loclit(n - 1, ModeB), q, NULL);
+            g(s, Ishr, loclit(n - k, ModeB), q, NULL);
+            g(s, Iadd, x, q, NULL);
+            g(s, Isar, loclit(k, ModeB), q, NULL);
+        }
+    } else {
+        m = smagic(d, n, &shift);
+        q = mulhi(s, x, m, 1);
+        if (d > 0 && (m >> (n - 1)) & 1)
+            g(s, Iadd, x, q, NULL);
+        else if (d < 0 && !((m >> (n - 1)) & 1))
+            g(s, Isub, x, q, NULL);
+        if (shift)
+            g(s, Isar, loclit(shift, ModeB), q, NULL);
+        t = copyof(s, q);
+        g(s, Ishr, loclit(n - 1, ModeB), t, NULL);
+        g(s, Iadd, t, q, NULL);
+        return q;
+    }
+    if (d < 0)
+        g(s, Ineg, q, NULL);
+    return q;
+}
+
+/*
+ * Division by a constant is done with shifts and a
+ * multiply by a magic number, rather than a div. Bytes
+ * and words are widened to 32 bits first. Returns NULL
+ * if the divisor isn't one we handle, leaving it to div.
+ */
+static Loc *divconst(Isel *s, Node *n)
+{
+    Node *lit;
+    vlong d;
+    uvlong mask;
+    int sgn, w, nbits;
+    Loc *x, *q, *r, *t;
+    Mode m;
+
+    lit = n->expr.args[1];
+    if (exprop(lit) != Olit || lit->expr.args[0]->lit.littype != Lint)
+        return NULL;
+    m = mode(n);
+    if (!isintmode(m))
+        return NULL;
+    sgn = istysigned(exprtype(n));
+    w = 8*modesize[m];
+    nbits = w < 32 ? 32 : w;
+    mask = w == 64 ? ~0ULL : (1ULL << w) - 1;
+    d = lit->expr.args[0]->lit.intval & mask;
+    if (sgn && w < 64 && (d >> (w - 1)) & 1)
+        d |= ~mask;
+    /* zero traps at run time, and divisors with the top bit set are rare */
+    if (d == 0 || (!sgn && (uvlong)d >> (nbits - 1)))
+        return NULL;
+
+    x = selexpr(s, n->expr.args[0]);
+    r = locreg(nbits == 64 ? ModeQ : ModeL);
+    if (w < 32)
+        g(s, sgn ? Imovsx : Imovzx, inr(s, x), r, NULL);
+    else
+        g(s, Imov, x, r, NULL);
+    x = r;
+
+    if (sgn)
+        q = sdivconst(s, x, d, nbits);
+    else
+        q = udivconst(s, x, d, nbits);
+    if (exprop(n) == Omod) {
+        if (!sgn && !(d & (d - 1))) {
+            g(s, Iand, immval(s, d - 1, x->mode), x, NULL);
+        } else {
+            g(s, Iimul, immval(s, d, x->mode), q, NULL);
+            g(s, Isub, q, x, NULL);
+        }
+        q = x;
+    }
+    if (w == nbits)
+        return q;
+    t = locreg(m);
+    g(s, Imov, q, t, NULL);
+    return t;
+}
+
 Loc *selexpr(Isel *s, Node *n)
 {
     Loc *a, *b, *c, *d, *r;
@@ -519,18 +872,33 @@ Loc *selexpr(Isel *s, Node *n)
             break;
         case Odiv:
         case Omod:
+            if ((r = divconst(s, n)) != NULL)
+                break;
             /* these get clobbered by the div insn */
             a = selexpr(s, args[0]);
             b = selexpr(s, args[1]);
             b = inr(s, b);
             c = coreg(Reax, mode(n));
             r = locreg(a->mode);
-            if (r->mode == ModeB)
-                g(s, Ixor, eax, eax, NULL);
-            else
-                g(s, Ixor, edx, edx, NULL);
-            g(s, Imov, a, c, NULL);
-            g(s, Idiv, b, NULL);
+            if (istysigned(exprtype(n))) {
+                /* idiv wants the dividend sign extended into %edx, or %ah */
+                g(s, Imov, a, c, NULL);
+                if (r->mode == ModeB) {
+                    g(s, Imovsx, c, locphysreg(Rax), NULL);
+                } else {
+                    d = coreg(Redx, mode(n));
+                    g(s, Imov, c, d, NULL);
+                    g(s, Isar, loclit(8*modesize[r->mode] - 1, ModeB), d, NULL);
+                }
+                g(s, Iidiv, b, NULL);
+            } else {
+                if (r->mode == ModeB)
+                    g(s, Ixor, eax, eax, NULL);
+                else
+                    g(s, Ixor, edx, edx, NULL);
+                g(s, Imov, a, c, NULL);
+                g(s, Idiv, b, NULL);
+            }
             if (exprop(n) == Odiv)
                 d = coreg(Reax, mode(n));
             else if (r->mode != ModeB)
@@ -579,7 +947,8 @@ Loc *selexpr(Isel *s, Node *n)
                 d = cl;
             }
             if (exprop(n) == Obsr) {
-                if (istysigned(n->expr.type))
+                /* casts may have retyped n, but not what it shifts */
+                if (istysigned(exprtype(args[0])))
                     g(s, Isar, d, a, NULL);
                 else
                     g(s, Ishr, d, a, NULL);
@@ -640,7 +1009,7 @@ Loc *selexpr(Isel *s, Node *n)
             if (exprop(args[0]) == Oderef)
                 a = memloc(s, args[0]->expr.args[0], mode(n));
             else
-                a = selexpr(s, args[0]);
+                a = loc(s, args[0]);
             b = inri(s, b);
             if (isfloatmode(b->mode))
                 g(s, Imovs, b, a, NULL);
@@ -657,6 +1026,9 @@ Loc *selexpr(Isel *s, Node *n)
         case Ocjmp:
             selcjmp(s, n, args);
             break;
+        case Ojtab:
+            seljtab(s, n, args);
+            break;
 
         case Olit: /* fall through */
             r = loc(s, n);
@@ -666,6 +1038,15 @@ Loc *selexpr(Isel *s, Node *n)
                 r = locreg(ModeQ);
                 a = loc(s, n);
                 g(s, Ilea, a, r, NULL);
+            } else if (loc(s, n)->type == Locreg) {
+                /* the ops above us are free to clobber what we hand
+                 * them, so a variable living in a register is copied */
+                a = loc(s, n);
+                r = locreg(a->mode);
+                if (isfloatmode(a->mode))
+                    g(s, Imovs, a, r, NULL);
+                else
+                    g(s, Imov, a, r, NULL);
             } else {
                 r = loc(s, n);
             }
@@ -721,7 +1102,7 @@ Loc *selexpr(Isel *s, Node *n)
         case Oslice: case Oidx: case Osize: case Numops:
         case Oucon: case Ouget: case Otup: case Oarr: case Ostruct:
         case Oslbase: case Osllen: case Ocast:
-        case Obreak: case Ocontinue:
+        case Obreak: case Ocontinue: case Ophi:
             dump(n, stdout);
             die("Should not see %s in isel", opstr(exprop(n)));
             break;
@@ -775,6 +1156,10 @@ void locprint(FILE *fd, Loc *l, char spec)
                     fprintf(fd, ")");
             } else if (l->type != Locmeml) {
                 die("Only locmeml can have unspecified base reg");
+            } else if (l->mem.idx) {
+                fprintf(fd, "(,");
+                locprint(fd, l->mem.idx, 'r');
+                fprintf(fd, ",%d)", l->mem.scale);
             }
             break;
         case Loclit:
@@ -792,12 +1177,12 @@ int subreg(Loc *a, Loc *b)
     return rclass(a) == rclass(b) && a->mode != b->mode;
 }
 
-void iprintf(FILE *fd, Insn *insn)
+/*
+ * Rewrites insn into the form that is actually emitted,
+ * returning 0 if there is nothing to emit at all.
+ */
+int finalinsn(Insn *insn)
 {
-    char *p;
-    int i;
-    int modeidx;
-
     /* x64 has a quirk; it has no movzlq because mov zero extends. This
      * means that we need to do a movl when we really want a movzlq. Since
      * we don't know the name of the reg to use, we need to sub it in when
@@ -814,7 +1199,7 @@ void iprintf(FILE *fd, Insn *insn)
         case Imovs:
             /* moving a reg to itself is dumb. */
             if (insn->args[0]->reg.colour == insn->args[1]->reg.colour)
-                return;
+                return 0;
             break;
         case Imov:
             assert(!isfloatmode(insn->args[1]->mode));
@@ -828,11 +1213,20 @@ void iprintf(FILE *fd, Insn *insn)
                 insn->args[0] = coreg(insn->args[0]->reg.colour, insn->args[1]->mode);
             /* moving a reg to itself is dumb. */
             if (insn->args[0]->reg.colour == insn->args[1]->reg.colour)
-                return;
+                return 0;
             break;
         default:
             break;
     }
+    return 1;
+}
+
+void iprintf(FILE *fd, Insn *insn)
+{
+    char *p;
+    int i;
+    int modeidx;
+
     p = insnfmts[insn->op];
     i = 0;
     modeidx = 0;
@@ -890,43 +1284,59 @@ static void isel(Isel *s, Node *n)
 }
 
 Reg savedregs[] = {
-    Rrcx, Rrdx, Rrbx, Rrsi, Rrdi, Rr8, Rr9, Rr10, Rr11, Rr12, Rr13, Rr14, Rr15,
-    /*
-    Rxmm0d, Rxmm1d, Rxmm2d, Rxmm3d, Rxmm4d, Rxmm5d, Rxmm6d, Rxmm7d,
-    Rxmm8d, Rxmm9d, Rxmm10d, Rxmm11d, Rxmm12d, Rxmm13d, Rxmm14d, Rxmm15d,
-    */
+    Rrbx, Rr12, Rr13, Rr14, Rr15,
 };
 
-static void prologue(Isel *s, size_t sz)
+/* binds the args passed in registers to their local slots */
+static void bindargs(Isel *s, Func *fn)
 {
-    Loc *rsp;
-    Loc *rbp;
-    Loc *stksz;
-    size_t i;
+    Reg r[2];
+    Mode m[2];
+    Loc *rbp, *dst;
+    ssize_t off;
+    Argcc cc;
+    size_t i, j, n;
 
-    rsp = locphysreg(Rrsp);
     rbp = locphysreg(Rrbp);
-    stksz = loclit(sz, ModeQ);
-    /* enter function */
-    g(s, Ipush, rbp, NULL);
-    g(s, Imov, rsp, rbp, NULL);
-    g(s, Isub, stksz, rsp, NULL);
-    /* save registers */
-    for (i = 0; i < sizeof(savedregs)/sizeof(savedregs[0]); i++) {
-        s->calleesave[i] = locreg(ModeQ);
-        g(s, Imov, locphysreg(savedregs[i]), s->calleesave[i], NULL);
+    cc.regcc = fn->regcc;
+    cc.nint = 0;
+    cc.nflt = 0;
+    for (i = 0; i < fn->nargs; i++) {
+        n = classify(&cc, decltype(fn->args[i]), r, m);
+        if (!n)
+            continue;
+        if (!hthas(s->stkoff, fn->args[i])) {
+            /* promoted: it lives in a register */
+            dst = locreg(m[0]);
+            htput(s->reglocs, fn->args[i], dst);
+            if (isfloatmode(m[0]))
+                g(s, Imovs, coreg(r[0], m[0]), dst, NULL);
+            else
+                g(s, Imov, coreg(r[0], m[0]), dst, NULL);
+            continue;
+        }
+        off = (ssize_t)htget(s->stkoff, fn->args[i]);
+        for (j = 0; j < n; j++) {
+            dst = locmem(-off + j*Ptrsz, rbp, NULL, m[j]);
+            if (isfloatmode(m[j]))
+                g(s, Imovs, coreg(r[j], m[j]), dst, NULL);
+            else
+                g(s, Imov, coreg(r[j], m[j]), dst, NULL);
+        }
     }
-    s->stksz = stksz; /* need to update if we spill */
+}
+
+static void prologue(Isel *s, Func *fn, size_t sz)
+{
+    /* the frame goes in once we know what it holds */
+    s->stksz = loclit(sz, ModeQ); /* need to update if we spill */
+    bindargs(s, fn);
 }
 
 static void epilogue(Isel *s)
 {
-    Loc *rsp, *rbp;
     Loc *ret;
-    size_t i;
 
-    rsp = locphysreg(Rrsp);
-    rbp = locphysreg(Rrbp);
     if (s->ret) {
         ret = loc(s, s->ret);
         if (floattype(exprtype(s->ret)))
@@ -934,35 +1344,156 @@ static void epilogue(Isel *s)
         else
             g(s, Imov, ret, coreg(Rax, ret->mode), NULL);
     }
-    /* restore registers */
-    for (i = 0; i < Nsaved; i++)
-        g(s, Imov, s->calleesave[i], locphysreg(savedregs[i]), NULL);
+}
+
+static int refersto(Loc *l, Reg r)
+{
+    if (!l)
+        return 0;
+    switch (l->type) {
+        case Locreg:
+            /* %rsp and %rbp have no colour, nor any narrower names */
+            if (l->reg.colour == r)
+                return 1;
+            return colourmap[r] && colourmap[l->reg.colour] == colourmap[r];
+        case Locmem: case Locmeml:
+            return refersto(l->mem.base, r) || refersto(l->mem.idx, r);
+        default:
+            return 0;
+    }
+}
+
+static int used(Isel *s, Reg r)
+{
+    size_t i, j, k;
+    Insn *insn;
+
+    for (i = 0; i < s->nbb; i++) {
+        for (j = 0; j < s->bb[i]->ni; j++) {
+            insn = s->bb[i]->il[j];
+            for (k = 0; k < insn->nargs; k++)
+                if (refersto(insn->args[k], r))
+                    return 1;
+        }
+    }
+    return 0;
+}
+
+/* no calls, and nothing that needs %rsp or %rbp set up */
+static int isleaf(Isel *s)
+{
+    size_t i, j;
+    Insn *insn;
+
+    if (s->stksz->lit != 0 || used(s, Rrbp) || used(s, Rrsp))
+        return 0;
+    for (i = 0; i < s->nbb; i++) {
+        for (j = 0; j < s->bb[i]->ni; j++) {
+            insn = s->bb[i]->il[j];
+            if (insn->op == Icall || insn->op == Icallind)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Wraps the allocated function in its frame, saving only
+ * the callee saved registers that the allocator handed out.
+ * They go below the locals, addressed from %rbp, since
+ * std.alloca and std.cstring leave %rsp moved. Leaf
+ * functions with nothing on the stack get no frame, and
+ * push what they save.
+ */
+static void frame(Isel *s)
+{
+    Loc *rsp, *rbp, *saved[Nsaved], *slot[Nsaved];
+    size_t i, nsaved, nil, off;
+    Insn **il;
+    int leaf;
+
+    rsp = locphysreg(Rrsp);
+    rbp = locphysreg(Rrbp);
+    leaf = isleaf(s);
+    nsaved = 0;
+    off = s->stksz->lit;
+    for (i = 0; i < Nsaved; i++) {
+        if (!used(s, savedregs[i]))
+            continue;
+        saved[nsaved] = locphysreg(savedregs[i]);
+        slot[nsaved] = locmem(-(off + (nsaved + 1)*Ptrsz), rbp, NULL, ModeQ);
+        nsaved++;
+    }
+    /* keeps %rsp 16 byte aligned at calls */
+    if (!leaf)
+        s->stksz->lit = align(off + nsaved*Ptrsz, 16);
+
+    /* enter function */
+    il = s->bb[0]->il;
+    nil = s->bb[0]->ni;
+    s->bb[0]->il = NULL;
+    s->bb[0]->ni = 0;
+    s->curbb = s->bb[0];
+    if (!leaf) {
+        g(s, Ipush, rbp, NULL);
+        g(s, Imov, rsp, rbp, NULL);
+        if (s->stksz->lit)
+            g(s, Isub, s->stksz, rsp, NULL);
+    }
+    for (i = 0; i < nsaved; i++) {
+        if (leaf)
+            g(s, Ipush, saved[i], NULL);
+        else
+            g(s, Imov, saved[i], slot[i], NULL);
+    }
+    for (i = 0; i < nil; i++)
+        lappend(&s->bb[0]->il, &s->bb[0]->ni, il[i]);
+    lfree(&il, &nil);
+
     /* leave function */
-    g(s, Imov, rbp, rsp, NULL);
-    g(s, Ipop, rbp, NULL);
+    s->curbb = s->bb[s->nbb - 1];
+    for (i = nsaved; i-- > 0;) {
+        if (leaf)
+            g(s, Ipop, saved[i], NULL);
+        else
+            g(s, Imov, slot[i], saved[i], NULL);
+    }
+    if (!leaf) {
+        g(s, Imov, rbp, rsp, NULL);
+        g(s, Ipop, rbp, NULL);
+    }
     g(s, Iret, NULL);
 }
 
-static void writeasm(FILE *fd, Isel *s, Func *fn)
+static void writeasm(Obj *o, Isel *s, Func *fn)
 {
     size_t i, j;
+    Jtab *t;
 
-    if (fn->isexport || !strcmp(fn->name, Symprefix "main"))
-        fprintf(fd, ".globl %s\n", fn->name);
-    fprintf(fd, "%s:\n", fn->name);
+    objlbl(o, fn->name, fn->isexport || !strcmp(fn->name, Symprefix "main"));
     for (j = 0; j < s->cfg->nbb; j++) {
         for (i = 0; i < s->bb[j]->nlbls; i++)
-            fprintf(fd, "%s:\n", s->bb[j]->lbls[i]);
+            objlbl(o, s->bb[j]->lbls[i], 0);
         for (i = 0; i < s->bb[j]->ni; i++)
-            iprintf(fd, s->bb[j]->il[i]);
+            objinsn(o, s->bb[j]->il[i]);
+    }
+    if (!s->njtab)
+        return;
+    objsec(o, Secrodata);
+    for (j = 0; j < s->njtab; j++) {
+        t = s->jtab[j];
+        objlbl(o, t->lbl, 0);
+        for (i = 0; i < t->ntarg; i++)
+            objaddr(o, t->targ[i], 0);
     }
+    objsec(o, Sectext);
 }
 
 static Asmbb *mkasmbb(Bb *bb)
 {
     Asmbb *as;
 
-    as = zalloc(sizeof(Asmbb));
+    as = azalloc(&fnarena, sizeof(Asmbb));
     as->id = bb->id;
     as->pred = bsdup(bb->pred);
     as->succ = bsdup(bb->succ);
@@ -971,36 +1502,11 @@ static Asmbb *mkasmbb(Bb *bb)
     return as;
 }
 
-static void writebytes(FILE *fd, char *p, size_t sz)
-{
-    size_t i;
-
-    for (i = 0; i < sz; i++) {
-        if (i % 60 == 0)
-            fprintf(fd, "\t.ascii \"");
-        if (p[i] == '"' || p[i] == '\\')
-            fprintf(fd, "\\");
-        if (isprint(p[i]))
-            fprintf(fd, "%c", p[i]);
-        else
-            fprintf(fd, "\\%03o", (uint8_t)p[i] & 0xff);
-        /* line wrapping for readability */
-        if (i % 60 == 59 || i == sz - 1)
-            fprintf(fd, "\"\n");
-    }
-}
-
-static size_t writelit(FILE *fd, Htab *strtab, Node *v, Type *ty)
+static size_t writelit(Obj *o, Htab *strtab, Node *v, Type *ty)
 {
     char buf[128];
     char *lbl;
     size_t sz;
-    char *intsz[] = {
-        [1] = ".byte",
-        [2] = ".short",
-        [4] = ".long",
-        [8] = ".quad"
-    };
     union {
         float fv;
         double dv;
@@ -1011,16 +1517,16 @@ static size_t writelit(FILE *fd, Htab *strtab, Node *v, Type *ty)
     assert(v->type == Nlit);
     sz = tysize(ty);
     switch (v->lit.littype) {
-        case Lint:      fprintf(fd, "\t%s %lld\n", intsz[sz], v->lit.intval);    break;
-        case Lbool:     fprintf(fd, "\t.byte %d\n", v->lit.boolval);     break;
-        case Lchr:      fprintf(fd, "\t.long %d\n",  v->lit.chrval);     break;
+        case Lint:      objint(o, v->lit.intval, sz);   break;
+        case Lbool:     objint(o, v->lit.boolval, 1);   break;
+        case Lchr:      objint(o, v->lit.chrval, 4);    break;
         case Lflt:
                 if (tybase(v->lit.type)->type == Tyfloat32) {
                     u.fv = v->lit.fltval;
-                    fprintf(fd, "\t.long 0x%"PRIx32"\n", u.lv);
+                    objint(o, u.lv, 4);
                 } else if (tybase(v->lit.type)->type == Tyfloat64) {
                     u.dv = v->lit.fltval;
-                    fprintf(fd, "\t.quad 0x%"PRIx64"\n", u.qv);
+                    objint(o, u.qv, 8);
                 }
                 break;
         case Lstr:
@@ -1030,8 +1536,8 @@ static size_t writelit(FILE *fd, Htab *strtab, Node *v, Type *ty)
                lbl = genlblstr(buf, sizeof buf);
                htput(strtab, v->lit.strval, strdup(lbl));
            }
-           fprintf(fd, "\t.quad %s\n", lbl);
-           fprintf(fd, "\t.quad %zd\n", strlen(v->lit.strval));
+           objaddr(o, lbl, 0);
+           objint(o, strlen(v->lit.strval), 8);
            break;
         case Lfunc:
             die("Generating this shit ain't ready yet ");
@@ -1043,11 +1549,9 @@ static size_t writelit(FILE *fd, Htab *strtab, Node *v, Type *ty)
     return sz;
 }
 
-static size_t writepad(FILE *fd, size_t sz)
+static size_t writepad(Obj *o, size_t sz)
 {
-    assert((ssize_t)sz >= 0);
-    if (sz > 0)
-        fprintf(fd, "\t.fill %zd,1,0\n", sz);
+    objpad(o, sz);
     return sz;
 }
 
@@ -1061,7 +1565,7 @@ static size_t getintlit(Node *n, char *failmsg)
     return n->lit.intval;
 }
 
-static size_t writeslice(FILE *fd, Htab *globls, Htab *strtab, Node *n)
+static size_t writeslice(Obj *o, Htab *globls, Htab *strtab, Node *n)
 {
     Node *base, *lo, *hi;
     ssize_t loval, hival, sz;
@@ -1081,12 +1585,12 @@ static size_t writeslice(FILE *fd, Htab *globls, Htab *strtab, Node *n)
     sz = tysize(tybase(exprtype(base))->sub[0]);
 
     lbl = htget(globls, base);
-    fprintf(fd, "\t.quad %s + (%zd*%zd)\n", lbl, loval, sz);
-    fprintf(fd, "\t.quad %zd\n", (hival - loval));
+    objaddr(o, lbl, loval*sz);
+    objint(o, hival - loval, 8);
     return size(n);
 }
 
-static size_t writestruct(FILE *fd, Htab *globls, Htab *strtab, Node *n)
+static size_t writestruct(Obj *o, Htab *globls, Htab *strtab, Node *n)
 {
     Type *t;
     Node **dcl;
@@ -1101,24 +1605,24 @@ static size_t writestruct(FILE *fd, Htab *globls, Htab *strtab, Node *n)
     dcl = t->sdecls;
     ndcl = t->nmemb;
     for (i = 0; i < ndcl; i++) {
-        sz += writepad(fd, tyalign(sz, size(dcl[i])) - sz);
+        sz += writepad(o, tyalign(sz, size(dcl[i])) - sz);
         found = 0;
         for (j = 0; j < n->expr.nargs; j++)
             if (!strcmp(namestr(n->expr.args[j]->expr.idx), declname(dcl[i]))) {
                 found = 1;
-                sz += writeblob(fd, globls, strtab, n->expr.args[j]);
+                sz += writeblob(o, globls, strtab, n->expr.args[j]);
             }
         if (!found)
-            sz += writepad(fd, size(dcl[i]));
+            sz += writepad(o, size(dcl[i]));
     }
     end = sz;
     for (i = 0; i < ndcl; i++)
         end = tyalign(end, size(dcl[i]));
-    sz += writepad(fd, end - sz);
+    sz += writepad(o, end - sz);
     return sz;
 }
 
-static size_t writeblob(FILE *fd, Htab *globls, Htab *strtab, Node *n)
+static size_t writeblob(Obj *o, Htab *globls, Htab *strtab, Node *n)
 {
     size_t i, sz;
 
@@ -1127,16 +1631,16 @@ static size_t writeblob(FILE *fd, Htab *globls, Htab *strtab, Node *n)
         case Oarr:
             sz = 0;
             for (i = 0; i < n->expr.nargs; i++)
-                sz += writeblob(fd, globls, strtab, n->expr.args[i]);
+                sz += writeblob(o, globls, strtab, n->expr.args[i]);
             break;
         case Ostruct:
-            sz = writestruct(fd, globls, strtab, n);
+            sz = writestruct(o, globls, strtab, n);
             break;
         case Olit:
-            sz = writelit(fd, strtab, n->expr.args[0], exprtype(n));
+            sz = writelit(o, strtab, n->expr.args[0], exprtype(n));
             break;
         case Oslice:
-            sz = writeslice(fd, globls, strtab, n);
+            sz = writeslice(o, globls, strtab, n);
             break;
         default:
             dump(n, stdout);
@@ -1146,7 +1650,7 @@ static size_t writeblob(FILE *fd, Htab *globls, Htab *strtab, Node *n)
     return sz;
 }
 
-void genblob(FILE *fd, Node *blob, Htab *globls, Htab *strtab)
+void genblob(Obj *o, Node *blob, Htab *globls, Htab *strtab)
 {
     char *lbl;
 
@@ -1154,19 +1658,66 @@ void genblob(FILE *fd, Node *blob, Htab *globls, Htab *strtab)
     assert(blob->type == Ndecl);
 
     lbl = htget(globls, blob);
-    if (blob->decl.vis != Visintern)
-        fprintf(fd, ".globl %s\n", lbl);
-    fprintf(fd, "%s:\n", lbl);
+    objlbl(o, lbl, blob->decl.vis != Visintern);
     if (blob->decl.init)
-        writeblob(fd, globls, strtab, blob->decl.init);
+        writeblob(o, globls, strtab, blob->decl.init);
     else
-        writepad(fd, size(blob));
+        writepad(o, size(blob));
+}
+
+/*
+ * The insns, locs and bbs live in fnarena, and go
+ * with it; this releases what the allocator grew
+ * on the heap around them.
+ */
+static void freeisel(Isel *s)
+{
+    Asmbb *bb;
+    size_t i;
+
+    for (i = 0; i < s->nbb; i++) {
+        bb = s->bb[i];
+        lfree(&bb->il, &bb->ni);
+        free(bb->lbls);
+        bsfree(bb->pred);
+        bsfree(bb->succ);
+        bsfree(bb->use);
+        bsfree(bb->def);
+        bsfree(bb->livein);
+        bsfree(bb->liveout);
+    }
+    lfree(&s->bb, &s->nbb);
+    lfree(&s->jtab, &s->njtab);
+    htfree(s->reglocs);
+    htfree(s->gedges);
+    for (i = 0; s->gadj && i < s->ngraph; i++)
+        free(s->gadj[i]);
+    free(s->gadj);
+    free(s->ngadj);
+    free(s->degree);
+    free(s->aliasmap);
+    for (i = 0; s->rmoves && i < s->ngraph; i++)
+        free(s->rmoves[i]);
+    free(s->rmoves);
+    free(s->nrmoves);
+    bsfree(s->initial);
+    bsfree(s->coalesced);
+    bsfree(s->spilled);
+    lfree(&s->selstk, &s->nselstk);
+    lfree(&s->mcoalesced, &s->nmcoalesced);
+    lfree(&s->mconstrained, &s->nmconstrained);
+    lfree(&s->mfrozen, &s->nmfrozen);
+    lfree(&s->mactive, &s->nmactive);
+    lfree(&s->wlmove, &s->nwlmove);
+    lfree(&s->wlspill, &s->nwlspill);
+    lfree(&s->wlfreeze, &s->nwlfreeze);
+    lfree(&s->wlsimp, &s->nwlsimp);
 }
 
 /* genasm requires all nodes in 'nl' to map cleanly to operations that are
  * natively supported, as promised in the output of reduce().  No 64-bit
  * operations on x32, no structures, and so on. */
-void genasm(FILE *fd, Func *fn, Htab *globls, Htab *strtab)
+void genasm(Obj *o, Func *fn, Htab *globls, Htab *strtab)
 {
     Isel is = {0,};
     size_t i, j;
@@ -1179,6 +1730,7 @@ void genasm(FILE *fd, Func *fn, Htab *globls, Htab *strtab)
     is.cfg = fn->cfg;
     /* ensure that all physical registers have a loc created, so we
      * don't get any surprises referring to them in the allocator */
+    resetregs();
     for (i = 0; i < Nreg; i++)
         locphysreg(i);
 
@@ -1186,7 +1738,7 @@ void genasm(FILE *fd, Func *fn, Htab *globls, Htab *strtab)
         lappend(&is.bb, &is.nbb, mkasmbb(fn->cfg->bb[i]));
 
     is.curbb = is.bb[0];
-    prologue(&is, fn->stksz);
+    prologue(&is, fn, fn->stksz);
     for (j = 0; j < fn->cfg->nbb - 1; j++) {
         is.curbb = is.bb[j];
         for (i = 0; i < fn->cfg->bb[j]->nnl; i++) {
@@ -1199,21 +1751,27 @@ void genasm(FILE *fd, Func *fn, Htab *globls, Htab *strtab)
     }
     is.curbb = is.bb[is.nbb - 1];
     epilogue(&is);
+    peep(&is, 0);
     regalloc(&is);
+    frame(&is);
+    peep(&is, 1);
 
     if (debugopt['i'])
-        writeasm(stdout, &is, fn);
-    writeasm(fd, &is, fn);
+        writeasm(mkobj(stdout, 0), &is, fn);
+    writeasm(o, &is, fn);
+    /* the object keeps nothing that points into the function */
+    assemble(o);
+    freeisel(&is);
+    afree(&fnarena);
 }
 
-void genstrings(FILE *fd, Htab *strtab)
+void genstrings(Obj *o, Htab *strtab)
 {
-    void **k;
-    size_t i, nk;
+    void *k;
+    size_t i;
 
-    k = htkeys(strtab, &nk);
-    for (i = 0; i < nk; i++) {
-        fprintf(fd, "%s:\n", (char*)htget(strtab, k[i]));
-        writebytes(fd, k[i], strlen(k[i]));
+    for (i = 0; htiter(strtab, &i, &k); i++) {
+        objlbl(o, htget(strtab, k), 0);
+        objbytes(o, k, strlen(k));
     }
 }
@@ -63,9 +63,10 @@ const Reg reginterferes[Nreg][Nmode + 1] = {
     [Rebp] = {Rebp},
 };
 
+static int nextlbl;
+
 char *genlblstr(char *buf, size_t sz)
 {
-    static int nextlbl;
     snprintf(buf, 128, ".L%d", nextlbl++);
     return buf;
 }
@@ -82,10 +83,10 @@ Loc *locstrlbl(char *lbl)
 {
     Loc *l;
 
-    l = zalloc(sizeof(Loc));
+    l = azalloc(&fnarena, sizeof(Loc));
     l->type = Loclbl;
     l->mode = ModeQ;
-    l->lbl = strdup(lbl);
+    l->lbl = astrdup(&fnarena, lbl);
     return l;
 }
 
@@ -93,10 +94,10 @@ Loc *loclitl(char *lbl)
 {
     Loc *l;
 
-    l = zalloc(sizeof(Loc));
+    l = azalloc(&fnarena, sizeof(Loc));
     l->type = Loclitl;
     l->mode = ModeQ;
-    l->lbl = strdup(lbl);
+    l->lbl = astrdup(&fnarena, lbl);
     return l;
 }
 
@@ -110,25 +111,31 @@ Loc *loclbl(Node *e)
     return locstrlbl(lbl->lit.lblval);
 }
 
+Arena fnarena;
 Loc **locmap = NULL;
-size_t maxregid = 0;
+static size_t locmapsz; /* allocated size of locmap */
+/* ids below Nreg are reserved for the physical registers */
+size_t maxregid = Nreg;
 
-static Loc *locregid(regid id, Mode m)
+static Loc *locregid(Arena *a, regid id, Mode m)
 {
     Loc *l;
 
-    l = zalloc(sizeof(Loc));
+    l = azalloc(a, sizeof(Loc));
     l->type = Locreg;
     l->mode = m;
     l->reg.id = id;
-    locmap = xrealloc(locmap, maxregid * sizeof(Loc*));
+    if (maxregid > locmapsz) {
+        locmapsz = max(2*locmapsz, maxregid);
+        locmap = xrealloc(locmap, locmapsz * sizeof(Loc*));
+    }
     locmap[l->reg.id] = l;
     return l;
 }
 
 Loc *locreg(Mode m)
 {
-    return locregid(maxregid++, m);
+    return locregid(&fnarena, maxregid++, m);
 }
 
 Loc *locphysreg(Reg r)
@@ -137,16 +144,35 @@ Loc *locphysreg(Reg r)
 
     if (physregs[r])
         return physregs[r];
-    physregs[r] = locreg(regmodes[r]);
+    /* these are shared by every function */
+    physregs[r] = locregid(&lifetime, r, regmodes[r]);
     physregs[r]->reg.colour = r;
     return physregs[r];
 }
 
+/*
+ * Virtual registers are numbered per function, so
+ * that the allocator's tables are sized by the
+ * function being compiled rather than by every
+ * register handed out so far.
+ */
+void resetregs(void)
+{
+    maxregid = Nreg;
+}
+
+/* Labels are numbered per file, so that the output
+ * doesn't depend on what else was compiled with it. */
+void resetlbls(void)
+{
+    nextlbl = 0;
+}
+
 Loc *locmem(long disp, Loc *base, Loc *idx, Mode mode)
 {
     Loc *l;
 
-    l = zalloc(sizeof(Loc));
+    l = azalloc(&fnarena, sizeof(Loc));
     l->type = Locmem;
     l->mode = mode;
     l->mem.constdisp = disp;
@@ -169,10 +195,10 @@ Loc *locmeml(char *disp, Loc *base, Loc *idx, Mode mode)
 {
     Loc *l;
 
-    l = zalloc(sizeof(Loc));
+    l = azalloc(&fnarena, sizeof(Loc));
     l->type = Locmeml;
     l->mode = mode;
-    l->mem.lbldisp = strdup(disp);
+    l->mem.lbldisp = astrdup(&fnarena, disp);
     l->mem.base = base;
     l->mem.idx = idx;
     l->mem.scale = 0;
@@ -193,7 +219,7 @@ Loc *loclit(long val, Mode m)
 {
     Loc *l;
 
-    l = zalloc(sizeof(Loc));
+    l = azalloc(&fnarena, sizeof(Loc));
     l->type = Loclit;
     l->mode = m;
     l->lit = val;
@@ -223,7 +249,7 @@ Loc *coreg(Reg r, Mode m)
         [Rdx]  = {Rnone, Rdl,  Rdx,  Redx, Rrdx},
         [Rbx]  = {Rnone, Rbl,  Rbx,  Rebx, Rrbx},
         [Rsi]  = {Rnone, Rsil, Rsi,  Resi, Rrsi},
-        [Rdi]  = {Rnone, Rsil, Rdi,  Redi, Rrdi},
+        [Rdi]  = {Rnone, Rdil, Rdi,  Redi, Rrdi},
         [Rr8w]  = {Rnone, Rr8b,  Rr8w,  Rr8d,  Rr8},
         [Rr9w]  = {Rnone, Rr9b,  Rr9w,  Rr9d,  Rr9},
         [Rr10w] = {Rnone, Rr10b, Rr10w, Rr10d, Rr10},
@@ -238,7 +264,7 @@ Loc *coreg(Reg r, Mode m)
         [Redx] = {Rnone, Rdl,  Rdx,  Redx, Rrdx},
         [Rebx] = {Rnone, Rbl,  Rbx,  Rebx, Rrbx},
         [Resi] = {Rnone, Rsil, Rsi,  Resi, Rrsi},
-        [Redi] = {Rnone, Rsil, Rdi,  Redi, Rrdi},
+        [Redi] = {Rnone, Rdil, Rdi,  Redi, Rrdi},
         [Rr8d]  = {Rnone, Rr8b,  Rr8w,  Rr8d,  Rr8},
         [Rr9d]  = {Rnone, Rr9b,  Rr9w,  Rr9d,  Rr9},
         [Rr10d] = {Rnone, Rr10b, Rr10w, Rr10d, Rr10},
@@ -253,7 +279,7 @@ Loc *coreg(Reg r, Mode m)
         [Rrdx] = {Rnone, Rdl,  Rdx,  Redx, Rrdx},
         [Rrbx] = {Rnone, Rbl,  Rbx,  Rebx, Rrbx},
         [Rrsi] = {Rnone, Rsil, Rsi,  Resi, Rrsi},
-        [Rrdi] = {Rnone, Rsil, Rdi,  Redi, Rrdi},
+        [Rrdi] = {Rnone, Rdil, Rdi,  Redi, Rrdi},
         [Rr8]   = {Rnone, Rr8b,  Rr8w,  Rr8d,  Rr8},
         [Rr9]   = {Rnone, Rr9b,  Rr9w,  Rr9d,  Rr9},
         [Rr10]  = {Rnone, Rr10b, Rr10w, Rr10d, Rr10},
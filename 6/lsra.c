@@ -0,0 +1,559 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+#include "parse.h"
+#include "opt.h"
+#include "asm.h"
+
+/*
+ * A linear scan register allocator, in the style of Poletto and
+ * Sarkar, for when iterated coalescing is too slow. Instructions
+ * are numbered in block order, with an instruction's uses at 2*i
+ * and its defs at 2*i+1. Virtual registers get a single interval
+ * spanning their lifetime, while physical registers keep precise
+ * ranges, since they tend to be live only around a few instructions.
+ *
+ * When we run out of registers, the interval that ends furthest
+ * away is split: it keeps its register up to the split point, and
+ * lives in its spill slot from there on. A few registers per class
+ * are held back from allocation, and are used to load and store
+ * spilled values, so that we only ever need a single rewrite pass.
+ */
+
+typedef struct Range Range;
+typedef struct Interval Interval;
+
+struct Range {
+    size_t from;        /* first position covered */
+    size_t to;          /* first position not covered */
+};
+
+struct Interval {
+    regid reg;
+    Range *r;           /* ranges, from the last to the first */
+    size_t nr;
+    size_t start;
+    size_t end;
+    int colour;         /* regmap index of the assigned register, or -1 */
+    int hint;           /* regmap index we'd like to get, or -1 */
+    regid partner;      /* register this one is moved to or from */
+    int spilled;
+    size_t split;       /* index of the first insn that uses the spill slot */
+};
+
+typedef struct Lsra Lsra;
+struct Lsra {
+    Isel *isel;
+    Interval **iv;      /* reg id => interval */
+    Interval **sorted;  /* intervals, sorted by start */
+    size_t nsorted;
+    Range *fixed[Northogonal]; /* ranges where physical regs are busy */
+    size_t nfixed[Northogonal];
+    size_t *bbstart;    /* index of the first insn in each bb */
+    size_t *bbend;      /* index one past the last insn in each bb */
+    Interval *active[Northogonal];
+};
+
+/* scratch registers used to reload spilled values */
+static int scratch[] = {11, 12, 13, 29, 30, 31};
+#define Nscratch (sizeof(scratch)/sizeof(scratch[0]))
+
+static int isscratch(int c)
+{
+    size_t i;
+
+    for (i = 0; i < Nscratch; i++)
+        if (scratch[i] == c)
+            return 1;
+    return 0;
+}
+
+static int colourclass(int c)
+{
+    if (c < 16)
+        return Classint;
+    return Classflt;
+}
+
+static Interval *interval(Lsra *l, regid r)
+{
+    Interval *iv;
+
+    if (l->iv[r])
+        return l->iv[r];
+    iv = zalloc(sizeof(Interval));
+    iv->reg = r;
+    iv->colour = -1;
+    iv->hint = -1;
+    iv->partner = Rnone;
+    l->iv[r] = iv;
+    return iv;
+}
+
+/* ranges are added from the end of the function backwards, so a new
+ * range either sits before the last one added, or overlaps it. */
+static void addrange(Interval *iv, size_t from, size_t to)
+{
+    Range *r;
+
+    if (iv->nr) {
+        r = &iv->r[iv->nr - 1];
+        if (to >= r->from) {
+            r->from = min(r->from, from);
+            r->to = max(r->to, to);
+            return;
+        }
+    }
+    iv->r = xrealloc(iv->r, (iv->nr + 1)*sizeof(Range));
+    iv->r[iv->nr].from = from;
+    iv->r[iv->nr].to = to;
+    iv->nr++;
+}
+
+/* a def starts the range that the later uses opened */
+static void setfrom(Interval *iv, size_t pos)
+{
+    if (iv->nr && iv->r[iv->nr - 1].from <= pos)
+        iv->r[iv->nr - 1].from = pos;
+    else
+        addrange(iv, pos, pos + 1);
+}
+
+static void hint(Lsra *l, Insn *insn)
+{
+    Loc *a, *b;
+
+    if (insn->op != Imov && insn->op != Imovs)
+        return;
+    a = insn->args[0];
+    b = insn->args[1];
+    if (a->type != Locreg || b->type != Locreg)
+        return;
+    if (a->reg.id < Nreg && b->reg.id >= Nreg)
+        interval(l, b->reg.id)->hint = colourmap[a->reg.colour];
+    else if (b->reg.id < Nreg && a->reg.id >= Nreg)
+        interval(l, a->reg.id)->hint = colourmap[b->reg.colour];
+    else if (a->reg.id >= Nreg && b->reg.id >= Nreg) {
+        interval(l, a->reg.id)->partner = b->reg.id;
+        interval(l, b->reg.id)->partner = a->reg.id;
+    }
+}
+
+static void buildintervals(Lsra *l)
+{
+    regid u[Maxuse], d[Maxdef];
+    size_t nu, nd, n, i, k, pos;
+    ssize_t j;
+    Asmbb *bb;
+    Isel *s;
+
+    s = l->isel;
+    l->bbstart = zalloc(s->nbb * sizeof(size_t));
+    l->bbend = zalloc(s->nbb * sizeof(size_t));
+    n = 0;
+    for (i = 0; i < s->nbb; i++) {
+        l->bbstart[i] = n;
+        n += s->bb[i]->ni;
+        l->bbend[i] = n;
+    }
+
+    for (j = s->nbb - 1; j >= 0; j--) {
+        bb = s->bb[j];
+        for (k = 0; bsiter(bb->liveout, &k); k++)
+            addrange(interval(l, k), 2*l->bbstart[j], 2*l->bbend[j]);
+        for (i = bb->ni; i-- > 0;) {
+            pos = 2*(l->bbstart[j] + i);
+            hint(l, bb->il[i]);
+            nd = defs(bb->il[i], d);
+            for (k = 0; k < nd; k++)
+                setfrom(interval(l, d[k]), pos + 1);
+            nu = uses(bb->il[i], u);
+            for (k = 0; k < nu; k++)
+                addrange(interval(l, u[k]), 2*l->bbstart[j], pos + 1);
+        }
+    }
+}
+
+static int rangecmp(const void *a, const void *b)
+{
+    const Range *ra, *rb;
+
+    ra = a;
+    rb = b;
+    if (ra->from != rb->from)
+        return ra->from < rb->from ? -1 : 1;
+    return 0;
+}
+
+static int startcmp(const void *a, const void *b)
+{
+    Interval *ia, *ib;
+
+    ia = *(Interval**)a;
+    ib = *(Interval**)b;
+    if (ia->start != ib->start)
+        return ia->start < ib->start ? -1 : 1;
+    if (ia->reg != ib->reg)
+        return ia->reg < ib->reg ? -1 : 1;
+    return 0;
+}
+
+/* %rsp, %rbp and %rip never get allocated, and have no colour */
+static int hascolour(Reg r)
+{
+    return colourmap[r] || r == Ral || r == Rax || r == Reax || r == Rrax;
+}
+
+/* Physical registers that alias each other share a colour, so
+ * their ranges get merged into one sorted, disjoint list. */
+static void gatherfixed(Lsra *l)
+{
+    Interval *iv;
+    Range *r;
+    size_t i, j, c, n;
+
+    for (i = 1; i < Nreg; i++) {
+        iv = l->iv[i];
+        if (!iv || !hascolour(i))
+            continue;
+        c = colourmap[i];
+        l->fixed[c] = xrealloc(l->fixed[c], (l->nfixed[c] + iv->nr)*sizeof(Range));
+        for (j = 0; j < iv->nr; j++)
+            l->fixed[c][l->nfixed[c]++] = iv->r[j];
+    }
+    for (c = 0; c < Northogonal; c++) {
+        if (!l->nfixed[c])
+            continue;
+        r = l->fixed[c];
+        qsort(r, l->nfixed[c], sizeof(Range), rangecmp);
+        n = 0;
+        for (i = 1; i < l->nfixed[c]; i++) {
+            if (r[i].from <= r[n].to)
+                r[n].to = max(r[n].to, r[i].to);
+            else
+                r[++n] = r[i];
+        }
+        l->nfixed[c] = n + 1;
+    }
+}
+
+/* is colour 'c' used by a physical register anywhere in [from, to)? */
+static int fixedbusy(Lsra *l, int c, size_t from, size_t to)
+{
+    size_t lo, hi, mid;
+    Range *r;
+
+    r = l->fixed[c];
+    lo = 0;
+    hi = l->nfixed[c];
+    /* find the first range ending after 'from' */
+    while (lo < hi) {
+        mid = (lo + hi)/2;
+        if (r[mid].to <= from)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < l->nfixed[c] && r[lo].from < to;
+}
+
+static int fixedclash(Lsra *l, Interval *iv, int c)
+{
+    size_t i;
+
+    for (i = 0; i < iv->nr; i++)
+        if (fixedbusy(l, c, iv->r[i].from, iv->r[i].to))
+            return 1;
+    return 0;
+}
+
+static int usable(Lsra *l, Interval *iv, int c)
+{
+    if (!regmap[c][locmap[iv->reg]->mode] || isscratch(c))
+        return 0;
+    return !l->active[c] && !fixedclash(l, iv, c);
+}
+
+static void expire(Lsra *l, size_t pos)
+{
+    size_t c;
+
+    for (c = 0; c < Northogonal; c++)
+        if (l->active[c] && l->active[c]->end <= pos)
+            l->active[c] = NULL;
+}
+
+/*
+ * Decides where a spilled interval moves into memory. The part
+ * before the split keeps its register, which is only safe if no
+ * edge jumps back from past the split into a block where the
+ * value is live. Otherwise, the whole interval gets spilled.
+ */
+static void spillat(Lsra *l, Interval *iv, size_t pos)
+{
+    size_t i, p, split;
+    Asmbb *bb;
+    Isel *s;
+
+    s = l->isel;
+    split = pos/2;
+    for (i = 0; i < s->nbb && split > 0; i++) {
+        bb = s->bb[i];
+        if (l->bbstart[i] >= split || !bshas(bb->livein, iv->reg))
+            continue;
+        for (p = 0; bsiter(bb->pred, &p); p++)
+            if (l->bbend[p] > split)
+                split = 0;
+    }
+    iv->spilled = 1;
+    iv->split = split;
+    if (debugopt['r']) {
+        printf("split ");
+        locprint(stdout, locmap[iv->reg], 'x');
+        printf(" at insn %zd\n", split);
+    }
+}
+
+static void allocate(Lsra *l, Interval *cur)
+{
+    Interval *iv, *victim;
+    int c, cls;
+
+    cls = rclass(locmap[cur->reg]);
+    /* try the hinted colour first, then anything free */
+    c = cur->hint;
+    if (c < 0 && cur->partner != Rnone && l->iv[cur->partner])
+        c = l->iv[cur->partner]->colour;
+    if (c < 0 || colourclass(c) != cls || !usable(l, cur, c))
+        for (c = 0; c < Northogonal; c++)
+            if (colourclass(c) == cls && usable(l, cur, c))
+                break;
+    if (c < Northogonal) {
+        cur->colour = c;
+        l->active[c] = cur;
+        return;
+    }
+
+    /* nothing free: take the register of whoever lives the longest */
+    victim = cur;
+    for (c = 0; c < Northogonal; c++) {
+        iv = l->active[c];
+        if (!iv || colourclass(c) != cls)
+            continue;
+        if (!regmap[c][locmap[cur->reg]->mode] || fixedclash(l, cur, c))
+            continue;
+        if (iv->end > victim->end)
+            victim = iv;
+    }
+    if (victim == cur) {
+        spillat(l, cur, cur->start);
+        return;
+    }
+    c = victim->colour;
+    spillat(l, victim, cur->start);
+    cur->colour = c;
+    l->active[c] = cur;
+}
+
+static void scan(Lsra *l)
+{
+    Interval *iv;
+    size_t i;
+
+    for (i = Nreg; i < maxregid; i++) {
+        iv = l->iv[i];
+        if (!iv || !iv->nr)
+            continue;
+        iv->start = iv->r[iv->nr - 1].from;
+        iv->end = iv->r[0].to;
+        lappend(&l->sorted, &l->nsorted, iv);
+    }
+    qsort(l->sorted, l->nsorted, sizeof(Interval*), startcmp);
+    for (i = 0; i < l->nsorted; i++) {
+        iv = l->sorted[i];
+        expire(l, iv->start);
+        allocate(l, iv);
+    }
+}
+
+static Loc *scratchreg(Lsra *l, Mode m, size_t idx, int *taken)
+{
+    size_t i;
+    int c;
+
+    for (i = 0; i < Nscratch; i++) {
+        c = scratch[i];
+        if (taken[c] || !regmap[c][m])
+            continue;
+        if (fixedbusy(l, c, 2*idx, 2*idx + 2))
+            continue;
+        taken[c] = 1;
+        return locphysreg(regmap[c][m]);
+    }
+    die("linear scan: out of scratch registers");
+    return NULL;
+}
+
+static Insn *spillmov(Loc *a, Loc *b)
+{
+    if (b->mode == ModeF || b->mode == ModeD)
+        return mkinsn(Imovs, a, b, NULL);
+    return mkinsn(Imov, a, b, NULL);
+}
+
+/* is 'r' a virtual register that lives in its spill slot at insn 'idx'? */
+static int inslot(Lsra *l, Loc *r, size_t idx)
+{
+    Interval *iv;
+
+    if (r->type != Locreg || r->reg.id < Nreg)
+        return 0;
+    iv = l->iv[r->reg.id];
+    return iv && iv->spilled && idx >= iv->split;
+}
+
+/* can 'src' be moved straight into a stack slot? Memory
+ * can't be, and neither can an immediate wider than 32 bits */
+static int slotsrc(Lsra *l, Loc *src, size_t idx)
+{
+    if (src->type == Locreg)
+        return !inslot(l, src, idx);
+    if (src->type == Loclit)
+        return src->lit >= INT32_MIN && src->lit <= INT32_MAX;
+    return 0;
+}
+
+static void rewritebb(Lsra *l, size_t bbidx)
+{
+    Remapping use[Maxuse], def[Maxdef];
+    regid u[Maxuse], d[Maxdef];
+    size_t nu, nd, nuse, ndef;
+    size_t i, j, k, idx;
+    int taken[Northogonal];
+    Insn **new, *insn;
+    size_t nnew;
+    Asmbb *bb;
+    Isel *s;
+
+    s = l->isel;
+    bb = s->bb[bbidx];
+    new = NULL;
+    nnew = 0;
+    for (i = 0; i < bb->ni; i++) {
+        idx = l->bbstart[bbidx] + i;
+        insn = bb->il[i];
+        /* moves to or from a spilled reg can go straight to memory,
+         * without needing a scratch register */
+        if ((insn->op == Imov || insn->op == Imovs) && insn->args[1]->type == Locreg) {
+            if (inslot(l, insn->args[1], idx) && slotsrc(l, insn->args[0], idx)) {
+                insn->args[1] = spillslot(s, insn->args[1]->reg.id);
+                lappend(&new, &nnew, insn);
+                continue;
+            } else if (inslot(l, insn->args[0], idx) && !inslot(l, insn->args[1], idx)) {
+                insn->args[0] = spillslot(s, insn->args[0]->reg.id);
+            }
+        }
+
+        nu = uses(insn, u);
+        nd = defs(insn, d);
+        nuse = 0;
+        ndef = 0;
+        bzero(taken, sizeof taken);
+        for (j = 0; j < nu; j++) {
+            if (!inslot(l, locmap[u[j]], idx))
+                continue;
+            for (k = 0; k < nuse; k++)
+                if (use[k].oldreg == u[j])
+                    break;
+            if (k != nuse)
+                continue;
+            use[nuse].oldreg = u[j];
+            use[nuse].newreg = scratchreg(l, locmap[u[j]]->mode, idx, taken);
+            lappend(&new, &nnew, spillmov(spillslot(s, u[j]), use[nuse].newreg));
+            nuse++;
+        }
+        for (j = 0; j < nd; j++) {
+            if (d[j] < Nreg || !l->iv[d[j]]->spilled)
+                continue;
+            def[ndef].oldreg = d[j];
+            def[ndef].newreg = NULL;
+            /* before the split, the value is in its register, but
+             * the slot still needs to be kept up to date */
+            if (!inslot(l, locmap[d[j]], idx))
+                def[ndef].newreg = locmap[d[j]];
+            for (k = 0; k < nuse; k++)
+                if (use[k].oldreg == d[j])
+                    def[ndef].newreg = use[k].newreg;
+            if (!def[ndef].newreg)
+                def[ndef].newreg = scratchreg(l, locmap[d[j]]->mode, idx, taken);
+            ndef++;
+        }
+        updatelocs(s, insn, use, nuse, def, ndef);
+        lappend(&new, &nnew, insn);
+        for (j = 0; j < ndef; j++)
+            lappend(&new, &nnew, spillmov(def[j].newreg, spillslot(s, def[j].oldreg)));
+    }
+    lfree(&bb->il, &bb->ni);
+    bb->il = new;
+    bb->ni = nnew;
+}
+
+static void paintlocs(Lsra *l)
+{
+    Interval *iv;
+    size_t i;
+    Loc *r;
+
+    for (i = 0; i < l->nsorted; i++) {
+        iv = l->sorted[i];
+        r = locmap[iv->reg];
+        if (iv->colour >= 0)
+            r->reg.colour = regmap[iv->colour][r->mode];
+        if (iv->spilled)
+            addspill(l->isel, r);
+        if (debugopt['r']) {
+            locprint(stdout, r, 'x');
+            printf(" [%zd, %zd) => %s%s\n", iv->start, iv->end,
+                   iv->colour >= 0 ? regnames[r->reg.colour] : "",
+                   iv->spilled ? " (spilled)" : "");
+        }
+    }
+}
+
+void lsregalloc(Isel *s)
+{
+    Lsra l = {0,};
+    size_t i;
+
+    l.isel = s;
+    l.iv = zalloc(maxregid * sizeof(Interval*));
+    liveness(s);
+    buildintervals(&l);
+    gatherfixed(&l);
+    scan(&l);
+
+    s->spillslots = mkht(ptrhash, ptreq);
+    paintlocs(&l);
+    for (i = 0; i < s->nbb; i++)
+        rewritebb(&l, i);
+    htfree(s->spillslots);
+    delnops(s);
+
+    for (i = 0; i < maxregid; i++) {
+        if (!l.iv[i])
+            continue;
+        free(l.iv[i]->r);
+        free(l.iv[i]);
+    }
+    for (i = 0; i < Northogonal; i++)
+        free(l.fixed[i]);
+    free(l.iv);
+    free(l.sorted);
+    free(l.bbstart);
+    free(l.bbend);
+}
@@ -12,6 +12,7 @@
 #include "parse.h"
 #include "opt.h"
 #include "asm.h"
+#include "platform.h"
 
 #include "../config.h"
 
@@ -20,24 +21,29 @@ Node *file;
 char debugopt[128];
 int writeasm;
 char *outfile;
+char *ralgo;
+int optlevel;
 char **incpaths;
 size_t nincpaths;
 
 static void usage(char *prog)
 {
-    printf("%s [-h] [-o outfile] [-d[dbgopts]] inputs\n", prog);
+    printf("%s [-h] [-O level] [-o outfile] [-d[dbgopts]] inputs\n", prog);
     printf("\t-h\tPrint this help\n");
     printf("\t-S\tWrite out `input.s` when compiling\n");
     printf("\t-I path\tAdd 'path' to use search path\n");
-    printf("\t-d\tPrint debug dumps. Recognized options: f r p i\n");
+    printf("\t-R alg\tUse register allocator 'alg': colour or linear\n");
+    printf("\t-O lvl\tOptimize at level 'lvl': 0 for none, 1 for ssa based passes\n");
+    printf("\t-d\tPrint debug dumps. Recognized options: f l T r i u d p\n");
     printf("\t\t\tf: log folded trees\n");
     printf("\t\t\tl: log lowered pre-cfg trees\n");
     printf("\t\t\tT: log tree immediately\n");
     printf("\t\t\tr: log register allocation activity\n");
     printf("\t\t\ti: log instruction selection activity\n");
     printf("\t\t\tu: log type unifications\n");
+    printf("\t\t\td: log dataflow over the flow graph\n");
+    printf("\t\t\tp: count peephole rewrites, by rule\n");
     printf("\t-o\tOutput to outfile\n");
-    printf("\t-S\tGenerate assembly instead of object code\n");
 }
 
 static void assem(char *asmsrc, char *input)
@@ -68,14 +74,51 @@ static char *gentemp(char *buf, size_t bufsz, char *path, char *suffix)
     return buf;
 }
 
+static void compile(char *path)
+{
+    Stab *globls;
+    char buf[1024];
+    char obj[1024];
+
+    globls = mkstab();
+    tyinit(globls);
+    tokinit(path);
+    file = mkfile(path);
+    file->file.exports = mkstab();
+    file->file.globls = globls;
+    yyparse();
+
+    /* before we do anything to the parse */
+    if (debugopt['T'])
+        dump(file, stdout);
+    infer(file);
+    /* after all type inference */
+    if (debugopt['t'])
+        dump(file, stdout);
+
+    if (Elfobj) {
+        swapsuffix(obj, sizeof obj, path, ".myr", ".o");
+        if (writeasm)
+            swapsuffix(buf, sizeof buf, path, ".myr", ".s");
+        gen(file, obj, writeasm ? buf : NULL);
+    } else {
+        if (writeasm)
+            swapsuffix(buf, sizeof buf, path, ".myr", ".s");
+        else
+            gentemp(buf, sizeof buf, path, ".s");
+        gen(file, NULL, buf);
+        assem(buf, path);
+    }
+    if (debugopt['p'])
+        peepstats(stdout);
+}
+
 int main(int argc, char **argv)
 {
     int opt;
     int i;
-    Stab *globls;
-    char buf[1024];
 
-    while ((opt = getopt(argc, argv, "d:hSo:I:")) != -1) {
+    while ((opt = getopt(argc, argv, "d:hSo:I:R:O:")) != -1) {
         switch (opt) {
             case 'o':
                 outfile = optarg;
@@ -97,6 +140,14 @@ int main(int argc, char **argv)
             case 'I':
                 lappend(&incpaths, &nincpaths, optarg);
                 break;
+            case 'R':
+                if (strcmp(optarg, "colour") && strcmp(optarg, "linear"))
+                    die("unknown register allocator '%s'", optarg);
+                ralgo = optarg;
+                break;
+            case 'O':
+                optlevel = atoi(optarg);
+                break;
             default:
                 usage(argv[0]);
                 exit(0);
@@ -105,31 +156,7 @@ int main(int argc, char **argv)
     }
 
     lappend(&incpaths, &nincpaths, Instroot "/lib/myr");
-    for (i = optind; i < argc; i++) {
-        globls = mkstab();
-        tyinit(globls);
-        tokinit(argv[i]);
-        file = mkfile(argv[i]);
-        file->file.exports = mkstab();
-        file->file.globls = globls;
-        yyparse();
-
-        /* before we do anything to the parse */
-        if (debugopt['T'])
-            dump(file, stdout);
-        infer(file);
-        /* after all type inference */
-        if (debugopt['t'])
-            dump(file, stdout);
-
-        if (writeasm) {
-            swapsuffix(buf, sizeof buf, argv[i], ".myr", ".s");
-        } else {
-            gentemp(buf, sizeof buf, argv[i], ".s");
-        }
-        gen(file, buf);
-        assem(buf, argv[i]);
-    }
-
+    for (i = optind; i < argc; i++)
+        compile(argv[i]);
     return 0;
 }
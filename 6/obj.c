@@ -0,0 +1,416 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include <string.h>
+#include <assert.h>
+
+#include "parse.h"
+#include "opt.h"
+#include "asm.h"
+#include "platform.h"
+
+/*
+ * Object file output. Everything that ends up in the
+ * output goes through here, so that we can write either
+ * textual assembly, a relocatable ELF object, or both
+ * at once from the same walk over the program.
+ */
+
+/* section indices in the ELF output */
+enum {
+    Shnull,
+    Shtext,
+    Shdata,
+    Shrodata,
+    Shrelatext,
+    Shreladata,
+    Shrelarodata,
+    Shsymtab,
+    Shstrtab,
+    Shshstrtab,
+    Shnote,
+    Nsh
+};
+
+static char *secnames[Nsec] = {
+    [Sectext] = ".text",
+    [Secdata] = ".data",
+    [Secrodata] = Rodatasec,
+};
+
+Obj *mkobj(FILE *asmfd, int bin)
+{
+    Obj *o;
+
+    o = zalloc(sizeof(Obj));
+    o->asmfd = asmfd;
+    o->bin = bin;
+    o->cur = Sectext;
+    o->syms = mkht(strhash, streq);
+    return o;
+}
+
+void secput(Objsec *s, void *p, size_t sz)
+{
+    if (s->len + sz > s->cap) {
+        s->cap = 2*s->cap + sz;
+        s->buf = xrealloc(s->buf, s->cap);
+    }
+    memcpy(s->buf + s->len, p, sz);
+    s->len += sz;
+}
+
+Sym *getsym(Obj *o, char *name)
+{
+    Sym *s;
+
+    s = htget(o->syms, name);
+    if (s)
+        return s;
+    s = zalloc(sizeof(Sym));
+    s->name = strdup(name);
+    htput(o->syms, s->name, s);
+    lappend(&o->sym, &o->nsym, s);
+    return s;
+}
+
+void objsec(Obj *o, Sec s)
+{
+    o->cur = s;
+    if (o->asmfd)
+        fprintf(o->asmfd, "%s\n", secnames[s]);
+}
+
+void objlbl(Obj *o, char *lbl, int global)
+{
+    Sym *s;
+
+    if (o->asmfd) {
+        if (global)
+            fprintf(o->asmfd, ".globl %s\n", lbl);
+        fprintf(o->asmfd, "%s:\n", lbl);
+    }
+    if (!o->bin)
+        return;
+    s = getsym(o, lbl);
+    if (s->defined)
+        die("Symbol %s defined twice", lbl);
+    s->global = global;
+    /* text labels get their offsets when the text is assembled */
+    if (o->cur == Sectext) {
+        lappend(&o->text, &o->ntext, mkinsn(Ilbl, locstrlbl(lbl), NULL));
+    } else {
+        s->defined = 1;
+        s->sec = o->cur;
+        s->off = o->sec[o->cur].len;
+    }
+}
+
+void objinsn(Obj *o, Insn *insn)
+{
+    if (!finalinsn(insn))
+        return;
+    if (o->asmfd)
+        iprintf(o->asmfd, insn);
+    if (o->bin) {
+        assert(o->cur == Sectext);
+        lappend(&o->text, &o->ntext, insn);
+    }
+}
+
+void objbytes(Obj *o, char *p, size_t sz)
+{
+    size_t i;
+    FILE *fd;
+
+    fd = o->asmfd;
+    for (i = 0; fd && i < sz; i++) {
+        if (i % 60 == 0)
+            fprintf(fd, "\t.ascii \"");
+        if (p[i] == '"' || p[i] == '\\')
+            fprintf(fd, "\\");
+        if (isprint(p[i]))
+            fprintf(fd, "%c", p[i]);
+        else
+            fprintf(fd, "\\%03o", (uint8_t)p[i] & 0xff);
+        /* line wrapping for readability */
+        if (i % 60 == 59 || i == sz - 1)
+            fprintf(fd, "\"\n");
+    }
+    if (o->bin)
+        secput(&o->sec[o->cur], p, sz);
+}
+
+void objint(Obj *o, uint64_t v, size_t sz)
+{
+    uint8_t b[8];
+    size_t i;
+    char *intsz[] = {
+        [1] = ".byte",
+        [2] = ".short",
+        [4] = ".long",
+        [8] = ".quad"
+    };
+
+    assert(sz == 1 || sz == 2 || sz == 4 || sz == 8);
+    if (o->asmfd)
+        fprintf(o->asmfd, "\t%s %"PRId64"\n", intsz[sz], (int64_t)v);
+    if (o->bin) {
+        for (i = 0; i < sz; i++)
+            b[i] = v >> (8*i);
+        secput(&o->sec[o->cur], b, sz);
+    }
+}
+
+/* a pointer sized reference to 'lbl + off' */
+void objaddr(Obj *o, char *lbl, long off)
+{
+    Objsec *s;
+    Reloc *r;
+    uint64_t z;
+
+    if (o->asmfd) {
+        if (off)
+            fprintf(o->asmfd, "\t.quad %s + %ld\n", lbl, off);
+        else
+            fprintf(o->asmfd, "\t.quad %s\n", lbl);
+    }
+    if (o->bin) {
+        s = &o->sec[o->cur];
+        r = zalloc(sizeof(Reloc));
+        r->off = s->len;
+        r->sym = strdup(lbl);
+        r->addend = off;
+        r->type = Rel64;
+        lappend(&s->rel, &s->nrel, r);
+        z = 0;
+        secput(s, &z, 8);
+        getsym(o, lbl);
+    }
+}
+
+void objpad(Obj *o, size_t sz)
+{
+    char *z;
+
+    assert((ssize_t)sz >= 0);
+    if (!sz)
+        return;
+    if (o->asmfd)
+        fprintf(o->asmfd, "\t.fill %zd,1,0\n", sz);
+    if (o->bin) {
+        z = zalloc(sz);
+        secput(&o->sec[o->cur], z, sz);
+        free(z);
+    }
+}
+
+/* little endian output helpers */
+static void put8(Objsec *s, uint8_t v)
+{
+    secput(s, &v, 1);
+}
+
+static void putle(Objsec *s, uint64_t v, size_t sz)
+{
+    uint8_t b[8];
+    size_t i;
+
+    for (i = 0; i < sz; i++)
+        b[i] = v >> (8*i);
+    secput(s, b, sz);
+}
+
+static void secalign(Objsec *s, size_t a)
+{
+    while (s->len % a)
+        put8(s, 0);
+}
+
+static size_t putstr(Objsec *s, char *str)
+{
+    size_t off;
+
+    off = s->len;
+    secput(s, str, strlen(str) + 1);
+    return off;
+}
+
+/* local labels are only there for the assembler */
+static int isasmlocal(Sym *s)
+{
+    return !s->global && !strncmp(s->name, ".L", 2);
+}
+
+static void putsym(Objsec *tab, size_t name, int bind, int type, int shndx, uint64_t val)
+{
+    putle(tab, name, 4);
+    put8(tab, (bind << 4) | type);
+    put8(tab, 0);
+    putle(tab, shndx, 2);
+    putle(tab, val, 8);
+    putle(tab, 0, 8);
+}
+
+static void putrelocs(Obj *o, Objsec *out, Objsec *sec)
+{
+    size_t i, idx;
+    long addend;
+    Reloc *r;
+    Sym *s;
+
+    for (i = 0; i < sec->nrel; i++) {
+        r = sec->rel[i];
+        s = getsym(o, r->sym);
+        addend = r->addend;
+        /* refer to locally defined symbols through their section */
+        if (s->defined && !s->global) {
+            idx = 1 + s->sec;
+            addend += s->off;
+        } else {
+            idx = s->idx;
+        }
+        putle(out, r->off, 8);
+        putle(out, (uint64_t)idx << 32 | r->type, 8);
+        putle(out, addend, 8);
+    }
+}
+
+static void putshdr(Objsec *hdr, size_t name, int type, uint64_t flags,
+                    size_t off, size_t sz, int link, int info, size_t algn, size_t entsz)
+{
+    putle(hdr, name, 4);
+    putle(hdr, type, 4);
+    putle(hdr, flags, 8);
+    putle(hdr, 0, 8);
+    putle(hdr, off, 8);
+    putle(hdr, sz, 8);
+    putle(hdr, link, 4);
+    putle(hdr, info, 4);
+    putle(hdr, algn, 8);
+    putle(hdr, entsz, 8);
+}
+
+/*
+ * Assembles the text, and writes out a relocatable
+ * ELF64 object: the text, data and rodata sections,
+ * their relocations, and the symbol and string tables.
+ */
+void objwrite(Obj *o, FILE *fd)
+{
+    Objsec f, rela[Nsec], symtab, strtab, shstr, hdr;
+    size_t off[Nsh], sz[Nsh], name[Nsh];
+    size_t i, nlocal, shoff;
+    Sym *s;
+
+    assemble(o);
+    resolvetext(o);
+    memset(&f, 0, sizeof f);
+    memset(rela, 0, sizeof rela);
+    memset(&symtab, 0, sizeof symtab);
+    memset(&strtab, 0, sizeof strtab);
+    memset(&shstr, 0, sizeof shstr);
+    memset(&hdr, 0, sizeof hdr);
+
+    /* symbols: null, section symbols, locals, then globals */
+    put8(&strtab, 0);
+    putsym(&symtab, 0, 0, 0, 0, 0);
+    putsym(&symtab, 0, 0, 3, Shtext, 0);
+    putsym(&symtab, 0, 0, 3, Shdata, 0);
+    putsym(&symtab, 0, 0, 3, Shrodata, 0);
+    nlocal = 4;
+    for (i = 0; i < o->nsym; i++) {
+        s = o->sym[i];
+        if (!s->defined || s->global || isasmlocal(s))
+            continue;
+        s->idx = nlocal++;
+        putsym(&symtab, putstr(&strtab, s->name), 0, 0, Shtext + s->sec, s->off);
+    }
+    for (i = 0; i < o->nsym; i++) {
+        s = o->sym[i];
+        if (s->defined && !s->global)
+            continue;
+        s->idx = symtab.len / 24;
+        if (s->defined)
+            putsym(&symtab, putstr(&strtab, s->name), 1, 0, Shtext + s->sec, s->off);
+        else
+            putsym(&symtab, putstr(&strtab, s->name), 1, 0, 0, 0);
+    }
+    for (i = 0; i < Nsec; i++)
+        putrelocs(o, &rela[i], &o->sec[i]);
+
+    put8(&shstr, 0);
+    name[Shnull] = 0;
+    name[Shtext] = putstr(&shstr, ".text");
+    name[Shdata] = putstr(&shstr, ".data");
+    name[Shrodata] = putstr(&shstr, ".rodata");
+    name[Shrelatext] = putstr(&shstr, ".rela.text");
+    name[Shreladata] = putstr(&shstr, ".rela.data");
+    name[Shrelarodata] = putstr(&shstr, ".rela.rodata");
+    name[Shsymtab] = putstr(&shstr, ".symtab");
+    name[Shstrtab] = putstr(&shstr, ".strtab");
+    name[Shshstrtab] = putstr(&shstr, ".shstrtab");
+    name[Shnote] = putstr(&shstr, ".note.GNU-stack");
+
+    /* lay out the file: header, section contents, section headers */
+    secput(&f, (char[64]){0}, 64);
+#define Place(sh, s, a) \
+    do { secalign(&f, a); off[sh] = f.len; sz[sh] = (s)->len; secput(&f, (s)->buf, (s)->len); } while (0)
+    Place(Shtext, &o->sec[Sectext], 16);
+    Place(Shdata, &o->sec[Secdata], 8);
+    Place(Shrodata, &o->sec[Secrodata], 8);
+    Place(Shrelatext, &rela[Sectext], 8);
+    Place(Shreladata, &rela[Secdata], 8);
+    Place(Shrelarodata, &rela[Secrodata], 8);
+    Place(Shsymtab, &symtab, 8);
+    Place(Shstrtab, &strtab, 1);
+    Place(Shshstrtab, &shstr, 1);
+#undef Place
+    off[Shnote] = f.len;
+    sz[Shnote] = 0;
+    secalign(&f, 8);
+    shoff = f.len;
+
+    putshdr(&hdr, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    putshdr(&hdr, name[Shtext], 1, 0x6, off[Shtext], sz[Shtext], 0, 0, 16, 0);
+    putshdr(&hdr, name[Shdata], 1, 0x3, off[Shdata], sz[Shdata], 0, 0, 8, 0);
+    putshdr(&hdr, name[Shrodata], 1, 0x2, off[Shrodata], sz[Shrodata], 0, 0, 8, 0);
+    putshdr(&hdr, name[Shrelatext], 4, 0x40, off[Shrelatext], sz[Shrelatext], Shsymtab, Shtext, 8, 24);
+    putshdr(&hdr, name[Shreladata], 4, 0x40, off[Shreladata], sz[Shreladata], Shsymtab, Shdata, 8, 24);
+    putshdr(&hdr, name[Shrelarodata], 4, 0x40, off[Shrelarodata], sz[Shrelarodata], Shsymtab, Shrodata, 8, 24);
+    putshdr(&hdr, name[Shsymtab], 2, 0, off[Shsymtab], sz[Shsymtab], Shstrtab, nlocal, 8, 24);
+    putshdr(&hdr, name[Shstrtab], 3, 0, off[Shstrtab], sz[Shstrtab], 0, 0, 1, 0);
+    putshdr(&hdr, name[Shshstrtab], 3, 0, off[Shshstrtab], sz[Shshstrtab], 0, 0, 1, 0);
+    putshdr(&hdr, name[Shnote], 1, 0, off[Shnote], sz[Shnote], 0, 0, 1, 0);
+    secput(&f, hdr.buf, hdr.len);
+
+    /* and finally the ELF header */
+    memcpy(f.buf, "\177ELF\2\1\1", 7);
+    f.len = 16;
+    putle(&f, 1, 2);    /* ET_REL */
+    putle(&f, 62, 2);   /* EM_X86_64 */
+    putle(&f, 1, 4);    /* EV_CURRENT */
+    putle(&f, 0, 8);    /* entry */
+    putle(&f, 0, 8);    /* phoff */
+    putle(&f, shoff, 8);
+    putle(&f, 0, 4);    /* flags */
+    putle(&f, 64, 2);   /* ehsize */
+    putle(&f, 0, 2);    /* phentsize */
+    putle(&f, 0, 2);    /* phnum */
+    putle(&f, 64, 2);   /* shentsize */
+    putle(&f, Nsh, 2);
+    putle(&f, Shshstrtab, 2);
+    f.len = shoff + hdr.len;
+
+    if (fwrite(f.buf, 1, f.len, fd) != f.len)
+        die("Couldn't write object file");
+    free(f.buf);
+    free(symtab.buf);
+    free(strtab.buf);
+    free(shstr.buf);
+    free(hdr.buf);
+    for (i = 0; i < Nsec; i++)
+        free(rela[i].buf);
+}
@@ -0,0 +1,549 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+#include "parse.h"
+#include "opt.h"
+#include "asm.h"
+
+/*
+ * A peephole optimizer. Each rule looks at the instruction
+ * at some position in a block, and the few around it, and
+ * rewrites them in place if it can, deleting instructions
+ * by nulling them out. The rules are run over every block
+ * until none fire. It runs once before register allocation,
+ * on virtual registers, and once after, on the finished
+ * function, with the rules that are only safe or only
+ * useful at that point.
+ */
+
+typedef struct Peep Peep;
+struct Peep {
+    Isel *isel;
+    int allocated;      /* registers are coloured */
+    size_t bb;          /* the block being rewritten */
+    Insn **il;
+    size_t ni;
+    size_t *nuse;       /* before allocation: reads of each register */
+    size_t nreg;
+    Htab *lblidx;       /* label -> index of the block it starts, + 1 */
+};
+
+typedef struct Rule Rule;
+struct Rule {
+    char *name;
+    int (*apply)(Peep *p, size_t i);
+    int before;         /* run before allocation */
+    int after;          /* run after allocation */
+    size_t nfired;
+};
+
+/* the jump taken when a setcc would have set its byte */
+static AsmOp jmpof[] = {
+    [Isetz] = Ijz,      [Isetnz] = Ijnz,
+    [Isetl] = Ijl,      [Isetle] = Ijle,
+    [Isetg] = Ijg,      [Isetge] = Ijge,
+    [Isetb] = Ijb,      [Isetbe] = Ijbe,
+    [Iseta] = Ija,      [Isetae] = Ijae,
+};
+
+/* the jump taken when the flags say the opposite */
+static AsmOp invjmp[] = {
+    [Ijz] = Ijnz,       [Ijnz] = Ijz,
+    [Ijl] = Ijge,       [Ijge] = Ijl,
+    [Ijle] = Ijg,       [Ijg] = Ijle,
+    [Ijb] = Ijae,       [Ijae] = Ijb,
+    [Ijbe] = Ija,       [Ija] = Ijbe,
+};
+
+static int isreg(Loc *l)
+{
+    return l->type == Locreg;
+}
+
+static int iscondjmp(Insn *insn)
+{
+    return insn->op < sizeof invjmp/sizeof invjmp[0] && invjmp[insn->op];
+}
+
+/* the same register, in the same mode */
+static int samereg(Peep *p, Loc *a, Loc *b)
+{
+    if (!isreg(a) || !isreg(b) || a->mode != b->mode)
+        return 0;
+    if (p->allocated || (a->reg.id < Nreg && b->reg.id < Nreg))
+        return a->reg.colour == b->reg.colour;
+    return a->reg.id == b->reg.id;
+}
+
+/* do a and b share any bits? */
+static int overlaps(Peep *p, Loc *a, Loc *b)
+{
+    if (!a || !b || !isreg(a) || !isreg(b))
+        return 0;
+    if (a->reg.colour == Rnone || b->reg.colour == Rnone)
+        return a->reg.id == b->reg.id;
+    if (a->reg.colour == b->reg.colour)
+        return 1;
+    /* %rsp and %rbp have no colour, nor any narrower names */
+    return colourmap[a->reg.colour] && colourmap[a->reg.colour] == colourmap[b->reg.colour];
+}
+
+static int sameloc(Peep *p, Loc *a, Loc *b)
+{
+    if (!a || !b)
+        return a == b;
+    if (a->type != b->type || a->mode != b->mode)
+        return 0;
+    switch (a->type) {
+        case Locreg:
+            return samereg(p, a, b);
+        case Locmem:
+            if (a->mem.constdisp != b->mem.constdisp || a->mem.scale != b->mem.scale)
+                return 0;
+            if (!sameloc(p, a->mem.base, b->mem.base))
+                return 0;
+            return sameloc(p, a->mem.idx, b->mem.idx);
+        case Loclit:
+            return a->lit == b->lit;
+        default:
+            return 0;
+    }
+}
+
+static int inaddr(Peep *p, Loc *r, Loc *m)
+{
+    return m->type == Locmem && (overlaps(p, r, m->mem.base) || overlaps(p, r, m->mem.idx));
+}
+
+/* the next instruction in the block at or after i, skipping comments */
+static Insn *next(Peep *p, size_t *i)
+{
+    for (; *i < p->ni; (*i)++)
+        if (p->il[*i] && !iscomment(p->il[*i]))
+            return p->il[*i];
+    return NULL;
+}
+
+static Insn *prev(Peep *p, size_t *i)
+{
+    while (*i > 0) {
+        (*i)--;
+        if (p->il[*i] && !iscomment(p->il[*i]))
+            return p->il[*i];
+    }
+    return NULL;
+}
+
+static void del(Peep *p, size_t i)
+{
+    regid u[Maxuse];
+    size_t j, n;
+
+    if (p->nuse) {
+        n = uses(p->il[i], u);
+        for (j = 0; j < n; j++)
+            p->nuse[u[j]]--;
+    }
+    p->il[i] = NULL;
+}
+
+/* the block a label starts, or -1 */
+static ssize_t lblblock(Peep *p, char *lbl)
+{
+    return (ssize_t)(size_t)htget(p->lblidx, lbl) - 1;
+}
+
+static Insn *firstinsn(Asmbb *bb)
+{
+    size_t i;
+
+    for (i = 0; i < bb->ni; i++)
+        if (bb->il[i] && !iscomment(bb->il[i]))
+            return bb->il[i];
+    return NULL;
+}
+
+/* does the code after the current block run straight into lbl? */
+static int fallsto(Peep *p, char *lbl)
+{
+    ssize_t b;
+    size_t i;
+
+    b = lblblock(p, lbl);
+    if (b <= (ssize_t)p->bb)
+        return 0;
+    for (i = p->bb + 1; i < (size_t)b; i++)
+        if (firstinsn(p->isel->bb[i]))
+            return 0;
+    return 1;
+}
+
+/* mov %r,%r */
+static int selfmov(Peep *p, size_t i)
+{
+    Insn *insn;
+
+    insn = p->il[i];
+    if (insn->op != Imov && insn->op != Imovs)
+        return 0;
+    if (!samereg(p, insn->args[0], insn->args[1]))
+        return 0;
+    del(p, i);
+    return 1;
+}
+
+/* mov %r,m; mov m,%s => mov %r,m; mov %r,%s */
+static int storeload(Peep *p, size_t i)
+{
+    Insn *st, *ld;
+    size_t j;
+
+    st = p->il[i];
+    j = i + 1;
+    if (st->op != Imov || !isreg(st->args[0]) || st->args[1]->type != Locmem)
+        return 0;
+    if (!(ld = next(p, &j)) || ld->op != Imov || !isreg(ld->args[1]))
+        return 0;
+    if (!sameloc(p, st->args[1], ld->args[0]) || st->args[0]->mode != ld->args[1]->mode)
+        return 0;
+    if (samereg(p, st->args[0], ld->args[1])) {
+        del(p, j);
+    } else {
+        if (p->nuse)
+            p->nuse[st->args[0]->reg.id]++;
+        del(p, j);
+        p->il[j] = mkinsn(Imov, st->args[0], ld->args[1], NULL);
+    }
+    return 1;
+}
+
+/* mov m,%r; mov %r,m => mov m,%r */
+static int loadstore(Peep *p, size_t i)
+{
+    Insn *ld, *st;
+    size_t j;
+
+    ld = p->il[i];
+    j = i + 1;
+    if (ld->op != Imov || ld->args[0]->type != Locmem || !isreg(ld->args[1]))
+        return 0;
+    if (!(st = next(p, &j)) || st->op != Imov)
+        return 0;
+    if (!samereg(p, ld->args[1], st->args[0]) || !sameloc(p, ld->args[0], st->args[1]))
+        return 0;
+    if (inaddr(p, ld->args[1], ld->args[0]))
+        return 0;
+    del(p, j);
+    return 1;
+}
+
+/*
+ * setcc %b; movzx %b,%r; ...; test %r,%r; jnz l => ... jcc l
+ *
+ * Nothing between the setcc and the test may touch the
+ * flags, so we only look back through moves.
+ */
+static int setjcc(Peep *p, size_t i)
+{
+    Insn *test, *jmp, *insn;
+    size_t j, k;
+    Loc *r;
+
+    test = p->il[i];
+    if (test->op != Itest || !samereg(p, test->args[0], test->args[1]))
+        return 0;
+    k = i + 1;
+    if (!(jmp = next(p, &k)) || (jmp->op != Ijz && jmp->op != Ijnz))
+        return 0;
+    r = test->args[0];
+    j = i;
+    while ((insn = prev(p, &j)) != NULL) {
+        if (insn->op >= Isetz && insn->op <= Isetae) {
+            if (!samereg(p, insn->args[0], r))
+                return 0;
+            break;
+        } else if (insn->op == Imov || insn->op == Imovzx) {
+            if (!overlaps(p, insn->args[1], r))
+                continue;
+            if (!samereg(p, insn->args[1], r))
+                return 0;
+            if (!isreg(insn->args[0]))
+                return 0;
+            r = insn->args[0];
+        } else {
+            return 0;
+        }
+    }
+    if (!insn)
+        return 0;
+    if (jmp->op == Ijnz)
+        p->il[k] = mkinsn(jmpof[insn->op], jmp->args[0], NULL);
+    else
+        p->il[k] = mkinsn(invjmp[jmpof[insn->op]], jmp->args[0], NULL);
+    del(p, i);
+    return 1;
+}
+
+/* a value computed into a register nothing reads */
+static int deaddef(Peep *p, size_t i)
+{
+    Insn *insn;
+    Loc *d;
+
+    insn = p->il[i];
+    switch (insn->op) {
+        case Imov: case Imovs: case Imovzx: case Imovsx: case Ilea:
+            d = insn->args[1];
+            break;
+        case Isetz: case Isetnz: case Isetl: case Isetle: case Isetg:
+        case Isetge: case Isetb: case Isetbe: case Iseta: case Isetae:
+            d = insn->args[0];
+            break;
+        default:
+            return 0;
+    }
+    if (!isreg(d) || d->reg.id < Nreg || p->nuse[d->reg.id])
+        return 0;
+    del(p, i);
+    return 1;
+}
+
+/* add $0,%r, and the like */
+static int identity(Peep *p, size_t i)
+{
+    Insn *insn;
+    Loc *l;
+
+    insn = p->il[i];
+    l = insn->args[0];
+    if (insn->nargs != 2 || l->type != Loclit)
+        return 0;
+    switch (insn->op) {
+        case Iadd: case Isub: case Ior: case Ixor:
+        case Ishl: case Isar: case Ishr:
+            if (l->lit != 0)
+                return 0;
+            break;
+        case Iimul:
+            if (l->lit != 1)
+                return 0;
+            break;
+        default:
+            return 0;
+    }
+    del(p, i);
+    return 1;
+}
+
+/* lea (%r),%s => mov %r,%s */
+static int leamov(Peep *p, size_t i)
+{
+    Insn *insn;
+    Loc *m, *d;
+
+    insn = p->il[i];
+    if (insn->op != Ilea)
+        return 0;
+    m = insn->args[0];
+    d = insn->args[1];
+    if (m->type != Locmem || m->mem.constdisp || m->mem.lbldisp || m->mem.idx)
+        return 0;
+    if (m->mem.base->mode != d->mode)
+        return 0;
+    p->il[i] = mkinsn(Imov, m->mem.base, d, NULL);
+    return 1;
+}
+
+/*
+ * anything after a jmp or ret never runs, up to the
+ * next label
+ */
+static int unreachable(Peep *p, size_t i)
+{
+    Insn *insn;
+    Asmbb *bb;
+    size_t b, j;
+    int fired;
+
+    insn = p->il[i];
+    if (insn->op != Ijmp && insn->op != Ijmpind && insn->op != Iret)
+        return 0;
+    fired = 0;
+    for (j = i + 1; next(p, &j); j++) {
+        del(p, j);
+        fired = 1;
+    }
+    for (b = p->bb + 1; b < p->isel->nbb; b++) {
+        bb = p->isel->bb[b];
+        if (bb->nlbls)
+            break;
+        for (j = 0; j < bb->ni; j++) {
+            if (bb->il[j] && !iscomment(bb->il[j])) {
+                bb->il[j] = NULL;
+                fired = 1;
+            }
+        }
+    }
+    return fired;
+}
+
+/* a jump to a block that only jumps goes straight there */
+static int jmpthread(Peep *p, size_t i)
+{
+    Insn *insn, *to;
+    ssize_t b;
+    Loc *dst;
+    size_t n;
+
+    insn = p->il[i];
+    if (insn->op != Ijmp && !iscondjmp(insn))
+        return 0;
+    if (insn->args[0]->type != Loclbl)
+        return 0;
+    dst = insn->args[0];
+    /* give up on empty loops rather than chase them forever */
+    for (n = 0; n <= p->isel->nbb; n++) {
+        if ((b = lblblock(p, dst->lbl)) < 0)
+            break;
+        to = firstinsn(p->isel->bb[b]);
+        if (!to || to->op != Ijmp || to->args[0]->type != Loclbl)
+            break;
+        dst = to->args[0];
+    }
+    if (n > p->isel->nbb || dst == insn->args[0])
+        return 0;
+    p->il[i] = mkinsn(insn->op, dst, NULL);
+    return 1;
+}
+
+/* jmp l; l: => l: */
+static int jmpnext(Peep *p, size_t i)
+{
+    Insn *insn;
+
+    insn = p->il[i];
+    if (insn->op != Ijmp || insn->args[0]->type != Loclbl)
+        return 0;
+    if (!fallsto(p, insn->args[0]->lbl))
+        return 0;
+    del(p, i);
+    return 1;
+}
+
+/* jcc l1; jmp l2; l1: => jncc l2; l1: */
+static int jccnext(Peep *p, size_t i)
+{
+    Insn *jcc, *jmp;
+    size_t j;
+
+    jcc = p->il[i];
+    j = i + 1;
+    if (!iscondjmp(jcc) || !(jmp = next(p, &j)) || jmp->op != Ijmp)
+        return 0;
+    if (jcc->args[0]->type != Loclbl || !fallsto(p, jcc->args[0]->lbl))
+        return 0;
+    p->il[i] = mkinsn(invjmp[jcc->op], jmp->args[0], NULL);
+    del(p, j);
+    return 1;
+}
+
+static Rule rules[] = {
+    {"selfmov",     selfmov,        1, 1},
+    {"storeload",   storeload,      1, 1},
+    {"loadstore",   loadstore,      1, 1},
+    {"setjcc",      setjcc,         1, 1},
+    {"deaddef",     deaddef,        1, 0},
+    {"identity",    identity,       1, 1},
+    {"leamov",      leamov,         1, 1},
+    {"unreachable", unreachable,    0, 1},
+    {"jmpthread",   jmpthread,      0, 1},
+    {"jmpnext",     jmpnext,        0, 1},
+    {"jccnext",     jccnext,        0, 1},
+};
+
+static void indexlbls(Peep *p)
+{
+    Asmbb *bb;
+    size_t i, j;
+
+    p->lblidx = mkht(strhash, streq);
+    for (i = 0; i < p->isel->nbb; i++) {
+        bb = p->isel->bb[i];
+        for (j = 0; j < bb->nlbls; j++)
+            htput(p->lblidx, bb->lbls[j], (void*)(i + 1));
+    }
+}
+
+static void countuses(Peep *p)
+{
+    regid u[Maxuse];
+    size_t i, j, k, n;
+    Asmbb *bb;
+
+    p->nreg = maxregid;
+    p->nuse = zalloc(p->nreg*sizeof(size_t));
+    for (i = 0; i < p->isel->nbb; i++) {
+        bb = p->isel->bb[i];
+        for (j = 0; j < bb->ni; j++) {
+            n = uses(bb->il[j], u);
+            for (k = 0; k < n; k++)
+                p->nuse[u[k]]++;
+        }
+    }
+}
+
+void peep(Isel *s, int allocated)
+{
+    Peep p = {0,};
+    size_t i, j, k, n;
+    Rule *r;
+    Asmbb *bb;
+    int changed;
+
+    p.isel = s;
+    p.allocated = allocated;
+    indexlbls(&p);
+    if (!allocated)
+        countuses(&p);
+    for (i = 0; i < s->nbb; i++) {
+        bb = s->bb[i];
+        p.bb = i;
+        p.il = bb->il;
+        p.ni = bb->ni;
+        do {
+            changed = 0;
+            for (j = 0; j < p.ni; j++) {
+                for (k = 0; k < sizeof rules/sizeof rules[0]; k++) {
+                    r = &rules[k];
+                    if (!p.il[j] || iscomment(p.il[j]))
+                        break;
+                    if (!(allocated ? r->after : r->before) || !r->apply(&p, j))
+                        continue;
+                    r->nfired++;
+                    changed = 1;
+                }
+            }
+        } while (changed);
+
+        n = 0;
+        for (j = 0; j < p.ni; j++)
+            if (p.il[j])
+                p.il[n++] = p.il[j];
+        bb->ni = n;
+    }
+    free(p.nuse);
+    htfree(p.lblidx);
+}
+
+void peepstats(FILE *fd)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof rules/sizeof rules[0]; i++)
+        fprintf(fd, "peep %-12s %zd\n", rules[i].name, rules[i].nfired);
+}
@@ -2,8 +2,12 @@
 /* for OSX */
 #   define Asmcmd "as -g -o %s %s"
 #   define Symprefix "_"
+#   define Rodatasec ".const"
+#   define Elfobj 0
 #else
 /* Default to linux */
 #   define Asmcmd "as -g -o %s %s"
 #   define Symprefix ""
+#   define Rodatasec ".section .rodata"
+#   define Elfobj 1 /* we can write objects without the assembler */
 #endif
@@ -40,7 +40,6 @@ Usemap deftab[] = {
 };
 
 /* A map of which registers interfere */
-#define Northogonal 32
 Reg regmap[Northogonal][Nmode] = {
     [0]  = {Rnone, Ral, Rax, Reax, Rrax},
     [1]  = {Rnone, Rcl, Rcx, Recx, Rrcx},
@@ -145,7 +144,7 @@ static int isfixreg(Loc *l)
     return 0;
 }
 
-static size_t uses(Insn *insn, regid *u)
+size_t uses(Insn *insn, regid *u)
 {
     size_t i, j;
     int k;
@@ -172,6 +171,9 @@ static size_t uses(Insn *insn, regid *u)
         /* not a leak; physical registers get memoized */
         u[j++] = locphysreg(usetab[insn->op].r[i])->reg.id;
     }
+    /* calls use the registers their args were passed in */
+    for (i = 0; i < insn->nargregs; i++)
+        u[j++] = locphysreg(insn->argregs[i])->reg.id;
     /* If the registers are in an address calculation,
      * they're used no matter what. */
     for (i = 0; i < insn->nargs; i++) {
@@ -182,13 +184,20 @@ static size_t uses(Insn *insn, regid *u)
             if (!isfixreg(m->mem.base))
                 u[j++] = m->mem.base->reg.id;
         if (m->mem.idx)
-            if (!isfixreg(m->mem.base))
+            if (!isfixreg(m->mem.idx))
                 u[j++] = m->mem.idx->reg.id;
     }
     return j;
 }
 
-static size_t defs(Insn *insn, regid *d)
+/* registers a call is free to trash, besides the return value */
+static Reg clobbers[Nclobber] = {
+    Rrcx, Rrdx, Rrsi, Rrdi, Rr8, Rr9, Rr10, Rr11,
+    Rxmm0d, Rxmm1d, Rxmm2d, Rxmm3d, Rxmm4d, Rxmm5d, Rxmm6d, Rxmm7d,
+    Rxmm8d, Rxmm9d, Rxmm10d, Rxmm11d, Rxmm12d, Rxmm13d, Rxmm14d, Rxmm15d,
+};
+
+size_t defs(Insn *insn, regid *d)
 {
     size_t i, j;
     int k;
@@ -213,6 +222,9 @@ static size_t defs(Insn *insn, regid *d)
         /* not a leak; physical registers get memoized */
         d[j++] = locphysreg(deftab[insn->op].r[i])->reg.id;
     }
+    if (insn->op == Icall || insn->op == Icallind)
+        for (i = 0; i < Nclobber; i++)
+            d[j++] = locphysreg(clobbers[i])->reg.id;
     return j;
 }
 
@@ -244,13 +256,12 @@ static int istrivial(Isel *s, regid r)
     return s->degree[r] < _K[rclass(locmap[r])];
 }
 
-static void liveness(Isel *s)
+void liveness(Isel *s)
 {
-    Bitset *old;
     Asmbb **bb;
     ssize_t nbb;
     ssize_t i;
-    size_t j;
+    size_t j, n;
     int changed;
 
     bb = s->bb;
@@ -265,7 +276,8 @@ static void liveness(Isel *s)
     while (changed) {
         changed = 0;
         for (i = nbb - 1; i >= 0; i--) {
-            old = bsdup(bb[i]->liveout);
+            /* liveout only grows, so it changed if its count did */
+            n = bscount(bb[i]->liveout);
             /* liveout[b] = U(s in succ) livein[s] */
             for (j = 0; bsiter(bb[i]->succ, &j); j++)
                 bsunion(bb[i]->liveout, bb[j]->livein);
@@ -275,7 +287,7 @@ static void liveness(Isel *s)
             bsdiff(bb[i]->livein, bb[i]->def);
             bsunion(bb[i]->livein, bb[i]->use);
             if (!changed)
-                changed = !bseq(old, bb[i]->liveout);
+                changed = bscount(bb[i]->liveout) != n;
         }
     }
 }
@@ -288,21 +300,45 @@ static int ismove(Insn *i)
     return i->args[0]->type == Locreg && i->args[1]->type == Locreg;
 }
 
+/*
+ * Interference edges are kept in a hash set keyed by the
+ * ordered pair of register ids, so the graph costs memory
+ * in proportion to the number of edges instead of the
+ * square of the number of registers.
+ */
+static void *edgekey(size_t u, size_t v)
+{
+    if (u > v)
+        return (void*)(((uint64_t)v << 32) | u);
+    return (void*)(((uint64_t)u << 32) | v);
+}
+
+/* both halves of the key matter, so mix them thoroughly */
+static ulong edgehash(void *k)
+{
+    uint64_t h;
+
+    h = (uint64_t)k;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
 static int gbhasedge(Isel *s, size_t u, size_t v)
 {
-    size_t i;
-    i = (maxregid * v) + u;
-    return (s->gbits[i/Sizetbits] & (1ULL <<(i % Sizetbits))) != 0;
+    return hthas(s->gedges, edgekey(u, v));
 }
 
 static void gbputedge(Isel *s, size_t u, size_t v)
 {
-    size_t i, j;
+    void *k;
 
-    i = (maxregid * u) + v;
-    j = (maxregid * v) + u;
-    s->gbits[i/Sizetbits] |= 1ULL << (i % Sizetbits);
-    s->gbits[j/Sizetbits] |= 1ULL << (j % Sizetbits);
+    k = edgekey(u, v);
+    if (!hthas(s->gedges, k))
+        htput(s->gedges, k, k);
     assert(gbhasedge(s, u, v) && gbhasedge(s, v, u));
 }
 
@@ -349,6 +385,12 @@ static int degreechange(Isel *s, regid u, regid v)
     return 1;
 }
 
+static void adjappend(Isel *s, regid u, regid v)
+{
+    s->gadj[u] = xrealloc(s->gadj[u], (s->ngadj[u] + 1)*sizeof(regid));
+    s->gadj[u][s->ngadj[u]++] = v;
+}
+
 static void addedge(Isel *s, regid u, regid v)
 {
     if (u == v || gbhasedge(s, u, v))
@@ -359,30 +401,32 @@ static void addedge(Isel *s, regid u, regid v)
         return;
 
     gbputedge(s, u, v);
-    gbputedge(s, v, u);
     if (!bshas(s->prepainted, u)) {
-        bsput(s->gadj[u], v);
+        adjappend(s, u, v);
         s->degree[u] += degreechange(s, v, u);
     }
     if (!bshas(s->prepainted, v)) {
-        bsput(s->gadj[v], u);
+        adjappend(s, v, u);
         s->degree[v] += degreechange(s, u, v);
     }
 }
 
 static void setup(Isel *s)
 {
-    size_t gchunks;
     size_t i;
 
-    free(s->gbits);
-    gchunks = (maxregid*maxregid)/Sizetbits + 1;
-    s->gbits = zalloc(gchunks*sizeof(size_t));
+    if (s->gedges)
+        htfree(s->gedges);
+    s->gedges = mkht(edgehash, ptreq);
     /* fresh adj list repr. */
+    if (s->gadj)
+        for (i = 0; i < s->ngraph; i++)
+            free(s->gadj[i]);
     free(s->gadj);
-    s->gadj = zalloc(maxregid * sizeof(Bitset*));
-    for (i = 0; i < maxregid; i++)
-        s->gadj[i] = mkbs();
+    free(s->ngadj);
+    s->gadj = zalloc(maxregid * sizeof(regid*));
+    s->ngadj = zalloc(maxregid * sizeof(size_t));
+    s->ngraph = maxregid;
 
     s->spilled = bsclear(s->spilled);
     s->coalesced = bsclear(s->coalesced);
@@ -420,8 +464,10 @@ static void build(Isel *s)
     bb = s->bb;
     nbb = s->nbb;
 
+    live = mkbs();
     for (i = 0; i < nbb; i++) {
-        live = bsdup(bb[i]->liveout);
+        bsclear(live);
+        bsunion(live, bb[i]->liveout);
         for (j = bb[i]->ni - 1; j >= 0; j--) {
             insn = bb[i]->il[j];
             nu = uses(insn, u);
@@ -468,13 +514,20 @@ static void build(Isel *s)
                 bsput(live, u[k]);
         }
     }
+    bsfree(live);
 }
 
-static int adjiter(Isel *s, regid n, regid *m)
+/*
+ * Iterates the neighbours of n that are still in the graph.
+ * *it is the cursor into the adjacency list, and the
+ * neighbour found is returned in *m.
+ */
+static int adjiter(Isel *s, regid n, size_t *it, regid *m)
 {
     size_t i, r;
 
-    for (r = *m; bsiter(s->gadj[n], &r); r++) {
+    for (; *it < s->ngadj[n]; (*it)++) {
+        r = s->gadj[n][*it];
         for (i = 0; i < s->nselstk; i++)
             if (r == s->selstk[i]->reg.id)
                 goto next;
@@ -563,6 +616,7 @@ static void decdegree(Isel *s, regid m)
     int found;
     size_t idx;
     regid n;
+    size_t it;
 
     assert(m < maxregid);
     before = istrivial(s, m);
@@ -571,7 +625,7 @@ static void decdegree(Isel *s, regid m)
 
     if (before != after) {
         enablemove(s, m);
-        for (n = 0; adjiter(s, m, &n); n++)
+        for (it = 0; adjiter(s, m, &it, &n); it++)
             enablemove(s, n);
 
         /* Subtle:
@@ -606,10 +660,11 @@ static void simp(Isel *s)
 {
     Loc *l;
     regid m;
+    size_t it;
 
     l = lpop(&s->wlsimp, &s->nwlsimp);
     lappend(&s->selstk, &s->nselstk, l);
-    for (m = 0; adjiter(s, l->reg.id, &m); m++) {
+    for (it = 0; adjiter(s, l->reg.id, &it, &m); it++) {
         decdegree(s, m);
     }
 }
@@ -644,12 +699,13 @@ static int conservative(Isel *s, regid u, regid v)
 {
     int k;
     regid n;
+    size_t it;
 
     k = 0;
-    for (n = 0; adjiter(s, u, &n); n++)
+    for (it = 0; adjiter(s, u, &it, &n); it++)
         if (!istrivial(s, n))
             k++;
-    for (n = 0; adjiter(s, v, &n); n++)
+    for (it = 0; adjiter(s, v, &it, &n); it++)
         if (!istrivial(s, n))
             k++;
     return k < _K[rclass(locmap[u])];
@@ -658,12 +714,17 @@ static int conservative(Isel *s, regid u, regid v)
 /* FIXME: is this actually correct? */
 static int ok(Isel *s, regid t, regid r)
 {
+    /* different views of one register, like %dil and %edi, clash */
+    if (bshas(s->prepainted, t) && bshas(s->prepainted, r))
+        if (colourmap[locmap[t]->reg.colour] == colourmap[locmap[r]->reg.colour])
+            return 0;
     return istrivial(s, t) || bshas(s->prepainted, t) || gbhasedge(s, t, r);
 }
 
 static int combinable(Isel *s, regid u, regid v)
 {
     regid t;
+    size_t it;
 
     /* Regs of different modes can't be combined as things stand.
      * In principle they should be combinable, but it confused the
@@ -675,7 +736,7 @@ static int combinable(Isel *s, regid u, regid v)
         return 1;
 
     /* if it is, are the adjacent nodes ok to combine with this? */
-    for (t = 0; adjiter(s, v, &t); t++)
+    for (it = 0; adjiter(s, v, &it, &t); it++)
         if (!ok(s, t, u))
             return 0;
     return 1;
@@ -684,6 +745,7 @@ static int combinable(Isel *s, regid u, regid v)
 static void combine(Isel *s, regid u, regid v)
 {
     regid t;
+    size_t it;
     size_t idx;
     size_t i, j;
     int has;
@@ -711,7 +773,7 @@ static void combine(Isel *s, regid u, regid v)
             lappend(&s->rmoves[u], &s->nrmoves[u], s->rmoves[v][i]);
     }
 
-    for (t = 0; adjiter(s, v, &t); t++) {
+    for (it = 0; adjiter(s, v, &it, &t); it++) {
         if (debugopt['r'] > 2)
             printedge(stdout, "combine-putedge:", t, u);
         addedge(s, t, u);
@@ -732,16 +794,18 @@ static void coalesce(Isel *s)
     u = getalias(s, m->args[0]->reg.id);
     v = getalias(s, m->args[1]->reg.id);
 
-    if (bshas(s->prepainted, v)) {
+    /* a spill temp must not end up representing a longer lived
+     * register, or the merged node could never be spilled */
+    if (bshas(s->prepainted, v) || (bshas(s->neverspill, u) && !bshas(s->prepainted, u))) {
         tmp = u;
         u = v;
         v = tmp;
     }
 
     if (u == v) {
+        /* only once: the first call may already move it to wlsimp */
         lappend(&s->mcoalesced, &s->nmcoalesced, m);
         wladd(s, u);
-        wladd(s, v);
     } else if (bshas(s->prepainted, v) || gbhasedge(s, u, v)) {
         lappend(&s->mconstrained, &s->nmconstrained, m);
         wladd(s, u);
@@ -847,6 +911,7 @@ static int paint(Isel *s)
     int taken[Nreg];
     Loc *n, *w;
     regid l;
+    size_t it;
     int i;
     int spilled;
     int found;
@@ -856,7 +921,8 @@ static int paint(Isel *s)
         bzero(taken, Nreg*sizeof(int));
         n = lpop(&s->selstk, &s->nselstk);
 
-        for (l = 0; bsiter(s->gadj[n->reg.id], &l); l++) {
+        for (it = 0; it < s->ngadj[n->reg.id]; it++) {
+            l = s->gadj[n->reg.id][it];
             if (debugopt['r'] > 1)
                 printedge(stdout, "paint-edge:", n->reg.id, l);
             w = locmap[getalias(s, l)];
@@ -889,12 +955,6 @@ static int paint(Isel *s)
     return spilled;
 }
 
-typedef struct Remapping Remapping;
-struct Remapping {
-    regid oldreg;
-    Loc *newreg;
-};
-
 static Loc *mapfind(Loc *old, Remapping *r, size_t nr)
 {
     Loc *new;
@@ -927,7 +987,7 @@ static Loc *mapfind(Loc *old, Remapping *r, size_t nr)
     return old;
 }
 
-static Loc *spillslot(Isel *s, regid reg)
+Loc *spillslot(Isel *s, regid reg)
 {
     size_t stkoff;
 
@@ -935,7 +995,7 @@ static Loc *spillslot(Isel *s, regid reg)
     return locmem(-stkoff, locphysreg(Rrbp), NULL, locmap[reg]->mode);
 }
 
-static void updatelocs(Isel *s, Insn *insn, Remapping *use, size_t nuse, Remapping *def, size_t ndef)
+void updatelocs(Isel *s, Insn *insn, Remapping *use, size_t nuse, Remapping *def, size_t ndef)
 {
     size_t i;
 
@@ -955,7 +1015,7 @@ static int remap(Isel *s, Insn *insn, Remapping *use, size_t *nuse, Remapping *d
     regid u[Maxuse], d[Maxdef];
     size_t nu, nd;
     size_t useidx, defidx;
-    size_t i, j, k;
+    size_t i, j;
     int found;
 
     useidx = 0;
@@ -979,13 +1039,11 @@ static int remap(Isel *s, Insn *insn, Remapping *use, size_t *nuse, Remapping *d
         /* if we already have remapped a use for this register, we want to
          * store the same register from the def. */
         found = 0;
-        for (j = 0; j < defidx; j++) {
-            for (k = 0; i < useidx; k++) {
-                if (use[j].oldreg == d[k]) {
-                    def[defidx].newreg = use[j].newreg;
-                    bsput(s->neverspill, def[defidx].newreg->reg.id);
-                    found = 1;
-                }
+        for (j = 0; j < useidx; j++) {
+            if (use[j].oldreg == d[i]) {
+                def[defidx].newreg = use[j].newreg;
+                found = 1;
+                break;
             }
         }
         if (!found) {
@@ -1001,6 +1059,13 @@ static int remap(Isel *s, Insn *insn, Remapping *use, size_t *nuse, Remapping *d
     return useidx > 0 || defidx > 0;
 }
 
+static Insn *spillmov(Loc *a, Loc *b)
+{
+    if (b->mode == ModeF || b->mode == ModeD)
+        return mkinsn(Imovs, a, b, NULL);
+    return mkinsn(Imov, a, b, NULL);
+}
+
 /*
  * Rewrite instructions using spilled registers, inserting
  * appropriate loads and stores into the BB
@@ -1020,7 +1085,7 @@ static void rewritebb(Isel *s, Asmbb *bb)
         /* if there is a remapping, insert the loads and stores as needed */
         if (remap(s, bb->il[j], use, &nuse, def, &ndef)) {
             for (i = 0; i < nuse; i++) {
-                insn = mkinsn(Imov, spillslot(s, use[i].oldreg), use[i].newreg, NULL);
+                insn = spillmov(spillslot(s, use[i].oldreg), use[i].newreg);
                 lappend(&new, &nnew, insn);
                 if (debugopt['r']) {
                     printf("loading ");
@@ -1034,7 +1099,7 @@ static void rewritebb(Isel *s, Asmbb *bb)
             updatelocs(s, insn, use, nuse, def, ndef);
             lappend(&new, &nnew, insn);
             for (i = 0; i < ndef; i++) {
-                insn = mkinsn(Imov, def[i].newreg, spillslot(s, def[i].oldreg), NULL);
+                insn = spillmov(def[i].newreg, spillslot(s, def[i].oldreg));
                 lappend(&new, &nnew, insn);
                 if (debugopt['r']) {
                     printf("storing ");
@@ -1053,7 +1118,7 @@ static void rewritebb(Isel *s, Asmbb *bb)
     bb->ni = nnew;
 }
 
-static void addspill(Isel *s, Loc *l)
+void addspill(Isel *s, Loc *l)
 {
     s->stksz->lit += modesize[l->mode];
     s->stksz->lit = align(s->stksz->lit, modesize[l->mode]);
@@ -1101,7 +1166,7 @@ static void rewrite(Isel *s)
  *
  * This is useless. This deletes them.
  */
-static void delnops(Isel *s)
+void delnops(Isel *s)
 {
     Insn *insn;
     Asmbb *bb;
@@ -1132,6 +1197,12 @@ void regalloc(Isel *s)
     int spilled;
     size_t i;
 
+    /* big functions take too long to colour */
+    if (ralgo ? !strcmp(ralgo, "linear") : maxregid - Nreg > Lsrathresh) {
+        lsregalloc(s);
+        return;
+    }
+
     /* Initialize the list of prepainted registers */
     s->prepainted = mkbs();
     bsput(s->prepainted, 0);
@@ -1141,8 +1212,6 @@ void regalloc(Isel *s)
     s->shouldspill = mkbs();
     s->neverspill = mkbs();
     s->initial = mkbs();
-    for (i = 0; i < Nsaved; i++)
-        bsput(s->shouldspill, s->calleesave[i]->reg.id);
     do {
         setup(s);
         liveness(s);
@@ -1237,7 +1306,7 @@ void dumpasm(Isel *s, FILE *fd)
     wlprint(stdout, "simp", s->wlsimp, s->nwlsimp);
     wlprint(stdout, "freeze", s->wlfreeze, s->nwlfreeze);
     /* noisy to dump this all the time; only dump for higher debug levels */
-    if (debugopt['r'] > 2) {
+    if (debugopt['r'] > 2 && s->gedges) {
         fprintf(fd, "IGRAPH ----- \n");
         for (i = 0; i < maxregid; i++) {
             for (j = i; j < maxregid; j++) {
@@ -49,6 +49,9 @@ struct Simp {
     size_t nblobs;
     size_t stksz;
     size_t argsz;
+    Argcc argcc;
+    Node **args;
+    size_t nargs;
     Htab *globls;
     Htab *stkoff;
 };
@@ -65,6 +68,7 @@ static Node *simpcast(Simp *s, Node *val, Type *to);
 static Node *simpslice(Simp *s, Node *n, Node *dst);
 static Node *idxaddr(Simp *s, Node *seq, Node *idx);
 static void umatch(Simp *s, Node *pat, Node *val, Type *t, Node *iftrue, Node *iffalse);
+static void matchtree(Simp *s, Node *val, Type *t, Node **pat, Node **lbl, size_t n, Node *fail);
 
 /* useful constants */
 static Type *tyintptr;
@@ -271,6 +275,55 @@ int floatnode(Node *n)
         return floattype(n->decl.type);
 }
 
+/* Functions taking varargs keep everything on the
+ * stack, since vastart() walks the args in memory. */
+int isregcc(Type *fn)
+{
+    fn = tybase(fn);
+    if (fn->type != Tyfunc)
+        return 0;
+    if (fn->nsub > 1 && tybase(fn->sub[fn->nsub - 1])->type == Tyvalist)
+        return 0;
+    return 1;
+}
+
+/* Decides where the next argument of type 't' goes. Returns
+ * the number of registers it occupies, filling in the registers
+ * and the mode of each piece, or 0 if it goes on the stack.
+ * Aggregates of up to 16 bytes are split into eightbytes and
+ * passed in integer registers. */
+size_t classify(Argcc *cc, Type *t, Reg *r, Mode *m)
+{
+    Reg intregs[] = {Rrdi, Rrsi, Rrdx, Rrcx, Rr8, Rr9};
+    Reg fltregs[] = {Rxmm0d, Rxmm1d, Rxmm2d, Rxmm3d, Rxmm4d, Rxmm5d, Rxmm6d, Rxmm7d};
+    Mode szmode[] = {[1] = ModeB, [2] = ModeW, [4] = ModeL, [8] = ModeQ};
+    size_t sz, last, n, i;
+
+    if (!cc->regcc)
+        return 0;
+    sz = tysize(t);
+    if (floattype(t)) {
+        if (cc->nflt == Nfltarg)
+            return 0;
+        r[0] = fltregs[cc->nflt++];
+        m[0] = (sz == 4) ? ModeF : ModeD;
+        return 1;
+    }
+    if (sz == 0 || sz > 2*Ptrsz)
+        return 0;
+    n = (sz + Ptrsz - 1)/Ptrsz;
+    last = sz - (n - 1)*Ptrsz;
+    if (last != 1 && last != 2 && last != 4 && last != 8)
+        return 0;
+    if (cc->nint + n > Nintarg)
+        return 0;
+    for (i = 0; i < n; i++) {
+        r[i] = intregs[cc->nint++];
+        m[i] = szmode[i == n - 1 ? last : Ptrsz];
+    }
+    return n;
+}
+
 size_t tysize(Type *t)
 {
     size_t sz;
@@ -669,38 +722,295 @@ static void umatch(Simp *s, Node *pat, Node *val, Type *t, Node *iftrue, Node *i
                 pat = patval(s, pat, uc->etype);
                 val = patval(s, val, uc->etype);
                 umatch(s, pat, val, uc->etype, iftrue, iffalse);
+            } else {
+                jmp(s, iftrue);
             }
             break;
     }
 }
 
+/* can the pattern be matched by switching on a single key? */
+static int iskeyed(Node *pat, Type *t)
+{
+    t = tybase(t);
+    if (exprop(pat) == Oucon)
+        return t->type == Tyunion;
+    /* negative literals are parsed as a negation */
+    if (exprop(pat) == Oneg && exprop(pat->expr.args[0]) == Olit)
+        if (pat->expr.args[0]->expr.args[0]->lit.littype == Lint)
+            pat = pat->expr.args[0];
+    if (exprop(pat) != Olit)
+        return 0;
+    switch (pat->expr.args[0]->lit.littype) {
+        case Lint: case Lchr: case Lbool:
+            break;
+        default:
+            return 0;
+    }
+    switch (t->type) {
+        case Tybool: case Tychar: case Tybyte:
+        case Tyint8: case Tyint16: case Tyint32: case Tyint:
+        case Tyuint8: case Tyuint16: case Tyuint32: case Tyuint:
+        case Tyint64: case Tyuint64: case Tylong:  case Tyulong:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* the union tag, or the (negated) literal value truncated to the type */
+static vlong patkey(Node *pat, Type *t)
+{
+    Node *lit;
+    uvlong v;
+    size_t sz;
+    int neg;
+
+    if (exprop(pat) == Oucon)
+        return finducon(pat)->id;
+    neg = exprop(pat) == Oneg;
+    if (neg)
+        pat = pat->expr.args[0];
+    lit = pat->expr.args[0];
+    switch (lit->lit.littype) {
+        case Lchr:      v = lit->lit.chrval;    break;
+        case Lbool:     v = lit->lit.boolval;   break;
+        default:        v = lit->lit.intval;    break;
+    }
+    if (neg)
+        v = -v;
+    sz = tysize(t);
+    if (sz < 8) {
+        v &= (1ULL << 8*sz) - 1;
+        if (istysigned(t) && v >> (8*sz - 1))
+            v |= ~0ULL << 8*sz;
+    }
+    return v;
+}
+
+static int keycmp(const void *pa, const void *pb)
+{
+    vlong a, b;
+
+    a = *(vlong*)pa;
+    b = *(vlong*)pb;
+    return (a > b) - (a < b);
+}
+
+static int ukeycmp(const void *pa, const void *pb)
+{
+    uvlong a, b;
+
+    a = *(uvlong*)pa;
+    b = *(uvlong*)pb;
+    return (a > b) - (a < b);
+}
+
+static Node *keycond(Op op, Node *k, vlong v)
+{
+    Node *lit, *n;
+
+    lit = mkintlit(k->line, v);
+    lit->expr.type = exprtype(k);
+    n = mkexpr(k->line, op, k, lit, NULL);
+    n->expr.type = mktype(k->line, Tybool);
+    return n;
+}
+
+/*
+ * Jumps to lbls[k - keys[0]], after checking that k is in
+ * range. Keys with no arm of their own go to 'fail'.
+ */
+static void jtab(Simp *s, Node *k, vlong *keys, Node **lbls, size_t n, Node *fail)
+{
+    Node *idx, *x, *tbl;
+    Node **args;
+    uvlong spread, i;
+    size_t j;
+
+    spread = (uvlong)keys[n - 1] - (uvlong)keys[0];
+    idx = k;
+    if (keys[0]) {
+        x = mkexpr(k->line, Osub, k, mkintlit(k->line, keys[0]), NULL);
+        x->expr.args[1]->expr.type = exprtype(k);
+        x->expr.type = exprtype(k);
+        idx = temp(s, x);
+        append(s, set(idx, x));
+    }
+    tbl = genlbl();
+    cjmp(s, keycond(Ougt, idx, spread), fail, tbl);
+    append(s, tbl);
+
+    args = xalloc((spread + 2)*sizeof(Node*));
+    args[0] = idx;
+    j = 0;
+    for (i = 0; i <= spread; i++) {
+        if ((uvlong)keys[j] - (uvlong)keys[0] == i)
+            args[i + 1] = lbls[j++];
+        else
+            args[i + 1] = fail;
+    }
+    append(s, mkexprl(k->line, Ojtab, args, spread + 2));
+}
+
+/*
+ * Goes to lbls[i] when k equals keys[i], or to 'fail' if
+ * it equals none of them. The keys are sorted and distinct.
+ * Dense sets of keys go through a jump table, and sparse
+ * ones are bisected down to a few compares.
+ */
+static void keyswitch(Simp *s, Node *k, vlong *keys, Node **lbls, size_t n, Node *fail)
+{
+    Node *lo, *hi, *next;
+    uvlong spread;
+    size_t i, mid;
+
+    spread = (uvlong)keys[n - 1] - (uvlong)keys[0];
+    if (n >= Jtabmin && spread < Jtabspread*n) {
+        jtab(s, k, keys, lbls, n, fail);
+        return;
+    }
+    if (n <= 3) {
+        for (i = 0; i < n - 1; i++) {
+            next = genlbl();
+            cjmp(s, keycond(Oeq, k, keys[i]), lbls[i], next);
+            append(s, next);
+        }
+        cjmp(s, keycond(Oeq, k, keys[i]), lbls[i], fail);
+        return;
+    }
+    mid = n/2;
+    lo = genlbl();
+    hi = genlbl();
+    cjmp(s, keycond(istysigned(exprtype(k)) ? Olt : Oult, k, keys[mid]), lo, hi);
+    append(s, lo);
+    keyswitch(s, k, keys, lbls, mid, fail);
+    append(s, hi);
+    keyswitch(s, k, keys + mid, lbls + mid, n - mid, fail);
+}
+
+/*
+ * Matches a run of literal or union constructor patterns.
+ * We switch once on the value or tag, and then the arms
+ * that share a tag have their payloads matched together,
+ * so the tag is tested only once however many arms use it.
+ */
+static void dispatch(Simp *s, Node *val, Type *t, Node **pat, Node **lbl, size_t n, Node *fail)
+{
+    Node **targ, **subpat, **sublbl;
+    vlong *key, *uniq;
+    size_t i, j, nuniq, nsub;
+    Node *k, *x;
+    Ucon *uc;
+
+    if (tybase(t)->type == Tyunion)
+        x = uconid(s, val);
+    else
+        x = val;
+    k = temp(s, x);
+    append(s, set(k, x));
+
+    key = xalloc(n*sizeof(vlong));
+    uniq = xalloc(n*sizeof(vlong));
+    for (i = 0; i < n; i++)
+        key[i] = uniq[i] = patkey(pat[i], t);
+    qsort(uniq, n, sizeof(vlong), istysigned(exprtype(k)) ? keycmp : ukeycmp);
+    nuniq = 0;
+    for (i = 0; i < n; i++)
+        if (!nuniq || uniq[i] != uniq[nuniq - 1])
+            uniq[nuniq++] = uniq[i];
+    targ = xalloc(nuniq*sizeof(Node*));
+    for (i = 0; i < nuniq; i++)
+        targ[i] = genlbl();
+    keyswitch(s, k, uniq, targ, nuniq, fail);
+
+    subpat = xalloc(n*sizeof(Node*));
+    sublbl = xalloc(n*sizeof(Node*));
+    for (i = 0; i < nuniq; i++) {
+        append(s, targ[i]);
+        uc = NULL;
+        nsub = 0;
+        for (j = 0; j < n; j++) {
+            if (key[j] != uniq[i])
+                continue;
+            if (exprop(pat[j]) == Oucon)
+                uc = finducon(pat[j]);
+            subpat[nsub] = pat[j];
+            sublbl[nsub] = lbl[j];
+            nsub++;
+        }
+        if (uc && uc->etype) {
+            for (j = 0; j < nsub; j++)
+                subpat[j] = patval(s, subpat[j], uc->etype);
+            matchtree(s, patval(s, val, uc->etype), uc->etype, subpat, sublbl, nsub, fail);
+        } else {
+            /* the first arm with the key shadows the rest */
+            jmp(s, sublbl[0]);
+        }
+    }
+    free(key);
+    free(uniq);
+    free(targ);
+    free(subpat);
+    free(sublbl);
+}
+
+/*
+ * Goes to lbl[i] for the first pat[i] that matches val,
+ * or to 'fail' if none do. Runs of keyed patterns are
+ * matched together by dispatch(), and everything else
+ * is tested in turn by umatch().
+ */
+static void matchtree(Simp *s, Node *val, Type *t, Node **pat, Node **lbl, size_t n, Node *fail)
+{
+    Node *next;
+    size_t i, j;
+
+    for (i = 0; i < n; i = j) {
+        next = genlbl();
+        for (j = i; j < n && iskeyed(pat[j], t); j++)
+            /* nothing */;
+        if (j - i >= 2) {
+            dispatch(s, val, t, pat + i, lbl + i, j - i, next);
+        } else {
+            j = i + 1;
+            umatch(s, pat[i], val, t, lbl[i], next);
+        }
+        append(s, next);
+    }
+    jmp(s, fail);
+}
+
 static void simpmatch(Simp *s, Node *n)
 {
-    Node *end, *cur, *next; /* labels */
+    Node *end; /* label */
     Node *val, *tmp;
-    Node *m;
-    size_t i;
+    Node **pat, **lbl;
+    size_t i, nm;
 
     end = genlbl();
     val = temp(s, n->matchstmt.val);
     tmp = rval(s, n->matchstmt.val, val);
     if (val != tmp)
         append(s, assign(s, val, tmp));
-    for (i = 0; i < n->matchstmt.nmatches; i++) {
-        m = n->matchstmt.matches[i];
 
-        /* check pattern */
-        cur = genlbl();
-        next = genlbl();
-        umatch(s, m->match.pat, val, val->expr.type, cur, next);
-
-        /* do the action if it matches */
-        append(s, cur);
-        simp(s, m->match.block);
+    /* test the patterns together, then lay out the arms */
+    nm = n->matchstmt.nmatches;
+    pat = xalloc(nm*sizeof(Node*));
+    lbl = xalloc(nm*sizeof(Node*));
+    for (i = 0; i < nm; i++) {
+        pat[i] = n->matchstmt.matches[i]->match.pat;
+        lbl[i] = genlbl();
+    }
+    matchtree(s, val, val->expr.type, pat, lbl, nm, end);
+    for (i = 0; i < nm; i++) {
+        append(s, lbl[i]);
+        simp(s, n->matchstmt.matches[i]->match.block);
         jmp(s, end);
-        append(s, next);
     }
     append(s, end);
+    free(pat);
+    free(lbl);
 }
 
 static void simpblk(Simp *s, Node *n)
@@ -1483,7 +1793,19 @@ static void declarelocal(Simp *s, Node *n)
 
 static void declarearg(Simp *s, Node *n)
 {
+    Reg r[2];
+    Mode m[2];
+    Type *t;
+
     assert(n->type == Ndecl || (n->type == Nexpr && exprop(n) == Ovar));
+    lappend(&s->args, &s->nargs, n);
+    /* args passed in registers get spilled to a local
+     * slot by the prologue, and live there from then on */
+    t = (n->type == Ndecl) ? n->decl.type : n->expr.type;
+    if (classify(&s->argcc, t, r, m)) {
+        declarelocal(s, n);
+        return;
+    }
     s->argsz = align(s->argsz, min(size(n), Ptrsz));
     htput(s->stkoff, n, (void*)-(s->argsz + 2*Ptrsz));
     if (debugopt['i']) {
@@ -1563,6 +1885,11 @@ static void flatten(Simp *s, Node *f)
     s->stmts = NULL;
     s->endlbl = genlbl();
     s->ret = NULL;
+    s->args = NULL;
+    s->nargs = 0;
+    s->argcc.regcc = isregcc(f->func.type);
+    s->argcc.nint = 0;
+    s->argcc.nflt = 0;
 
     /* make a temp for the return type */
     ty = f->func.type->sub[0];
@@ -1583,6 +1910,43 @@ static void flatten(Simp *s, Node *f)
     append(s, s->endlbl);
 }
 
+/*
+ * Takes the stack slots away from locals that never have
+ * their address taken and fit in a register, and packs the
+ * slots that are left. Args passed in registers stay there.
+ */
+static void promote(Simp *s, Cfg *cfg)
+{
+    Bitset *esc;
+    void **k;
+    size_t i, nk, id;
+    ssize_t off;
+    Node *n;
+    Ty t;
+
+    esc = escapes(cfg, s->globls);
+    k = htkeys(s->stkoff, &nk);
+    s->stksz = 0;
+    for (i = 0; i < nk; i++) {
+        n = k[i];
+        off = (ssize_t)htget(s->stkoff, n);
+        /* args passed on the stack are the caller's */
+        if (off < 0)
+            continue;
+        id = n->type == Ndecl ? n->decl.did : n->expr.did;
+        t = tybase(nodetype(n))->type;
+        if (!stacknode(n) && t != Tyvoid && t != Tyvalist && !bshas(esc, id)) {
+            htdel(s->stkoff, n);
+            continue;
+        }
+        s->stksz += size(n);
+        s->stksz = align(s->stksz, min(size(n), Ptrsz));
+        htput(s->stkoff, n, (void*)s->stksz);
+    }
+    free(k);
+    bsfree(esc);
+}
+
 static Func *simpfn(Simp *s, char *name, Node *n, Vis vis)
 {
     size_t i;
@@ -1619,16 +1983,28 @@ static Func *simpfn(Simp *s, char *name, Node *n, Vis vis)
     }
 
     cfg = mkcfg(s->stmts, s->nstmts);
+    if (optlevel > 0) {
+        ssa(cfg, s->globls, s->ret);
+        sccp(cfg);
+        gvn(cfg);
+        unssa(cfg);
+        promote(s, cfg);
+    }
     if (debugopt['t'] || debugopt['s'])
         dumpcfg(cfg, stdout);
+    if (debugopt['d'])
+        dumpflow(cfg, s->globls, s->ret, stdout);
 
-    fn = zalloc(sizeof(Func));
+    fn = azalloc(&lifetime, sizeof(Func));
     fn->name = strdup(name);
     if (vis != Visintern)
         fn->isexport = 1;
     fn->stksz = align(s->stksz, 8);
     fn->stkoff = s->stkoff;
     fn->ret = s->ret;
+    fn->args = s->args;
+    fn->nargs = s->nargs;
+    fn->regcc = s->argcc.regcc;
     fn->cfg = cfg;
     return fn;
 }
@@ -1728,15 +2104,22 @@ static void simpglobl(Node *dcl, Htab *globls, Func ***fn, size_t *nfn, Node ***
     free(name);
 }
 
-void gen(Node *file, char *out)
+/*
+ * Generates code for 'file', writing a relocatable
+ * object to 'objfile' and textual assembly to 'asmfile'.
+ * Either may be null.
+ */
+void gen(Node *file, char *objfile, char *asmfile)
 {
     Htab *globls, *strtab;
     Node *n, **blob;
     Func **fn;
     size_t nfn, nblob;
     size_t i;
-    FILE *fd;
+    FILE *fd, *asmfd;
+    Obj *o;
 
+    resetlbls();
     /* declare useful constants */
     tyintptr = mktype(-1, Tyuint64);
     tyword = mktype(-1, Tyuint);
@@ -1767,17 +2150,31 @@ void gen(Node *file, char *out)
     }
     popstab();
 
-    fd = fopen(out, "w");
-    if (!fd)
-        die("Couldn't open fd %s", out);
+    asmfd = NULL;
+    if (asmfile) {
+        asmfd = fopen(asmfile, "w");
+        if (!asmfd)
+            die("Couldn't open fd %s", asmfile);
+    }
+    o = mkobj(asmfd, objfile != NULL);
 
     strtab = mkht(strhash, streq);
-    fprintf(fd, ".data\n");
+    objsec(o, Secdata);
     for (i = 0; i < nblob; i++)
-        genblob(fd, blob[i], globls, strtab);
-    fprintf(fd, ".text\n");
+        genblob(o, blob[i], globls, strtab);
+    objsec(o, Sectext);
     for (i = 0; i < nfn; i++)
-        genasm(fd, fn[i], globls, strtab);
-    genstrings(fd, strtab);
-    fclose(fd);
+        genasm(o, fn[i], globls, strtab);
+    objsec(o, Secdata);
+    genstrings(o, strtab);
+    if (asmfd)
+        fclose(asmfd);
+
+    if (objfile) {
+        fd = fopen(objfile, "w");
+        if (!fd)
+            die("Couldn't open fd %s", objfile);
+        objwrite(o, fd);
+        fclose(fd);
+    }
 }
@@ -0,0 +1,3 @@
+#define Instroot "/usr/local"
+#define Asmcmd "as -g -o %s %s"
+#define Fprefix ""
@@ -0,0 +1,2 @@
+export INST_ROOT=/usr/local
+export SYS=linux
@@ -0,0 +1,392 @@
+.data
+.text
+.globl std$strcmp
+std$strcmp:
+	pushq %rbp
+	movq %rsp,%rbp
+	subq $128,%rsp
+	movq %rcx,-96(%rbp)
+	movq %rdx,-104(%rbp)
+	movq %rbx,-112(%rbp)
+	movq %rsi,-120(%rbp)
+	movq %rdi,-128(%rbp)
+	movq %rdi,-8(%rbp)
+	movq %rsi,-24(%rbp)
+	movq %rdx,-16(%rbp)
+	movq %rcx,-40(%rbp)
+	movq %r8,-32(%rbp)
+
+	# bb = 1, bbidx = 0, line=30:
+	leaq -24(%rbp),%rcx
+	movq 8(%rcx),%rcx
+	movl %ecx,%edi
+	leaq -40(%rbp),%rcx
+	movq 8(%rcx),%rcx
+	movl %ecx,%esi
+	call std$min$22$256357945
+
+	# bb = 1, bbidx = 1, line=30:
+	movl %eax,-44(%rbp)
+
+	# bb = 1, bbidx = 2, line=31:
+	movl $0,-48(%rbp)
+
+	# bb = 1, bbidx = 3, line=-1:
+	jmp .L2
+.L1:
+
+	# bb = 2, bbidx = 0, line=32:
+	leaq -24(%rbp),%rax
+	movl -48(%rbp),%ecx
+	movl %ecx,%ebx
+	movq (%rax),%rax
+	leaq -40(%rbp),%rcx
+	movl -48(%rbp),%edx
+	movl %edx,%edx
+	movq (%rcx),%rcx
+	movb (%rax,%rbx),%al
+	cmpb  (%rcx,%rdx),%al
+	jb .L5
+	jmp .L6
+.L5:
+
+	# bb = 3, bbidx = 0, line=33:
+	leaq -56(%rbp),%rax
+	movl $0,(%rax)
+
+	# bb = 3, bbidx = 1, line=33:
+	leaq -56(%rbp),%rsi
+	movq -8(%rbp),%rdi
+	movq $8,%rcx
+	rep movsb
+
+	# bb = 3, bbidx = 2, line=-1:
+	jmp .L0
+
+	# bb = 4, bbidx = 0, line=-1:
+	jmp .L7
+.L6:
+
+	# bb = 5, bbidx = 0, line=34:
+	leaq -24(%rbp),%rax
+	movl -48(%rbp),%ecx
+	movl %ecx,%ebx
+	movq (%rax),%rax
+	leaq -40(%rbp),%rcx
+	movl -48(%rbp),%edx
+	movl %edx,%edx
+	movq (%rcx),%rcx
+	movb (%rax,%rbx),%al
+	cmpb  (%rcx,%rdx),%al
+	ja .L8
+	jmp .L9
+.L8:
+
+	# bb = 6, bbidx = 0, line=35:
+	leaq -64(%rbp),%rax
+	movl $2,(%rax)
+
+	# bb = 6, bbidx = 1, line=35:
+	leaq -64(%rbp),%rsi
+	movq -8(%rbp),%rdi
+	movq $8,%rcx
+	rep movsb
+
+	# bb = 6, bbidx = 2, line=-1:
+	jmp .L0
+
+	# bb = 7, bbidx = 0, line=-1:
+	jmp .L10
+.L9:
+
+	# bb = 8, bbidx = 0, line=-1:
+	jmp .L10
+.L10:
+
+	# bb = 9, bbidx = 0, line=-1:
+	jmp .L7
+.L7:
+
+	# bb = 10, bbidx = 0, line=-1:
+	jmp .L3
+.L3:
+
+	# bb = 11, bbidx = 0, line=31:
+
+	# bb = 11, bbidx = 1, line=31:
+	movl -48(%rbp),%eax
+	addl $1,%eax
+	movl %eax,-48(%rbp)
+
+	# bb = 11, bbidx = 2, line=-1:
+	jmp .L2
+.L2:
+
+	# bb = 12, bbidx = 0, line=31:
+	movl -48(%rbp),%eax
+	cmpl  -44(%rbp),%eax
+	jl .L1
+	jmp .L4
+.L4:
+
+	# bb = 13, bbidx = 0, line=39:
+	leaq -24(%rbp),%rax
+	movq 8(%rax),%rax
+	leaq -40(%rbp),%rcx
+	movq 8(%rcx),%rcx
+	cmpl  %ecx,%eax
+	jl .L11
+	jmp .L12
+.L11:
+
+	# bb = 14, bbidx = 0, line=40:
+	leaq -72(%rbp),%rax
+	movl $0,(%rax)
+
+	# bb = 14, bbidx = 1, line=40:
+	leaq -72(%rbp),%rsi
+	movq -8(%rbp),%rdi
+	movq $8,%rcx
+	rep movsb
+
+	# bb = 14, bbidx = 2, line=-1:
+	jmp .L0
+
+	# bb = 15, bbidx = 0, line=-1:
+	jmp .L13
+.L12:
+
+	# bb = 16, bbidx = 0, line=41:
+	leaq -24(%rbp),%rax
+	movq 8(%rax),%rax
+	leaq -40(%rbp),%rcx
+	movq 8(%rcx),%rcx
+	cmpl  %ecx,%eax
+	jg .L14
+	jmp .L15
+.L14:
+
+	# bb = 17, bbidx = 0, line=42:
+	leaq -80(%rbp),%rax
+	movl $2,(%rax)
+
+	# bb = 17, bbidx = 1, line=42:
+	leaq -80(%rbp),%rsi
+	movq -8(%rbp),%rdi
+	movq $8,%rcx
+	rep movsb
+
+	# bb = 17, bbidx = 2, line=-1:
+	jmp .L0
+
+	# bb = 18, bbidx = 0, line=-1:
+	jmp .L16
+.L15:
+
+	# bb = 19, bbidx = 0, line=44:
+	leaq -88(%rbp),%rax
+	movl $1,(%rax)
+
+	# bb = 19, bbidx = 1, line=44:
+	leaq -88(%rbp),%rsi
+	movq -8(%rbp),%rdi
+	movq $8,%rcx
+	rep movsb
+
+	# bb = 19, bbidx = 2, line=-1:
+	jmp .L0
+
+	# bb = 20, bbidx = 0, line=-1:
+	jmp .L16
+.L16:
+
+	# bb = 21, bbidx = 0, line=-1:
+	jmp .L13
+.L13:
+
+	# bb = 22, bbidx = 0, line=-1:
+	jmp .L0
+.L0:
+	movq -8(%rbp),%rax
+	movq -96(%rbp),%rcx
+	movq -104(%rbp),%rdx
+	movq -112(%rbp),%rbx
+	movq -120(%rbp),%rsi
+	movq -128(%rbp),%rdi
+	movq %rbp,%rsp
+	popq %rbp
+	ret
+.globl std$strncmp
+std$strncmp:
+	pushq %rbp
+	movq %rsp,%rbp
+	subq $96,%rsp
+	movq %rcx,-64(%rbp)
+	movq %rdx,-72(%rbp)
+	movq %rsi,-80(%rbp)
+	movq %rdi,-88(%rbp)
+	movq %r8,-96(%rbp)
+	movq %rdi,-8(%rbp)
+	movq %rsi,-24(%rbp)
+	movq %rdx,-16(%rbp)
+	movq %rcx,-40(%rbp)
+	movq %r8,-32(%rbp)
+	movq %r9,-48(%rbp)
+
+	# bb = 1, bbidx = 0, line=50:
+	leaq -24(%rbp),%rax
+	movq 8(%rax),%rdi
+	movq -48(%rbp),%rsi
+	call std$min$22$130637113
+
+	# bb = 1, bbidx = 1, line=50:
+	leaq -24(%rbp),%rcx
+	movl $0,%edx
+	movl %edx,%edx
+	movq (%rcx),%rcx
+	addq %rdx,%rcx
+	leaq -24(%rbp),%rdx
+	movq %rcx,(%rdx)
+
+	# bb = 1, bbidx = 2, line=50:
+	movl $0,%ecx
+	movl %ecx,%ecx
+	subq %rcx,%rax
+	leaq -24(%rbp),%rcx
+	movq %rax,8(%rcx)
+
+	# bb = 1, bbidx = 3, line=50:
+
+	# bb = 1, bbidx = 4, line=51:
+	leaq -40(%rbp),%rax
+	movq 8(%rax),%rdi
+	movq -48(%rbp),%rsi
+	call std$min$22$130637113
+
+	# bb = 1, bbidx = 5, line=51:
+	leaq -40(%rbp),%rcx
+	movl $0,%edx
+	movl %edx,%edx
+	movq (%rcx),%rcx
+	addq %rdx,%rcx
+	leaq -40(%rbp),%rdx
+	movq %rcx,(%rdx)
+
+	# bb = 1, bbidx = 6, line=51:
+	movl $0,%ecx
+	movl %ecx,%ecx
+	subq %rcx,%rax
+	leaq -40(%rbp),%rcx
+	movq %rax,8(%rcx)
+
+	# bb = 1, bbidx = 7, line=51:
+
+	# bb = 1, bbidx = 8, line=52:
+	leaq -56(%rbp),%rdi
+	leaq -24(%rbp),%rax
+	movq (%rax),%rsi
+	movq 8(%rax),%rdx
+	leaq -40(%rbp),%rax
+	movq (%rax),%rcx
+	movq 8(%rax),%r8
+	call std$strcmp
+
+	# bb = 1, bbidx = 9, line=52:
+	leaq -56(%rbp),%rsi
+	movq -8(%rbp),%rdi
+	movq $8,%rcx
+	rep movsb
+
+	# bb = 1, bbidx = 10, line=-1:
+	jmp .L17
+.L17:
+	movq -8(%rbp),%rax
+	movq -64(%rbp),%rcx
+	movq -72(%rbp),%rdx
+	movq -80(%rbp),%rsi
+	movq -88(%rbp),%rdi
+	movq -96(%rbp),%r8
+	movq %rbp,%rsp
+	popq %rbp
+	ret
+std$min$22$256357945:
+	pushq %rbp
+	movq %rsp,%rbp
+	subq $8,%rsp
+	movl %edi,-4(%rbp)
+	movl %esi,-8(%rbp)
+
+	# bb = 1, bbidx = 0, line=7:
+	movl -4(%rbp),%eax
+	cmpl  -8(%rbp),%eax
+	jl .L19
+	jmp .L20
+.L19:
+
+	# bb = 2, bbidx = 0, line=6:
+	movl -4(%rbp),%eax
+
+	# bb = 2, bbidx = 1, line=-1:
+	jmp .L18
+
+	# bb = 3, bbidx = 0, line=-1:
+	jmp .L21
+.L20:
+
+	# bb = 4, bbidx = 0, line=6:
+	movl -8(%rbp),%eax
+
+	# bb = 4, bbidx = 1, line=-1:
+	jmp .L18
+
+	# bb = 5, bbidx = 0, line=-1:
+	jmp .L21
+.L21:
+
+	# bb = 6, bbidx = 0, line=-1:
+	jmp .L18
+.L18:
+	movq %rbp,%rsp
+	popq %rbp
+	ret
+std$min$22$130637113:
+	pushq %rbp
+	movq %rsp,%rbp
+	subq $16,%rsp
+	movq %rdi,-8(%rbp)
+	movq %rsi,-16(%rbp)
+
+	# bb = 1, bbidx = 0, line=7:
+	movq -8(%rbp),%rax
+	cmpq  -16(%rbp),%rax
+	jb .L23
+	jmp .L24
+.L23:
+
+	# bb = 2, bbidx = 0, line=6:
+	movq -8(%rbp),%rax
+
+	# bb = 2, bbidx = 1, line=-1:
+	jmp .L22
+
+	# bb = 3, bbidx = 0, line=-1:
+	jmp .L25
+.L24:
+
+	# bb = 4, bbidx = 0, line=6:
+	movq -16(%rbp),%rax
+
+	# bb = 4, bbidx = 1, line=-1:
+	jmp .L22
+
+	# bb = 5, bbidx = 0, line=-1:
+	jmp .L25
+.L25:
+
+	# bb = 6, bbidx = 0, line=-1:
+	jmp .L22
+.L22:
+	movq %rbp,%rsp
+	popq %rbp
+	ret
+.data
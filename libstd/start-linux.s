@@ -101,6 +101,8 @@ _start:
         call cvt
 	pushq %rsi
 	pushq %rdx
+	/* and in registers, for the register convention */
+	movq %rdx,%rdi
 
 	/* enter the main program */
 	call	main
@@ -109,3 +111,5 @@ _start:
 	movq	$60,%rax
 	syscall
 
+/* our stack is not executable */
+.section .note.GNU-stack,"",@progbits
@@ -99,6 +99,8 @@ start:
         call cvt
 	pushq %rsi
 	pushq %rdx
+	/* and in registers, for the register convention */
+	movq %rdx,%rdi
 
 	/* enter the main program */
 	call	_main
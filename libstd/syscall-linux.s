@@ -21,3 +21,5 @@ std$syscall:
 	popq %rbp
 	ret
 
+/* our stack is not executable */
+.section .note.GNU-stack,"",@progbits
@@ -12,7 +12,7 @@
 .globl _std$cstring
 _std$cstring:
 std$cstring:
-	movq (%rsp),%r15	/* ret addr */
+	movq (%rsp),%r11	/* ret addr */
 	movq 8(%rsp),%rsi	/* src */
 	movq 16(%rsp),%rcx	/* len */
 	
@@ -27,21 +27,24 @@ std$cstring:
 	rep movsb
 	movb $0,(%rdi)          /* terminate */
 	
-	pushq %r15              /* ret addr */
+	pushq %r11              /* ret addr */
 	ret
 
 .globl std$alloca
 .globl _std$alloca
 _std$alloca:
 std$alloca:
-	movq (%rsp),%r15	/* ret addr */
-	movq 8(%rsp),%rbx	/* len */
+	movq (%rsp),%r11	/* ret addr */
+	movq 8(%rsp),%rdx	/* len */
 	
 	/* get stack space */
-	subq %rbx,%rsp          /* get stack space */
+	subq %rdx,%rsp          /* get stack space */
 	movq %rsp,%rax          /* top of stack (return value) */
 	subq $16,%rsp		/* "unpop" the args for return */
 	andq $(~15),%rsp        /* align */
 
-	pushq %r15              /* ret addr */
+	pushq %r11              /* ret addr */
 	ret
+
+/* our stack is not executable */
+.section .note.GNU-stack,"",@progbits
@@ -0,0 +1,19 @@
+.data
+.text
+.globl std$vastart
+std$vastart:
+	pushq %rbp
+	movq %rsp,%rbp
+	subq $8,%rsp
+	movq %rdi,-8(%rbp)
+
+	# bb = 1, bbidx = 0, line=21:
+	movq -8(%rbp),%rax
+
+	# bb = 1, bbidx = 1, line=-1:
+	jmp .L0
+.L0:
+	movq %rbp,%rsp
+	popq %rbp
+	ret
+.data
@@ -18,7 +18,7 @@ static Bb *mkbb(Cfg *cfg)
 {
     Bb *bb;
 
-    bb = zalloc(sizeof(Bb));
+    bb = azalloc(&lifetime, sizeof(Bb));
     bb->id = cfg->nextbbid++;
     bb->pred = mkbs();
     bb->succ = mkbs();
@@ -34,6 +34,17 @@ static char *lblstr(Node *n)
     return n->expr.args[0]->lit.lblval;
 }
 
+static void edge(Cfg *cfg, Bb *bb, Node *lbl)
+{
+    Bb *targ;
+
+    targ = htget(cfg->lblmap, lblstr(lbl));
+    if (!targ)
+        die("No bb with label \"%s\"", lblstr(lbl));
+    bsput(bb->succ, targ->id);
+    bsput(targ->pred, bb->id);
+}
+
 static void label(Cfg *cfg, Node *lbl, Bb *bb)
 {
     htput(cfg->lblmap, lblstr(lbl), bb);
@@ -45,6 +56,7 @@ static int addnode(Cfg *cfg, Bb *bb, Node *n)
     switch (exprop(n)) {
         case Ojmp:
         case Ocjmp:
+        case Ojtab:
             lappend(&bb->nl, &bb->nnl, n);
             lappend(&cfg->fixjmp, &cfg->nfixjmp, n);
             lappend(&cfg->fixblk, &cfg->nfixblk, bb);
@@ -76,7 +88,7 @@ static Bb *addlabel(Cfg *cfg, Bb *bb, Node **nl, size_t i)
 {
     /* if the current block assumes fall-through, insert an explicit jump */
     if (i > 0 && nl[i - 1]->type == Nexpr) {
-        if (exprop(nl[i - 1]) != Ocjmp && exprop(nl[i - 1]) != Ojmp)
+        if (exprop(nl[i - 1]) != Ocjmp && exprop(nl[i - 1]) != Ojmp && exprop(nl[i - 1]) != Ojtab)
             addnode(cfg, bb, mkexpr(-1, Ojmp, mklbl(-1, lblstr(nl[i])), NULL));
     }
     if (bb->nnl)
@@ -89,12 +101,12 @@ Cfg *mkcfg(Node **nl, size_t nn)
 {
     Cfg *cfg;
     Bb *pre, *post;
-    Bb *bb, *targ;
-    Node *a, *b;
-    size_t i;
+    Bb *bb;
+    Node *n;
+    size_t i, j;
 
-    cfg = zalloc(sizeof(Cfg));
-    cfg->lblmap = mkht(strhash, streq);
+    cfg = azalloc(&lifetime, sizeof(Cfg));
+    cfg->lblmap = mkht(ihash, ptreq);
     pre = mkbb(cfg);
     bb = mkbb(cfg);
     for (i = 0; i < nn; i++) {
@@ -119,33 +131,23 @@ Cfg *mkcfg(Node **nl, size_t nn)
     bsput(post->pred, cfg->bb[cfg->nbb - 2]->id);
     for (i = 0; i < cfg->nfixjmp; i++) {
         bb = cfg->fixblk[i];
-        switch (exprop(cfg->fixjmp[i])) {
+        n = cfg->fixjmp[i];
+        switch (exprop(n)) {
             case Ojmp:
-                a = cfg->fixjmp[i]->expr.args[0];
-                b = NULL;
+                edge(cfg, bb, n->expr.args[0]);
                 break;
             case Ocjmp:
-                a = cfg->fixjmp[i]->expr.args[1];
-                b = cfg->fixjmp[i]->expr.args[2];
+                edge(cfg, bb, n->expr.args[1]);
+                edge(cfg, bb, n->expr.args[2]);
+                break;
+            case Ojtab:
+                for (j = 1; j < n->expr.nargs; j++)
+                    edge(cfg, bb, n->expr.args[j]);
                 break;
             default:
                 die("Bad jump fix thingy");
                 break;
         }
-        if (a) {
-            targ = htget(cfg->lblmap, lblstr(a));
-            if (!targ)
-                die("No bb with label \"%s\"", lblstr(a));
-            bsput(bb->succ, targ->id);
-            bsput(targ->pred, bb->id);
-        }
-        if (b) {
-            targ = htget(cfg->lblmap, lblstr(b));
-            if (!targ)
-                die("No bb with label \"%s\"", lblstr(b));
-            bsput(bb->succ, targ->id);
-            bsput(targ->pred, bb->id);
-        }
     }
     return cfg;
 }
@@ -13,28 +13,611 @@
 #include "parse.h"
 #include "opt.h"
 
+/* state shared while numbering the elements of a problem */
+typedef struct Dfctx Dfctx;
+struct Dfctx {
+    Dfprob *df;
+    Htab *globls;   /* Ovar => symbol, for everything not local */
+    Bitset *esc;    /* locals with their address taken */
+    Htab *vardefs;  /* Ovar => Bitset of defs or exprs it affects */
+    Htab *exprs;    /* Node => index into df->elts */
+};
+
+Dfprob *mkdf(Cfg *cfg, int forward, void (*meet)(Bitset *, Bitset *))
+{
+    Dfprob *df;
+    size_t i;
+
+    df = zalloc(sizeof(Dfprob));
+    df->forward = forward;
+    df->meet = meet;
+    df->boundary = mkbs();
+    df->top = mkbs();
+    df->nbb = cfg->nbb;
+    df->gen = xalloc(cfg->nbb*sizeof(Bitset*));
+    df->kill = xalloc(cfg->nbb*sizeof(Bitset*));
+    df->in = xalloc(cfg->nbb*sizeof(Bitset*));
+    df->out = xalloc(cfg->nbb*sizeof(Bitset*));
+    for (i = 0; i < cfg->nbb; i++) {
+        df->gen[i] = mkbs();
+        df->kill[i] = mkbs();
+        df->in[i] = mkbs();
+        df->out[i] = mkbs();
+    }
+    return df;
+}
+
+void dffree(Dfprob *df)
+{
+    size_t i;
+
+    for (i = 0; i < df->nbb; i++) {
+        bsfree(df->gen[i]);
+        bsfree(df->kill[i]);
+        bsfree(df->in[i]);
+        bsfree(df->out[i]);
+    }
+    free(df->gen);
+    free(df->kill);
+    free(df->in);
+    free(df->out);
+    bsfree(df->boundary);
+    bsfree(df->top);
+    lfree(&df->elts, &df->nelts);
+    free(df);
+}
+
+static void genkill(Dfprob *df, Bb *bb, Bitset *dst, Bitset *src)
+{
+    bsunion(dst, src);
+    bsdiff(dst, df->kill[bb->id]);
+    bsunion(dst, df->gen[bb->id]);
+}
+
+static void postorder(Cfg *cfg, Bb *bb, int forward, Bitset *seen, Bb ***order, size_t *norder)
+{
+    Bitset *next;
+    size_t i;
+
+    bsput(seen, bb->id);
+    next = forward ? bb->succ : bb->pred;
+    for (i = 0; bsiter(next, &i); i++)
+        if (!bshas(seen, i))
+            postorder(cfg, cfg->bb[i], forward, seen, order, norder);
+    lappend(order, norder, bb);
+}
+
 /*
-static void nodeuse(Node *n, Bitset *bs)
+ * Solves df over cfg by iterating to a fixed point. Blocks
+ * are visited in reverse postorder of the direction of
+ * flow, and only once something flowing into them changes:
+ * the worklist is a set of positions in that order, swept
+ * from the front, so a block queued ahead of the sweep is
+ * picked up on the same pass. Anything without a loop
+ * settles in one pass, and loops take about one more pass
+ * per level of nesting.
+ */
+void dfsolve(Cfg *cfg, Dfprob *df)
 {
+    Bitset *work, *seen, *prev, *next, *src, *tmp;
+    Bitset **from, **to;
+    Bb **order, *bb;
+    size_t norder, i, j, *pos;
+    void (*transfer)(Dfprob *df, Bb *bb, Bitset *dst, Bitset *src);
+
+    order = NULL;
+    norder = 0;
+    seen = mkbs();
+    /* unreachable blocks still get an answer */
+    for (i = 0; i < cfg->nbb; i++) {
+        j = df->forward ? i : cfg->nbb - i - 1;
+        if (!bshas(seen, j))
+            postorder(cfg, cfg->bb[j], df->forward, seen, &order, &norder);
+    }
+    pos = xalloc(cfg->nbb*sizeof(size_t));
+    work = mkbs();
+    for (i = 0; i < norder; i++) {
+        pos[order[norder - i - 1]->id] = i;
+        bsput(work, i);
+    }
+
+    /* 'from' holds what flows into a block, 'to' what leaves it */
+    from = df->forward ? df->in : df->out;
+    to = df->forward ? df->out : df->in;
+    for (i = 0; i < cfg->nbb; i++) {
+        bsclear(to[i]);
+        bsunion(to[i], df->top);
+    }
+    transfer = df->transfer ? df->transfer : genkill;
+    tmp = mkbs();
+    df->npass = 0;
+    df->nvisit = 0;
+    while (bscount(work) != 0) {
+        df->npass++;
+        for (i = 0; bsiter(work, &i); i++) {
+            bsdel(work, i);
+            bb = order[norder - i - 1];
+            prev = df->forward ? bb->pred : bb->succ;
+            next = df->forward ? bb->succ : bb->pred;
+
+            src = bsclear(from[bb->id]);
+            if (bscount(prev) == 0) {
+                bsunion(src, df->boundary);
+            } else {
+                bsunion(src, df->top);
+                for (j = 0; bsiter(prev, &j); j++)
+                    df->meet(src, to[j]);
+            }
+            bsclear(tmp);
+            transfer(df, bb, tmp, src);
+            df->nvisit++;
+            if (bseq(tmp, to[bb->id]))
+                continue;
+            /* swap rather than copy; the old value becomes scratch */
+            src = to[bb->id];
+            to[bb->id] = tmp;
+            tmp = src;
+            for (j = 0; bsiter(next, &j); j++)
+                bsput(work, pos[j]);
+        }
+    }
+    bsfree(tmp);
+    bsfree(work);
+    bsfree(seen);
+    free(pos);
+    lfree(&order, &norder);
 }
 
-static void nodedef(Node *n, Bitset *bs)
+static int isvar(Node *n)
 {
+    return n->type == Nexpr && exprop(n) == Ovar;
 }
 
-static void bbuse(Bb *bb, Bitset *bs)
+static int islocal(Dfctx *ctx, Node *n)
 {
+    return !hthas(ctx->globls, n);
 }
 
-static void bbdef(Bb *bb, Bitset *bs)
+/* locals whose value can only change by assignment to them */
+static int tracked(Dfctx *ctx, Node *n)
 {
+    return isvar(n) && islocal(ctx, n) && !bshas(ctx->esc, n->expr.did);
+}
+
+static void addrtaken(Node *n, Htab *globls, Bitset *esc, int inaddr)
+{
+    size_t i;
+
+    if (n->type != Nexpr)
+        return;
+    if (exprop(n) == Ovar) {
+        if (inaddr && !hthas(globls, n))
+            bsput(esc, n->expr.did);
+        return;
+    }
+    if (exprop(n) == Oaddr)
+        inaddr = 1;
+    for (i = 0; i < n->expr.nargs; i++)
+        addrtaken(n->expr.args[i], globls, esc, inaddr);
+}
+
+/* the decl ids of locals that have their address taken */
+Bitset *escapes(Cfg *cfg, Htab *globls)
+{
+    Bitset *esc;
+    size_t i, j;
+
+    esc = mkbs();
+    for (i = 0; i < cfg->nbb; i++)
+        for (j = 0; j < cfg->bb[i]->nnl; j++)
+            addrtaken(cfg->bb[i]->nl[j], globls, esc, 0);
+    return esc;
 }
-*/
 
-void flow(Cfg *cfg)
+static void initctx(Dfctx *ctx, Cfg *cfg, Dfprob *df, Htab *globls)
 {
+    ctx->df = df;
+    ctx->globls = globls;
+    ctx->esc = escapes(cfg, globls);
+    ctx->vardefs = mkht(varhash, vareq);
+    ctx->exprs = NULL;
+}
+
+static void freectx(Dfctx *ctx)
+{
+    void **k;
+    size_t i, nk;
+
+    k = htkeys(ctx->vardefs, &nk);
+    for (i = 0; i < nk; i++)
+        bsfree(htget(ctx->vardefs, k[i]));
+    free(k);
+    htfree(ctx->vardefs);
+    if (ctx->exprs)
+        htfree(ctx->exprs);
+    bsfree(ctx->esc);
+}
+
+/* the set of defs or exprs for var, created on demand */
+static Bitset *varset(Dfctx *ctx, Node *var)
+{
+    Bitset *bs;
+
+    bs = htget(ctx->vardefs, var);
+    if (!bs) {
+        bs = mkbs();
+        htput(ctx->vardefs, var, bs);
+    }
+    return bs;
+}
+
+/* upward exposed uses and definitions of locals in n */
+static void liveuse(Dfctx *ctx, Node *n, Bitset *use, Bitset *def)
+{
+    Node *lhs;
+    size_t i;
+
+    if (n->type != Nexpr)
+        return;
+    switch (exprop(n)) {
+        case Ovar:
+            if (islocal(ctx, n) && !bshas(def, n->expr.did))
+                bsput(use, n->expr.did);
+            break;
+        case Oset:
+            lhs = n->expr.args[0];
+            liveuse(ctx, n->expr.args[1], use, def);
+            if (isvar(lhs) && islocal(ctx, lhs))
+                bsput(def, lhs->expr.did);
+            else
+                liveuse(ctx, lhs, use, def);
+            break;
+        default:
+            for (i = 0; i < n->expr.nargs; i++)
+                liveuse(ctx, n->expr.args[i], use, def);
+            break;
+    }
+}
+
+/*
+ * Live variables, by decl id. Locals that have their
+ * address taken may be read through a pointer at any
+ * point, so they are live everywhere.
+ */
+Dfprob *dflive(Cfg *cfg, Htab *globls, Node *ret)
+{
+    Dfctx ctx;
+    Dfprob *df;
+    size_t i, j;
+
+    df = mkdf(cfg, 0, bsunion);
+    initctx(&ctx, cfg, df, globls);
+    for (i = 0; i < cfg->nbb; i++) {
+        for (j = 0; j < cfg->bb[i]->nnl; j++)
+            liveuse(&ctx, cfg->bb[i]->nl[j], df->gen[i], df->kill[i]);
+        bsunion(df->gen[i], ctx.esc);
+    }
+    if (ret)
+        bsput(df->boundary, ret->expr.did);
+    freectx(&ctx);
+    dfsolve(cfg, df);
+    return df;
+}
+
+/* numbers the assignments to tracked locals in n */
+static void numberdefs(Dfctx *ctx, Node *n)
+{
+    Node *lhs;
+    size_t i;
+
+    if (n->type != Nexpr)
+        return;
+    for (i = 0; i < n->expr.nargs; i++)
+        numberdefs(ctx, n->expr.args[i]);
+    if (exprop(n) != Oset)
+        return;
+    lhs = n->expr.args[0];
+    if (tracked(ctx, lhs)) {
+        bsput(varset(ctx, lhs), ctx->df->nelts);
+        lappend(&ctx->df->elts, &ctx->df->nelts, n);
+    }
+}
+
+/*
+ * Reaching definitions. The elements are the Oset nodes
+ * that assign to locals; stores through pointers are not
+ * definitions, so locals that have their address taken
+ * are left out entirely.
+ */
+Dfprob *dfreach(Cfg *cfg, Htab *globls)
+{
+    Bitset *gen, *defs;
+    Dfctx ctx;
+    Dfprob *df;
+    size_t i, j, d, *first;
+
+    df = mkdf(cfg, 1, bsunion);
+    initctx(&ctx, cfg, df, globls);
+    /* defs are numbered in block order, so each block's are contiguous */
+    first = xalloc((cfg->nbb + 1)*sizeof(size_t));
+    for (i = 0; i < cfg->nbb; i++) {
+        first[i] = df->nelts;
+        for (j = 0; j < cfg->bb[i]->nnl; j++)
+            numberdefs(&ctx, cfg->bb[i]->nl[j]);
+    }
+    first[cfg->nbb] = df->nelts;
+    for (i = 0; i < cfg->nbb; i++) {
+        gen = df->gen[i];
+        for (d = first[i]; d < first[i + 1]; d++) {
+            defs = varset(&ctx, df->elts[d]->expr.args[0]);
+            bsdiff(gen, defs);
+            bsunion(df->kill[i], defs);
+            bsput(gen, d);
+        }
+    }
+    free(first);
+    freectx(&ctx);
+    dfsolve(cfg, df);
+    return df;
 }
 
-void checkret(Cfg *cfg)
+/* operators that compute a value from their operands alone */
+static int isarith(Op op)
 {
+    switch (op) {
+        case Oadd: case Osub: case Omul: case Odiv: case Omod: case Oneg:
+        case Obor: case Oband: case Obxor: case Obsl: case Obsr: case Obnot:
+        case Olnot: case Oeq: case One: case Ogt: case Oge: case Olt: case Ole:
+        case Ocast: case Otrunc: case Ozwiden: case Oswiden:
+        case Oflt2int: case Oint2flt: case Osllen: case Oslbase:
+        case Ofadd: case Ofsub: case Ofmul: case Ofdiv: case Ofneg:
+        case Ofeq: case Ofne: case Ofgt: case Ofge: case Oflt: case Ofle:
+        case Oueq: case Oune: case Ougt: case Ouge: case Oult: case Oule:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int isintlit(Node *n)
+{
+    Node *l;
+
+    if (exprop(n) != Olit)
+        return 0;
+    l = n->expr.args[0];
+    return l->lit.littype == Lint || l->lit.littype == Lchr || l->lit.littype == Lbool;
+}
+
+static uvlong litval(Node *n)
+{
+    Node *l;
+
+    l = n->expr.args[0];
+    switch (l->lit.littype) {
+        case Lint:      return l->lit.intval;       break;
+        case Lchr:      return l->lit.chrval;       break;
+        case Lbool:     return l->lit.boolval;      break;
+        default:        die("Bad literal in dataflow");     break;
+    }
+    return 0;
+}
+
+/* can n be recomputed anywhere its operands hold the same values? */
+static int isavail(Dfctx *ctx, Node *n)
+{
+    size_t i;
+
+    if (n->type != Nexpr)
+        return 0;
+    if (exprop(n) == Ovar)
+        return tracked(ctx, n);
+    if (exprop(n) == Olit)
+        return isintlit(n);
+    if (!isarith(exprop(n)))
+        return 0;
+    for (i = 0; i < n->expr.nargs; i++)
+        if (!isavail(ctx, n->expr.args[i]))
+            return 0;
+    return 1;
+}
+
+static ulong exprhash(void *p)
+{
+    ulong h;
+    size_t i;
+    Node *n;
+
+    n = p;
+    h = exprop(n);
+    switch (exprop(n)) {
+        case Ovar:      return h*31 + n->expr.did;      break;
+        case Olit:      return h*31 + litval(n);        break;
+        default:
+            for (i = 0; i < n->expr.nargs; i++)
+                h = h*31 + exprhash(n->expr.args[i]);
+            break;
+    }
+    return h;
+}
+
+static int expreq(void *pa, void *pb)
+{
+    Node *a, *b;
+    size_t i;
+
+    a = pa;
+    b = pb;
+    if (exprop(a) != exprop(b) || a->expr.nargs != b->expr.nargs)
+        return 0;
+    if (!tyeq(exprtype(a), exprtype(b)))
+        return 0;
+    switch (exprop(a)) {
+        case Ovar:
+            return a->expr.did == b->expr.did;
+        case Olit:
+            return a->expr.args[0]->lit.littype == b->expr.args[0]->lit.littype &&
+                litval(a) == litval(b);
+        default:
+            for (i = 0; i < a->expr.nargs; i++)
+                if (!expreq(a->expr.args[i], b->expr.args[i]))
+                    return 0;
+            return 1;
+    }
+}
+
+/* adds idx to the kill set of every var that n reads */
+static void exprvars(Dfctx *ctx, Node *n, size_t idx)
+{
+    size_t i;
+
+    if (exprop(n) == Ovar)
+        bsput(varset(ctx, n), idx);
+    else if (exprop(n) != Olit)
+        for (i = 0; i < n->expr.nargs; i++)
+            exprvars(ctx, n->expr.args[i], idx);
+}
+
+static void numberexprs(Dfctx *ctx, Node *n)
+{
+    Dfprob *df;
+    size_t i;
+
+    if (n->type != Nexpr || exprop(n) == Ovar || exprop(n) == Olit)
+        return;
+    for (i = 0; i < n->expr.nargs; i++)
+        numberexprs(ctx, n->expr.args[i]);
+    df = ctx->df;
+    if (isavail(ctx, n) && !hthas(ctx->exprs, n)) {
+        htput(ctx->exprs, n, (void*)df->nelts);
+        exprvars(ctx, n, df->nelts);
+        bsput(df->top, df->nelts);
+        lappend(&df->elts, &df->nelts, n);
+    }
+}
+
+/* expressions computed in n and not clobbered after */
+static void availgen(Dfctx *ctx, Node *n, Bitset *gen, Bitset *kill)
+{
+    Bitset *clobbered;
+    Node *lhs;
+    size_t i;
+
+    if (n->type != Nexpr || exprop(n) == Ovar || exprop(n) == Olit)
+        return;
+    if (exprop(n) == Oset) {
+        lhs = n->expr.args[0];
+        availgen(ctx, n->expr.args[1], gen, kill);
+        if (!tracked(ctx, lhs)) {
+            availgen(ctx, lhs, gen, kill);
+        } else if ((clobbered = htget(ctx->vardefs, lhs)) != NULL) {
+            bsdiff(gen, clobbered);
+            bsunion(kill, clobbered);
+        }
+        return;
+    }
+    for (i = 0; i < n->expr.nargs; i++)
+        availgen(ctx, n->expr.args[i], gen, kill);
+    if (isavail(ctx, n))
+        bsput(gen, (size_t)htget(ctx->exprs, n));
+}
+
+/*
+ * Available expressions. The elements are the distinct
+ * arithmetic expressions over integer constants and
+ * tracked locals; the first occurrence of each stands
+ * for all of them. Only assignments to a local can
+ * change their value, so calls and stores kill nothing.
+ */
+Dfprob *dfavail(Cfg *cfg, Htab *globls)
+{
+    Dfctx ctx;
+    Dfprob *df;
+    size_t i, j;
+
+    df = mkdf(cfg, 1, bsintersect);
+    initctx(&ctx, cfg, df, globls);
+    ctx.exprs = mkht(exprhash, expreq);
+    for (i = 0; i < cfg->nbb; i++)
+        for (j = 0; j < cfg->bb[i]->nnl; j++)
+            numberexprs(&ctx, cfg->bb[i]->nl[j]);
+    for (i = 0; i < cfg->nbb; i++)
+        for (j = 0; j < cfg->bb[i]->nnl; j++)
+            availgen(&ctx, cfg->bb[i]->nl[j], df->gen[i], df->kill[i]);
+    freectx(&ctx);
+    dfsolve(cfg, df);
+    return df;
+}
+
+static void dumpvars(Bitset *bs, FILE *fd)
+{
+    char *sep;
+    size_t i;
+
+    sep = "";
+    fprintf(fd, "{");
+    for (i = 0; bsiter(bs, &i); i++) {
+        fprintf(fd, "%s%s", sep, declname(decls[i]));
+        sep = ",";
+    }
+    fprintf(fd, "}");
+}
+
+static void dumpelts(Bitset *bs, FILE *fd)
+{
+    char *sep;
+    size_t i;
+
+    sep = "";
+    fprintf(fd, "{");
+    for (i = 0; bsiter(bs, &i); i++) {
+        fprintf(fd, "%s%zd", sep, i);
+        sep = ",";
+    }
+    fprintf(fd, "}");
+}
+
+static void dumpsolve(char *name, Dfprob *df, FILE *fd)
+{
+    fprintf(fd, "%s: %zd elements, %zd passes, %zd visits\n",
+            name, df->nelts, df->npass, df->nvisit);
+}
+
+void dumpflow(Cfg *cfg, Htab *globls, Node *ret, FILE *fd)
+{
+    Dfprob *live, *reach, *avail;
+    size_t i;
+
+    live = dflive(cfg, globls, ret);
+    reach = dfreach(cfg, globls);
+    avail = dfavail(cfg, globls);
+    dumpsolve("live", live, fd);
+    dumpsolve("reaching", reach, fd);
+    for (i = 0; i < reach->nelts; i++)
+        fprintf(fd, "\tdef %zd: %s on line %d\n", i,
+                declname(decls[reach->elts[i]->expr.args[0]->expr.did]),
+                reach->elts[i]->line);
+    dumpsolve("available", avail, fd);
+    for (i = 0; i < avail->nelts; i++)
+        fprintf(fd, "\texpr %zd: %s on line %d\n", i,
+                opstr(exprop(avail->elts[i])), avail->elts[i]->line);
+    for (i = 0; i < cfg->nbb; i++) {
+        fprintf(fd, "Bb %zd:\n", i);
+        fprintf(fd, "\tlive in ");
+        dumpvars(live->in[i], fd);
+        fprintf(fd, " out ");
+        dumpvars(live->out[i], fd);
+        fprintf(fd, "\n\treaching in ");
+        dumpelts(reach->in[i], fd);
+        fprintf(fd, " out ");
+        dumpelts(reach->out[i], fd);
+        fprintf(fd, "\n\tavailable in ");
+        dumpelts(avail->in[i], fd);
+        fprintf(fd, " out ");
+        dumpelts(avail->out[i], fd);
+        fprintf(fd, "\n");
+    }
+    dffree(live);
+    dffree(reach);
+    dffree(avail);
 }
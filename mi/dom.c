@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "parse.h"
+#include "opt.h"
+
+static void number(Cfg *cfg, Bb *bb, Bitset *seen, Bb ***po, size_t *npo)
+{
+    size_t i;
+
+    bsput(seen, bb->id);
+    for (i = 0; bsiter(bb->succ, &i); i++)
+        if (!bshas(seen, i))
+            number(cfg, cfg->bb[i], seen, po, npo);
+    bb->po = *npo;
+    lappend(po, npo, bb);
+}
+
+/* walks up from a and b to the nearest block dominating both */
+static Bb *intersect(Bb *a, Bb *b)
+{
+    while (a != b) {
+        while (a->po < b->po)
+            a = a->idom;
+        while (b->po < a->po)
+            b = b->idom;
+    }
+    return a;
+}
+
+/*
+ * Computes the dominator tree and dominance frontiers,
+ * following Cooper, Harvey and Kennedy's "A Simple, Fast
+ * Dominance Algorithm": idoms are refined in reverse
+ * postorder until they stop changing, which for the
+ * graphs we build takes two or three sweeps.
+ */
+void dom(Cfg *cfg)
+{
+    Bb **po, *bb, *idom, *p, *r;
+    Bitset *seen;
+    size_t i, j, npo;
+    int changed;
+
+    for (i = 0; i < cfg->nbb; i++) {
+        bb = cfg->bb[i];
+        bb->idom = NULL;
+        lfree(&bb->dtree, &bb->ndtree);
+        if (bb->front)
+            bsclear(bb->front);
+        else
+            bb->front = mkbs();
+    }
+
+    po = NULL;
+    npo = 0;
+    seen = mkbs();
+    number(cfg, cfg->bb[0], seen, &po, &npo);
+    cfg->bb[0]->idom = cfg->bb[0];
+    changed = 1;
+    while (changed) {
+        changed = 0;
+        for (i = npo - 1; i-- > 0;) {
+            bb = po[i];
+            idom = NULL;
+            for (j = 0; bsiter(bb->pred, &j); j++) {
+                p = cfg->bb[j];
+                if (!p->idom)
+                    continue;
+                idom = idom ? intersect(p, idom) : p;
+            }
+            if (bb->idom != idom) {
+                bb->idom = idom;
+                changed = 1;
+            }
+        }
+    }
+
+    for (i = 0; i + 1 < npo; i++)
+        lappend(&po[i]->idom->dtree, &po[i]->idom->ndtree, po[i]);
+    for (i = 0; i < npo; i++) {
+        bb = po[i];
+        if (bscount(bb->pred) < 2)
+            continue;
+        for (j = 0; bsiter(bb->pred, &j); j++) {
+            r = cfg->bb[j];
+            if (!r->idom)
+                continue;
+            while (r != bb->idom) {
+                bsput(r->front, bb->id);
+                r = r->idom;
+            }
+        }
+    }
+    bsfree(seen);
+    lfree(&po, &npo);
+}
+
+/* does a dominate b? both must be reachable */
+int dominates(Bb *a, Bb *b)
+{
+    while (b != a && b->idom != b)
+        b = b->idom;
+    return a == b;
+}
@@ -0,0 +1,574 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "parse.h"
+#include "opt.h"
+
+/*
+ * A value: an operator applied to other values. Values
+ * are hash consed, so two expressions compute the same
+ * thing exactly when they map to the same Vn.
+ */
+typedef struct Vn Vn;
+struct Vn {
+    Op op;
+    Type *ty;
+    Vn *args[2];
+    size_t nargs;
+    size_t did;         /* Ovar and Oaddr leaves */
+    uvlong lit;         /* Olit leaves */
+    size_t stamp;       /* the memory it was read from, for loads */
+
+    /* the expression that first computed it */
+    Node **slot;
+    Bb *bb;
+    size_t idx;
+    Node ***uses;       /* the expressions that compute it again */
+    size_t nuses;
+    Node *tmp;          /* what holds it, once something reuses it */
+    Node *def;
+};
+
+typedef struct Gvn Gvn;
+struct Gvn {
+    Cfg *cfg;
+    Htab *tab;          /* Vn => Vn, for the values available here */
+    Htab *vn;           /* ssa variable => its value */
+    Vn **scope;         /* values added, innermost block last */
+    size_t nscope;
+    Vn **all;
+    size_t nall;
+    Vn **reused;        /* the values reused, in order, so that... */
+    size_t nreused;     /* ...reuses inside a reuse can be dropped */
+
+    /* memory versions. Locals whose address is only ever
+     * used to load and store get their own, since nothing
+     * else can write them; everything else shares one. */
+    Bitset *leaked;
+    Htab *local;        /* confined local => index + 1 */
+    size_t nlocal;
+    size_t *lmem;
+    size_t mem;
+    size_t clock;
+    size_t ntmp;
+};
+
+static int isvar(Node *n)
+{
+    return n->type == Nexpr && exprop(n) == Ovar;
+}
+
+static int isphi(Node *n)
+{
+    return exprop(n) == Oset && exprop(n->expr.args[1]) == Ophi;
+}
+
+static int isssa(Gvn *g, Node *n)
+{
+    return isvar(n) && hthas(g->cfg->ssavars, n);
+}
+
+static int isintlit(Node *n)
+{
+    Node *l;
+
+    l = n->expr.args[0];
+    return l->lit.littype == Lint || l->lit.littype == Lchr || l->lit.littype == Lbool;
+}
+
+static uvlong litval(Node *n)
+{
+    Node *l;
+
+    l = n->expr.args[0];
+    switch (l->lit.littype) {
+        case Lint:      return l->lit.intval;       break;
+        case Lchr:      return l->lit.chrval;       break;
+        case Lbool:     return l->lit.boolval;      break;
+        default:        die("Bad literal in gvn");  break;
+    }
+    return 0;
+}
+
+static ulong vnhash(void *p)
+{
+    ulong h;
+    size_t i;
+    Vn *v;
+
+    v = p;
+    h = v->op*31 + v->did;
+    h = h*31 + v->lit;
+    h = h*31 + v->stamp;
+    for (i = 0; i < v->nargs; i++)
+        h = h*31 + (ulong)(uintptr_t)v->args[i];
+    return h;
+}
+
+static int vneq(void *pa, void *pb)
+{
+    Vn *a, *b;
+    size_t i;
+
+    a = pa;
+    b = pb;
+    if (a->op != b->op || a->nargs != b->nargs || a->did != b->did)
+        return 0;
+    if (a->lit != b->lit || a->stamp != b->stamp)
+        return 0;
+    for (i = 0; i < a->nargs; i++)
+        if (a->args[i] != b->args[i])
+            return 0;
+    return tyeq(a->ty, b->ty);
+}
+
+/* worth keeping in a register and reusing */
+static int iscand(Node *n)
+{
+    if (!ispureop[exprop(n)])
+        return 0;
+    switch (exprop(n)) {
+        case Oadd: case Osub: case Omul: case Odiv: case Omod: case Oneg:
+        case Obor: case Oband: case Obxor: case Obsl: case Obsr: case Obnot:
+        case Otrunc: case Ozwiden: case Oswiden: case Oflt2int: case Oint2flt:
+        case Ofadd: case Ofsub: case Ofmul: case Ofdiv: case Ofneg:
+        case Oderef:
+            break;
+        default:
+            return 0;
+    }
+    switch (tybase(exprtype(n))->type) {
+        case Tybool: case Tychar: case Tyint8: case Tyint16: case Tyint:
+        case Tyint32: case Tyint64: case Tylong: case Tybyte: case Tyuint8:
+        case Tyuint16: case Tyuint: case Tyuint32: case Tyuint64: case Tyulong:
+        case Tyfloat32: case Tyfloat64: case Typtr:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* the variable an address points into, if we can tell */
+static Node *root(Node *a)
+{
+    switch (exprop(a)) {
+        case Oaddr:
+            if (isvar(a->expr.args[0]))
+                return a->expr.args[0];
+            if (exprop(a->expr.args[0]) == Oderef)
+                return root(a->expr.args[0]->expr.args[0]);
+            return NULL;
+        case Oadd: case Osub:
+            return root(a->expr.args[0]);
+        default:
+            return NULL;
+    }
+}
+
+/* finds the variables whose address is used for anything but loads and stores */
+static void leaks(Node *n, Bitset *leaked, int inaddr)
+{
+    size_t i;
+
+    if (n->type != Nexpr)
+        return;
+    switch (exprop(n)) {
+        case Oderef:
+            leaks(n->expr.args[0], leaked, 1);
+            break;
+        case Oblit:
+            leaks(n->expr.args[0], leaked, 1);
+            leaks(n->expr.args[1], leaked, 1);
+            leaks(n->expr.args[2], leaked, 0);
+            break;
+        case Oaddr:
+            if (isvar(n->expr.args[0])) {
+                if (!inaddr)
+                    bsput(leaked, n->expr.args[0]->expr.did);
+            } else if (exprop(n->expr.args[0]) == Oderef) {
+                leaks(n->expr.args[0]->expr.args[0], leaked, inaddr);
+            } else {
+                leaks(n->expr.args[0], leaked, 0);
+            }
+            break;
+        case Oadd: case Osub:
+            leaks(n->expr.args[0], leaked, inaddr);
+            leaks(n->expr.args[1], leaked, 0);
+            break;
+        default:
+            for (i = 0; i < n->expr.nargs; i++)
+                leaks(n->expr.args[i], leaked, 0);
+            break;
+    }
+}
+
+/* the locals that only loads and stores can touch */
+static void findlocals(Gvn *g, Node *n)
+{
+    size_t i;
+
+    if (n->type != Nexpr)
+        return;
+    if (isvar(n)) {
+        if (isssa(g, n) || hthas(g->local, n))
+            return;
+        if (decls[n->expr.did]->decl.isglobl || bshas(g->leaked, n->expr.did))
+            return;
+        htput(g->local, n, (void*)++g->nlocal);
+        return;
+    }
+    for (i = 0; i < n->expr.nargs; i++)
+        findlocals(g, n->expr.args[i]);
+}
+
+static int hasimpure(Node *n)
+{
+    size_t i;
+
+    if (n->type != Nexpr)
+        return 0;
+    if (!ispureop[exprop(n)])
+        return 1;
+    for (i = 0; i < n->expr.nargs; i++)
+        if (hasimpure(n->expr.args[i]))
+            return 1;
+    return 0;
+}
+
+/* the version of the memory that v lives in */
+static size_t memof(Gvn *g, Node *v)
+{
+    size_t i;
+
+    if (!v || !(i = (size_t)htget(g->local, v)))
+        return g->mem;
+    return g->lmem[i - 1];
+}
+
+/* something wrote to v, or to anywhere if v is NULL */
+static void clobber(Gvn *g, Node *v)
+{
+    size_t i;
+
+    if (!v || !(i = (size_t)htget(g->local, v)))
+        g->mem = ++g->clock;
+    else
+        g->lmem[i - 1] = ++g->clock;
+}
+
+static Vn *lookup(Gvn *g, Vn *k)
+{
+    Vn *v;
+
+    if ((v = htget(g->tab, k)) != NULL)
+        return v;
+    v = xalloc(sizeof(Vn));
+    *v = *k;
+    htput(g->tab, v, v);
+    lappend(&g->scope, &g->nscope, v);
+    lappend(&g->all, &g->nall, v);
+    return v;
+}
+
+static Vn *leaf(Gvn *g, Node *n)
+{
+    Vn k = {0,};
+
+    k.op = exprop(n);
+    k.ty = exprtype(n);
+    switch (exprop(n)) {
+        case Ovar:
+            k.did = n->expr.did;
+            if (!isssa(g, n) && !decls[n->expr.did]->decl.isconst)
+                k.stamp = memof(g, n);
+            break;
+        case Oaddr:
+            k.did = n->expr.args[0]->expr.did;
+            break;
+        case Olit:
+            k.lit = litval(n);
+            break;
+        default:
+            die("Bad leaf in gvn");
+            break;
+    }
+    return lookup(g, &k);
+}
+
+/* numbers the expression at *slot, and everything under it */
+static Vn *number(Gvn *g, Node **slot, Bb *bb, size_t idx)
+{
+    Vn k = {0,}, *a[2] = {NULL, NULL}, *v;
+    Node *n;
+    size_t i, mark;
+    int ok;
+
+    n = *slot;
+    if (n->type != Nexpr)
+        return NULL;
+    switch (exprop(n)) {
+        case Ovar:
+            /* a use of a copy is a use of what it copied */
+            v = isssa(g, n) ? htget(g->vn, n) : NULL;
+            if (v && tyeq(v->ty, exprtype(n)))
+                return v;
+            return leaf(g, n);
+        case Olit:
+            return isintlit(n) ? leaf(g, n) : NULL;
+        case Oaddr:
+            if (isvar(n->expr.args[0]))
+                return leaf(g, n);
+            if (exprop(n->expr.args[0]) == Oderef)
+                number(g, &n->expr.args[0]->expr.args[0], bb, idx);
+            else
+                number(g, &n->expr.args[0], bb, idx);
+            return NULL;
+        default:
+            break;
+    }
+
+    ok = iscand(n) && n->expr.nargs <= 2;
+    mark = g->nreused;
+    for (i = 0; i < n->expr.nargs; i++) {
+        v = number(g, &n->expr.args[i], bb, idx);
+        if (i < 2)
+            a[i] = v;
+        ok = ok && v;
+    }
+    if (!ok)
+        return NULL;
+    k.op = exprop(n);
+    k.ty = exprtype(n);
+    k.nargs = n->expr.nargs;
+    for (i = 0; i < k.nargs; i++)
+        k.args[i] = a[i];
+    if (exprop(n) == Oderef)
+        k.stamp = memof(g, root(n->expr.args[0]));
+    if ((v = htget(g->tab, &k)) != NULL) {
+        /* the whole tree goes, so nothing under it is reused */
+        for (i = mark; i < g->nreused; i++)
+            g->reused[i]->nuses--;
+        g->nreused = mark;
+        lappend(&v->uses, &v->nuses, slot);
+        lappend(&g->reused, &g->nreused, v);
+        return v;
+    }
+    k.slot = slot;
+    k.bb = bb;
+    k.idx = idx;
+    return lookup(g, &k);
+}
+
+static void numberstmt(Gvn *g, Bb *bb, size_t idx)
+{
+    Node *n, *lhs;
+    size_t i;
+    int impure;
+    Vn *v;
+
+    n = bb->nl[idx];
+    if (isphi(n)) {
+        htput(g->vn, n->expr.args[0], leaf(g, n->expr.args[0]));
+        return;
+    }
+    /* we don't know when a call happens relative to the loads around it */
+    impure = hasimpure(n);
+    if (impure)
+        clobber(g, NULL);
+    switch (exprop(n)) {
+        case Oset:
+            lhs = n->expr.args[0];
+            v = number(g, &n->expr.args[1], bb, idx);
+            if (isssa(g, lhs)) {
+                htput(g->vn, lhs, v ? v : leaf(g, lhs));
+            } else if (isvar(lhs)) {
+                clobber(g, lhs);
+            } else if (exprop(lhs) == Oderef) {
+                number(g, &lhs->expr.args[0], bb, idx);
+                clobber(g, root(lhs->expr.args[0]));
+            } else {
+                number(g, &n->expr.args[0], bb, idx);
+                clobber(g, NULL);
+            }
+            break;
+        case Oblit:
+            for (i = 0; i < n->expr.nargs; i++)
+                number(g, &n->expr.args[i], bb, idx);
+            clobber(g, root(n->expr.args[0]));
+            break;
+        default:
+            for (i = 0; i < n->expr.nargs; i++)
+                number(g, &n->expr.args[i], bb, idx);
+            break;
+    }
+    if (impure)
+        clobber(g, NULL);
+}
+
+/*
+ * Walks the dominator tree, so the values computed in a
+ * block are available to everything it dominates. Loads
+ * are only reused within an extended basic block: a block
+ * with a single predecessor continues its memory versions,
+ * and any other starts afresh.
+ */
+static void walk(Gvn *g, Bb *bb)
+{
+    size_t i, mark, mem, *lmem;
+    Bb *pred;
+
+    mem = g->mem;
+    lmem = memdup(g->lmem, g->nlocal*sizeof(size_t));
+    pred = NULL;
+    if (bscount(bb->pred) == 1) {
+        i = 0;
+        bsiter(bb->pred, &i);
+        pred = g->cfg->bb[i];
+    }
+    if (pred != bb->idom) {
+        clobber(g, NULL);
+        for (i = 0; i < g->nlocal; i++)
+            g->lmem[i] = g->mem;
+    }
+
+    mark = g->nscope;
+    for (i = 0; i < bb->nnl; i++)
+        numberstmt(g, bb, i);
+    for (i = 0; i < bb->ndtree; i++)
+        walk(g, bb->dtree[i]);
+    for (i = mark; i < g->nscope; i++)
+        htdel(g->tab, g->scope[i]);
+    g->nscope = mark;
+
+    g->mem = mem;
+    memcpy(g->lmem, lmem, g->nlocal*sizeof(size_t));
+    free(lmem);
+}
+
+static Node *mktmp(Gvn *g, Node *n)
+{
+    char buf[128];
+    Node *d, *r;
+
+    snprintf(buf, sizeof buf, ".v%zd", g->ntmp++);
+    d = mkdecl(n->line, mkname(n->line, buf), exprtype(n));
+    r = mkexpr(n->line, Ovar, d->decl.name, NULL);
+    r->expr.type = exprtype(n);
+    r->expr.did = d->decl.did;
+    htput(g->cfg->ssavars, r, r);
+    return r;
+}
+
+static Node *use(Node *v, Node *n)
+{
+    Node *r;
+
+    r = mkexpr(n->line, Ovar, v->expr.args[0], NULL);
+    r->expr.type = exprtype(n);
+    r->expr.did = v->expr.did;
+    return r;
+}
+
+/* puts the values that get reused into variables, and reuses them */
+static void rewrite(Gvn *g)
+{
+    Node *n, **nl;
+    size_t i, j, k, nnl;
+    Vn *v, ***mat;
+    size_t *nmat;
+    Bb *bb;
+
+    mat = zalloc(g->cfg->nbb*sizeof(Vn**));
+    nmat = zalloc(g->cfg->nbb*sizeof(size_t));
+    for (i = 0; i < g->nall; i++) {
+        v = g->all[i];
+        if (!v->nuses)
+            continue;
+        n = v->bb->nl[v->idx];
+        if (exprop(n) == Oset && v->slot == &n->expr.args[1] && isssa(g, n->expr.args[0])) {
+            v->tmp = n->expr.args[0];
+        } else {
+            n = *v->slot;
+            v->tmp = mktmp(g, n);
+            v->def = mkexpr(n->line, Oset, v->tmp, n, NULL);
+            v->def->expr.type = exprtype(n);
+            *v->slot = use(v->tmp, n);
+            lappend(&mat[v->bb->id], &nmat[v->bb->id], v);
+        }
+        for (j = 0; j < v->nuses; j++)
+            *v->uses[j] = use(v->tmp, *v->uses[j]);
+    }
+
+    for (i = 0; i < g->cfg->nbb; i++) {
+        if (!nmat[i])
+            continue;
+        bb = g->cfg->bb[i];
+        nl = NULL;
+        nnl = 0;
+        k = 0;
+        for (j = 0; j < bb->nnl; j++) {
+            for (; k < nmat[i] && mat[i][k]->idx == j; k++)
+                lappend(&nl, &nnl, mat[i][k]->def);
+            lappend(&nl, &nnl, bb->nl[j]);
+        }
+        lfree(&bb->nl, &bb->nnl);
+        lfree(&mat[i], &nmat[i]);
+        bb->nl = nl;
+        bb->nnl = nnl;
+    }
+    free(mat);
+    free(nmat);
+}
+
+/*
+ * Global value numbering over ssa form. Any pure scalar
+ * expression that a dominating block already computed is
+ * replaced by a variable holding the earlier result, so
+ * the address arithmetic that simplification repeats for
+ * every s[i].field is done once.
+ */
+void gvn(Cfg *cfg)
+{
+    Gvn g = {0,};
+    size_t i, j;
+
+    assert(cfg->ssavars != NULL);
+    dom(cfg);
+    g.cfg = cfg;
+    g.tab = mkht(vnhash, vneq);
+    g.vn = mkht(varhash, vareq);
+    g.local = mkht(varhash, vareq);
+    g.leaked = mkbs();
+    for (i = 0; i < cfg->nbb; i++)
+        for (j = 0; j < cfg->bb[i]->nnl; j++)
+            leaks(cfg->bb[i]->nl[j], g.leaked, 0);
+    for (i = 0; i < cfg->nbb; i++)
+        for (j = 0; j < cfg->bb[i]->nnl; j++)
+            findlocals(&g, cfg->bb[i]->nl[j]);
+    g.lmem = zalloc(g.nlocal*sizeof(size_t));
+
+    walk(&g, cfg->bb[0]);
+    rewrite(&g);
+
+    for (i = 0; i < g.nall; i++) {
+        lfree(&g.all[i]->uses, &g.all[i]->nuses);
+        free(g.all[i]);
+    }
+    lfree(&g.all, &g.nall);
+    lfree(&g.scope, &g.nscope);
+    lfree(&g.reused, &g.nreused);
+    free(g.lmem);
+    bsfree(g.leaked);
+    htfree(g.tab);
+    htfree(g.vn);
+    htfree(g.local);
+}
@@ -1,5 +1,6 @@
 typedef struct Cfg Cfg;
 typedef struct Bb Bb;
+typedef struct Dfprob Dfprob;
 
 struct  Cfg {
     Bb **bb;
@@ -14,6 +15,9 @@ struct  Cfg {
     size_t nfixjmp;
     Bb **fixblk;
     size_t nfixblk;
+
+    /* while in ssa form: Ovar => the variable it is a version of */
+    Htab *ssavars;
 };
 
 struct Bb {
@@ -24,6 +28,41 @@ struct Bb {
     size_t nnl;
     Bitset *pred;
     Bitset *succ;
+
+    /* filled in by dom(). idom is NULL for unreachable blocks,
+     * and the entry block is its own idom */
+    Bb *idom;
+    Bb **dtree;         /* blocks immediately dominated by this one */
+    size_t ndtree;
+    Bitset *front;      /* dominance frontier */
+    size_t po;          /* postorder number */
+};
+
+/* A bit vector dataflow problem over a Cfg. The solver
+ * fills in 'in' and 'out', indexed by block id. */
+struct Dfprob {
+    int forward;        /* direction of flow */
+    /* combines the values flowing into a block: bsunion or bsintersect */
+    void (*meet)(Bitset *acc, Bitset *v);
+    /* computes 'dst' from 'src' across bb: out from in
+     * going forward, in from out going backward. If NULL,
+     * dst = gen[bb] + (src - kill[bb]) */
+    void (*transfer)(Dfprob *df, Bb *bb, Bitset *dst, Bitset *src);
+    Bitset *boundary;   /* flows into the entry (forward) or exit (backward) */
+    Bitset *top;        /* the identity of meet; all of 'elts' for bsintersect */
+    Bitset **gen;
+    Bitset **kill;
+    void *ctx;          /* for the transfer function */
+
+    /* what the bits stand for, if they aren't decl ids */
+    Node **elts;
+    size_t nelts;
+
+    Bitset **in;
+    Bitset **out;
+    size_t nbb;
+    size_t nvisit;      /* blocks transferred while solving */
+    size_t npass;       /* sweeps over the worklist */
 };
 
 /* expression folding */
@@ -31,4 +70,24 @@ Node *fold(Node *n, int foldvar);
 /* Takes a reduced block, and returns a flow graph. */
 Cfg *mkcfg(Node **nl, size_t nn);
 void dumpcfg(Cfg *c, FILE *fd);
-void flow(Cfg *cfg);
+
+/* dataflow */
+Dfprob *mkdf(Cfg *cfg, int forward, void (*meet)(Bitset *, Bitset *));
+void dfsolve(Cfg *cfg, Dfprob *df);
+void dffree(Dfprob *df);
+/* variables are the Ovar nodes not in 'globls'; 'ret' is live on exit */
+Dfprob *dflive(Cfg *cfg, Htab *globls, Node *ret);
+Dfprob *dfreach(Cfg *cfg, Htab *globls);
+Dfprob *dfavail(Cfg *cfg, Htab *globls);
+void dumpflow(Cfg *cfg, Htab *globls, Node *ret, FILE *fd);
+Bitset *escapes(Cfg *cfg, Htab *globls);
+
+/* dominators and ssa form */
+void dom(Cfg *cfg);
+int dominates(Bb *a, Bb *b);
+void ssa(Cfg *cfg, Htab *globls, Node *ret);
+void unssa(Cfg *cfg);
+size_t predidx(Bb *bb, Bb *pred);
+/* passes over ssa form */
+void sccp(Cfg *cfg);
+void gvn(Cfg *cfg);
@@ -0,0 +1,556 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "parse.h"
+#include "opt.h"
+
+/* what we know about a value: nothing yet, one constant, or that it varies */
+enum {
+    Vtop,
+    Vconst,
+    Vbot,
+};
+
+typedef struct Sccp Sccp;
+struct Sccp {
+    Cfg *cfg;
+    Htab *idx;          /* ssa variable => index + 1 */
+    Node **var;
+    size_t nvar;
+    int *state;
+    vlong *val;
+    Bitset **users;     /* per variable: the blocks that read it */
+    Bitset **edge;      /* per block: the predecessors it has been reached from */
+    Bitset *reached;
+    Bitset *work;
+};
+
+static int isvar(Node *n)
+{
+    return n->type == Nexpr && exprop(n) == Ovar;
+}
+
+static int isphi(Node *n)
+{
+    return exprop(n) == Oset && exprop(n->expr.args[1]) == Ophi;
+}
+
+/* the width in bits of the integers we track, or 0 */
+static int width(Type *t)
+{
+    switch (tybase(t)->type) {
+        case Tybool: case Tyint8: case Tybyte: case Tyuint8:
+            return 8;
+        case Tyint16: case Tyuint16:
+            return 16;
+        case Tyint: case Tyint32: case Tyuint: case Tyuint32: case Tychar:
+            return 32;
+        case Tyint64: case Tylong: case Tyuint64: case Tyulong: case Typtr:
+            return 64;
+        default:
+            return 0;
+    }
+}
+
+/* wraps v to t, sign or zero extending what is left */
+static vlong norm(uvlong v, Type *t)
+{
+    uvlong m;
+    int w;
+
+    w = width(t);
+    if (w == 64)
+        return v;
+    m = (1ULL << w) - 1;
+    v &= m;
+    if (istysigned(t) && (v >> (w - 1)) & 1)
+        v |= ~m;
+    return v;
+}
+
+/* the table entry a constant index picks: isel zero extends it */
+static uvlong slot(Node *idx, vlong v)
+{
+    int w;
+
+    w = width(exprtype(idx));
+    if (w == 0 || w == 64)
+        return v;
+    return v & ((1ULL << w) - 1);
+}
+
+static Bb *target(Cfg *cfg, Node *lbl)
+{
+    return htget(cfg->lblmap, lbl->expr.args[0]->lit.lblval);
+}
+
+static int eval(Sccp *s, Node *n, vlong *v);
+
+/* evaluates the operands of n, which are all integers */
+static int evalargs(Sccp *s, Node *n, vlong *a)
+{
+    size_t i;
+    int st, r;
+
+    r = Vconst;
+    for (i = 0; i < n->expr.nargs; i++) {
+        st = eval(s, n->expr.args[i], &a[i]);
+        if (st == Vbot)
+            return Vbot;
+        if (st == Vtop)
+            r = Vtop;
+    }
+    return r;
+}
+
+static int evalvar(Sccp *s, Node *n, vlong *v)
+{
+    ssize_t k;
+    Node *d;
+
+    k = (ssize_t)htget(s->idx, n) - 1;
+    if (k >= 0) {
+        *v = norm(s->val[k], exprtype(n));
+        return s->state[k];
+    }
+    /* a constant whose initializer we can work out */
+    d = decls[n->expr.did];
+    if (!d->decl.isconst || d->decl.isextern || !d->decl.init)
+        return Vbot;
+    if (eval(s, d->decl.init, v) != Vconst)
+        return Vbot;
+    *v = norm(*v, exprtype(n));
+    return Vconst;
+}
+
+static int evalphi(Sccp *s, Bb *bb, Node *n, vlong *v)
+{
+    size_t i, k;
+    vlong a;
+    int st, r;
+
+    r = Vtop;
+    k = 0;
+    for (i = 0; bsiter(bb->pred, &i); i++, k++) {
+        if (!bshas(s->edge[bb->id], i))
+            continue;
+        st = eval(s, n->expr.args[k], &a);
+        if (st == Vbot || (st == Vconst && r == Vconst && a != *v))
+            return Vbot;
+        if (st == Vconst) {
+            *v = a;
+            r = Vconst;
+        }
+    }
+    return r;
+}
+
+/*
+ * Works out n the way the machine would: in the width
+ * and signedness of its type. Anything we can't be sure
+ * of, like signed division of negative values, is left
+ * for run time.
+ */
+static int eval(Sccp *s, Node *n, vlong *v)
+{
+    vlong a[2];
+    uvlong x, y;
+    Node *l;
+    int w, st;
+
+    if (n->type != Nexpr || !n->expr.type || !width(exprtype(n)))
+        return Vbot;
+    switch (exprop(n)) {
+        case Olit:
+            l = n->expr.args[0];
+            switch (l->lit.littype) {
+                case Lint:      *v = norm(l->lit.intval, exprtype(n)); return Vconst;
+                case Lchr:      *v = norm(l->lit.chrval, exprtype(n)); return Vconst;
+                case Lbool:     *v = l->lit.boolval != 0; return Vconst;
+                default:        return Vbot;
+            }
+        case Ovar:
+            return evalvar(s, n, v);
+        case Oadd: case Osub: case Omul: case Odiv: case Omod:
+        case Obor: case Oband: case Obxor: case Obsl: case Obsr:
+        case Oneg: case Obnot: case Olnot:
+        case Oeq: case One: case Ogt: case Oge: case Olt: case Ole:
+        case Oueq: case Oune: case Ougt: case Ouge: case Oult: case Oule:
+        case Otrunc: case Ozwiden: case Oswiden:
+            break;
+        default:
+            return Vbot;
+    }
+
+    if (n->expr.nargs > 2 || !width(exprtype(n->expr.args[0])))
+        return Vbot;
+    if (n->expr.nargs == 2 && !width(exprtype(n->expr.args[1])))
+        return Vbot;
+    if ((st = evalargs(s, n, a)) != Vconst)
+        return st;
+    x = a[0];
+    y = n->expr.nargs == 2 ? (uvlong)a[1] : 0;
+    w = width(exprtype(n));
+    switch (exprop(n)) {
+        case Oadd:      x = x + y;      break;
+        case Osub:      x = x - y;      break;
+        case Omul:      x = x * y;      break;
+        case Obor:      x = x | y;      break;
+        case Oband:     x = x & y;      break;
+        case Obxor:     x = x ^ y;      break;
+        case Oneg:      x = -x;         break;
+        case Obnot:     x = ~x;         break;
+        case Olnot:     x = !x;         break;
+        case Odiv: case Omod:
+            /* idiv traps on overflow, so leave that for run time */
+            if (!y || (istysigned(exprtype(n)) && a[1] == -1))
+                return Vbot;
+            if (istysigned(exprtype(n)))
+                x = exprop(n) == Odiv ? a[0] / a[1] : a[0] % a[1];
+            else
+                x = exprop(n) == Odiv ? x / y : x % y;
+            break;
+        case Obsl: case Obsr:
+            if (y >= (uvlong)w)
+                return Vbot;
+            if (exprop(n) == Obsl)
+                x = x << y;
+            else if (istysigned(exprtype(n->expr.args[0])))
+                x = a[0] >> y;
+            else
+                x = x >> y;
+            break;
+        case Oeq: case Oueq:    x = a[0] == a[1];       break;
+        case One: case Oune:    x = a[0] != a[1];       break;
+        case Ogt:               x = a[0] > a[1];        break;
+        case Oge:               x = a[0] >= a[1];       break;
+        case Olt:               x = a[0] < a[1];        break;
+        case Ole:               x = a[0] <= a[1];       break;
+        /* unsigned compares see the operands zero extended */
+        case Ougt: case Ouge: case Oult: case Oule:
+            w = width(exprtype(n->expr.args[0]));
+            if (w < 64) {
+                x &= (1ULL << w) - 1;
+                y &= (1ULL << w) - 1;
+            }
+            switch (exprop(n)) {
+                case Ougt:      x = x > y;      break;
+                case Ouge:      x = x >= y;     break;
+                case Oult:      x = x < y;      break;
+                default:        x = x <= y;     break;
+            }
+            break;
+        case Ozwiden: case Oswiden:
+            w = width(exprtype(n->expr.args[0]));
+            if (w < 64)
+                x &= (1ULL << w) - 1;
+            if (w < 64 && exprop(n) == Oswiden && (x >> (w - 1)) & 1)
+                x |= ~((1ULL << w) - 1);
+            break;
+        case Otrunc:
+            break;
+        default:
+            die("Bad op %s in sccp", opstr(exprop(n)));
+            break;
+    }
+    *v = norm(x, exprtype(n));
+    return Vconst;
+}
+
+static void markedge(Sccp *s, Bb *from, Bb *to)
+{
+    if (bshas(s->edge[to->id], from->id))
+        return;
+    bsput(s->edge[to->id], from->id);
+    bsput(s->reached, to->id);
+    bsput(s->work, to->id);
+}
+
+static void setvar(Sccp *s, Node *v, int st, vlong val)
+{
+    ssize_t k;
+    size_t i;
+
+    k = (ssize_t)htget(s->idx, v) - 1;
+    if (k < 0 || st == Vtop || s->state[k] == Vbot)
+        return;
+    /* values only ever go down: top, then a constant, then varying */
+    if (s->state[k] == Vconst) {
+        if (st == Vconst && s->val[k] == val)
+            return;
+        st = Vbot;
+    }
+    s->state[k] = st;
+    s->val[k] = val;
+    for (i = 0; bsiter(s->users[k], &i); i++)
+        if (bshas(s->reached, i))
+            bsput(s->work, i);
+}
+
+static void visit(Sccp *s, Bb *bb)
+{
+    Node *n, *last;
+    size_t i;
+    vlong v;
+    int st;
+
+    last = NULL;
+    for (i = 0; i < bb->nnl; i++) {
+        n = bb->nl[i];
+        last = n;
+        if (exprop(n) != Oset || !isvar(n->expr.args[0]))
+            continue;
+        v = 0;
+        if (isphi(n))
+            st = evalphi(s, bb, n->expr.args[1], &v);
+        else
+            st = eval(s, n->expr.args[1], &v);
+        setvar(s, n->expr.args[0], st, v);
+    }
+
+    if (last && exprop(last) == Ojmp) {
+        markedge(s, bb, target(s->cfg, last->expr.args[0]));
+    } else if (last && exprop(last) == Ocjmp) {
+        st = eval(s, last->expr.args[0], &v);
+        if (st == Vbot || (st == Vconst && v))
+            markedge(s, bb, target(s->cfg, last->expr.args[1]));
+        if (st == Vbot || (st == Vconst && !v))
+            markedge(s, bb, target(s->cfg, last->expr.args[2]));
+    } else if (last && exprop(last) == Ojtab) {
+        st = eval(s, last->expr.args[0], &v);
+        for (i = 1; i < last->expr.nargs; i++)
+            if (st == Vbot || (st == Vconst && slot(last->expr.args[0], v) == i - 1))
+                markedge(s, bb, target(s->cfg, last->expr.args[i]));
+    } else {
+        for (i = 0; bsiter(bb->succ, &i); i++)
+            markedge(s, bb, s->cfg->bb[i]);
+    }
+}
+
+static void findusers(Sccp *s, Node *n, Bb *bb)
+{
+    ssize_t k;
+    size_t i;
+
+    if (n->type != Nexpr)
+        return;
+    if (isvar(n) && (k = (ssize_t)htget(s->idx, n) - 1) >= 0)
+        bsput(s->users[k], bb->id);
+    if (exprop(n) == Oset && isvar(n->expr.args[0]))
+        findusers(s, n->expr.args[1], bb);
+    else
+        for (i = 0; i < n->expr.nargs; i++)
+            findusers(s, n->expr.args[i], bb);
+}
+
+/* does v fit in an immediate operand of t's width? */
+static int fitsimm(vlong v, Type *t)
+{
+    return width(t) < 64 || (v >= INT32_MIN && v <= INT32_MAX);
+}
+
+/* replaces every constant computation in n with its value */
+static Node *subst(Sccp *s, Node *n)
+{
+    Node *r;
+    size_t i;
+    vlong v;
+
+    if (n->type != Nexpr || exprop(n) == Olit || exprop(n) == Oaddr)
+        return n;
+    if (eval(s, n, &v) == Vconst && fitsimm(v, exprtype(n))) {
+        r = mkintlit(n->line, v);
+        r->expr.type = exprtype(n);
+        return r;
+    }
+    if (exprop(n) == Oset && isvar(n->expr.args[0])) {
+        n->expr.args[1] = subst(s, n->expr.args[1]);
+    } else {
+        for (i = 0; i < n->expr.nargs; i++)
+            n->expr.args[i] = subst(s, n->expr.args[i]);
+    }
+    return n;
+}
+
+/* takes away the edge, and the arguments it brought to phis */
+static void cutedge(Bb *from, Bb *to)
+{
+    Node *phi;
+    size_t i, k;
+
+    k = predidx(to, from);
+    for (i = 0; i < to->nnl && isphi(to->nl[i]); i++) {
+        phi = to->nl[i]->expr.args[1];
+        memmove(&phi->expr.args[k], &phi->expr.args[k + 1], (phi->expr.nargs - k - 1)*sizeof(Node*));
+        phi->expr.nargs--;
+    }
+    bsdel(from->succ, to->id);
+    bsdel(to->pred, from->id);
+}
+
+static Bitset *renumber(Bitset *bs, size_t *id)
+{
+    Bitset *r;
+    size_t i;
+
+    r = mkbs();
+    for (i = 0; bsiter(bs, &i); i++)
+        bsput(r, id[i]);
+    bsfree(bs);
+    return r;
+}
+
+/*
+ * Drops the blocks that were never reached, keeping the
+ * entry and exit, and renumbers the rest. Dominator info
+ * is stale afterwards, until dom() runs again.
+ */
+static void prune(Sccp *s)
+{
+    size_t i, j, n, *id;
+    Bb **bb;
+    Cfg *cfg;
+
+    cfg = s->cfg;
+    for (i = 0; i < cfg->nbb; i++)
+        for (j = 0; bsiter(cfg->bb[i]->succ, &j); j++)
+            if (!bshas(s->edge[j], i))
+                cutedge(cfg->bb[i], cfg->bb[j]);
+
+    id = xalloc(cfg->nbb*sizeof(size_t));
+    bb = cfg->bb;
+    n = 0;
+    for (i = 0; i < cfg->nbb; i++) {
+        if (bshas(s->reached, i) || i == 0 || i == cfg->nbb - 1) {
+            id[i] = n;
+            bb[n++] = bb[i];
+            continue;
+        }
+        for (j = 0; j < bb[i]->nlbls; j++)
+            htdel(cfg->lblmap, bb[i]->lbls[j]);
+        bsfree(bb[i]->pred);
+        bsfree(bb[i]->succ);
+    }
+    cfg->nbb = n;
+    for (i = 0; i < cfg->nbb; i++) {
+        bb[i]->id = i;
+        bb[i]->pred = renumber(bb[i]->pred, id);
+        bb[i]->succ = renumber(bb[i]->succ, id);
+    }
+    free(id);
+}
+
+/* rewrites what the analysis proved: constants, dead definitions, and branches */
+static void apply(Sccp *s)
+{
+    Node *n, **nl;
+    size_t i, j, nnl;
+    ssize_t k;
+    vlong v;
+    Bb *bb;
+
+    for (i = 0; i < s->cfg->nbb; i++) {
+        bb = s->cfg->bb[i];
+        if (!bshas(s->reached, i)) {
+            lfree(&bb->nl, &bb->nnl);
+            continue;
+        }
+        nl = NULL;
+        nnl = 0;
+        for (j = 0; j < bb->nnl; j++) {
+            n = bb->nl[j];
+            /* a constant's uses all get its value, so it needs no definition */
+            if (exprop(n) == Oset && isvar(n->expr.args[0])) {
+                k = (ssize_t)htget(s->idx, n->expr.args[0]) - 1;
+                if (k >= 0 && s->state[k] == Vconst && fitsimm(s->val[k], exprtype(n->expr.args[0])))
+                    continue;
+            }
+            if (exprop(n) == Ocjmp && eval(s, n->expr.args[0], &v) == Vconst)
+                n = mkexpr(n->line, Ojmp, n->expr.args[v ? 1 : 2], NULL);
+            else if (exprop(n) == Ojtab && eval(s, n->expr.args[0], &v) == Vconst
+                     && slot(n->expr.args[0], v) + 1 < n->expr.nargs)
+                n = mkexpr(n->line, Ojmp, n->expr.args[slot(n->expr.args[0], v) + 1], NULL);
+            else if (!isphi(n))
+                n = subst(s, n);
+            else
+                n->expr.args[1] = subst(s, n->expr.args[1]);
+            lappend(&nl, &nnl, n);
+        }
+        lfree(&bb->nl, &bb->nnl);
+        bb->nl = nl;
+        bb->nnl = nnl;
+    }
+}
+
+/*
+ * Sparse conditional constant propagation, after Wegman
+ * and Zadeck: values flow along the ssa graph, but only
+ * out of blocks some executable edge reaches, so a
+ * branch on a constant keeps the code it skips from
+ * spoiling what is known below it. Must run in ssa form.
+ */
+void sccp(Cfg *cfg)
+{
+    Sccp s = {0,};
+    void **k;
+    size_t i, j, nk, nbb;
+
+    assert(cfg->ssavars != NULL);
+    s.cfg = cfg;
+    s.idx = mkht(varhash, vareq);
+    k = htkeys(cfg->ssavars, &nk);
+    for (i = 0; i < nk; i++) {
+        lappend(&s.var, &s.nvar, k[i]);
+        htput(s.idx, k[i], (void*)s.nvar);
+    }
+    free(k);
+    s.state = xalloc(s.nvar*sizeof(int));
+    s.val = zalloc(s.nvar*sizeof(vlong));
+    s.users = xalloc(s.nvar*sizeof(Bitset*));
+    for (i = 0; i < s.nvar; i++) {
+        /* the variables themselves hold whatever came in */
+        s.state[i] = htget(cfg->ssavars, s.var[i]) == s.var[i] ? Vbot : Vtop;
+        s.users[i] = mkbs();
+    }
+    nbb = cfg->nbb;
+    s.edge = xalloc(nbb*sizeof(Bitset*));
+    for (i = 0; i < nbb; i++) {
+        s.edge[i] = mkbs();
+        for (j = 0; j < cfg->bb[i]->nnl; j++)
+            findusers(&s, cfg->bb[i]->nl[j], cfg->bb[i]);
+    }
+
+    s.reached = mkbs();
+    s.work = mkbs();
+    bsput(s.reached, 0);
+    bsput(s.work, 0);
+    for (i = 0; bsiter(s.work, &i); i = 0) {
+        bsdel(s.work, i);
+        visit(&s, cfg->bb[i]);
+    }
+
+    apply(&s);
+    prune(&s);
+
+    for (i = 0; i < s.nvar; i++)
+        bsfree(s.users[i]);
+    for (i = 0; i < nbb; i++)
+        bsfree(s.edge[i]);
+    free(s.users);
+    free(s.edge);
+    free(s.state);
+    free(s.val);
+    lfree(&s.var, &s.nvar);
+    htfree(s.idx);
+    bsfree(s.reached);
+    bsfree(s.work);
+}
@@ -0,0 +1,599 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "parse.h"
+#include "opt.h"
+
+typedef struct Ssa Ssa;
+struct Ssa {
+    Cfg *cfg;
+    Htab *vars;     /* Ovar => index + 1, for the variables we rename */
+    Node **var;
+    size_t nvar;
+    Node ***stk;    /* per variable, its current version on top */
+    size_t *nstk;
+    size_t *nver;
+};
+
+static int isvar(Node *n)
+{
+    return n->type == Nexpr && exprop(n) == Ovar;
+}
+
+static int isphi(Node *n)
+{
+    return exprop(n) == Oset && exprop(n->expr.args[1]) == Ophi;
+}
+
+static int isjmp(Node *n)
+{
+    return exprop(n) == Ojmp || exprop(n) == Ocjmp || exprop(n) == Ojtab;
+}
+
+/* a copy of n with its own argument list */
+static Node *dupexpr(Node *n)
+{
+    Node *r;
+
+    r = mknode(n->line, Nexpr);
+    r->expr = n->expr;
+    r->expr.args = memdup(n->expr.args, n->expr.nargs*sizeof(Node*));
+    return r;
+}
+
+/* a new variable standing in for v */
+static Node *mkversion(Cfg *cfg, Node *v, char *suffix, size_t n)
+{
+    char buf[128];
+    Node *d, *r;
+
+    snprintf(buf, sizeof buf, "%s.%s%zd", declname(decls[v->expr.did]), suffix, n);
+    d = mkdecl(v->line, mkname(v->line, buf), exprtype(v));
+    r = mkexpr(v->line, Ovar, d->decl.name, NULL);
+    r->expr.type = v->expr.type;
+    r->expr.did = d->decl.did;
+    htput(cfg->ssavars, r, htget(cfg->ssavars, v));
+    return r;
+}
+
+/* the variables that can be renamed: assigned, scalar, and never addressed */
+static void findvars(Ssa *s, Htab *globls, Node *ret)
+{
+    Bitset *esc;
+    Node *n, *v;
+    size_t i, j;
+    Ty t;
+
+    esc = escapes(s->cfg, globls);
+    for (i = 0; i < s->cfg->nbb; i++) {
+        for (j = 0; j < s->cfg->bb[i]->nnl; j++) {
+            n = s->cfg->bb[i]->nl[j];
+            if (exprop(n) != Oset || !isvar(n->expr.args[0]))
+                continue;
+            v = n->expr.args[0];
+            if (hthas(globls, v) || bshas(esc, v->expr.did) || hthas(s->vars, v))
+                continue;
+            /* anything the backend can keep in a register */
+            t = tybase(exprtype(v))->type;
+            if (t == Tyvoid || t == Tyvalist || t >= Tyslice)
+                continue;
+            if (ret && v->expr.did == ret->expr.did)
+                continue;
+            lappend(&s->var, &s->nvar, v);
+            htput(s->vars, v, (void*)s->nvar);
+            htput(s->cfg->ssavars, v, v);
+        }
+    }
+    bsfree(esc);
+}
+
+static Node *mkphi(Node *v, size_t npred)
+{
+    Node **args;
+    size_t i;
+
+    args = xalloc(npred*sizeof(Node*));
+    for (i = 0; i < npred; i++)
+        args[i] = v;
+    return mkexpr(v->line, Oset, v, mkexprl(v->line, Ophi, args, npred), NULL);
+}
+
+/*
+ * Places phis at the iterated dominance frontier of each
+ * variable's definitions, but only where the variable is
+ * live, so that no phi merges a value nobody reads.
+ */
+static void placephis(Ssa *s, Htab *globls, Node *ret)
+{
+    Bitset *defs, *work, *hasphi;
+    Node ***phis, **nl, *n;
+    size_t *nphis, i, j, k, nnl;
+    Dfprob *live;
+    Cfg *cfg;
+    Bb *bb;
+
+    cfg = s->cfg;
+    live = dflive(cfg, globls, ret);
+    phis = zalloc(cfg->nbb*sizeof(Node**));
+    nphis = zalloc(cfg->nbb*sizeof(size_t));
+    defs = mkbs();
+    work = mkbs();
+    hasphi = mkbs();
+    for (k = 0; k < s->nvar; k++) {
+        bsclear(defs);
+        bsclear(hasphi);
+        for (i = 0; i < cfg->nbb; i++) {
+            for (j = 0; j < cfg->bb[i]->nnl; j++) {
+                n = cfg->bb[i]->nl[j];
+                if (exprop(n) == Oset && isvar(n->expr.args[0]) &&
+                    n->expr.args[0]->expr.did == s->var[k]->expr.did)
+                    bsput(defs, i);
+            }
+        }
+        bsunion(bsclear(work), defs);
+        for (i = 0; bsiter(work, &i); i = 0) {
+            bsdel(work, i);
+            bb = cfg->bb[i];
+            if (!bb->idom)
+                continue;
+            for (j = 0; bsiter(bb->front, &j); j++) {
+                if (bshas(hasphi, j) || !bshas(live->in[j], s->var[k]->expr.did))
+                    continue;
+                lappend(&phis[j], &nphis[j], mkphi(s->var[k], bscount(cfg->bb[j]->pred)));
+                bsput(hasphi, j);
+                if (!bshas(defs, j))
+                    bsput(work, j);
+            }
+        }
+    }
+    for (i = 0; i < cfg->nbb; i++) {
+        if (!nphis[i])
+            continue;
+        bb = cfg->bb[i];
+        nl = phis[i];
+        nnl = nphis[i];
+        for (j = 0; j < bb->nnl; j++)
+            lappend(&nl, &nnl, bb->nl[j]);
+        lfree(&bb->nl, &bb->nnl);
+        bb->nl = nl;
+        bb->nnl = nnl;
+    }
+    free(phis);
+    free(nphis);
+    bsfree(defs);
+    bsfree(work);
+    bsfree(hasphi);
+    dffree(live);
+}
+
+static Node *top(Ssa *s, Node *v)
+{
+    Node *r;
+    size_t k;
+
+    k = (size_t)htget(s->vars, htget(s->cfg->ssavars, v)) - 1;
+    /* uses get their own node, so later passes can rewrite them in
+     * place, and keep their type, which a cast may have changed */
+    r = dupexpr(s->stk[k][s->nstk[k] - 1]);
+    r->expr.type = v->expr.type;
+    return r;
+}
+
+static Node *define(Ssa *s, Node *v, Node ***pushed, size_t *npushed)
+{
+    Node *r;
+    size_t k;
+
+    k = (size_t)htget(s->vars, v) - 1;
+    r = mkversion(s->cfg, v, "", ++s->nver[k]);
+    lappend(&s->stk[k], &s->nstk[k], r);
+    lappend(pushed, npushed, v);
+    return r;
+}
+
+/* copies n with every use and definition renamed to its current version */
+static Node *rewrite(Ssa *s, Node *n, Node ***pushed, size_t *npushed)
+{
+    Node *r, *lhs;
+    size_t i;
+
+    if (n->type != Nexpr)
+        return n;
+    switch (exprop(n)) {
+        case Olit:
+            return n;
+        case Ovar:
+            if (!hthas(s->vars, n))
+                return n;
+            return top(s, n);
+        case Oset:
+            r = dupexpr(n);
+            r->expr.args[1] = rewrite(s, n->expr.args[1], pushed, npushed);
+            lhs = n->expr.args[0];
+            if (isvar(lhs) && hthas(s->vars, lhs))
+                r->expr.args[0] = define(s, lhs, pushed, npushed);
+            else
+                r->expr.args[0] = rewrite(s, lhs, pushed, npushed);
+            return r;
+        default:
+            r = dupexpr(n);
+            for (i = 0; i < n->expr.nargs; i++)
+                r->expr.args[i] = rewrite(s, n->expr.args[i], pushed, npushed);
+            return r;
+    }
+}
+
+/* which phi argument comes from pred */
+size_t predidx(Bb *bb, Bb *pred)
+{
+    size_t i, n;
+
+    n = 0;
+    for (i = 0; bsiter(bb->pred, &i) && i < (size_t)pred->id; i++)
+        n++;
+    return n;
+}
+
+static void renamebb(Ssa *s, Bb *bb)
+{
+    Node **pushed, *phi, *v;
+    size_t i, j, k, npushed;
+    Bb *succ;
+
+    pushed = NULL;
+    npushed = 0;
+    for (i = 0; i < bb->nnl; i++) {
+        if (isphi(bb->nl[i])) {
+            phi = dupexpr(bb->nl[i]);
+            v = htget(s->cfg->ssavars, phi->expr.args[0]);
+            phi->expr.args[0] = define(s, v, &pushed, &npushed);
+            bb->nl[i] = phi;
+        } else {
+            bb->nl[i] = rewrite(s, bb->nl[i], &pushed, &npushed);
+        }
+    }
+    for (i = 0; bsiter(bb->succ, &i); i++) {
+        succ = s->cfg->bb[i];
+        k = predidx(succ, bb);
+        for (j = 0; j < succ->nnl && isphi(succ->nl[j]); j++) {
+            phi = succ->nl[j]->expr.args[1];
+            phi->expr.args[k] = top(s, phi->expr.args[k]);
+        }
+    }
+    for (i = 0; i < bb->ndtree; i++)
+        renamebb(s, bb->dtree[i]);
+    for (i = 0; i < npushed; i++) {
+        k = (size_t)htget(s->vars, pushed[i]) - 1;
+        s->nstk[k]--;
+    }
+    lfree(&pushed, &npushed);
+}
+
+/*
+ * Puts cfg into pruned ssa form. Every local scalar that
+ * never has its address taken is split into one version
+ * per assignment, with phis at the joins. The variable
+ * itself remains as the version live on entry, so that
+ * arguments and uninitialized reads keep working.
+ */
+void ssa(Cfg *cfg, Htab *globls, Node *ret)
+{
+    Ssa s = {0,};
+    size_t k;
+
+    s.cfg = cfg;
+    s.vars = mkht(varhash, vareq);
+    cfg->ssavars = mkht(varhash, vareq);
+    findvars(&s, globls, ret);
+    dom(cfg);
+    placephis(&s, globls, ret);
+
+    s.stk = zalloc(s.nvar*sizeof(Node**));
+    s.nstk = zalloc(s.nvar*sizeof(size_t));
+    s.nver = zalloc(s.nvar*sizeof(size_t));
+    for (k = 0; k < s.nvar; k++)
+        lappend(&s.stk[k], &s.nstk[k], s.var[k]);
+    renamebb(&s, cfg->bb[0]);
+
+    for (k = 0; k < s.nvar; k++)
+        lfree(&s.stk[k], &s.nstk[k]);
+    free(s.stk);
+    free(s.nstk);
+    free(s.nver);
+    lfree(&s.var, &s.nvar);
+    htfree(s.vars);
+}
+
+/* the state for coalescing the variables of one ssa form */
+typedef struct Coal Coal;
+struct Coal {
+    Htab *idx;      /* Ovar => index + 1 */
+    Node **var;
+    size_t nvar;
+    Node **name;    /* per class: the variable they all become */
+    size_t *up;     /* union-find parent */
+    Bitset **ig;    /* per class: everything its members interfere with */
+    Bitset **mem;   /* per class: its members */
+};
+
+static Node *mkcopy(Node *dst, Node *src)
+{
+    Node *n;
+
+    n = mkexpr(dst->line, Oset, dst, src, NULL);
+    n->expr.type = exprtype(dst);
+    return n;
+}
+
+/* puts n at the end of bb, but ahead of the jump leaving it */
+static void addcopy(Bb *bb, Node *n)
+{
+    Node *j;
+
+    if (bb->nnl && isjmp(bb->nl[bb->nnl - 1])) {
+        j = bb->nl[bb->nnl - 1];
+        bb->nl[bb->nnl - 1] = n;
+        lappend(&bb->nl, &bb->nnl, j);
+    } else {
+        lappend(&bb->nl, &bb->nnl, n);
+    }
+}
+
+/*
+ * Replaces 'x = phi(a, b)' with 'x = t', and has every
+ * predecessor set 't = a' or 't = b' on its way out. A
+ * block that branches two ways sets t on both, which is
+ * harmless: t is only read by the phi it stands for, and
+ * every way into that block sets it. So no edges need
+ * to be split, and coalescing removes the copies that
+ * nothing depends on.
+ */
+static void lowerphis(Cfg *cfg)
+{
+    Node *dst, *phi, *t;
+    size_t i, j, k, p, ntmp;
+    Bb *bb;
+
+    ntmp = 0;
+    for (i = 0; i < cfg->nbb; i++) {
+        bb = cfg->bb[i];
+        for (j = 0; j < bb->nnl && isphi(bb->nl[j]); j++) {
+            dst = bb->nl[j]->expr.args[0];
+            phi = bb->nl[j]->expr.args[1];
+            t = mkversion(cfg, dst, "phi", ntmp++);
+            k = 0;
+            for (p = 0; bsiter(bb->pred, &p); p++)
+                addcopy(cfg->bb[p], mkcopy(dupexpr(t), phi->expr.args[k++]));
+            bb->nl[j] = mkcopy(dst, dupexpr(t));
+        }
+    }
+}
+
+static ssize_t varidx(Coal *c, Node *n)
+{
+    if (!isvar(n) || !hthas(c->idx, n))
+        return -1;
+    return (ssize_t)htget(c->idx, n) - 1;
+}
+
+/* the variable n assigns, if it is one we coalesce */
+static ssize_t defidx(Coal *c, Node *n)
+{
+    if (exprop(n) != Oset)
+        return -1;
+    return varidx(c, n->expr.args[0]);
+}
+
+/* adds everything n reads to bs */
+static void readset(Coal *c, Node *n, Bitset *bs)
+{
+    ssize_t v;
+    size_t i;
+
+    if (n->type != Nexpr || exprop(n) == Olit)
+        return;
+    if ((v = varidx(c, n)) >= 0) {
+        bsput(bs, v);
+    } else if (exprop(n) == Oset && isvar(n->expr.args[0])) {
+        readset(c, n->expr.args[1], bs);
+    } else {
+        for (i = 0; i < n->expr.nargs; i++)
+            readset(c, n->expr.args[i], bs);
+    }
+}
+
+static size_t find(Coal *c, size_t v)
+{
+    while (c->up[v] != v) {
+        c->up[v] = c->up[c->up[v]];
+        v = c->up[v];
+    }
+    return v;
+}
+
+static int clash(Coal *c, size_t a, size_t b)
+{
+    size_t i;
+
+    for (i = 0; bsiter(c->mem[b], &i); i++)
+        if (bshas(c->ig[a], i))
+            return 1;
+    return 0;
+}
+
+/* builds the interference graph from liveness, walking each block backwards */
+static void interfere(Coal *c, Cfg *cfg)
+{
+    Bitset *live, *rd;
+    ssize_t d, src;
+    size_t i, j, l;
+    Dfprob *df;
+    Node *n;
+
+    df = mkdf(cfg, 0, bsunion);
+    rd = mkbs();
+    for (i = 0; i < cfg->nbb; i++) {
+        for (j = cfg->bb[i]->nnl; j-- > 0;) {
+            n = cfg->bb[i]->nl[j];
+            if ((d = defidx(c, n)) >= 0) {
+                bsdel(df->gen[i], d);
+                bsput(df->kill[i], d);
+            }
+            readset(c, n, bsclear(rd));
+            bsunion(df->gen[i], rd);
+        }
+    }
+    dfsolve(cfg, df);
+
+    live = mkbs();
+    for (i = 0; i < cfg->nbb; i++) {
+        bsunion(bsclear(live), df->out[i]);
+        for (j = cfg->bb[i]->nnl; j-- > 0;) {
+            n = cfg->bb[i]->nl[j];
+            if ((d = defidx(c, n)) >= 0) {
+                /* a copy doesn't make its ends interfere */
+                src = varidx(c, n->expr.args[1]);
+                for (l = 0; bsiter(live, &l); l++) {
+                    if ((ssize_t)l == d || (ssize_t)l == src)
+                        continue;
+                    bsput(c->ig[d], l);
+                    bsput(c->ig[l], d);
+                }
+                bsdel(live, d);
+            }
+            readset(c, n, bsclear(rd));
+            bsunion(live, rd);
+        }
+    }
+    bsfree(live);
+    bsfree(rd);
+    dffree(df);
+}
+
+/* copies n with every coalesced variable renamed */
+static Node *recolour(Coal *c, Node *n)
+{
+    Node *r, *name;
+    ssize_t v;
+    size_t i;
+
+    if (n->type != Nexpr || exprop(n) == Olit)
+        return n;
+    if ((v = varidx(c, n)) >= 0) {
+        name = c->name[find(c, v)];
+        if (name->expr.did == n->expr.did)
+            return n;
+        r = dupexpr(name);
+        r->expr.type = n->expr.type;
+        return r;
+    }
+    r = dupexpr(n);
+    for (i = 0; i < n->expr.nargs; i++)
+        r->expr.args[i] = recolour(c, n->expr.args[i]);
+    return r;
+}
+
+static int isselfcopy(Node *n)
+{
+    return exprop(n) == Oset && isvar(n->expr.args[0]) && isvar(n->expr.args[1]) &&
+        n->expr.args[0]->expr.did == n->expr.args[1]->expr.did;
+}
+
+/*
+ * Takes cfg out of ssa form. The phis become copies, and
+ * then the copies between versions of the same variable
+ * are coalesced wherever the versions' live ranges don't
+ * overlap, renaming each group back to the variable if it
+ * is in the group. A function that nothing was done to
+ * between ssa() and unssa() comes out as it went in.
+ */
+void unssa(Cfg *cfg)
+{
+    Coal c = {0,};
+    void **k;
+    size_t i, j, nk, nnl;
+    ssize_t d, s;
+    Node *n, **nl;
+    Bb *bb;
+
+    lowerphis(cfg);
+
+    c.idx = mkht(varhash, vareq);
+    k = htkeys(cfg->ssavars, &nk);
+    for (i = 0; i < nk; i++) {
+        lappend(&c.var, &c.nvar, k[i]);
+        htput(c.idx, k[i], (void*)c.nvar);
+    }
+    free(k);
+    c.up = xalloc(c.nvar*sizeof(size_t));
+    c.ig = xalloc(c.nvar*sizeof(Bitset*));
+    c.mem = xalloc(c.nvar*sizeof(Bitset*));
+    c.name = xalloc(c.nvar*sizeof(Node*));
+    for (i = 0; i < c.nvar; i++) {
+        c.up[i] = i;
+        c.ig[i] = mkbs();
+        c.mem[i] = mkbs();
+        bsput(c.mem[i], i);
+    }
+    interfere(&c, cfg);
+
+    for (i = 0; i < cfg->nbb; i++) {
+        for (j = 0; j < cfg->bb[i]->nnl; j++) {
+            n = cfg->bb[i]->nl[j];
+            if ((d = defidx(&c, n)) < 0 || (s = varidx(&c, n->expr.args[1])) < 0)
+                continue;
+            if (htget(cfg->ssavars, c.var[d]) != htget(cfg->ssavars, c.var[s]))
+                continue;
+            d = find(&c, d);
+            s = find(&c, s);
+            if (d == s || clash(&c, d, s))
+                continue;
+            c.up[s] = d;
+            bsunion(c.ig[d], c.ig[s]);
+            bsunion(c.mem[d], c.mem[s]);
+        }
+    }
+
+    /* a group keeps the name of the original variable, if it has it */
+    for (i = 0; i < c.nvar; i++)
+        c.name[i] = c.var[find(&c, i)];
+    for (i = 0; i < c.nvar; i++)
+        if (htget(cfg->ssavars, c.var[i]) == c.var[i])
+            c.name[find(&c, i)] = c.var[i];
+
+    for (i = 0; i < cfg->nbb; i++) {
+        bb = cfg->bb[i];
+        nl = NULL;
+        nnl = 0;
+        for (j = 0; j < bb->nnl; j++) {
+            n = recolour(&c, bb->nl[j]);
+            if (!isselfcopy(n))
+                lappend(&nl, &nnl, n);
+        }
+        lfree(&bb->nl, &bb->nnl);
+        bb->nl = nl;
+        bb->nnl = nnl;
+    }
+
+    for (i = 0; i < c.nvar; i++) {
+        bsfree(c.ig[i]);
+        bsfree(c.mem[i]);
+    }
+    free(c.ig);
+    free(c.mem);
+    free(c.up);
+    free(c.name);
+    lfree(&c.var, &c.nvar);
+    htfree(c.idx);
+    htfree(cfg->ssavars);
+    cfg->ssavars = NULL;
+}
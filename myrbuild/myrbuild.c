@@ -5,11 +5,15 @@
 #include <assert.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/file.h>
 #include <sys/wait.h>
 #include <sys/utsname.h>
 #include <ctype.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
+#include <signal.h>
+#include <errno.h>
 #include <regex.h>
 #include <err.h>
 
@@ -33,6 +37,9 @@ char *binname;
 /* additional paths to search for packages */
 char **incpaths;
 size_t nincpaths;
+/* flags passed through to the compiler */
+char **mcflags;
+size_t nmcflags;
 /* libraries to link against, and their deps */
 Htab *libgraph;  /* string -> null terminated string list */
 /* the linker script to use */
@@ -41,17 +48,76 @@ char *ldscript;
 char *sysname;
 
 regex_t usepat;
-Htab *compiled; /* used as string set */
+Htab *compiled; /* file => Job* producing its usefile, or null */
 Htab *loopdetect; /* used as string set */
 
+typedef struct Hash Hash;
+struct Hash {
+    uint64_t hi;
+    uint64_t lo;
+};
+
+/* a command in the build graph */
+typedef struct Job Job;
+struct Job {
+    char **cmd;
+    Job **rdeps;        /* jobs waiting on this one */
+    size_t nrdeps;
+    size_t nwait;       /* unfinished jobs this one waits on */
+    pid_t pid;
+    FILE *out;          /* the job's output, replayed when it finishes */
+    FILE *err;
+    char tok;           /* jobserver token held, or 0 */
+    char *src;          /* the file it builds... */
+    char **inputs;      /* ...the usefiles it reads... */
+    size_t ninputs;
+    char **closure;     /* ...every local usefile behind those... */
+    size_t nclosure;
+    char **libs;        /* ...and every library behind them all */
+    size_t nlibs;
+    char *product;      /* ...and what it writes */
+    char *tool;
+    Hash key;           /* hash of the inputs known up front */
+    char *cachepath;    /* where the product goes in the cache */
+    int cutoff;         /* keep the old product if it doesn't change */
+    char *prev;         /* the old product, while the job runs */
+    char *stamp;        /* built alongside the product, from the same inputs */
+    Job **batch;        /* the jobs run by the same command, this one included */
+    size_t nbatch;
+};
+
+Job **jobs;
+size_t njobs;
+/* how many jobs to run at once; 0 means ask the jobserver */
+long maxjobs = -1;
+int jsrd = -1;  /* GNU make jobserver fds */
+int jswr = -1;
+int chldpipe[2] = {-1, -1};  /* written to when a job exits */
+/* the most files given to one compiler when sharing make's job slots */
+#define Maxbatch 8
+
+/*
+ * The content addressed build cache. Outputs are stored
+ * under a hash of everything that goes into them, so
+ * they survive checkouts and can be shared between trees.
+ */
+char *cachedir;
+size_t cachehits;
+size_t cachemisses;
+int showstats;      /* print the hits and misses after a build */
+
 static void usage(char *prog)
 {
-    printf("%s [-h] [-I path] [-l lib] [-b bin] inputs...\n", prog);
+    printf("%s [-h] [-j jobs] [-I path] [-l lib] [-b bin] inputs...\n", prog);
     printf("\t-h\tprint this help\n");
     printf("\t-b bin\tBuild a binary called 'bin'\n");
     printf("\t-l lib\tBuild a library called 'name'\n");
     printf("\t-s script\tUse the linker script 'script' when linking\n");
     printf("\t-I path\tAdd 'path' to use search path\n");
+    printf("\t-j jobs\tRun up to 'jobs' commands at once\n");
+    printf("\t-c dir\tCache build outputs in 'dir'\n");
+    printf("\t-S\tPrint cache hits and misses\n");
+    printf("\t-F flag\tPass 'flag' to the compiler\n");
 }
 
 int hassuffix(char *path, char *suffix)
@@ -142,7 +208,16 @@ int isfresh(char *from, char *to)
     if (stat(to, &to_sb) == -1)
         return 0;
 
-    return from_sb.st_mtime <= to_sb.st_mtime;
+    /* builds are fast enough that seconds don't tell them apart */
+#ifdef __APPLE__
+    if (from_sb.st_mtimespec.tv_sec != to_sb.st_mtimespec.tv_sec)
+        return from_sb.st_mtimespec.tv_sec < to_sb.st_mtimespec.tv_sec;
+    return from_sb.st_mtimespec.tv_nsec <= to_sb.st_mtimespec.tv_nsec;
+#else
+    if (from_sb.st_mtim.tv_sec != to_sb.st_mtim.tv_sec)
+        return from_sb.st_mtim.tv_sec < to_sb.st_mtim.tv_sec;
+    return from_sb.st_mtim.tv_nsec <= to_sb.st_mtim.tv_nsec;
+#endif
 }
 
 int inlist(char **list, size_t sz, char *str)
@@ -203,82 +278,769 @@ FILE *openlib(char *lib)
     err(1, "could not open library file %s\n", lib);
 }
 
+/* FNV-1a, widened to 128 bits so collisions don't matter */
+void hashbytes(Hash *h, void *buf, size_t n)
+{
+    uint64_t a, b, lo, carry;
+    unsigned char *p;
+    size_t i;
+
+    p = buf;
+    for (i = 0; i < n; i++) {
+        h->lo ^= p[i];
+        /* h *= 2^88 + 0x13b */
+        lo = h->lo;
+        a = lo >> 32;
+        b = lo & 0xffffffff;
+        carry = (a*0x13b + ((b*0x13b) >> 32)) >> 32;
+        h->lo = lo*0x13b;
+        h->hi = h->hi*0x13b + carry + (lo << 24);
+    }
+}
+
+void hashinit(Hash *h)
+{
+    h->hi = 0x6c62272e07bb0142ULL;
+    h->lo = 0x62b821756295c58dULL;
+}
+
+/* strings are hashed with their terminator, so "a","bc" != "ab","c" */
+void hashstr(Hash *h, char *str)
+{
+    hashbytes(h, str, strlen(str) + 1);
+}
+
+int hashfile(Hash *h, char *path)
+{
+    char buf[8192];
+    size_t n;
+    FILE *f;
+
+    f = fopen(path, "r");
+    if (!f)
+        return 0;
+    while ((n = fread(buf, 1, sizeof buf, f)) > 0)
+        hashbytes(h, buf, n);
+    fclose(f);
+    return 1;
+}
+
+void hashhex(Hash *h, char *buf, size_t sz)
+{
+    snprintf(buf, sz, "%016llx%016llx", (unsigned long long)h->hi, (unsigned long long)h->lo);
+}
+
+/* hashes the binary that 'bin' runs, searching $PATH like execvp does */
+void hashtool(Hash *h, char *bin)
+{
+    char buf[1024];
+    char *path, *p, *q;
+
+    hashstr(h, bin);
+    if (strchr(bin, '/')) {
+        hashfile(h, bin);
+        return;
+    }
+    path = getenv("PATH");
+    if (!path)
+        return;
+    for (p = path; *p; p = q) {
+        q = p + strcspn(p, ":");
+        snprintf(buf, sizeof buf, "%.*s/%s", (int)(q - p), p, bin);
+        if (access(buf, X_OK) == 0 && hashfile(h, buf))
+            return;
+        if (*q)
+            q++;
+    }
+}
+
+/* finds a library usefile in the same order as the compiler does */
+int hashlib(Hash *h, char *lib)
+{
+    char buf[1024];
+    size_t i;
+
+    hashstr(h, lib);
+    for (i = 0; i < nincpaths; i++) {
+        snprintf(buf, sizeof buf, "%s/%s", incpaths[i], lib);
+        if (hashfile(h, buf))
+            return 1;
+    }
+    snprintf(buf, sizeof buf, "%s/%s/%s", Instroot, "/lib/myr", lib);
+    return hashfile(h, buf);
+}
+
+int samefile(char *a, char *b)
+{
+    char abuf[8192], bbuf[8192];
+    FILE *fa, *fb;
+    size_t na, nb;
+    int same;
+
+    fa = fopen(a, "r");
+    fb = fopen(b, "r");
+    same = fa && fb;
+    while (same) {
+        na = fread(abuf, 1, sizeof abuf, fa);
+        nb = fread(bbuf, 1, sizeof bbuf, fb);
+        if (na != nb || memcmp(abuf, bbuf, na) != 0)
+            same = 0;
+        else if (na == 0)
+            break;
+    }
+    if (fa)
+        fclose(fa);
+    if (fb)
+        fclose(fb);
+    return same;
+}
+
+/* copies a file, replacing 'to' atomically */
+int copyfile(char *from, char *to)
+{
+    char buf[8192];
+    char tmp[1024];
+    FILE *in, *out;
+    size_t n;
+    int ok;
+
+    in = fopen(from, "r");
+    if (!in)
+        return 0;
+    snprintf(tmp, sizeof tmp, "%s.tmp%ld", to, (long)getpid());
+    out = fopen(tmp, "w");
+    if (!out) {
+        fclose(in);
+        return 0;
+    }
+    ok = 1;
+    while ((n = fread(buf, 1, sizeof buf, in)) > 0)
+        if (fwrite(buf, 1, n, out) != n)
+            ok = 0;
+    if (ferror(in))
+        ok = 0;
+    fclose(in);
+    if (fclose(out) != 0)
+        ok = 0;
+    if (ok && rename(tmp, to) == 0)
+        return 1;
+    unlink(tmp);
+    return 0;
+}
+
+/* the path of the cache entry for an output with inputs 'in', built by 'tool' */
+char *cachepath(Hash *in, char *tool, char *suffix)
+{
+    char buf[1024];
+    char key[33];
+    Hash h;
+
+    h = *in;
+    hashtool(&h, tool);
+    hashhex(&h, key, sizeof key);
+    snprintf(buf, sizeof buf, "%s/%.2s/%s%s", cachedir, key, key + 2, suffix);
+    return strdup(buf);
+}
+
+/*
+ * Restores 'out' from the cache entry 'path' if it has
+ * one. Otherwise counts the miss, and the caller builds it.
+ */
+int fromcache(char *path, char *out)
+{
+    if (samefile(path, out) || copyfile(path, out)) {
+        cachehits++;
+        return 1;
+    }
+    cachemisses++;
+    return 0;
+}
+
+/* checks if 'out' is newer than everything the job reads */
+int newer(Job *j, char *out)
+{
+    size_t i;
+
+    if (!isfresh(j->src, out))
+        return 0;
+    for (i = 0; i < j->ninputs; i++)
+        if (!isfresh(j->inputs[i], out))
+            return 0;
+    return 1;
+}
+
+/*
+ * Checks whether a job's product can be reused, either
+ * from the cache or because it is newer than everything
+ * that goes into it. This is done once the jobs it waits
+ * on are done, so that it sees the usefiles they wrote.
+ */
+int uptodate(Job *j)
+{
+    char *suffix;
+    size_t i;
+    Hash h;
+
+    if (cachedir) {
+        h = j->key;
+        for (i = 0; i < j->nclosure; i++) {
+            hashstr(&h, j->closure[i]);
+            if (!hashfile(&h, j->closure[i]))
+                err(1, "Could not open %s", j->closure[i]);
+        }
+        suffix = strrchr(j->product, '.');
+        j->cachepath = cachepath(&h, j->tool, suffix);
+        return fromcache(j->cachepath, j->product);
+    }
+    if (newer(j, j->product))
+        return 1;
+    /* a usefile kept by the cutoff is older than its inputs */
+    return j->stamp && access(j->product, F_OK) == 0 && newer(j, j->stamp);
+}
+
+void tocache(char *out, char *path)
+{
+    char dir[1024];
+    char *p;
+
+    p = strrchr(path, '/');
+    snprintf(dir, sizeof dir, "%.*s", (int)(p - path), path);
+    if (mkdir(dir, 0777) == -1 && errno != EEXIST)
+        warn("Could not create cache dir %s", dir);
+    else if (!copyfile(out, path))
+        warn("Could not cache %s", out);
+}
+
+/* adds this run's hits and misses to the totals kept in the cache */
+void cachestats(void)
+{
+    char buf[1024];
+    unsigned long hits, misses;
+    FILE *f;
+    int fd;
+
+    hits = 0;
+    misses = 0;
+    snprintf(buf, sizeof buf, "%s/stats", cachedir);
+    fd = open(buf, O_RDWR | O_CREAT, 0666);
+    if (fd == -1 || !(f = fdopen(fd, "r+"))) {
+        warn("Could not open %s", buf);
+        return;
+    }
+    flock(fd, LOCK_EX);
+    if (fscanf(f, "hits %lu misses %lu", &hits, &misses) != 2) {
+        hits = 0;
+        misses = 0;
+    }
+    hits += cachehits;
+    misses += cachemisses;
+    rewind(f);
+    fprintf(f, "hits %lu misses %lu\n", hits, misses);
+    fflush(f);
+    ftruncate(fd, ftell(f));
+    fclose(f);
+    if (showstats)
+        printf("cache: %zu hits, %zu misses (%lu hits, %lu misses in total)\n",
+               cachehits, cachemisses, hits, misses);
+}
+
 void scrapelib(Htab *g, char *lib)
 {
     char **deps;
-    size_t ndeps;
+    size_t ndeps, i;
     FILE *use;
-    char *l;
 
     if (hthas(libgraph, lib))
         return;
     deps = NULL;
     ndeps = 0;
     use = openlib(lib);
-    if (fgetc(use) != 'U')
-        err(1, "library \"%s\" is not a usefile.", lib);
-    /* we don't care about the usefile's name */
-    free(rdstr(use));
-    while (fgetc(use) == 'L') {
-        l = rdstr(use);
-        lappend(&deps, &ndeps, l);
-        scrapelib(g, l);
-    }
+    if (!rdlibdeps(use, &deps, &ndeps))
+        errx(1, "library \"%s\" is not a usefile.", lib);
+    fclose(use);
+    for (i = 0; i < ndeps; i++)
+        scrapelib(g, deps[i]);
     lappend(&deps, &ndeps, NULL);
     htput(g, lib, deps);
 }
 
-void compile(char *file)
+/* appends 's' to the list, unless it's there already */
+void addonce(char ***l, size_t *n, char *s)
+{
+    size_t i;
+
+    for (i = 0; i < *n; i++)
+        if (!strcmp((*l)[i], s))
+            return;
+    lappend(l, n, s);
+}
+
+/* adds 'lib' and everything it depends on to the list */
+void addlib(char ***l, size_t *n, char *lib)
 {
-    size_t i, ndeps;
+    char **deps;
+    size_t i;
+
+    for (i = 0; i < *n; i++)
+        if (!strcmp((*l)[i], lib))
+            return;
+    lappend(l, n, lib);
+    deps = htget(libgraph, lib);
+    for (i = 0; deps[i]; i++)
+        addlib(l, n, deps[i]);
+}
+
+void setinputs(Job *j, char *src, char **inputs, size_t ninputs, char *product, char *tool, Hash *key)
+{
+    j->src = src;
+    j->inputs = inputs;
+    j->ninputs = ninputs;
+    j->product = product;
+    j->tool = tool;
+    j->key = *key;
+}
+
+Job *mkjob(char **cmd, Job **deps, size_t ndeps)
+{
+    Job *j;
+    size_t i;
+
+    j = zalloc(sizeof(Job));
+    j->cmd = cmd;
+    for (i = 0; i < ndeps; i++) {
+        lappend(&deps[i]->rdeps, &deps[i]->nrdeps, j);
+        j->nwait++;
+    }
+    lappend(&jobs, &njobs, j);
+    return j;
+}
+
+/* copies the captured output of a job to 'to' */
+void replay(FILE *from, FILE *to)
+{
+    char buf[4096];
+    size_t n;
+
+    rewind(from);
+    while ((n = fread(buf, 1, sizeof buf, from)) > 0)
+        fwrite(buf, 1, n, to);
+    fclose(from);
+}
+
+void launch(Job *j)
+{
+    char buf[1024];
+    pid_t pid;
+
+    /* a failed build leaves the old product here, so it still gets compared */
+    if (j->cutoff) {
+        snprintf(buf, sizeof buf, "%s.prev", j->product);
+        if (rename(j->product, buf) == 0 || access(buf, F_OK) == 0)
+            j->prev = strdup(buf);
+    }
+    j->out = tmpfile();
+    j->err = tmpfile();
+    if (!j->out || !j->err)
+        err(1, "Could not create temp file");
+    fflush(stdout);
+    fflush(stderr);
+    pid = fork();
+    if (pid == -1) {
+        err(1, "Could not fork");
+    } else if (pid == 0) {
+        dup2(fileno(j->out), 1);
+        dup2(fileno(j->err), 2);
+        if (execvp(j->cmd[0], j->cmd) == -1)
+            err(1, "Failed to exec %s", j->cmd[0]);
+    }
+    j->pid = pid;
+}
+
+/*
+ * Parses the jobserver fds out of MAKEFLAGS. Make only
+ * passes them on to recipes it knows run a sub-make, so
+ * they are checked before we trust them.
+ */
+void findjobserver(void)
+{
+    char *flags, *p;
+    int rd, wr;
+
+    flags = getenv("MAKEFLAGS");
+    if (!flags)
+        return;
+    if ((p = strstr(flags, "--jobserver-auth=")) != NULL)
+        p += strlen("--jobserver-auth=");
+    else if ((p = strstr(flags, "--jobserver-fds=")) != NULL)
+        p += strlen("--jobserver-fds=");
+    else
+        return;
+    if (!strncmp(p, "fifo:", 5)) {
+        p = strdupn(p + 5, strcspn(p + 5, " "));
+        rd = open(p, O_RDWR);
+        free(p);
+        wr = rd;
+    } else if (sscanf(p, "%d,%d", &rd, &wr) != 2) {
+        return;
+    }
+    if (rd < 0 || wr < 0 || fcntl(rd, F_GETFD) == -1 || fcntl(wr, F_GETFD) == -1)
+        return;
+    jsrd = rd;
+    jswr = wr;
+}
+
+void wakeup(int sig)
+{
+    int e;
+
+    e = errno;
+    if (write(chldpipe[1], "", 1) == -1) {
+        /* the pipe is full, so a wakeup is pending anyway */
+    }
+    errno = e;
+}
+
+/*
+ * Waits for a token from the jobserver, or for one of our
+ * jobs to exit, whichever comes first. Returns the token,
+ * or 0 if a job exited, so that it gets reaped, and its
+ * token returned, before we ask for another.
+ */
+char acquire(void)
+{
+    struct pollfd fds[2];
+    char c, buf[64];
+    ssize_t n;
+
+    fds[0].fd = jsrd;
+    fds[0].events = POLLIN;
+    fds[1].fd = chldpipe[0];
+    fds[1].events = POLLIN;
+    while (1) {
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR)
+                continue;
+            err(1, "Could not wait for jobserver");
+        }
+        if (fds[1].revents & POLLIN) {
+            while (read(chldpipe[0], buf, sizeof buf) > 0)
+                /* drain */;
+            return 0;
+        }
+        if (fds[0].revents & (POLLIN | POLLHUP)) {
+            n = read(jsrd, &c, 1);
+            if (n == 1)
+                return c;
+            if (n == 0)
+                errx(1, "Jobserver went away");
+            /* another make job beat us to the token */
+            if (errno != EINTR && errno != EAGAIN)
+                err(1, "Could not read jobserver");
+        }
+    }
+}
+
+/*
+ * Queues a job once everything it waits on is done,
+ * or skips straight past it if its product is already
+ * up to date.
+ */
+void enqueue(Job *j, Job ***ready, size_t *nready)
+{
+    size_t i;
+
+    if (!uptodate(j)) {
+        lappend(ready, nready, j);
+        return;
+    }
+    for (i = 0; i < j->nrdeps; i++)
+        if (--j->rdeps[i]->nwait == 0)
+            enqueue(j->rdeps[i], ready, nready);
+}
+
+/*
+ * Gathers other ready compiles into the same compiler
+ * invocation as 'j', so that the usefiles they share
+ * are only loaded once. They are spread evenly over the
+ * 'nslots' free job slots, so that batching doesn't cost
+ * us parallelism; 0 means we can't tell how many there are.
+ */
+void gather(Job *j, Job ***ready, size_t *nready, size_t head, size_t nslots)
+{
+    size_t i, n, want;
     char **cmd;
     size_t ncmd;
+
+    n = 1;
+    for (i = head; i < *nready; i++)
+        if ((*ready)[i]->tool == mc)
+            n++;
+    if (nslots)
+        want = (n + nslots - 1) / nslots;
+    else
+        want = n < Maxbatch ? n : Maxbatch;
+    for (i = head; i < *nready && j->nbatch < want; ) {
+        if ((*ready)[i]->tool == mc) {
+            lappend(&j->batch, &j->nbatch, (*ready)[i]);
+            ldel(ready, nready, i);
+        } else {
+            i++;
+        }
+    }
+    if (j->nbatch == 1)
+        return;
+
+    cmd = NULL;
+    ncmd = 0;
+    for (i = 0; j->cmd[i]; i++)
+        lappend(&cmd, &ncmd, j->cmd[i]);
+    for (i = 1; i < j->nbatch; i++)
+        lappend(&cmd, &ncmd, j->batch[i]->src);
+    lappend(&cmd, &ncmd, NULL);
+    j->cmd = cmd;
+}
+
+/*
+ * Called when a job finishes. If a usefile came out the
+ * same as before, the old one is put back, so that its
+ * timestamp doesn't make its users rebuild. If the job
+ * failed, the old one is only kept to compare against
+ * next time, so that the job runs again.
+ */
+void finish(Job *j, int ok)
+{
+    if (!ok && j->cutoff)
+        unlink(j->product);
+    else if (j->prev && samefile(j->prev, j->product))
+        rename(j->prev, j->product);
+    else if (j->prev)
+        unlink(j->prev);
+    if (ok && j->cachepath)
+        tocache(j->product, j->cachepath);
+}
+
+/* finishes a job that succeeded, and queues what it frees up */
+void done(Job *j, Job ***ready, size_t *nready)
+{
+    size_t i;
+
+    finish(j, 1);
+    for (i = 0; i < j->nrdeps; i++)
+        if (--j->rdeps[i]->nwait == 0)
+            enqueue(j->rdeps[i], ready, nready);
+}
+
+/*
+ * Runs every job in the build graph, as many at once as
+ * we are allowed, as soon as the jobs they wait on are
+ * done. The first failure stops anything new from being
+ * started; the jobs still running are waited for, so
+ * that no half written outputs are left behind.
+ */
+void runjobs(void)
+{
+    Job **ready, **running, *j;
+    size_t nready, nrunning, head, i;
+    struct sigaction sa;
+    int status, failed;
+    pid_t pid;
+    char tok;
+
+    ready = NULL;
+    nready = 0;
+    running = NULL;
+    nrunning = 0;
+    head = 0;
+    failed = 0;
+    /* skipping a job can free up ones later in the list, so find the roots first */
+    for (i = 0; i < njobs; i++)
+        if (!jobs[i]->nwait)
+            lappend(&running, &nrunning, jobs[i]);
+    for (i = 0; i < nrunning; i++)
+        enqueue(running[i], &ready, &nready);
+    lfree(&running, &nrunning);
+
+    /* a job exiting wakes up acquire() */
+    if (maxjobs == 0) {
+        if (pipe(chldpipe) == -1)
+            err(1, "Could not create pipe");
+        for (i = 0; i < 2; i++) {
+            fcntl(chldpipe[i], F_SETFD, FD_CLOEXEC);
+            fcntl(chldpipe[i], F_SETFL, O_NONBLOCK);
+        }
+        memset(&sa, 0, sizeof sa);
+        sa.sa_handler = wakeup;
+        sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+        sigaction(SIGCHLD, &sa, NULL);
+    }
+    while (nrunning || (head < nready && !failed)) {
+        /* start what we can */
+        if (head < nready && !failed) {
+            tok = 0;
+            if (nrunning == 0 || (maxjobs > 0 && nrunning < (size_t)maxjobs) ||
+                (maxjobs == 0 && (tok = acquire()) != 0)) {
+                j = ready[head++];
+                j->tok = tok;
+                lappend(&j->batch, &j->nbatch, j);
+                if (j->tool == mc)
+                    gather(j, &ready, &nready, head, maxjobs > 0 ? maxjobs - nrunning : 0);
+                launch(j);
+                lappend(&running, &nrunning, j);
+                continue;
+            }
+        }
+
+        /* acquire() only gives up when a job exited, but the
+         * wakeup may be left over from one we already reaped */
+        if (maxjobs == 0 && head < nready && !failed)
+            pid = waitpid(-1, &status, WNOHANG);
+        else
+            pid = waitpid(-1, &status, 0);
+        if (pid == 0 || (pid == -1 && errno == EINTR))
+            continue;
+        if (pid == -1)
+            err(1, "Could not wait for jobs");
+        for (i = 0; i < nrunning; i++)
+            if (running[i]->pid == pid)
+                break;
+        if (i == nrunning)
+            continue;
+        j = running[i];
+        ldel(&running, &nrunning, i);
+
+        printl(j->cmd);
+        replay(j->out, stdout);
+        replay(j->err, stderr);
+        fflush(stdout);
+        fflush(stderr);
+        if (j->tok && write(jswr, &j->tok, 1) != 1)
+            err(1, "Could not return jobserver token");
+        if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+            for (i = 0; i < j->nbatch; i++)
+                finish(j->batch[i], 0);
+            if (!failed)
+                failed = WEXITSTATUS(status);
+        } else if (WIFSIGNALED(status)) {
+            for (i = 0; i < j->nbatch; i++)
+                finish(j->batch[i], 0);
+            fprintf(stderr, "%s: exited with signal %d\n", j->cmd[0], WTERMSIG(status));
+            failed = 1;
+        } else {
+            for (i = 0; i < j->nbatch; i++)
+                done(j->batch[i], &ready, &nready);
+        }
+    }
+    if (failed)
+        exit(failed);
+    lfree(&ready, &nready);
+    lfree(&running, &nrunning);
+}
+
+/*
+ * Adds the jobs needed to build 'file' to the build
+ * graph, after those for the files it uses. Returns
+ * the job that writes its usefile, or null if nothing
+ * has to wait for it. Whether a job actually needs to
+ * run is only decided once the jobs it waits on are done.
+ */
+Job *compile(char *file)
+{
+    size_t i, k, ndeps, nwait, nuses, nclosure, nlibs;
+    char **cmd, **uses, **closure, **libs;
+    size_t ncmd;
     char *s;
     char *localdep;
     char *deps[512];
-    char use[1024];
-    char obj[1024];
+    char buf[1024];
     char *extra[] = {"-g", "-o", "" /* filename */};
+    Job **wait, *d, *j;
+    Hash h;
 
     if (hthas(compiled, file))
-        return;
+        return htget(compiled, file);
     if (hthas(loopdetect, file))
         die("Cycle in dependency graph, involving %s\n", file);
     htput(loopdetect, file, file);
+    /* the jobs outlive our caller's copy of the name */
+    s = strdup(file);
+    j = NULL;
+    wait = NULL;
+    nwait = 0;
+    uses = NULL;
+    nuses = 0;
+    closure = NULL;
+    nclosure = 0;
+    libs = NULL;
+    nlibs = 0;
+    /* the inputs common to everything built from this file */
+    hashinit(&h);
+    if (cachedir) {
+        hashstr(&h, "myrbuild cache v3");
+        for (i = 0; i < nincpaths; i++)
+            hashstr(&h, incpaths[i]);
+        for (i = 0; i < nmcflags; i++)
+            hashstr(&h, mcflags[i]);
+        hashstr(&h, file);
+        if (!hashfile(&h, file))
+            err(1, "Could not open file \"%s\"", file);
+    }
     if (hassuffix(file, ".myr")) {
-        swapsuffix(use, sizeof use, file, ".myr", ".use");
-        swapsuffix(obj, sizeof obj, file, ".myr", ".o");
         getdeps(file, deps, 512, &ndeps);
         for (i = 0; i < ndeps; i++) {
             if (isquoted(deps[i])) {
                 localdep = usetomyr(deps[i]);
-                compile(localdep);
+                d = compile(localdep);
+                if (d)
+                    lappend(&wait, &nwait, d);
+                swapsuffix(buf, sizeof buf, localdep, ".myr", ".use");
+                lappend(&uses, &nuses, strdup(buf));
+                addonce(&closure, &nclosure, uses[nuses - 1]);
+                /* a change deep down may not show in the usefile we read */
+                for (k = 0; d && k < d->nclosure; k++)
+                    addonce(&closure, &nclosure, d->closure[k]);
+                for (k = 0; d && k < d->nlibs; k++)
+                    addonce(&libs, &nlibs, d->libs[k]);
                 free(localdep);
             } else {
                 scrapelib(libgraph, deps[i]);
+                addlib(&libs, &nlibs, deps[i]);
             }
         }
-        if (isfresh(file, use))
-            goto done;
-        if (isfresh(file, obj))
-            goto done;
-        gencmd(&cmd, &ncmd, muse, file, NULL, 0);
-        run(cmd);
-
-        gencmd(&cmd, &ncmd, mc, file, NULL, 0);
-        run(cmd);
+        if (cachedir)
+            for (i = 0; i < nlibs; i++)
+                hashlib(&h, libs[i]);
+        /* 6m only needs the usefiles of our deps, not our own */
+        gencmd(&cmd, &ncmd, muse, s, NULL, 0);
+        j = mkjob(cmd, wait, nwait);
+        swapsuffix(buf, sizeof buf, file, ".myr", ".use");
+        setinputs(j, s, uses, nuses, strdup(buf), muse, &h);
+        gencmd(&cmd, &ncmd, mc, s, mcflags, nmcflags);
+        d = mkjob(cmd, wait, nwait);
+        swapsuffix(buf, sizeof buf, file, ".myr", ".o");
+        setinputs(d, s, uses, nuses, strdup(buf), mc, &h);
+        j->closure = d->closure = closure;
+        j->nclosure = d->nclosure = nclosure;
+        j->libs = d->libs = libs;
+        j->nlibs = d->nlibs = nlibs;
+
+        /*
+         * nothing changes for our users if our interface doesn't.
+         * The object is rebuilt whenever the usefile is, so its
+         * timestamp shows when the usefile was last checked.
+         */
+        j->cutoff = 1;
+        j->stamp = d->product;
     } else if (hassuffix(file, ".s")) {
-        swapsuffix(obj, sizeof obj, file, ".s", ".o");
-        if (isfresh(file, obj))
-            goto done;
-        extra[2] = obj;
-        gencmd(&cmd, &ncmd, as, file, extra, 3);
-        run(cmd);
-    }
-done:
-    s = strdup(file);
-    htput(compiled, s, s);
+        swapsuffix(buf, sizeof buf, file, ".s", ".o");
+        extra[2] = strdup(buf);
+        gencmd(&cmd, &ncmd, as, s, extra, 3);
+        d = mkjob(cmd, NULL, 0);
+        setinputs(d, s, NULL, 0, extra[2], as, &h);
+    }
+    lfree(&wait, &nwait);
+    htput(compiled, s, j);
     htdel(loopdetect, file);
+    return j;
 }
 
 void mergeuse(char **files, size_t nfiles)
@@ -444,8 +1206,15 @@ int main(int argc, char **argv)
 
     if (uname(&name) == 0)
         sysname = strdup(name.sysname);
-    while ((opt = getopt(argc, argv, "hb:l:s:I:C:A:M:L:R:")) != -1) {
+    while ((opt = getopt(argc, argv, "hb:l:s:I:C:A:M:L:R:j:c:SF:")) != -1) {
         switch (opt) {
+            case 'j':
+                maxjobs = strtol(optarg, NULL, 0);
+                if (maxjobs <= 0)
+                    die("-j needs a positive job count");
+                break;
+            case 'c': cachedir = optarg; break;
+            case 'S': showstats = 1; break;
             case 'b': binname = optarg; break;
             case 'l': libname = optarg; break;
             case 's': ldscript = optarg; break;
@@ -457,6 +1226,9 @@ int main(int argc, char **argv)
             case 'I':
                 lappend(&incpaths, &nincpaths, optarg);
                 break;
+            case 'F':
+                lappend(&mcflags, &nmcflags, optarg);
+                break;
             case 'h':
                 usage(argv[0]);
                 exit(0);
@@ -474,15 +1246,31 @@ int main(int argc, char **argv)
     libgraph = mkht(strhash, streq);
     compiled = mkht(strhash, streq);
     loopdetect = mkht(strhash, streq);
+    if (!cachedir)
+        cachedir = getenv("MYRCACHE");
+    if (cachedir && *cachedir) {
+        if (mkdir(cachedir, 0777) == -1 && errno != EEXIST)
+            err(1, "Could not create cache dir %s", cachedir);
+    } else {
+        cachedir = NULL;
+    }
     regcomp(&usepat, "^[[:space:]]*use[[:space:]]+([^[:space:]]+)", REG_EXTENDED);
+    /* with no -j, run as wide as make's jobserver lets us */
+    if (maxjobs == -1) {
+        findjobserver();
+        maxjobs = jsrd == -1 ? 1 : 0;
+    }
     for (i = optind; i < argc; i++)
         compile(argv[i]);
+    runjobs();
     if (libname) {
         mergeuse(&argv[optind], argc - optind);
         archive(&argv[optind], argc - optind);
     } else {
         linkobj(&argv[optind], argc - optind);
     }
+    if (cachedir)
+        cachestats();
 
     return 0;
 }
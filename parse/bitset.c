@@ -9,37 +9,15 @@
 
 #define Sizetbits (CHAR_BIT*sizeof(size_t)) /* used in graph reprs */
 
-/* Equalizes the size of a and b by
- * growing the smaller to the size of the
- * larger, zeroing out the new elements.
- * This allows the code to simply iterate
- * over both without keeping track of the
- * minimum size.
- */
-static void eqsz(Bitset *a, Bitset *b)
+/* Grows bs to hold at least 'sz' chunks, zeroing
+ * the new ones. The binary operations only ever grow
+ * their destination, and leave the source alone. */
+static void grow(Bitset *bs, size_t sz)
 {
-    size_t sz;
-    size_t i;
-    size_t *p;
-
-    if (a->nchunks > b->nchunks)
-        sz = a->nchunks;
-    else
-        sz = b->nchunks;
-
-    p = zalloc(sz * sizeof(size_t));
-    for (i = 0; i < a->nchunks; i++)
-        p[i] = a->chunks[i];
-    free(a->chunks);
-    a->chunks = p;
-    a->nchunks = sz;
-
-    p = zalloc(sz * sizeof(size_t));
-    for (i = 0; i < b->nchunks; i++)
-        p[i] = b->chunks[i];
-    free(b->chunks);
-    b->chunks = p;
-    b->nchunks = sz;
+    if (bs->nchunks >= sz)
+        return;
+    bs->chunks = zrealloc(bs->chunks, bs->nchunks*sizeof(size_t), sz*sizeof(size_t));
+    bs->nchunks = sz;
 }
 
 /* Creates a new all-zero bit set */
@@ -91,13 +69,11 @@ Bitset *bsclear(Bitset *bs)
 /* Counts the number of values held in a bit set */
 size_t bscount(Bitset *bs)
 {
-    size_t i, j, n;
+    size_t i, n;
 
     n = 0;
     for (i = 0; i < bs->nchunks; i++)
-        for (j = 0; j < sizeof(size_t)*CHAR_BIT; j++)
-            if (bs->chunks[i] & 1ULL << j)
-                n++;
+        n += __builtin_popcountll(bs->chunks[i]);
     return n;
 }
 
@@ -120,17 +96,20 @@ size_t bscount(Bitset *bs)
  */
 int bsiter(Bitset *bs, size_t *elt)
 {
-    size_t i;
+    size_t i, w;
 
-    for (i = *elt; i < bsmax(bs); i++) {
-        while (i < bsmax(bs) && !bs->chunks[i/Sizetbits])
-            i = (i + Sizetbits) & ~(Sizetbits - 1);
-        if (bshas(bs, i)) {
-            *elt = i;
-            return 1;
-        }
+    i = *elt/Sizetbits;
+    if (i >= bs->nchunks)
+        return 0;
+    /* mask off the bits below elt in its chunk, then find the lowest set one */
+    w = bs->chunks[i] & (~(size_t)0 << (*elt % Sizetbits));
+    while (!w) {
+        if (++i == bs->nchunks)
+            return 0;
+        w = bs->chunks[i];
     }
-    return 0;
+    *elt = i*Sizetbits + __builtin_ctzll(w);
+    return 1;
 }
 
 /* Returns the largest value that the bitset can possibly
@@ -170,8 +149,8 @@ void bsunion(Bitset *a, Bitset *b)
 {
     size_t i;
 
-    eqsz(a, b);
-    for (i = 0; i < a->nchunks; i++)
+    grow(a, b->nchunks);
+    for (i = 0; i < b->nchunks; i++)
         a->chunks[i] |= b->chunks[i];
 }
 
@@ -179,27 +158,26 @@ void bsintersect(Bitset *a, Bitset *b)
 {
     size_t i;
 
-    eqsz(a, b);
     for (i = 0; i < a->nchunks; i++)
-        a->chunks[i] &= b->chunks[i];
+        a->chunks[i] &= i < b->nchunks ? b->chunks[i] : 0;
 }
 
 void bsdiff(Bitset *a, Bitset *b)
 {
-    size_t i;
+    size_t i, n;
 
-    eqsz(a, b);
-    for (i = 0; i < a->nchunks; i++)
+    n = min(a->nchunks, b->nchunks);
+    for (i = 0; i < n; i++)
         a->chunks[i] &= ~b->chunks[i];
 }
 
+/* the chunks past the end of the shorter set must be empty in the longer */
 int bseq(Bitset *a, Bitset *b)
 {
     size_t i;
 
-    eqsz(a, b);
-    for (i = 0; i < a->nchunks; i++) {
-        if (a->chunks[i] != b->chunks[i])
+    for (i = 0; i < a->nchunks || i < b->nchunks; i++) {
+        if ((i < a->nchunks ? a->chunks[i] : 0) != (i < b->nchunks ? b->chunks[i] : 0))
             return 0;
     }
     return 1;
@@ -207,11 +185,12 @@ int bseq(Bitset *a, Bitset *b)
 
 int bsissubset(Bitset *set, Bitset *sub)
 {
-    size_t i;
+    size_t i, c;
 
-    eqsz(set, sub);
-    for (i = 0; i < set->nchunks; i++)
-        if ((sub->chunks[i] & set->chunks[i]) != set->chunks[i])
+    for (i = 0; i < set->nchunks; i++) {
+        c = i < sub->nchunks ? sub->chunks[i] : 0;
+        if ((c & set->chunks[i]) != set->chunks[i])
             return 0;
+    }
     return 1;
 }
@@ -0,0 +1,2936 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison implementation for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* C LALR(1) parser skeleton written by Richard Stallman, by
+   simplifying the original so-called "semantic" parser.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+/* All symbols defined below should begin with yy or YY, to avoid
+   infringing on user name space.  This should be done even for local
+   variables, as they might otherwise be expanded by user macros.
+   There are some unavoidable exceptions within include files to
+   define necessary library symbols; they are noted "INFRINGES ON
+   USER NAME SPACE" below.  */
+
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
+
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
+
+/* Skeleton name.  */
+#define YYSKELETON_NAME "yacc.c"
+
+/* Pure parsers.  */
+#define YYPURE 0
+
+/* Push parsers.  */
+#define YYPUSH 0
+
+/* Pull parsers.  */
+#define YYPULL 1
+
+
+
+
+/* First part of user prologue.  */
+#line 1 "gram.y"
+
+#define YYERROR_VERBOSE
+#define YYDEBUG 1
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "parse.h"
+
+Stab *curscope;
+
+void yyerror(const char *s);
+int yylex(void);
+
+static Op binop(int toktype);
+static Node *mkpseudodecl(Type *t);
+static void installucons(Stab *st, Type *t);
+static void constrainwith(Type *t, char *str);
+
+
+#line 100 "gram.c"
+
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
+#  endif
+# endif
+
+#include "gram.h"
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_Terror = 3,                     /* Terror  */
+  YYSYMBOL_Tplus = 4,                      /* Tplus  */
+  YYSYMBOL_Tminus = 5,                     /* Tminus  */
+  YYSYMBOL_Tmul = 6,                       /* Tmul  */
+  YYSYMBOL_Tdiv = 7,                       /* Tdiv  */
+  YYSYMBOL_Tinc = 8,                       /* Tinc  */
+  YYSYMBOL_Tdec = 9,                       /* Tdec  */
+  YYSYMBOL_Tmod = 10,                      /* Tmod  */
+  YYSYMBOL_Tasn = 11,                      /* Tasn  */
+  YYSYMBOL_Taddeq = 12,                    /* Taddeq  */
+  YYSYMBOL_Tsubeq = 13,                    /* Tsubeq  */
+  YYSYMBOL_Tmuleq = 14,                    /* Tmuleq  */
+  YYSYMBOL_Tdiveq = 15,                    /* Tdiveq  */
+  YYSYMBOL_Tmodeq = 16,                    /* Tmodeq  */
+  YYSYMBOL_Tboreq = 17,                    /* Tboreq  */
+  YYSYMBOL_Tbxoreq = 18,                   /* Tbxoreq  */
+  YYSYMBOL_Tbandeq = 19,                   /* Tbandeq  */
+  YYSYMBOL_Tbsleq = 20,                    /* Tbsleq  */
+  YYSYMBOL_Tbsreq = 21,                    /* Tbsreq  */
+  YYSYMBOL_Tbor = 22,                      /* Tbor  */
+  YYSYMBOL_Tbxor = 23,                     /* Tbxor  */
+  YYSYMBOL_Tband = 24,                     /* Tband  */
+  YYSYMBOL_Tbsl = 25,                      /* Tbsl  */
+  YYSYMBOL_Tbsr = 26,                      /* Tbsr  */
+  YYSYMBOL_Tbnot = 27,                     /* Tbnot  */
+  YYSYMBOL_Teq = 28,                       /* Teq  */
+  YYSYMBOL_Tgt = 29,                       /* Tgt  */
+  YYSYMBOL_Tlt = 30,                       /* Tlt  */
+  YYSYMBOL_Tge = 31,                       /* Tge  */
+  YYSYMBOL_Tle = 32,                       /* Tle  */
+  YYSYMBOL_Tne = 33,                       /* Tne  */
+  YYSYMBOL_Tlor = 34,                      /* Tlor  */
+  YYSYMBOL_Tland = 35,                     /* Tland  */
+  YYSYMBOL_Tlnot = 36,                     /* Tlnot  */
+  YYSYMBOL_Tobrace = 37,                   /* Tobrace  */
+  YYSYMBOL_Tcbrace = 38,                   /* Tcbrace  */
+  YYSYMBOL_Toparen = 39,                   /* Toparen  */
+  YYSYMBOL_Tcparen = 40,                   /* Tcparen  */
+  YYSYMBOL_Tosqbrac = 41,                  /* Tosqbrac  */
+  YYSYMBOL_Tcsqbrac = 42,                  /* Tcsqbrac  */
+  YYSYMBOL_Tat = 43,                       /* Tat  */
+  YYSYMBOL_Ttick = 44,                     /* Ttick  */
+  YYSYMBOL_Tderef = 45,                    /* Tderef  */
+  YYSYMBOL_Ttype = 46,                     /* Ttype  */
+  YYSYMBOL_Tfor = 47,                      /* Tfor  */
+  YYSYMBOL_Tin = 48,                       /* Tin  */
+  YYSYMBOL_Twhile = 49,                    /* Twhile  */
+  YYSYMBOL_Tif = 50,                       /* Tif  */
+  YYSYMBOL_Telse = 51,                     /* Telse  */
+  YYSYMBOL_Telif = 52,                     /* Telif  */
+  YYSYMBOL_Tmatch = 53,                    /* Tmatch  */
+  YYSYMBOL_Tdefault = 54,                  /* Tdefault  */
+  YYSYMBOL_Tgoto = 55,                     /* Tgoto  */
+  YYSYMBOL_Tbreak = 56,                    /* Tbreak  */
+  YYSYMBOL_Tcontinue = 57,                 /* Tcontinue  */
+  YYSYMBOL_Tintlit = 58,                   /* Tintlit  */
+  YYSYMBOL_Tstrlit = 59,                   /* Tstrlit  */
+  YYSYMBOL_Tfloatlit = 60,                 /* Tfloatlit  */
+  YYSYMBOL_Tchrlit = 61,                   /* Tchrlit  */
+  YYSYMBOL_Tboollit = 62,                  /* Tboollit  */
+  YYSYMBOL_Ttrait = 63,                    /* Ttrait  */
+  YYSYMBOL_Timpl = 64,                     /* Timpl  */
+  YYSYMBOL_Tstruct = 65,                   /* Tstruct  */
+  YYSYMBOL_Tunion = 66,                    /* Tunion  */
+  YYSYMBOL_Ttyparam = 67,                  /* Ttyparam  */
+  YYSYMBOL_Tattr = 68,                     /* Tattr  */
+  YYSYMBOL_Tconst = 69,                    /* Tconst  */
+  YYSYMBOL_Tvar = 70,                      /* Tvar  */
+  YYSYMBOL_Tgeneric = 71,                  /* Tgeneric  */
+  YYSYMBOL_Textern = 72,                   /* Textern  */
+  YYSYMBOL_Tcast = 73,                     /* Tcast  */
+  YYSYMBOL_Texport = 74,                   /* Texport  */
+  YYSYMBOL_Tprotect = 75,                  /* Tprotect  */
+  YYSYMBOL_Tellipsis = 76,                 /* Tellipsis  */
+  YYSYMBOL_Tendln = 77,                    /* Tendln  */
+  YYSYMBOL_Tendblk = 78,                   /* Tendblk  */
+  YYSYMBOL_Tcolon = 79,                    /* Tcolon  */
+  YYSYMBOL_Twith = 80,                     /* Twith  */
+  YYSYMBOL_Tdot = 81,                      /* Tdot  */
+  YYSYMBOL_Tcomma = 82,                    /* Tcomma  */
+  YYSYMBOL_Tret = 83,                      /* Tret  */
+  YYSYMBOL_Tuse = 84,                      /* Tuse  */
+  YYSYMBOL_Tpkg = 85,                      /* Tpkg  */
+  YYSYMBOL_Tsizeof = 86,                   /* Tsizeof  */
+  YYSYMBOL_Tident = 87,                    /* Tident  */
+  YYSYMBOL_Teof = 88,                      /* Teof  */
+  YYSYMBOL_YYACCEPT = 89,                  /* $accept  */
+  YYSYMBOL_file = 90,                      /* file  */
+  YYSYMBOL_toplev = 91,                    /* toplev  */
+  YYSYMBOL_decl = 92,                      /* decl  */
+  YYSYMBOL_decllist = 93,                  /* decllist  */
+  YYSYMBOL_use = 94,                       /* use  */
+  YYSYMBOL_optident = 95,                  /* optident  */
+  YYSYMBOL_package = 96,                   /* package  */
+  YYSYMBOL_pkgbody = 97,                   /* pkgbody  */
+  YYSYMBOL_pkgitem = 98,                   /* pkgitem  */
+  YYSYMBOL_visdef = 99,                    /* visdef  */
+  YYSYMBOL_declbody = 100,                 /* declbody  */
+  YYSYMBOL_declcore = 101,                 /* declcore  */
+  YYSYMBOL_name = 102,                     /* name  */
+  YYSYMBOL_implstmt = 103,                 /* implstmt  */
+  YYSYMBOL_traitdef = 104,                 /* traitdef  */
+  YYSYMBOL_traitbody = 105,                /* traitbody  */
+  YYSYMBOL_tydef = 106,                    /* tydef  */
+  YYSYMBOL_typeid = 107,                   /* typeid  */
+  YYSYMBOL_typarams = 108,                 /* typarams  */
+  YYSYMBOL_type = 109,                     /* type  */
+  YYSYMBOL_generictype = 110,              /* generictype  */
+  YYSYMBOL_typaramlist = 111,              /* typaramlist  */
+  YYSYMBOL_compoundtype = 112,             /* compoundtype  */
+  YYSYMBOL_functype = 113,                 /* functype  */
+  YYSYMBOL_funcsig = 114,                  /* funcsig  */
+  YYSYMBOL_argdefs = 115,                  /* argdefs  */
+  YYSYMBOL_tupledef = 116,                 /* tupledef  */
+  YYSYMBOL_typelist = 117,                 /* typelist  */
+  YYSYMBOL_structdef = 118,                /* structdef  */
+  YYSYMBOL_structbody = 119,               /* structbody  */
+  YYSYMBOL_structent = 120,                /* structent  */
+  YYSYMBOL_uniondef = 121,                 /* uniondef  */
+  YYSYMBOL_unionbody = 122,                /* unionbody  */
+  YYSYMBOL_unionelt = 123,                 /* unionelt  */
+  YYSYMBOL_goto = 124,                     /* goto  */
+  YYSYMBOL_retexpr = 125,                  /* retexpr  */
+  YYSYMBOL_optexpr = 126,                  /* optexpr  */
+  YYSYMBOL_optexprln = 127,                /* optexprln  */
+  YYSYMBOL_exprln = 128,                   /* exprln  */
+  YYSYMBOL_expr = 129,                     /* expr  */
+  YYSYMBOL_asnexpr = 130,                  /* asnexpr  */
+  YYSYMBOL_asnop = 131,                    /* asnop  */
+  YYSYMBOL_lorexpr = 132,                  /* lorexpr  */
+  YYSYMBOL_landexpr = 133,                 /* landexpr  */
+  YYSYMBOL_cmpexpr = 134,                  /* cmpexpr  */
+  YYSYMBOL_cmpop = 135,                    /* cmpop  */
+  YYSYMBOL_castexpr = 136,                 /* castexpr  */
+  YYSYMBOL_unionexpr = 137,                /* unionexpr  */
+  YYSYMBOL_borexpr = 138,                  /* borexpr  */
+  YYSYMBOL_bandexpr = 139,                 /* bandexpr  */
+  YYSYMBOL_addexpr = 140,                  /* addexpr  */
+  YYSYMBOL_addop = 141,                    /* addop  */
+  YYSYMBOL_mulexpr = 142,                  /* mulexpr  */
+  YYSYMBOL_mulop = 143,                    /* mulop  */
+  YYSYMBOL_shiftexpr = 144,                /* shiftexpr  */
+  YYSYMBOL_shiftop = 145,                  /* shiftop  */
+  YYSYMBOL_prefixexpr = 146,               /* prefixexpr  */
+  YYSYMBOL_postfixexpr = 147,              /* postfixexpr  */
+  YYSYMBOL_arglist = 148,                  /* arglist  */
+  YYSYMBOL_atomicexpr = 149,               /* atomicexpr  */
+  YYSYMBOL_tupbody = 150,                  /* tupbody  */
+  YYSYMBOL_tuphead = 151,                  /* tuphead  */
+  YYSYMBOL_tuprest = 152,                  /* tuprest  */
+  YYSYMBOL_literal = 153,                  /* literal  */
+  YYSYMBOL_tuplit = 154,                   /* tuplit  */
+  YYSYMBOL_littok = 155,                   /* littok  */
+  YYSYMBOL_funclit = 156,                  /* funclit  */
+  YYSYMBOL_params = 157,                   /* params  */
+  YYSYMBOL_seqlit = 158,                   /* seqlit  */
+  YYSYMBOL_arrayelts = 159,                /* arrayelts  */
+  YYSYMBOL_arrayelt = 160,                 /* arrayelt  */
+  YYSYMBOL_structelts = 161,               /* structelts  */
+  YYSYMBOL_structelt = 162,                /* structelt  */
+  YYSYMBOL_endlns = 163,                   /* endlns  */
+  YYSYMBOL_stmt = 164,                     /* stmt  */
+  YYSYMBOL_break = 165,                    /* break  */
+  YYSYMBOL_continue = 166,                 /* continue  */
+  YYSYMBOL_forstmt = 167,                  /* forstmt  */
+  YYSYMBOL_whilestmt = 168,                /* whilestmt  */
+  YYSYMBOL_ifstmt = 169,                   /* ifstmt  */
+  YYSYMBOL_elifs = 170,                    /* elifs  */
+  YYSYMBOL_matchstmt = 171,                /* matchstmt  */
+  YYSYMBOL_matches = 172,                  /* matches  */
+  YYSYMBOL_match = 173,                    /* match  */
+  YYSYMBOL_block = 174,                    /* block  */
+  YYSYMBOL_blkbody = 175,                  /* blkbody  */
+  YYSYMBOL_label = 176                     /* label  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
+
+
+
+
+#ifdef short
+# undef short
+#endif
+
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
+
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
+#endif
+
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
+
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
+typedef signed char yytype_int8;
+#endif
+
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
+#else
+typedef short yytype_int16;
+#endif
+
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
+#else
+typedef short yytype_uint8;
+#endif
+
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
+#else
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
+#endif
+
+#ifndef YYSIZE_T
+# ifdef __SIZE_TYPE__
+#  define YYSIZE_T __SIZE_TYPE__
+# elif defined size_t
+#  define YYSIZE_T size_t
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYSIZE_T size_t
+# else
+#  define YYSIZE_T unsigned
+# endif
+#endif
+
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_int16 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
+
+#ifndef YY_
+# if defined YYENABLE_NLS && YYENABLE_NLS
+#  if ENABLE_NLS
+#   include <libintl.h> /* INFRINGES ON USER NAME SPACE */
+#   define YY_(Msgid) dgettext ("bison-runtime", Msgid)
+#  endif
+# endif
+# ifndef YY_
+#  define YY_(Msgid) Msgid
+# endif
+#endif
+
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
+# endif
+#endif
+
+/* Suppress unused-variable warnings by "using" E.  */
+#if ! defined lint || defined __GNUC__
+# define YY_USE(E) ((void) (E))
+#else
+# define YY_USE(E) /* empty */
+#endif
+
+/* Suppress an incorrect diagnostic about yylval being uninitialized.  */
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
+    _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
+    _Pragma ("GCC diagnostic pop")
+#else
+# define YY_INITIAL_VALUE(Value) Value
+#endif
+#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END
+#endif
+#ifndef YY_INITIAL_VALUE
+# define YY_INITIAL_VALUE(Value) /* Nothing. */
+#endif
+
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
+
+#if !defined yyoverflow
+
+/* The parser invokes alloca or malloc; define the necessary symbols.  */
+
+# ifdef YYSTACK_USE_ALLOCA
+#  if YYSTACK_USE_ALLOCA
+#   ifdef __GNUC__
+#    define YYSTACK_ALLOC __builtin_alloca
+#   elif defined __BUILTIN_VA_ARG_INCR
+#    include <alloca.h> /* INFRINGES ON USER NAME SPACE */
+#   elif defined _AIX
+#    define YYSTACK_ALLOC __alloca
+#   elif defined _MSC_VER
+#    include <malloc.h> /* INFRINGES ON USER NAME SPACE */
+#    define alloca _alloca
+#   else
+#    define YYSTACK_ALLOC alloca
+#    if ! defined _ALLOCA_H && ! defined EXIT_SUCCESS
+#     include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+      /* Use EXIT_SUCCESS as a witness for stdlib.h.  */
+#     ifndef EXIT_SUCCESS
+#      define EXIT_SUCCESS 0
+#     endif
+#    endif
+#   endif
+#  endif
+# endif
+
+# ifdef YYSTACK_ALLOC
+   /* Pacify GCC's 'empty if-body' warning.  */
+#  define YYSTACK_FREE(Ptr) do { /* empty */; } while (0)
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+    /* The OS might guarantee only one guard page at the bottom of the stack,
+       and a page size can be as small as 4096 bytes.  So we cannot safely
+       invoke alloca (N) if N exceeds 4096.  Use a slightly smaller number
+       to allow for a few compiler-allocated temporary stack slots.  */
+#   define YYSTACK_ALLOC_MAXIMUM 4032 /* reasonable circa 2006 */
+#  endif
+# else
+#  define YYSTACK_ALLOC YYMALLOC
+#  define YYSTACK_FREE YYFREE
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+#   define YYSTACK_ALLOC_MAXIMUM YYSIZE_MAXIMUM
+#  endif
+#  if (defined __cplusplus && ! defined EXIT_SUCCESS \
+       && ! ((defined YYMALLOC || defined malloc) \
+             && (defined YYFREE || defined free)))
+#   include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+#   ifndef EXIT_SUCCESS
+#    define EXIT_SUCCESS 0
+#   endif
+#  endif
+#  ifndef YYMALLOC
+#   define YYMALLOC malloc
+#   if ! defined malloc && ! defined EXIT_SUCCESS
+void *malloc (YYSIZE_T); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+#  ifndef YYFREE
+#   define YYFREE free
+#   if ! defined free && ! defined EXIT_SUCCESS
+void free (void *); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+# endif
+#endif /* !defined yyoverflow */
+
+#if (! defined yyoverflow \
+     && (! defined __cplusplus \
+         || (defined YYSTYPE_IS_TRIVIAL && YYSTYPE_IS_TRIVIAL)))
+
+/* A type that is properly aligned for any stack member.  */
+union yyalloc
+{
+  yy_state_t yyss_alloc;
+  YYSTYPE yyvs_alloc;
+};
+
+/* The size of the maximum gap between one aligned stack and the next.  */
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
+
+/* The size of an array large to enough to hold all stacks, each with
+   N elements.  */
+# define YYSTACK_BYTES(N) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
+      + YYSTACK_GAP_MAXIMUM)
+
+# define YYCOPY_NEEDED 1
+
+/* Relocate STACK from its old location to the new one.  The
+   local variables YYSIZE and YYSTACKSIZE give the old and new number of
+   elements in the stack, and YYPTR gives the new location of the
+   stack.  Advance YYPTR to a properly aligned location for the next
+   stack.  */
+# define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
+    do                                                                  \
+      {                                                                 \
+        YYPTRDIFF_T yynewbytes;                                         \
+        YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
+        Stack = &yyptr->Stack_alloc;                                    \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
+      }                                                                 \
+    while (0)
+
+#endif
+
+#if defined YYCOPY_NEEDED && YYCOPY_NEEDED
+/* Copy COUNT objects from SRC to DST.  The source and destination do
+   not overlap.  */
+# ifndef YYCOPY
+#  if defined __GNUC__ && 1 < __GNUC__
+#   define YYCOPY(Dst, Src, Count) \
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
+#  else
+#   define YYCOPY(Dst, Src, Count)              \
+      do                                        \
+        {                                       \
+          YYPTRDIFF_T yyi;                      \
+          for (yyi = 0; yyi < (Count); yyi++)   \
+            (Dst)[yyi] = (Src)[yyi];            \
+        }                                       \
+      while (0)
+#  endif
+# endif
+#endif /* !YYCOPY_NEEDED */
+
+/* YYFINAL -- State number of the termination state.  */
+#define YYFINAL  36
+/* YYLAST -- Last index in YYTABLE.  */
+#define YYLAST   664
+
+/* YYNTOKENS -- Number of terminals.  */
+#define YYNTOKENS  89
+/* YYNNTS -- Number of nonterminals.  */
+#define YYNNTS  88
+/* YYNRULES -- Number of rules.  */
+#define YYNRULES  231
+/* YYNSTATES -- Number of states.  */
+#define YYNSTATES  373
+
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   343
+
+
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
+
+/* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
+{
+       0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
+       5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25,    26,    27,    28,    29,    30,    31,    32,    33,    34,
+      35,    36,    37,    38,    39,    40,    41,    42,    43,    44,
+      45,    46,    47,    48,    49,    50,    51,    52,    53,    54,
+      55,    56,    57,    58,    59,    60,    61,    62,    63,    64,
+      65,    66,    67,    68,    69,    70,    71,    72,    73,    74,
+      75,    76,    77,    78,    79,    80,    81,    82,    83,    84,
+      85,    86,    87,    88
+};
+
+#if YYDEBUG
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
+{
+       0,   191,   191,   192,   196,   203,   205,   206,   209,   210,
+     211,   214,   216,   221,   228,   233,   240,   252,   255,   260,
+     262,   266,   267,   270,   280,   281,   284,   291,   293,   294,
+     295,   296,   299,   300,   303,   305,   308,   310,   314,   316,
+     320,   326,   331,   332,   341,   344,   348,   353,   361,   364,
+     368,   369,   370,   371,   372,   373,   377,   379,   382,   390,
+     393,   398,   399,   400,   401,   402,   403,   404,   407,   410,
+     412,   416,   420,   423,   428,   432,   435,   440,   445,   447,
+     452,   454,   456,   461,   466,   469,   474,   476,   478,   480,
+     484,   488,   490,   491,   495,   496,   499,   500,   503,   506,
+     509,   511,   514,   515,   516,   517,   518,   519,   520,   521,
+     522,   523,   524,   527,   529,   532,   534,   537,   539,   543,
+     543,   543,   543,   543,   543,   545,   548,   552,   554,   556,
+     560,   562,   564,   567,   569,   572,   574,   577,   577,   579,
+     581,   584,   584,   584,   588,   590,   593,   593,   596,   597,
+     598,   599,   600,   601,   602,   603,   607,   609,   611,   613,
+     615,   617,   619,   621,   624,   626,   629,   633,   635,   636,
+     638,   642,   647,   651,   652,   654,   658,   659,   660,   661,
+     664,   667,   668,   669,   670,   671,   677,   679,   683,   685,
+     688,   691,   693,   695,   700,   703,   705,   708,   712,   715,
+     719,   723,   724,   727,   728,   729,   730,   731,   732,   733,
+     734,   735,   736,   739,   743,   747,   749,   758,   762,   766,
+     768,   770,   774,   778,   782,   787,   790,   793,   800,   804,
+     808,   816
+};
+#endif
+
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
+/* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
+   First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
+static const char *const yytname[] =
+{
+  "\"end of file\"", "error", "\"invalid token\"", "Terror", "Tplus",
+  "Tminus", "Tmul", "Tdiv", "Tinc", "Tdec", "Tmod", "Tasn", "Taddeq",
+  "Tsubeq", "Tmuleq", "Tdiveq", "Tmodeq", "Tboreq", "Tbxoreq", "Tbandeq",
+  "Tbsleq", "Tbsreq", "Tbor", "Tbxor", "Tband", "Tbsl", "Tbsr", "Tbnot",
+  "Teq", "Tgt", "Tlt", "Tge", "Tle", "Tne", "Tlor", "Tland", "Tlnot",
+  "Tobrace", "Tcbrace", "Toparen", "Tcparen", "Tosqbrac", "Tcsqbrac",
+  "Tat", "Ttick", "Tderef", "Ttype", "Tfor", "Tin", "Twhile", "Tif",
+  "Telse", "Telif", "Tmatch", "Tdefault", "Tgoto", "Tbreak", "Tcontinue",
+  "Tintlit", "Tstrlit", "Tfloatlit", "Tchrlit", "Tboollit", "Ttrait",
+  "Timpl", "Tstruct", "Tunion", "Ttyparam", "Tattr", "Tconst", "Tvar",
+  "Tgeneric", "Textern", "Tcast", "Texport", "Tprotect", "Tellipsis",
+  "Tendln", "Tendblk", "Tcolon", "Twith", "Tdot", "Tcomma", "Tret", "Tuse",
+  "Tpkg", "Tsizeof", "Tident", "Teof", "$accept", "file", "toplev", "decl",
+  "decllist", "use", "optident", "package", "pkgbody", "pkgitem", "visdef",
+  "declbody", "declcore", "name", "implstmt", "traitdef", "traitbody",
+  "tydef", "typeid", "typarams", "type", "generictype", "typaramlist",
+  "compoundtype", "functype", "funcsig", "argdefs", "tupledef", "typelist",
+  "structdef", "structbody", "structent", "uniondef", "unionbody",
+  "unionelt", "goto", "retexpr", "optexpr", "optexprln", "exprln", "expr",
+  "asnexpr", "asnop", "lorexpr", "landexpr", "cmpexpr", "cmpop",
+  "castexpr", "unionexpr", "borexpr", "bandexpr", "addexpr", "addop",
+  "mulexpr", "mulop", "shiftexpr", "shiftop", "prefixexpr", "postfixexpr",
+  "arglist", "atomicexpr", "tupbody", "tuphead", "tuprest", "literal",
+  "tuplit", "littok", "funclit", "params", "seqlit", "arrayelts",
+  "arrayelt", "structelts", "structelt", "endlns", "stmt", "break",
+  "continue", "forstmt", "whilestmt", "ifstmt", "elifs", "matchstmt",
+  "matches", "match", "block", "blkbody", "label", YY_NULLPTR
+};
+
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
+{
+  return yytname[yysymbol];
+}
+#endif
+
+#define YYPACT_NINF (-297)
+
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
+
+#define YYTABLE_NINF (-213)
+
+#define yytable_value_is_error(Yyn) \
+  0
+
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
+static const yytype_int16 yypact[] =
+{
+     130,   -46,   -28,   -14,   -14,   -14,   -14,   128,   -20,   -12,
+      19,  -297,  -297,  -297,  -297,  -297,  -297,  -297,    82,   103,
+      60,    58,    59,  -297,    48,   134,    78,  -297,  -297,   108,
+     -14,   -14,  -297,  -297,  -297,   178,  -297,   130,    60,    59,
+     111,   207,   -14,   -14,    59,   146,    97,   129,  -297,   197,
+     190,  -297,  -297,  -297,  -297,  -297,  -297,   -14,   513,    59,
+     -14,  -297,  -297,   203,  -297,    -5,  -297,   190,    -6,  -297,
+    -297,  -297,   223,    85,   190,    -8,  -297,   186,   204,  -297,
+     205,   211,   145,  -297,   -14,  -297,   215,    38,  -297,    59,
+     151,  -297,  -297,   577,   577,   577,   577,   577,   577,   577,
+     -14,   513,   247,   -14,  -297,  -297,  -297,  -297,  -297,   254,
+    -297,  -297,  -297,   608,   259,   224,  -297,   222,   185,   272,
+     212,   112,   221,  -297,    12,  -297,  -297,  -297,  -297,  -297,
+    -297,   190,  -297,  -297,   191,  -297,  -297,  -297,  -297,  -297,
+    -297,    60,   -14,  -297,   170,   220,  -297,   -14,    59,  -297,
+      59,  -297,  -297,  -297,  -297,  -297,  -297,   383,  -297,  -297,
+    -297,    -4,   256,   257,  -297,  -297,  -297,  -297,  -297,  -297,
+    -297,  -297,   -11,     7,   261,   513,  -297,    26,    28,  -297,
+     427,   577,    59,  -297,  -297,  -297,  -297,  -297,  -297,  -297,
+    -297,  -297,  -297,  -297,   513,   513,   513,  -297,  -297,  -297,
+    -297,  -297,  -297,   513,   263,   577,   577,   577,  -297,  -297,
+     577,  -297,  -297,  -297,   577,  -297,  -297,   577,  -297,  -297,
+     513,   513,  -297,   217,   203,  -297,  -297,  -297,    21,  -297,
+    -297,  -297,  -297,   190,   190,  -297,    17,  -297,  -297,  -297,
+     358,   -14,    59,  -297,  -297,  -297,  -297,   225,  -297,  -297,
+    -297,  -297,   218,  -297,  -297,   185,   121,   259,  -297,   224,
+    -297,    59,   272,   272,   212,   112,   221,  -297,  -297,    25,
+     229,   268,  -297,  -297,  -297,   -14,   220,  -297,   438,   513,
+     513,   513,   226,  -297,  -297,   227,   513,  -297,  -297,  -297,
+    -297,  -297,  -297,  -297,  -297,  -297,  -297,  -297,    14,  -297,
+    -297,    43,   513,   502,  -297,    61,   300,   220,  -297,   141,
+    -297,   513,   513,  -297,  -297,  -297,   438,  -297,    57,   358,
+     235,   358,  -297,  -297,  -297,  -297,  -297,   358,   358,  -297,
+    -297,   513,  -297,  -297,   274,  -297,   438,   513,  -297,  -297,
+     193,   102,    10,  -297,  -297,    18,  -297,  -297,   358,   358,
+    -297,   358,   513,  -297,  -297,   513,  -297,   220,  -297,  -297,
+    -297,   358,   238,     5,  -297,   102,   358,   513,  -297,  -297,
+     243,  -297,   282
+};
+
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_uint8 yydefact[] =
+{
+      10,     0,     0,     0,     0,     0,     0,     0,     0,    22,
+       0,     2,     4,     5,     6,     9,     8,     7,    46,    45,
+       0,    38,     0,    12,    17,    35,    36,    11,    13,     0,
+       0,     0,    20,    19,    21,     0,     1,    10,     0,     0,
+      56,     0,     0,    73,     0,     0,     0,     0,    55,    66,
+      40,    54,    53,    61,    51,    50,    52,     0,     0,     0,
+       0,    15,    14,    31,     3,     0,    48,    44,     0,   201,
+      39,    71,     0,    69,    75,     0,    65,     0,     0,    82,
+       0,     0,     0,    78,     0,    89,     0,     0,    84,     0,
+       0,    64,    18,     0,     0,     0,     0,     0,     0,     0,
+     190,     0,   201,     0,   185,   181,   183,   182,   184,     0,
+     167,    34,    99,   101,   114,   116,   118,   126,   129,   132,
+     134,   136,   140,   145,   155,   163,   168,   179,   177,   176,
+     178,    37,    16,    26,     0,    24,    30,    29,    28,    27,
+      47,     0,     0,    57,     0,    42,    68,     0,     0,    74,
+       0,    32,    33,    81,    80,    77,    79,     0,    88,    83,
+      85,     0,     0,     0,   154,   153,   148,   149,   150,   152,
+     151,   188,     0,     0,     0,   173,   193,     0,     0,   198,
+       0,   128,     0,   102,   103,   104,   105,   106,   107,   108,
+     109,   110,   111,   112,     0,     0,     0,   119,   120,   121,
+     122,   123,   124,     0,     0,     0,     0,     0,   137,   138,
+       0,   141,   142,   143,     0,   146,   147,     0,   157,   158,
+     166,    95,   161,     0,    31,    23,    49,    59,     0,    41,
+     201,   202,    72,    70,    76,    87,     0,    67,    62,    63,
+     212,     0,     0,   169,   172,   180,   174,   171,   191,   201,
+     192,   201,     0,   201,   194,   127,     0,   113,   100,   115,
+     117,     0,   130,   131,   133,   135,   139,   144,   164,     0,
+       0,    94,   156,    25,    58,     0,    43,    86,     0,     0,
+       0,     0,     0,   213,   214,     0,    93,   227,   203,   206,
+      92,   228,   204,   205,   209,   210,   208,   211,     0,   207,
+     189,     0,     0,   196,   199,     0,     0,   197,   170,     0,
+     162,     0,    95,   159,    60,    97,     0,    96,     0,   212,
+       0,   212,   201,    90,   231,    91,   186,   212,   212,   175,
+     195,     0,   125,   165,     0,    94,     0,     0,    98,   217,
+       0,     0,     0,   230,   229,     0,   201,   160,   212,   212,
+     226,   212,     0,   221,   218,     0,   187,   200,   215,   216,
+     220,   212,     0,     0,   223,     0,   212,     0,   222,   219,
+       0,   224,   225
+};
+
+/* YYPGOTO[NTERM-NUM].  */
+static const yytype_int16 yypgoto[] =
+{
+    -297,  -297,   285,     0,    49,  -297,  -297,  -297,  -297,   100,
+     -39,  -297,   -36,     1,   -61,   -60,  -297,   -54,  -297,  -297,
+     -17,     6,  -297,  -297,  -297,  -297,  -297,  -297,   236,  -297,
+    -297,   246,  -297,  -297,   249,  -297,  -297,    22,  -219,  -251,
+     -52,  -170,  -297,  -297,   136,   137,  -297,   142,  -297,   165,
+      75,   140,  -297,   138,  -297,   135,  -297,   -81,  -297,  -297,
+    -297,  -297,  -297,  -297,  -297,  -297,  -297,  -297,  -297,  -297,
+    -297,    47,  -297,   104,  -101,  -296,  -297,  -297,  -297,  -297,
+    -297,    -9,  -297,  -297,   -10,   -90,  -229,  -297
+};
+
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_int16 yydefgoto[] =
+{
+       0,    10,    11,   287,    23,    13,    35,    14,   134,   135,
+      80,    24,    25,    26,    15,    16,   144,    17,    19,    65,
+      74,    51,   228,    52,    53,    72,    73,    54,    75,    55,
+      82,    83,    56,    87,    88,   288,   289,   270,   316,   317,
+     290,   112,   195,   113,   114,   115,   203,   116,   117,   118,
+     119,   120,   210,   121,   214,   122,   217,   123,   124,   269,
+     125,   174,   175,   247,   126,   127,   128,   129,   172,   130,
+     177,   254,   178,   179,   145,   291,   292,   293,   294,   295,
+     296,   354,   297,   363,   364,   339,   340,   299
+};
+
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
+static const yytype_int16 yytable[] =
+{
+      12,   180,   137,   138,    22,    50,   111,    71,    86,   139,
+      81,   298,   164,   165,   166,   167,   168,   169,   170,    36,
+     218,   219,    67,    49,   136,   258,    41,   367,   319,   321,
+     322,   344,   355,   142,   149,   140,   237,    12,   163,    32,
+      49,    18,   131,    70,    66,    49,    81,   243,    86,   173,
+     268,   220,   326,   221,    27,    28,   356,   222,    90,    20,
+      49,   274,    91,   133,   171,   310,   240,    33,   248,   143,
+     250,   241,   242,    21,   150,    34,   344,   141,   150,    61,
+      62,    21,    84,   368,    90,   157,   349,   231,    91,   244,
+      49,   327,   341,   223,   277,   327,    37,   336,    43,   345,
+      44,   361,    45,   275,   181,   337,    92,   311,   249,   132,
+     251,   232,    77,    78,    39,    85,   159,   348,   211,   212,
+     328,    38,   213,   246,    46,    47,    40,    40,   253,   276,
+      57,   233,   365,   234,   338,    48,   267,   370,   231,    42,
+     236,   333,   252,   227,   230,    58,    21,   226,   303,    49,
+     305,    49,   307,   351,   352,    93,    94,    59,    49,    95,
+      96,   308,    90,   137,   138,   256,    91,   147,   148,   271,
+     139,    77,    78,    84,    79,    97,     1,    60,    98,   327,
+     353,   332,    90,    49,    21,   136,    91,    99,   100,    63,
+     101,    68,   102,     2,     3,   103,    29,    30,    31,     4,
+       5,     6,     7,    77,    78,   300,    85,   205,   206,   104,
+     105,   106,   107,   108,     8,     9,   208,   209,    69,    77,
+      78,   342,    79,   155,   133,   301,   318,   320,   320,   320,
+     162,    90,    21,    76,   325,    91,    89,   109,   110,     4,
+       5,     6,     7,    49,   309,   357,   215,   216,   229,     1,
+     329,   253,   197,   198,   199,   200,   201,   202,   358,   359,
+     335,   360,    49,   146,   320,   151,     2,     3,   224,   225,
+     327,   350,     4,     5,     6,     7,   314,    77,    78,   346,
+     262,   263,   153,   152,   320,   320,    93,    94,   154,   176,
+      95,    96,   158,   182,   196,   204,   207,   231,   238,   239,
+     320,   245,   261,   362,   272,   306,    97,   302,   312,    98,
+     313,   331,   338,   323,   324,   362,   347,   366,    99,   100,
+     372,   101,    64,   102,   273,   161,   103,   343,   156,   278,
+     257,   279,   280,   259,   334,   281,   160,   282,   283,   284,
+     104,   105,   106,   107,   108,   260,   255,   264,   265,   266,
+     330,     4,     5,     6,     7,   304,   369,   371,     0,  -212,
+       0,   285,    93,    94,     0,   286,    95,    96,   109,   110,
+       0,     0,   343,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,    97,     0,     0,    98,     0,     0,     0,     0,
+       0,     0,     0,     0,    99,   100,     0,   101,     0,   102,
+       0,     0,   103,     0,     0,   278,     0,   279,   280,     0,
+       0,   281,     0,   282,   283,   284,   104,   105,   106,   107,
+     108,     0,    43,     0,    44,     0,    45,     4,     5,     6,
+       7,    93,    94,     0,     0,    95,    96,   285,     0,     0,
+       0,   286,    93,    94,   109,   110,    95,    96,    46,    47,
+      40,    97,     0,     0,    98,     0,     0,     0,     0,    48,
+     235,     0,    97,    99,   100,    98,   101,     0,   102,     0,
+      21,   103,     0,     0,    99,   100,     0,   101,     0,   102,
+       0,     0,   103,     0,     0,   104,   105,   106,   107,   108,
+       0,     0,     0,     0,     0,     0,   104,   105,   106,   107,
+     108,     0,     0,     0,   231,     0,    93,    94,   252,     0,
+      95,    96,     0,   109,   110,   315,     0,    93,    94,     0,
+       0,    95,    96,     0,   109,   110,    97,     0,     0,    98,
+       0,     0,     0,     0,     0,     0,     0,    97,    99,   100,
+      98,   101,     0,   102,     0,     0,   103,     0,     0,    99,
+     100,     0,   101,     0,   102,     0,     0,   103,     0,     0,
+     104,   105,   106,   107,   108,     0,     0,     0,     0,     0,
+       0,   104,   105,   106,   107,   108,     0,     0,     0,   231,
+       0,    93,    94,     0,     0,    95,    96,     0,   109,   110,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,   109,
+     110,    97,     0,     0,    98,     0,     0,     0,     0,     0,
+       0,     0,     0,    99,   100,     0,   101,     0,   102,   183,
+     184,   185,   186,   187,   188,   189,   190,   191,   192,   193,
+       0,     0,     0,     0,     0,   104,   105,   106,   107,   108,
+       0,     0,   194,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,   109,   110
+};
+
+static const yytype_int16 yycheck[] =
+{
+       0,   102,    63,    63,     3,    22,    58,    43,    47,    63,
+      46,   240,    93,    94,    95,    96,    97,    98,    99,     0,
+       8,     9,    39,    22,    63,   195,    20,    22,   279,   280,
+     281,   327,    22,    39,    42,    40,    40,    37,    90,    59,
+      39,    87,    59,    42,    38,    44,    82,    40,    87,   101,
+     220,    39,    38,    41,     5,     6,    38,    45,    41,    87,
+      59,    40,    45,    63,   100,    40,    77,    87,    42,    68,
+      42,    82,    83,    87,    82,    87,   372,    82,    82,    30,
+      31,    87,    44,    78,    41,    84,   337,    77,    45,    82,
+      89,    77,   321,    81,    77,    77,    77,   316,    39,   328,
+      41,   352,    43,    82,   103,    48,    57,    82,    82,    60,
+      82,   147,    74,    75,    11,    77,    78,   336,     6,     7,
+      77,    39,    10,   175,    65,    66,    67,    67,   180,   230,
+      82,   148,   361,   150,    77,    76,   217,   366,    77,    81,
+     157,   311,    81,   142,   144,    11,    87,   141,   249,   148,
+     251,   150,   253,    51,    52,     4,     5,    79,   157,     8,
+       9,    40,    41,   224,   224,   182,    45,    82,    83,   221,
+     224,    74,    75,    44,    77,    24,    46,    69,    27,    77,
+      78,    40,    41,   182,    87,   224,    45,    36,    37,    11,
+      39,    80,    41,    63,    64,    44,    68,    69,    70,    69,
+      70,    71,    72,    74,    75,   241,    77,    22,    23,    58,
+      59,    60,    61,    62,    84,    85,     4,     5,    11,    74,
+      75,   322,    77,    78,   224,   242,   278,   279,   280,   281,
+      79,    41,    87,    87,   286,    45,    39,    86,    87,    69,
+      70,    71,    72,   242,   261,   346,    25,    26,    78,    46,
+     302,   303,    28,    29,    30,    31,    32,    33,   348,   349,
+     312,   351,   261,    40,   316,    79,    63,    64,    77,    78,
+      77,    78,    69,    70,    71,    72,   275,    74,    75,   331,
+     205,   206,    77,    79,   336,   337,     4,     5,    77,    42,
+       8,     9,    77,    39,    35,    73,    24,    77,    42,    42,
+     352,    40,    39,   355,    87,    87,    24,    82,    79,    27,
+      42,    11,    77,    87,    87,   367,    42,    79,    36,    37,
+      77,    39,    37,    41,   224,    89,    44,   327,    82,    47,
+     194,    49,    50,   196,   312,    53,    87,    55,    56,    57,
+      58,    59,    60,    61,    62,   203,   181,   207,   210,   214,
+     303,    69,    70,    71,    72,   251,   365,   367,    -1,    77,
+      -1,    79,     4,     5,    -1,    83,     8,     9,    86,    87,
+      -1,    -1,   372,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    24,    -1,    -1,    27,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    36,    37,    -1,    39,    -1,    41,
+      -1,    -1,    44,    -1,    -1,    47,    -1,    49,    50,    -1,
+      -1,    53,    -1,    55,    56,    57,    58,    59,    60,    61,
+      62,    -1,    39,    -1,    41,    -1,    43,    69,    70,    71,
+      72,     4,     5,    -1,    -1,     8,     9,    79,    -1,    -1,
+      -1,    83,     4,     5,    86,    87,     8,     9,    65,    66,
+      67,    24,    -1,    -1,    27,    -1,    -1,    -1,    -1,    76,
+      77,    -1,    24,    36,    37,    27,    39,    -1,    41,    -1,
+      87,    44,    -1,    -1,    36,    37,    -1,    39,    -1,    41,
+      -1,    -1,    44,    -1,    -1,    58,    59,    60,    61,    62,
+      -1,    -1,    -1,    -1,    -1,    -1,    58,    59,    60,    61,
+      62,    -1,    -1,    -1,    77,    -1,     4,     5,    81,    -1,
+       8,     9,    -1,    86,    87,    77,    -1,     4,     5,    -1,
+      -1,     8,     9,    -1,    86,    87,    24,    -1,    -1,    27,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    24,    36,    37,
+      27,    39,    -1,    41,    -1,    -1,    44,    -1,    -1,    36,
+      37,    -1,    39,    -1,    41,    -1,    -1,    44,    -1,    -1,
+      58,    59,    60,    61,    62,    -1,    -1,    -1,    -1,    -1,
+      -1,    58,    59,    60,    61,    62,    -1,    -1,    -1,    77,
+      -1,     4,     5,    -1,    -1,     8,     9,    -1,    86,    87,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    86,
+      87,    24,    -1,    -1,    27,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    36,    37,    -1,    39,    -1,    41,    11,
+      12,    13,    14,    15,    16,    17,    18,    19,    20,    21,
+      -1,    -1,    -1,    -1,    -1,    58,    59,    60,    61,    62,
+      -1,    -1,    34,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    86,    87
+};
+
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_uint8 yystos[] =
+{
+       0,    46,    63,    64,    69,    70,    71,    72,    84,    85,
+      90,    91,    92,    94,    96,   103,   104,   106,    87,   107,
+      87,    87,   102,    93,   100,   101,   102,    93,    93,    68,
+      69,    70,    59,    87,    87,    95,     0,    77,    39,    11,
+      67,   110,    81,    39,    41,    43,    65,    66,    76,   102,
+     109,   110,   112,   113,   116,   118,   121,    82,    11,    79,
+      69,    93,    93,    11,    91,   108,   110,   109,    80,    11,
+     102,   101,   114,   115,   109,   117,    87,    74,    75,    77,
+      99,   101,   119,   120,    44,    77,    99,   122,   123,    39,
+      41,    45,    93,     4,     5,     8,     9,    24,    27,    36,
+      37,    39,    41,    44,    58,    59,    60,    61,    62,    86,
+      87,   129,   130,   132,   133,   134,   136,   137,   138,   139,
+     140,   142,   144,   146,   147,   149,   153,   154,   155,   156,
+     158,   109,    93,    92,    97,    98,    99,   103,   104,   106,
+      40,    82,    39,   102,   105,   163,    40,    82,    83,    42,
+      82,    79,    79,    77,    77,    78,   120,   102,    77,    78,
+     123,   117,    79,   129,   146,   146,   146,   146,   146,   146,
+     146,   101,   157,   129,   150,   151,    42,   159,   161,   162,
+     163,   102,    39,    11,    12,    13,    14,    15,    16,    17,
+      18,    19,    20,    21,    34,   131,    35,    28,    29,    30,
+      31,    32,    33,   135,    73,    22,    23,    24,     4,     5,
+     141,     6,     7,    10,   143,    25,    26,   145,     8,     9,
+      39,    41,    45,    81,    77,    78,   110,   102,   111,    78,
+      92,    77,   101,   109,   109,    77,   109,    40,    42,    42,
+      77,    82,    83,    40,    82,    40,   129,   152,    42,    82,
+      42,    82,    81,   129,   160,   138,   109,   133,   130,   134,
+     136,    39,   139,   139,   140,   142,   144,   146,   130,   148,
+     126,   129,    87,    98,    40,    82,   163,    77,    47,    49,
+      50,    53,    55,    56,    57,    79,    83,    92,   124,   125,
+     129,   164,   165,   166,   167,   168,   169,   171,   175,   176,
+     101,   109,    82,   163,   162,   163,    87,   163,    40,   109,
+      40,    82,    79,    42,   102,    77,   127,   128,   129,   128,
+     129,   128,   128,    87,    87,   129,    38,    77,    77,   129,
+     160,    11,    40,   130,   126,   129,   127,    48,    77,   174,
+     175,   175,   163,    92,   164,   175,   129,    42,   127,   128,
+      78,    51,    52,    78,   170,    22,    38,   163,   174,   174,
+     174,   128,   129,   172,   173,   175,    79,    22,    78,   170,
+     175,   173,    77
+};
+
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_uint8 yyr1[] =
+{
+       0,    89,    90,    90,    91,    91,    91,    91,    91,    91,
+      91,    92,    92,    92,    92,    92,    92,    93,    93,    94,
+      94,    95,    95,    96,    97,    97,    98,    98,    98,    98,
+      98,    98,    99,    99,   100,   100,   101,   101,   102,   102,
+     103,   104,   105,   105,   106,   106,   107,   107,   108,   108,
+     109,   109,   109,   109,   109,   109,   110,   110,   110,   111,
+     111,   112,   112,   112,   112,   112,   112,   112,   113,   114,
+     114,   115,   115,   115,   116,   117,   117,   118,   119,   119,
+     120,   120,   120,   121,   122,   122,   123,   123,   123,   123,
+     124,   125,   125,   125,   126,   126,   127,   127,   128,   129,
+     130,   130,   131,   131,   131,   131,   131,   131,   131,   131,
+     131,   131,   131,   132,   132,   133,   133,   134,   134,   135,
+     135,   135,   135,   135,   135,   136,   136,   137,   137,   137,
+     138,   138,   138,   139,   139,   140,   140,   141,   141,   142,
+     142,   143,   143,   143,   144,   144,   145,   145,   146,   146,
+     146,   146,   146,   146,   146,   146,   147,   147,   147,   147,
+     147,   147,   147,   147,   148,   148,   148,   149,   149,   149,
+     149,   150,   151,   152,   152,   152,   153,   153,   153,   153,
+     154,   155,   155,   155,   155,   155,   156,   156,   157,   157,
+     157,   158,   158,   158,   159,   159,   159,   160,   161,   161,
+     162,   163,   163,   164,   164,   164,   164,   164,   164,   164,
+     164,   164,   164,   165,   166,   167,   167,   168,   169,   170,
+     170,   170,   171,   172,   172,   173,   174,   175,   175,   175,
+     175,   176
+};
+
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
+{
+       0,     2,     1,     3,     1,     1,     1,     1,     1,     1,
+       0,     2,     2,     2,     3,     3,     4,     1,     3,     2,
+       2,     1,     0,     5,     1,     3,     1,     1,     1,     1,
+       1,     0,     2,     2,     3,     1,     1,     3,     1,     3,
+       3,     6,     1,     3,     4,     2,     1,     4,     1,     3,
+       1,     1,     1,     1,     1,     1,     1,     3,     5,     1,
+       3,     1,     4,     4,     2,     2,     1,     4,     3,     1,
+       3,     1,     3,     0,     3,     1,     3,     3,     1,     2,
+       2,     2,     1,     3,     1,     2,     4,     3,     2,     1,
+       2,     2,     1,     1,     1,     0,     1,     1,     2,     1,
+       3,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+       1,     1,     1,     3,     1,     3,     1,     3,     1,     1,
+       1,     1,     1,     1,     1,     5,     1,     3,     2,     1,
+       3,     3,     1,     3,     1,     3,     1,     1,     1,     3,
+       1,     1,     1,     1,     3,     1,     1,     1,     2,     2,
+       2,     2,     2,     2,     2,     1,     3,     2,     2,     4,
+       6,     2,     4,     1,     1,     3,     0,     1,     1,     3,
+       4,     2,     2,     0,     1,     3,     1,     1,     1,     1,
+       3,     1,     1,     1,     1,     1,     5,     7,     1,     3,
+       0,     3,     3,     2,     2,     4,     3,     2,     1,     3,
+       6,     0,     2,     1,     1,     1,     1,     1,     1,     1,
+       1,     1,     0,     1,     1,     5,     5,     3,     4,     4,
+       2,     1,     6,     1,     3,     4,     2,     1,     1,     3,
+       3,     2
+};
+
+
+enum { YYENOMEM = -2 };
+
+#define yyerrok         (yyerrstatus = 0)
+#define yyclearin       (yychar = YYEMPTY)
+
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
+
+
+#define YYRECOVERING()  (!!yyerrstatus)
+
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
+
+
+/* Enable debugging if requested.  */
+#if YYDEBUG
+
+# ifndef YYFPRINTF
+#  include <stdio.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYFPRINTF fprintf
+# endif
+
+# define YYDPRINTF(Args)                        \
+do {                                            \
+  if (yydebug)                                  \
+    YYFPRINTF Args;                             \
+} while (0)
+
+
+
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
+do {                                                                      \
+  if (yydebug)                                                            \
+    {                                                                     \
+      YYFPRINTF (stderr, "%s ", Title);                                   \
+      yy_symbol_print (stderr,                                            \
+                  Kind, Value); \
+      YYFPRINTF (stderr, "\n");                                           \
+    }                                                                     \
+} while (0)
+
+
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
+
+static void
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+{
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
+  if (!yyvaluep)
+    return;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
+
+static void
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+{
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
+
+  yy_symbol_value_print (yyo, yykind, yyvaluep);
+  YYFPRINTF (yyo, ")");
+}
+
+/*------------------------------------------------------------------.
+| yy_stack_print -- Print the state stack from its BOTTOM up to its |
+| TOP (included).                                                   |
+`------------------------------------------------------------------*/
+
+static void
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
+{
+  YYFPRINTF (stderr, "Stack now");
+  for (; yybottom <= yytop; yybottom++)
+    {
+      int yybot = *yybottom;
+      YYFPRINTF (stderr, " %d", yybot);
+    }
+  YYFPRINTF (stderr, "\n");
+}
+
+# define YY_STACK_PRINT(Bottom, Top)                            \
+do {                                                            \
+  if (yydebug)                                                  \
+    yy_stack_print ((Bottom), (Top));                           \
+} while (0)
+
+
+/*------------------------------------------------.
+| Report that the YYRULE is going to be reduced.  |
+`------------------------------------------------*/
+
+static void
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule)
+{
+  int yylno = yyrline[yyrule];
+  int yynrhs = yyr2[yyrule];
+  int yyi;
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
+             yyrule - 1, yylno);
+  /* The symbols being reduced.  */
+  for (yyi = 0; yyi < yynrhs; yyi++)
+    {
+      YYFPRINTF (stderr, "   $%d = ", yyi + 1);
+      yy_symbol_print (stderr,
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)]);
+      YYFPRINTF (stderr, "\n");
+    }
+}
+
+# define YY_REDUCE_PRINT(Rule)          \
+do {                                    \
+  if (yydebug)                          \
+    yy_reduce_print (yyssp, yyvsp, Rule); \
+} while (0)
+
+/* Nonzero means print parse trace.  It is left uninitialized so that
+   multiple parsers can coexist.  */
+int yydebug;
+#else /* !YYDEBUG */
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
+# define YY_STACK_PRINT(Bottom, Top)
+# define YY_REDUCE_PRINT(Rule)
+#endif /* !YYDEBUG */
+
+
+/* YYINITDEPTH -- initial size of the parser's stacks.  */
+#ifndef YYINITDEPTH
+# define YYINITDEPTH 200
+#endif
+
+/* YYMAXDEPTH -- maximum size the stacks can grow to (effective only
+   if the built-in stack extension method is used).
+
+   Do not make this value too large; the results are undefined if
+   YYSTACK_ALLOC_MAXIMUM < YYSTACK_BYTES (YYMAXDEPTH)
+   evaluated with infinite-precision integer arithmetic.  */
+
+#ifndef YYMAXDEPTH
+# define YYMAXDEPTH 10000
+#endif
+
+
+
+
+
+
+/*-----------------------------------------------.
+| Release the memory associated to this symbol.  |
+`-----------------------------------------------*/
+
+static void
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep)
+{
+  YY_USE (yyvaluep);
+  if (!yymsg)
+    yymsg = "Deleting";
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+/* Lookahead token kind.  */
+int yychar;
+
+/* The semantic value of the lookahead symbol.  */
+YYSTYPE yylval;
+/* Number of syntax errors so far.  */
+int yynerrs;
+
+
+
+
+/*----------.
+| yyparse.  |
+`----------*/
+
+int
+yyparse (void)
+{
+    yy_state_fast_t yystate = 0;
+    /* Number of tokens to shift before error messages enabled.  */
+    int yyerrstatus = 0;
+
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
+       to reallocate them elsewhere.  */
+
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
+
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
+
+  int yyn;
+  /* The return value of yyparse.  */
+  int yyresult;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
+  /* The variables used to return semantic value and location from the
+     action routines.  */
+  YYSTYPE yyval;
+
+
+
+#define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
+
+  /* The number of symbols on the RHS of the reduced rule.
+     Keep to zero when no symbol should be popped.  */
+  int yylen = 0;
+
+  YYDPRINTF ((stderr, "Starting parse\n"));
+
+  yychar = YYEMPTY; /* Cause a token to be read.  */
+
+  goto yysetstate;
+
+
+/*------------------------------------------------------------.
+| yynewstate -- push a new state, which is found in yystate.  |
+`------------------------------------------------------------*/
+yynewstate:
+  /* In all cases, when you get here, the value and location stacks
+     have just been pushed.  So pushing a state here evens the stacks.  */
+  yyssp++;
+
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
+
+  if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
+    {
+      /* Get the current used size of the three stacks, in elements.  */
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
+
+# if defined yyoverflow
+      {
+        /* Give user a chance to reallocate the stack.  Use copies of
+           these so that the &'s don't force the real ones into
+           memory.  */
+        yy_state_t *yyss1 = yyss;
+        YYSTYPE *yyvs1 = yyvs;
+
+        /* Each stack pointer address is followed by the size of the
+           data in use in that stack, in bytes.  This used to be a
+           conditional around just the two extra args, but that might
+           be undefined if yyoverflow is a macro.  */
+        yyoverflow (YY_("memory exhausted"),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
+                    &yystacksize);
+        yyss = yyss1;
+        yyvs = yyvs1;
+      }
+# else /* defined YYSTACK_RELOCATE */
+      /* Extend the stack our own way.  */
+      if (YYMAXDEPTH <= yystacksize)
+        YYNOMEM;
+      yystacksize *= 2;
+      if (YYMAXDEPTH < yystacksize)
+        yystacksize = YYMAXDEPTH;
+
+      {
+        yy_state_t *yyss1 = yyss;
+        union yyalloc *yyptr =
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
+        if (! yyptr)
+          YYNOMEM;
+        YYSTACK_RELOCATE (yyss_alloc, yyss);
+        YYSTACK_RELOCATE (yyvs_alloc, yyvs);
+#  undef YYSTACK_RELOCATE
+        if (yyss1 != yyssa)
+          YYSTACK_FREE (yyss1);
+      }
+# endif
+
+      yyssp = yyss + yysize - 1;
+      yyvsp = yyvs + yysize - 1;
+
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
+
+      if (yyss + yystacksize - 1 <= yyssp)
+        YYABORT;
+    }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
+
+
+  if (yystate == YYFINAL)
+    YYACCEPT;
+
+  goto yybackup;
+
+
+/*-----------.
+| yybackup.  |
+`-----------*/
+yybackup:
+  /* Do appropriate processing given the current state.  Read a
+     lookahead token if we need one and don't already have one.  */
+
+  /* First try to decide what to do without reference to lookahead token.  */
+  yyn = yypact[yystate];
+  if (yypact_value_is_default (yyn))
+    goto yydefault;
+
+  /* Not known => get a lookahead token if don't already have one.  */
+
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
+  if (yychar == YYEMPTY)
+    {
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex ();
+    }
+
+  if (yychar <= YYEOF)
+    {
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
+      YYDPRINTF ((stderr, "Now at end of input.\n"));
+    }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
+  else
+    {
+      yytoken = YYTRANSLATE (yychar);
+      YY_SYMBOL_PRINT ("Next token is", yytoken, &yylval, &yylloc);
+    }
+
+  /* If the proper action on seeing token YYTOKEN is to reduce or to
+     detect an error, take that action.  */
+  yyn += yytoken;
+  if (yyn < 0 || YYLAST < yyn || yycheck[yyn] != yytoken)
+    goto yydefault;
+  yyn = yytable[yyn];
+  if (yyn <= 0)
+    {
+      if (yytable_value_is_error (yyn))
+        goto yyerrlab;
+      yyn = -yyn;
+      goto yyreduce;
+    }
+
+  /* Count tokens shifted since error; after three, turn off error
+     status.  */
+  if (yyerrstatus)
+    yyerrstatus--;
+
+  /* Shift the lookahead token.  */
+  YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
+  yystate = yyn;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
+  goto yynewstate;
+
+
+/*-----------------------------------------------------------.
+| yydefault -- do the default action for the current state.  |
+`-----------------------------------------------------------*/
+yydefault:
+  yyn = yydefact[yystate];
+  if (yyn == 0)
+    goto yyerrlab;
+  goto yyreduce;
+
+
+/*-----------------------------.
+| yyreduce -- do a reduction.  |
+`-----------------------------*/
+yyreduce:
+  /* yyn is the number of a rule to reduce with.  */
+  yylen = yyr2[yyn];
+
+  /* If YYLEN is nonzero, implement the default value of the action:
+     '$$ = $1'.
+
+     Otherwise, the following line sets YYVAL to garbage.
+     This behavior is undocumented and Bison
+     users should not rely upon it.  Assigning to YYVAL
+     unconditionally makes the parser a bit smaller, and it avoids a
+     GCC warning that YYVAL may be used uninitialized.  */
+  yyval = yyvsp[1-yylen];
+
+
+  YY_REDUCE_PRINT (yyn);
+  switch (yyn)
+    {
+  case 4: /* toplev: decl  */
+#line 197 "gram.y"
+            {size_t i;
+             for (i = 0; i < (yyvsp[0].nodelist).nn; i++) {
+                lappend(&file->file.stmts, &file->file.nstmts, (yyvsp[0].nodelist).nl[i]);
+                (yyvsp[0].nodelist).nl[i]->decl.isglobl = 1;
+                putdcl(file->file.globls, (yyvsp[0].nodelist).nl[i]);
+             }}
+#line 1616 "gram.c"
+    break;
+
+  case 5: /* toplev: use  */
+#line 204 "gram.y"
+            {lappend(&file->file.uses, &file->file.nuses, (yyvsp[0].node));}
+#line 1622 "gram.c"
+    break;
+
+  case 7: /* toplev: tydef  */
+#line 207 "gram.y"
+            {puttype(file->file.globls, mkname((yyvsp[0].tydef).line, (yyvsp[0].tydef).name), (yyvsp[0].tydef).type);
+             installucons(file->file.globls, (yyvsp[0].tydef).type);}
+#line 1629 "gram.c"
+    break;
+
+  case 11: /* decl: Tvar decllist  */
+#line 215 "gram.y"
+            {(yyval.nodelist) = (yyvsp[0].nodelist);}
+#line 1635 "gram.c"
+    break;
+
+  case 12: /* decl: Tconst decllist  */
+#line 217 "gram.y"
+            {size_t i;
+             for (i = 0; i < (yyvsp[0].nodelist).nn; i++)
+                (yyvsp[0].nodelist).nl[i]->decl.isconst = 1;
+             (yyval.nodelist) = (yyvsp[0].nodelist);}
+#line 1644 "gram.c"
+    break;
+
+  case 13: /* decl: Tgeneric decllist  */
+#line 222 "gram.y"
+            {size_t i;
+             for (i = 0; i < (yyvsp[0].nodelist).nn; i++) {
+                (yyvsp[0].nodelist).nl[i]->decl.isconst = 1;
+                (yyvsp[0].nodelist).nl[i]->decl.isgeneric = 1;
+             }
+             (yyval.nodelist) = (yyvsp[0].nodelist);}
+#line 1655 "gram.c"
+    break;
+
+  case 14: /* decl: Textern Tvar decllist  */
+#line 229 "gram.y"
+            {size_t i;
+             for (i = 0; i < (yyvsp[0].nodelist).nn; i++)
+                (yyvsp[0].nodelist).nl[i]->decl.isextern = 1;
+             (yyval.nodelist) = (yyvsp[0].nodelist);}
+#line 1664 "gram.c"
+    break;
+
+  case 15: /* decl: Textern Tconst decllist  */
+#line 234 "gram.y"
+            {size_t i;
+             for (i = 0; i < (yyvsp[0].nodelist).nn; i++) {
+                (yyvsp[0].nodelist).nl[i]->decl.isconst = 1;
+                (yyvsp[0].nodelist).nl[i]->decl.isextern = 1;
+             }
+             (yyval.nodelist) = (yyvsp[0].nodelist);}
+#line 1675 "gram.c"
+    break;
+
+  case 16: /* decl: Textern Tattr Tconst decllist  */
+#line 241 "gram.y"
+            {size_t i;
+             if (strcmp((yyvsp[-2].tok)->str, "stkcc"))
+                fatal((yyvsp[-2].tok)->line, "Unknown attribute $%s", (yyvsp[-2].tok)->str);
+             for (i = 0; i < (yyvsp[0].nodelist).nn; i++) {
+                (yyvsp[0].nodelist).nl[i]->decl.isconst = 1;
+                (yyvsp[0].nodelist).nl[i]->decl.isextern = 1;
+                (yyvsp[0].nodelist).nl[i]->decl.isstkcc = 1;
+             }
+             (yyval.nodelist) = (yyvsp[0].nodelist);}
+#line 1689 "gram.c"
+    break;
+
+  case 17: /* decllist: declbody  */
+#line 253 "gram.y"
+            {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0;
+             lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 1696 "gram.c"
+    break;
+
+  case 18: /* decllist: declbody Tcomma decllist  */
+#line 256 "gram.y"
+             {linsert(&(yyvsp[0].nodelist).nl, &(yyvsp[0].nodelist).nn, 0, (yyvsp[-2].node));
+             (yyval.nodelist)=(yyvsp[0].nodelist);}
+#line 1703 "gram.c"
+    break;
+
+  case 19: /* use: Tuse Tident  */
+#line 261 "gram.y"
+            {(yyval.node) = mkuse((yyvsp[-1].tok)->line, (yyvsp[0].tok)->str, 0);}
+#line 1709 "gram.c"
+    break;
+
+  case 20: /* use: Tuse Tstrlit  */
+#line 263 "gram.y"
+            {(yyval.node) = mkuse((yyvsp[-1].tok)->line, (yyvsp[0].tok)->str, 1);}
+#line 1715 "gram.c"
+    break;
+
+  case 21: /* optident: Tident  */
+#line 266 "gram.y"
+                      {(yyval.tok) = (yyvsp[0].tok);}
+#line 1721 "gram.c"
+    break;
+
+  case 22: /* optident: %empty  */
+#line 267 "gram.y"
+                      {(yyval.tok) = NULL;}
+#line 1727 "gram.c"
+    break;
+
+  case 23: /* package: Tpkg optident Tasn pkgbody Tendblk  */
+#line 271 "gram.y"
+            {if (file->file.exports->name)
+                 fatal((yyvsp[-4].tok)->line, "Package already declared\n");
+             if ((yyvsp[-3].tok)) {
+                 updatens(file->file.exports, (yyvsp[-3].tok)->str);
+                 updatens(file->file.globls, (yyvsp[-3].tok)->str);
+             }
+            }
+#line 1739 "gram.c"
+    break;
+
+  case 26: /* pkgitem: decl  */
+#line 285 "gram.y"
+            {size_t i;
+            for (i = 0; i < (yyvsp[0].nodelist).nn; i++) {
+                putdcl(file->file.exports, (yyvsp[0].nodelist).nl[i]);
+                if ((yyvsp[0].nodelist).nl[i]->decl.init)
+                    lappend(&file->file.stmts, &file->file.nstmts, (yyvsp[0].nodelist).nl[i]);
+            }}
+#line 1750 "gram.c"
+    break;
+
+  case 27: /* pkgitem: tydef  */
+#line 291 "gram.y"
+                {puttype(file->file.exports, mkname((yyvsp[0].tydef).line, (yyvsp[0].tydef).name), (yyvsp[0].tydef).type);
+             installucons(file->file.exports, (yyvsp[0].tydef).type);}
+#line 1757 "gram.c"
+    break;
+
+  case 30: /* pkgitem: visdef  */
+#line 295 "gram.y"
+                 {die("Unimplemented visdef");}
+#line 1763 "gram.c"
+    break;
+
+  case 34: /* declbody: declcore Tasn expr  */
+#line 304 "gram.y"
+            {(yyval.node) = (yyvsp[-2].node); (yyvsp[-2].node)->decl.init = (yyvsp[0].node);}
+#line 1769 "gram.c"
+    break;
+
+  case 36: /* declcore: name  */
+#line 309 "gram.y"
+            {(yyval.node) = mkdecl((yyvsp[0].node)->line, (yyvsp[0].node), mktyvar((yyvsp[0].node)->line));}
+#line 1775 "gram.c"
+    break;
+
+  case 37: /* declcore: name Tcolon type  */
+#line 311 "gram.y"
+            {(yyval.node) = mkdecl((yyvsp[-2].node)->line, (yyvsp[-2].node), (yyvsp[0].ty));}
+#line 1781 "gram.c"
+    break;
+
+  case 38: /* name: Tident  */
+#line 315 "gram.y"
+            {(yyval.node) = mkname((yyvsp[0].tok)->line, (yyvsp[0].tok)->str);}
+#line 1787 "gram.c"
+    break;
+
+  case 39: /* name: Tident Tdot name  */
+#line 317 "gram.y"
+            {(yyval.node) = (yyvsp[0].node); setns((yyvsp[0].node), (yyvsp[-2].tok)->str);}
+#line 1793 "gram.c"
+    break;
+
+  case 40: /* implstmt: Timpl name type  */
+#line 320 "gram.y"
+                          {
+            (yyval.node) = NULL;
+            die("impl foo not done");
+            }
+#line 1802 "gram.c"
+    break;
+
+  case 41: /* traitdef: Ttrait Tident generictype Tasn traitbody Tendblk  */
+#line 327 "gram.y"
+            {(yyval.node) = mktrait((yyvsp[-5].tok)->line, mkname((yyvsp[-4].tok)->line, (yyvsp[-4].tok)->str), (yyvsp[-1].nodelist).nl, (yyvsp[-1].nodelist).nn, NULL, 0);}
+#line 1808 "gram.c"
+    break;
+
+  case 42: /* traitbody: endlns  */
+#line 331 "gram.y"
+                 {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0;}
+#line 1814 "gram.c"
+    break;
+
+  case 43: /* traitbody: traitbody decl endlns  */
+#line 333 "gram.y"
+            {size_t i;
+             (yyval.nodelist) = (yyvsp[-2].nodelist);
+             for (i = 0; i < (yyvsp[-1].nodelist).nn; i++)
+                lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[-1].nodelist).nl[i]);
+            }
+#line 1824 "gram.c"
+    break;
+
+  case 44: /* tydef: Ttype typeid Tasn type  */
+#line 342 "gram.y"
+            {(yyval.tydef) = (yyvsp[-2].tydef);
+             (yyval.tydef).type = mktyname((yyvsp[-2].tydef).line, mkname((yyvsp[-2].tydef).line, (yyvsp[-2].tydef).name), (yyvsp[-2].tydef).params, (yyvsp[-2].tydef).nparams, (yyvsp[0].ty));}
+#line 1831 "gram.c"
+    break;
+
+  case 45: /* tydef: Ttype typeid  */
+#line 345 "gram.y"
+            {(yyval.tydef) = (yyvsp[0].tydef);}
+#line 1837 "gram.c"
+    break;
+
+  case 46: /* typeid: Tident  */
+#line 349 "gram.y"
+            {(yyval.tydef).line = (yyvsp[0].tok)->line;
+             (yyval.tydef).name = (yyvsp[0].tok)->str;
+             (yyval.tydef).params = NULL;
+             (yyval.tydef).type = NULL;}
+#line 1846 "gram.c"
+    break;
+
+  case 47: /* typeid: Tident Toparen typarams Tcparen  */
+#line 354 "gram.y"
+            {(yyval.tydef).line = (yyvsp[-3].tok)->line;
+             (yyval.tydef).name = (yyvsp[-3].tok)->str;
+             (yyval.tydef).params = (yyvsp[-1].tylist).types;
+             (yyval.tydef).nparams = (yyvsp[-1].tylist).ntypes;
+             (yyval.tydef).type = NULL;}
+#line 1856 "gram.c"
+    break;
+
+  case 48: /* typarams: generictype  */
+#line 362 "gram.y"
+            {(yyval.tylist).types = NULL; (yyval.tylist).ntypes = 0;
+             lappend(&(yyval.tylist).types, &(yyval.tylist).ntypes, (yyvsp[0].ty));}
+#line 1863 "gram.c"
+    break;
+
+  case 49: /* typarams: typarams Tcomma generictype  */
+#line 365 "gram.y"
+            {lappend(&(yyval.tylist).types, &(yyval.tylist).ntypes, (yyvsp[0].ty));}
+#line 1869 "gram.c"
+    break;
+
+  case 55: /* type: Tellipsis  */
+#line 373 "gram.y"
+                    {(yyval.ty) = mktype((yyvsp[0].tok)->line, Tyvalist);}
+#line 1875 "gram.c"
+    break;
+
+  case 56: /* generictype: Ttyparam  */
+#line 378 "gram.y"
+            {(yyval.ty) = mktyparam((yyvsp[0].tok)->line, (yyvsp[0].tok)->str);}
+#line 1881 "gram.c"
+    break;
+
+  case 57: /* generictype: Ttyparam Twith name  */
+#line 380 "gram.y"
+            {(yyval.ty) = mktyparam((yyvsp[-2].tok)->line, (yyvsp[-2].tok)->str);
+             constrainwith((yyval.ty), (yyvsp[0].node)->name.name);}
+#line 1888 "gram.c"
+    break;
+
+  case 58: /* generictype: Ttyparam Twith Toparen typaramlist Tcparen  */
+#line 383 "gram.y"
+            {size_t i;
+             (yyval.ty) = mktyparam((yyvsp[-4].tok)->line, (yyvsp[-4].tok)->str);
+             for (i = 0; i < (yyvsp[-1].nodelist).nn; i++)
+                constrainwith((yyval.ty), (yyvsp[-1].nodelist).nl[i]->name.name);}
+#line 1897 "gram.c"
+    break;
+
+  case 59: /* typaramlist: name  */
+#line 391 "gram.y"
+            {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0;
+             lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 1904 "gram.c"
+    break;
+
+  case 60: /* typaramlist: typaramlist Tcomma name  */
+#line 394 "gram.y"
+            {lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 1910 "gram.c"
+    break;
+
+  case 61: /* compoundtype: functype  */
+#line 398 "gram.y"
+                     {(yyval.ty) = (yyvsp[0].ty);}
+#line 1916 "gram.c"
+    break;
+
+  case 62: /* compoundtype: type Tosqbrac Tcolon Tcsqbrac  */
+#line 399 "gram.y"
+                                        {(yyval.ty) = mktyslice((yyvsp[-2].tok)->line, (yyvsp[-3].ty));}
+#line 1922 "gram.c"
+    break;
+
+  case 63: /* compoundtype: type Tosqbrac expr Tcsqbrac  */
+#line 400 "gram.y"
+                                      {(yyval.ty) = mktyarray((yyvsp[-2].tok)->line, (yyvsp[-3].ty), (yyvsp[-1].node));}
+#line 1928 "gram.c"
+    break;
+
+  case 64: /* compoundtype: type Tderef  */
+#line 401 "gram.y"
+                      {(yyval.ty) = mktyptr((yyvsp[0].tok)->line, (yyvsp[-1].ty));}
+#line 1934 "gram.c"
+    break;
+
+  case 65: /* compoundtype: Tat Tident  */
+#line 402 "gram.y"
+                     {(yyval.ty) = mktyparam((yyvsp[-1].tok)->line, (yyvsp[0].tok)->str);}
+#line 1940 "gram.c"
+    break;
+
+  case 66: /* compoundtype: name  */
+#line 403 "gram.y"
+                     {(yyval.ty) = mktyunres((yyvsp[0].node)->line, (yyvsp[0].node), NULL, 0);}
+#line 1946 "gram.c"
+    break;
+
+  case 67: /* compoundtype: name Toparen typelist Tcparen  */
+#line 404 "gram.y"
+                                        {(yyval.ty) = mktyunres((yyvsp[-3].node)->line, (yyvsp[-3].node), (yyvsp[-1].tylist).types, (yyvsp[-1].tylist).ntypes);}
+#line 1952 "gram.c"
+    break;
+
+  case 68: /* functype: Toparen funcsig Tcparen  */
+#line 407 "gram.y"
+                                  {(yyval.ty) = (yyvsp[-1].ty);}
+#line 1958 "gram.c"
+    break;
+
+  case 69: /* funcsig: argdefs  */
+#line 411 "gram.y"
+            {(yyval.ty) = mktyfunc((yyvsp[0].nodelist).line, (yyvsp[0].nodelist).nl, (yyvsp[0].nodelist).nn, mktyvar((yyvsp[0].nodelist).line));}
+#line 1964 "gram.c"
+    break;
+
+  case 70: /* funcsig: argdefs Tret type  */
+#line 413 "gram.y"
+            {(yyval.ty) = mktyfunc((yyvsp[-2].nodelist).line, (yyvsp[-2].nodelist).nl, (yyvsp[-2].nodelist).nn, (yyvsp[0].ty));}
+#line 1970 "gram.c"
+    break;
+
+  case 71: /* argdefs: declcore  */
+#line 417 "gram.y"
+            {(yyval.nodelist).line = (yyvsp[0].node)->line;
+             (yyval.nodelist).nl = NULL;
+             (yyval.nodelist).nn = 0; lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 1978 "gram.c"
+    break;
+
+  case 72: /* argdefs: argdefs Tcomma declcore  */
+#line 421 "gram.y"
+            {lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 1984 "gram.c"
+    break;
+
+  case 73: /* argdefs: %empty  */
+#line 423 "gram.y"
+            {(yyval.nodelist).line = line;
+             (yyval.nodelist).nl = NULL;
+             (yyval.nodelist).nn = 0;}
+#line 1992 "gram.c"
+    break;
+
+  case 74: /* tupledef: Tosqbrac typelist Tcsqbrac  */
+#line 429 "gram.y"
+            {(yyval.ty) = mktytuple((yyvsp[-2].tok)->line, (yyvsp[-1].tylist).types, (yyvsp[-1].tylist).ntypes);}
+#line 1998 "gram.c"
+    break;
+
+  case 75: /* typelist: type  */
+#line 433 "gram.y"
+            {(yyval.tylist).types = NULL; (yyval.tylist).ntypes = 0;
+             lappend(&(yyval.tylist).types, &(yyval.tylist).ntypes, (yyvsp[0].ty));}
+#line 2005 "gram.c"
+    break;
+
+  case 76: /* typelist: typelist Tcomma type  */
+#line 436 "gram.y"
+            {lappend(&(yyval.tylist).types, &(yyval.tylist).ntypes, (yyvsp[0].ty));}
+#line 2011 "gram.c"
+    break;
+
+  case 77: /* structdef: Tstruct structbody Tendblk  */
+#line 441 "gram.y"
+            {(yyval.ty) = mktystruct((yyvsp[-2].tok)->line, (yyvsp[-1].nodelist).nl, (yyvsp[-1].nodelist).nn);}
+#line 2017 "gram.c"
+    break;
+
+  case 78: /* structbody: structent  */
+#line 446 "gram.y"
+            {if ((yyvsp[0].node)) {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0; lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}}
+#line 2023 "gram.c"
+    break;
+
+  case 79: /* structbody: structbody structent  */
+#line 448 "gram.y"
+            {if ((yyvsp[0].node)) {lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}}
+#line 2029 "gram.c"
+    break;
+
+  case 80: /* structent: declcore Tendln  */
+#line 453 "gram.y"
+            {(yyval.node) = (yyvsp[-1].node);}
+#line 2035 "gram.c"
+    break;
+
+  case 81: /* structent: visdef Tendln  */
+#line 455 "gram.y"
+            {(yyval.node) = NULL;}
+#line 2041 "gram.c"
+    break;
+
+  case 82: /* structent: Tendln  */
+#line 457 "gram.y"
+            {(yyval.node) = NULL;}
+#line 2047 "gram.c"
+    break;
+
+  case 83: /* uniondef: Tunion unionbody Tendblk  */
+#line 462 "gram.y"
+            {(yyval.ty) = mktyunion((yyvsp[-2].tok)->line, (yyvsp[-1].uconlist).ucl, (yyvsp[-1].uconlist).nucl);}
+#line 2053 "gram.c"
+    break;
+
+  case 84: /* unionbody: unionelt  */
+#line 467 "gram.y"
+            {(yyval.uconlist).ucl = NULL; (yyval.uconlist).nucl = 0;
+             if ((yyvsp[0].ucon)) {lappend(&(yyval.uconlist).ucl, &(yyval.uconlist).nucl, (yyvsp[0].ucon));}}
+#line 2060 "gram.c"
+    break;
+
+  case 85: /* unionbody: unionbody unionelt  */
+#line 470 "gram.y"
+            {if ((yyvsp[0].ucon)) {lappend(&(yyval.uconlist).ucl, &(yyval.uconlist).nucl, (yyvsp[0].ucon));}}
+#line 2066 "gram.c"
+    break;
+
+  case 86: /* unionelt: Ttick name type Tendln  */
+#line 475 "gram.y"
+            {(yyval.ucon) = mkucon((yyvsp[-2].node)->line, (yyvsp[-2].node), NULL, (yyvsp[-1].ty));}
+#line 2072 "gram.c"
+    break;
+
+  case 87: /* unionelt: Ttick name Tendln  */
+#line 477 "gram.y"
+            {(yyval.ucon) = mkucon((yyvsp[-1].node)->line, (yyvsp[-1].node), NULL, NULL);}
+#line 2078 "gram.c"
+    break;
+
+  case 88: /* unionelt: visdef Tendln  */
+#line 479 "gram.y"
+            {(yyval.ucon) = NULL;}
+#line 2084 "gram.c"
+    break;
+
+  case 89: /* unionelt: Tendln  */
+#line 481 "gram.y"
+            {(yyval.ucon) = NULL;}
+#line 2090 "gram.c"
+    break;
+
+  case 90: /* goto: Tgoto Tident  */
+#line 485 "gram.y"
+                {(yyval.node) = mkexpr((yyvsp[-1].tok)->line, Ojmp, mklbl((yyvsp[0].tok)->line, (yyvsp[0].tok)->str), NULL);}
+#line 2096 "gram.c"
+    break;
+
+  case 91: /* retexpr: Tret expr  */
+#line 489 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-1].tok)->line, Oret, (yyvsp[0].node), NULL);}
+#line 2102 "gram.c"
+    break;
+
+  case 93: /* retexpr: Tret  */
+#line 492 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[0].tok)->line, Oret, NULL);}
+#line 2108 "gram.c"
+    break;
+
+  case 94: /* optexpr: expr  */
+#line 495 "gram.y"
+               {(yyval.node) = (yyvsp[0].node);}
+#line 2114 "gram.c"
+    break;
+
+  case 95: /* optexpr: %empty  */
+#line 496 "gram.y"
+                      {(yyval.node) = NULL;}
+#line 2120 "gram.c"
+    break;
+
+  case 96: /* optexprln: exprln  */
+#line 499 "gram.y"
+                  {(yyval.node) = (yyvsp[0].node);}
+#line 2126 "gram.c"
+    break;
+
+  case 97: /* optexprln: Tendln  */
+#line 500 "gram.y"
+                  {(yyval.node) = NULL;}
+#line 2132 "gram.c"
+    break;
+
+  case 100: /* asnexpr: lorexpr asnop asnexpr  */
+#line 510 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].node)->line, binop((yyvsp[-1].tok)->type), (yyvsp[-2].node), (yyvsp[0].node), NULL);}
+#line 2138 "gram.c"
+    break;
+
+  case 113: /* lorexpr: lorexpr Tlor landexpr  */
+#line 528 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].node)->line, binop((yyvsp[-1].tok)->type), (yyvsp[-2].node), (yyvsp[0].node), NULL);}
+#line 2144 "gram.c"
+    break;
+
+  case 115: /* landexpr: landexpr Tland cmpexpr  */
+#line 533 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].node)->line, binop((yyvsp[-1].tok)->type), (yyvsp[-2].node), (yyvsp[0].node), NULL);}
+#line 2150 "gram.c"
+    break;
+
+  case 117: /* cmpexpr: cmpexpr cmpop castexpr  */
+#line 538 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].node)->line, binop((yyvsp[-1].tok)->type), (yyvsp[-2].node), (yyvsp[0].node), NULL);}
+#line 2156 "gram.c"
+    break;
+
+  case 125: /* castexpr: unionexpr Tcast Toparen type Tcparen  */
+#line 546 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-4].node)->line, Ocast, (yyvsp[-4].node), NULL);
+             (yyval.node)->expr.type = (yyvsp[-1].ty);}
+#line 2163 "gram.c"
+    break;
+
+  case 127: /* unionexpr: Ttick name borexpr  */
+#line 553 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].tok)->line, Oucon, (yyvsp[-1].node), (yyvsp[0].node), NULL);}
+#line 2169 "gram.c"
+    break;
+
+  case 128: /* unionexpr: Ttick name  */
+#line 555 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-1].tok)->line, Oucon, (yyvsp[0].node), NULL);}
+#line 2175 "gram.c"
+    break;
+
+  case 130: /* borexpr: borexpr Tbor bandexpr  */
+#line 561 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].node)->line, binop((yyvsp[-1].tok)->type), (yyvsp[-2].node), (yyvsp[0].node), NULL);}
+#line 2181 "gram.c"
+    break;
+
+  case 131: /* borexpr: borexpr Tbxor bandexpr  */
+#line 563 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].node)->line, binop((yyvsp[-1].tok)->type), (yyvsp[-2].node), (yyvsp[0].node), NULL);}
+#line 2187 "gram.c"
+    break;
+
+  case 133: /* bandexpr: bandexpr Tband addexpr  */
+#line 568 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].node)->line, binop((yyvsp[-1].tok)->type), (yyvsp[-2].node), (yyvsp[0].node), NULL);}
+#line 2193 "gram.c"
+    break;
+
+  case 135: /* addexpr: addexpr addop mulexpr  */
+#line 573 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].node)->line, binop((yyvsp[-1].tok)->type), (yyvsp[-2].node), (yyvsp[0].node), NULL);}
+#line 2199 "gram.c"
+    break;
+
+  case 139: /* mulexpr: mulexpr mulop shiftexpr  */
+#line 580 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].node)->line, binop((yyvsp[-1].tok)->type), (yyvsp[-2].node), (yyvsp[0].node), NULL);}
+#line 2205 "gram.c"
+    break;
+
+  case 144: /* shiftexpr: shiftexpr shiftop prefixexpr  */
+#line 589 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].node)->line, binop((yyvsp[-1].tok)->type), (yyvsp[-2].node), (yyvsp[0].node), NULL);}
+#line 2211 "gram.c"
+    break;
+
+  case 148: /* prefixexpr: Tinc prefixexpr  */
+#line 596 "gram.y"
+                               {(yyval.node) = mkexpr((yyvsp[-1].tok)->line, Opreinc, (yyvsp[0].node), NULL);}
+#line 2217 "gram.c"
+    break;
+
+  case 149: /* prefixexpr: Tdec prefixexpr  */
+#line 597 "gram.y"
+                               {(yyval.node) = mkexpr((yyvsp[-1].tok)->line, Opredec, (yyvsp[0].node), NULL);}
+#line 2223 "gram.c"
+    break;
+
+  case 150: /* prefixexpr: Tband prefixexpr  */
+#line 598 "gram.y"
+                               {(yyval.node) = mkexpr((yyvsp[-1].tok)->line, Oaddr, (yyvsp[0].node), NULL);}
+#line 2229 "gram.c"
+    break;
+
+  case 151: /* prefixexpr: Tlnot prefixexpr  */
+#line 599 "gram.y"
+                               {(yyval.node) = mkexpr((yyvsp[-1].tok)->line, Olnot, (yyvsp[0].node), NULL);}
+#line 2235 "gram.c"
+    break;
+
+  case 152: /* prefixexpr: Tbnot prefixexpr  */
+#line 600 "gram.y"
+                               {(yyval.node) = mkexpr((yyvsp[-1].tok)->line, Obnot, (yyvsp[0].node), NULL);}
+#line 2241 "gram.c"
+    break;
+
+  case 153: /* prefixexpr: Tminus prefixexpr  */
+#line 601 "gram.y"
+                               {(yyval.node) = mkexpr((yyvsp[-1].tok)->line, Oneg, (yyvsp[0].node), NULL);}
+#line 2247 "gram.c"
+    break;
+
+  case 154: /* prefixexpr: Tplus prefixexpr  */
+#line 602 "gram.y"
+                               {(yyval.node) = (yyvsp[0].node);}
+#line 2253 "gram.c"
+    break;
+
+  case 156: /* postfixexpr: postfixexpr Tdot Tident  */
+#line 608 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-2].node)->line, Omemb, (yyvsp[-2].node), mkname((yyvsp[0].tok)->line, (yyvsp[0].tok)->str), NULL);}
+#line 2259 "gram.c"
+    break;
+
+  case 157: /* postfixexpr: postfixexpr Tinc  */
+#line 610 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-1].node)->line, Opostinc, (yyvsp[-1].node), NULL);}
+#line 2265 "gram.c"
+    break;
+
+  case 158: /* postfixexpr: postfixexpr Tdec  */
+#line 612 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-1].node)->line, Opostdec, (yyvsp[-1].node), NULL);}
+#line 2271 "gram.c"
+    break;
+
+  case 159: /* postfixexpr: postfixexpr Tosqbrac expr Tcsqbrac  */
+#line 614 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-3].node)->line, Oidx, (yyvsp[-3].node), (yyvsp[-1].node), NULL);}
+#line 2277 "gram.c"
+    break;
+
+  case 160: /* postfixexpr: postfixexpr Tosqbrac optexpr Tcolon optexpr Tcsqbrac  */
+#line 616 "gram.y"
+            {(yyval.node) = mksliceexpr((yyvsp[-5].node)->line, (yyvsp[-5].node), (yyvsp[-3].node), (yyvsp[-1].node));}
+#line 2283 "gram.c"
+    break;
+
+  case 161: /* postfixexpr: postfixexpr Tderef  */
+#line 618 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-1].node)->line, Oderef, (yyvsp[-1].node), NULL);}
+#line 2289 "gram.c"
+    break;
+
+  case 162: /* postfixexpr: postfixexpr Toparen arglist Tcparen  */
+#line 620 "gram.y"
+            {(yyval.node) = mkcall((yyvsp[-3].node)->line, (yyvsp[-3].node), (yyvsp[-1].nodelist).nl, (yyvsp[-1].nodelist).nn);}
+#line 2295 "gram.c"
+    break;
+
+  case 164: /* arglist: asnexpr  */
+#line 625 "gram.y"
+            {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0; lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 2301 "gram.c"
+    break;
+
+  case 165: /* arglist: arglist Tcomma asnexpr  */
+#line 627 "gram.y"
+            {lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 2307 "gram.c"
+    break;
+
+  case 166: /* arglist: %empty  */
+#line 629 "gram.y"
+            {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0;}
+#line 2313 "gram.c"
+    break;
+
+  case 167: /* atomicexpr: Tident  */
+#line 634 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[0].tok)->line, Ovar, mkname((yyvsp[0].tok)->line, (yyvsp[0].tok)->str), NULL);}
+#line 2319 "gram.c"
+    break;
+
+  case 169: /* atomicexpr: Toparen expr Tcparen  */
+#line 637 "gram.y"
+            {(yyval.node) = (yyvsp[-1].node);}
+#line 2325 "gram.c"
+    break;
+
+  case 170: /* atomicexpr: Tsizeof Toparen type Tcparen  */
+#line 639 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[-3].tok)->line, Osize, mkpseudodecl((yyvsp[-1].ty)), NULL);}
+#line 2331 "gram.c"
+    break;
+
+  case 171: /* tupbody: tuphead tuprest  */
+#line 643 "gram.y"
+            {(yyval.nodelist) = (yyvsp[0].nodelist);
+             linsert(&(yyval.nodelist).nl, &(yyval.nodelist).nn, 0, (yyvsp[-1].node));}
+#line 2338 "gram.c"
+    break;
+
+  case 172: /* tuphead: expr Tcomma  */
+#line 647 "gram.y"
+                      {(yyval.node) = (yyvsp[-1].node);}
+#line 2344 "gram.c"
+    break;
+
+  case 173: /* tuprest: %empty  */
+#line 651 "gram.y"
+            {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0;}
+#line 2350 "gram.c"
+    break;
+
+  case 174: /* tuprest: expr  */
+#line 653 "gram.y"
+            {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0; lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 2356 "gram.c"
+    break;
+
+  case 175: /* tuprest: tuprest Tcomma expr  */
+#line 655 "gram.y"
+            {lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 2362 "gram.c"
+    break;
+
+  case 176: /* literal: funclit  */
+#line 658 "gram.y"
+                        {(yyval.node) = mkexpr((yyvsp[0].node)->line, Olit, (yyvsp[0].node), NULL);}
+#line 2368 "gram.c"
+    break;
+
+  case 177: /* literal: littok  */
+#line 659 "gram.y"
+                        {(yyval.node) = mkexpr((yyvsp[0].node)->line, Olit, (yyvsp[0].node), NULL);}
+#line 2374 "gram.c"
+    break;
+
+  case 178: /* literal: seqlit  */
+#line 660 "gram.y"
+                        {(yyval.node) = (yyvsp[0].node);}
+#line 2380 "gram.c"
+    break;
+
+  case 179: /* literal: tuplit  */
+#line 661 "gram.y"
+                        {(yyval.node) = (yyvsp[0].node);}
+#line 2386 "gram.c"
+    break;
+
+  case 180: /* tuplit: Toparen tupbody Tcparen  */
+#line 665 "gram.y"
+            {(yyval.node) = mkexprl((yyvsp[-2].tok)->line, Otup, (yyvsp[-1].nodelist).nl, (yyvsp[-1].nodelist).nn);}
+#line 2392 "gram.c"
+    break;
+
+  case 181: /* littok: Tstrlit  */
+#line 667 "gram.y"
+                        {(yyval.node) = mkstr((yyvsp[0].tok)->line, (yyvsp[0].tok)->str);}
+#line 2398 "gram.c"
+    break;
+
+  case 182: /* littok: Tchrlit  */
+#line 668 "gram.y"
+                        {(yyval.node) = mkchar((yyvsp[0].tok)->line, (yyvsp[0].tok)->chrval);}
+#line 2404 "gram.c"
+    break;
+
+  case 183: /* littok: Tfloatlit  */
+#line 669 "gram.y"
+                        {(yyval.node) = mkfloat((yyvsp[0].tok)->line, (yyvsp[0].tok)->fltval);}
+#line 2410 "gram.c"
+    break;
+
+  case 184: /* littok: Tboollit  */
+#line 670 "gram.y"
+                        {(yyval.node) = mkbool((yyvsp[0].tok)->line, !strcmp((yyvsp[0].tok)->str, "true"));}
+#line 2416 "gram.c"
+    break;
+
+  case 185: /* littok: Tintlit  */
+#line 672 "gram.y"
+                {(yyval.node) = mkint((yyvsp[0].tok)->line, (yyvsp[0].tok)->intval);
+		 if ((yyvsp[0].tok)->inttype)
+		 	(yyval.node)->lit.type = mktype((yyvsp[0].tok)->line, (yyvsp[0].tok)->inttype);}
+#line 2424 "gram.c"
+    break;
+
+  case 186: /* funclit: Tobrace params Tendln blkbody Tcbrace  */
+#line 678 "gram.y"
+            {(yyval.node) = mkfunc((yyvsp[-4].tok)->line, (yyvsp[-3].nodelist).nl, (yyvsp[-3].nodelist).nn, mktyvar((yyvsp[-2].tok)->line), (yyvsp[-1].node));}
+#line 2430 "gram.c"
+    break;
+
+  case 187: /* funclit: Tobrace params Tret type Tendln blkbody Tcbrace  */
+#line 680 "gram.y"
+            {(yyval.node) = mkfunc((yyvsp[-6].tok)->line, (yyvsp[-5].nodelist).nl, (yyvsp[-5].nodelist).nn, (yyvsp[-3].ty), (yyvsp[-1].node));}
+#line 2436 "gram.c"
+    break;
+
+  case 188: /* params: declcore  */
+#line 684 "gram.y"
+            {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0; lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 2442 "gram.c"
+    break;
+
+  case 189: /* params: params Tcomma declcore  */
+#line 686 "gram.y"
+            {lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 2448 "gram.c"
+    break;
+
+  case 190: /* params: %empty  */
+#line 688 "gram.y"
+            {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0;}
+#line 2454 "gram.c"
+    break;
+
+  case 191: /* seqlit: Tosqbrac arrayelts Tcsqbrac  */
+#line 692 "gram.y"
+            {(yyval.node) = mkexprl((yyvsp[-2].tok)->line, Oarr, (yyvsp[-1].nodelist).nl, (yyvsp[-1].nodelist).nn);}
+#line 2460 "gram.c"
+    break;
+
+  case 192: /* seqlit: Tosqbrac structelts Tcsqbrac  */
+#line 694 "gram.y"
+            {(yyval.node) = mkexprl((yyvsp[-2].tok)->line, Ostruct, (yyvsp[-1].nodelist).nl, (yyvsp[-1].nodelist).nn);}
+#line 2466 "gram.c"
+    break;
+
+  case 193: /* seqlit: Tosqbrac Tcsqbrac  */
+#line 696 "gram.y"
+            {(yyval.node) = mkexprl((yyvsp[-1].tok)->line, Oarr, NULL, 0);}
+#line 2472 "gram.c"
+    break;
+
+  case 194: /* arrayelts: endlns arrayelt  */
+#line 701 "gram.y"
+            {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0;
+             lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, mkidxinit((yyvsp[0].node)->line, mkint((yyvsp[0].node)->line, 0), (yyvsp[0].node)));}
+#line 2479 "gram.c"
+    break;
+
+  case 195: /* arrayelts: arrayelts Tcomma endlns arrayelt  */
+#line 704 "gram.y"
+             {lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, mkidxinit((yyvsp[0].node)->line, mkint((yyvsp[0].node)->line, (yyval.nodelist).nn), (yyvsp[0].node)));}
+#line 2485 "gram.c"
+    break;
+
+  case 197: /* arrayelt: expr endlns  */
+#line 708 "gram.y"
+                      {(yyval.node) = (yyvsp[-1].node);}
+#line 2491 "gram.c"
+    break;
+
+  case 198: /* structelts: structelt  */
+#line 713 "gram.y"
+            {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0;
+             lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 2498 "gram.c"
+    break;
+
+  case 199: /* structelts: structelts Tcomma structelt  */
+#line 716 "gram.y"
+             {lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 2504 "gram.c"
+    break;
+
+  case 200: /* structelt: endlns Tdot Tident Tasn expr endlns  */
+#line 720 "gram.y"
+            {(yyval.node) = mkidxinit((yyvsp[-4].tok)->line, mkname((yyvsp[-3].tok)->line, (yyvsp[-3].tok)->str), (yyvsp[-1].node));}
+#line 2510 "gram.c"
+    break;
+
+  case 212: /* stmt: %empty  */
+#line 736 "gram.y"
+                      {(yyval.node) = NULL;}
+#line 2516 "gram.c"
+    break;
+
+  case 213: /* break: Tbreak  */
+#line 740 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[0].tok)->line, Obreak, NULL);}
+#line 2522 "gram.c"
+    break;
+
+  case 214: /* continue: Tcontinue  */
+#line 744 "gram.y"
+            {(yyval.node) = mkexpr((yyvsp[0].tok)->line, Ocontinue, NULL);}
+#line 2528 "gram.c"
+    break;
+
+  case 215: /* forstmt: Tfor optexprln optexprln optexprln block  */
+#line 748 "gram.y"
+            {(yyval.node) = mkloopstmt((yyvsp[-4].tok)->line, (yyvsp[-3].node), (yyvsp[-2].node), (yyvsp[-1].node), (yyvsp[0].node));}
+#line 2534 "gram.c"
+    break;
+
+  case 216: /* forstmt: Tfor expr Tin exprln block  */
+#line 750 "gram.y"
+            {(yyval.node) = mkiterstmt((yyvsp[-4].tok)->line, (yyvsp[-3].node), (yyvsp[-1].node), (yyvsp[0].node));}
+#line 2540 "gram.c"
+    break;
+
+  case 217: /* whilestmt: Twhile exprln block  */
+#line 759 "gram.y"
+            {(yyval.node) = mkloopstmt((yyvsp[-2].tok)->line, NULL, (yyvsp[-1].node), NULL, (yyvsp[0].node));}
+#line 2546 "gram.c"
+    break;
+
+  case 218: /* ifstmt: Tif exprln blkbody elifs  */
+#line 763 "gram.y"
+            {(yyval.node) = mkifstmt((yyvsp[-3].tok)->line, (yyvsp[-2].node), (yyvsp[-1].node), (yyvsp[0].node));}
+#line 2552 "gram.c"
+    break;
+
+  case 219: /* elifs: Telif exprln blkbody elifs  */
+#line 767 "gram.y"
+            {(yyval.node) = mkifstmt((yyvsp[-3].tok)->line, (yyvsp[-2].node), (yyvsp[-1].node), (yyvsp[0].node));}
+#line 2558 "gram.c"
+    break;
+
+  case 220: /* elifs: Telse block  */
+#line 769 "gram.y"
+            {(yyval.node) = (yyvsp[0].node);}
+#line 2564 "gram.c"
+    break;
+
+  case 221: /* elifs: Tendblk  */
+#line 771 "gram.y"
+            {(yyval.node) = NULL;}
+#line 2570 "gram.c"
+    break;
+
+  case 222: /* matchstmt: Tmatch exprln endlns Tbor matches Tendblk  */
+#line 775 "gram.y"
+            {(yyval.node) = mkmatchstmt((yyvsp[-5].tok)->line, (yyvsp[-4].node), (yyvsp[-1].nodelist).nl, (yyvsp[-1].nodelist).nn);}
+#line 2576 "gram.c"
+    break;
+
+  case 223: /* matches: match  */
+#line 779 "gram.y"
+            {(yyval.nodelist).nl = NULL; (yyval.nodelist).nn = 0;
+             if ((yyvsp[0].node))
+                 lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 2584 "gram.c"
+    break;
+
+  case 224: /* matches: matches Tbor match  */
+#line 783 "gram.y"
+            {if ((yyvsp[-1].tok))
+                 lappend(&(yyval.nodelist).nl, &(yyval.nodelist).nn, (yyvsp[0].node));}
+#line 2591 "gram.c"
+    break;
+
+  case 225: /* match: expr Tcolon blkbody Tendln  */
+#line 787 "gram.y"
+                                     {(yyval.node) = mkmatch((yyvsp[-3].node)->line, (yyvsp[-3].node), (yyvsp[-1].node));}
+#line 2597 "gram.c"
+    break;
+
+  case 227: /* blkbody: decl  */
+#line 794 "gram.y"
+            {size_t i;
+             (yyval.node) = mkblock(line, mkstab());
+             for (i = 0; i < (yyvsp[0].nodelist).nn; i++) {
+                putdcl((yyval.node)->block.scope, (yyvsp[0].nodelist).nl[i]);
+                lappend(&(yyval.node)->block.stmts, &(yyval.node)->block.nstmts, (yyvsp[0].nodelist).nl[i]);
+            }}
+#line 2608 "gram.c"
+    break;
+
+  case 228: /* blkbody: stmt  */
+#line 801 "gram.y"
+            {(yyval.node) = mkblock(line, mkstab());
+             if ((yyvsp[0].node))
+                lappend(&(yyval.node)->block.stmts, &(yyval.node)->block.nstmts, (yyvsp[0].node));}
+#line 2616 "gram.c"
+    break;
+
+  case 229: /* blkbody: blkbody Tendln stmt  */
+#line 805 "gram.y"
+            {if ((yyvsp[0].node))
+                lappend(&(yyvsp[-2].node)->block.stmts, &(yyvsp[-2].node)->block.nstmts, (yyvsp[0].node));
+             (yyval.node) = (yyvsp[-2].node);}
+#line 2624 "gram.c"
+    break;
+
+  case 230: /* blkbody: blkbody Tendln decl  */
+#line 809 "gram.y"
+            {size_t i;
+             for (i = 0; i < (yyvsp[0].nodelist).nn; i++){
+                putdcl((yyval.node)->block.scope, (yyvsp[0].nodelist).nl[i]);
+                lappend(&(yyvsp[-2].node)->block.stmts, &(yyvsp[-2].node)->block.nstmts, (yyvsp[0].nodelist).nl[i]);
+            }}
+#line 2634 "gram.c"
+    break;
+
+  case 231: /* label: Tcolon Tident  */
+#line 817 "gram.y"
+            {(yyval.node) = mklbl((yyvsp[0].tok)->line, (yyvsp[0].tok)->str);}
+#line 2640 "gram.c"
+    break;
+
+
+#line 2644 "gram.c"
+
+      default: break;
+    }
+  /* User semantic actions sometimes alter yychar, and that requires
+     that yytoken be updated with the new translation.  We take the
+     approach of translating immediately before every use of yytoken.
+     One alternative is translating here after every semantic action,
+     but that translation would be missed if the semantic action invokes
+     YYABORT, YYACCEPT, or YYERROR immediately after altering yychar or
+     if it invokes YYBACKUP.  In the case of YYABORT or YYACCEPT, an
+     incorrect destructor might then be invoked immediately.  In the
+     case of YYERROR or YYBACKUP, subsequent parser actions might lead
+     to an incorrect destructor call or verbose syntax error message
+     before the lookahead is translated.  */
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
+
+  YYPOPSTACK (yylen);
+  yylen = 0;
+
+  *++yyvsp = yyval;
+
+  /* Now 'shift' the result of the reduction.  Determine what state
+     that goes to, based on the state we popped back to and the rule
+     number reduced by.  */
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
+
+  goto yynewstate;
+
+
+/*--------------------------------------.
+| yyerrlab -- here on detecting error.  |
+`--------------------------------------*/
+yyerrlab:
+  /* Make sure we have latest lookahead translation.  See comments at
+     user semantic actions for why this is necessary.  */
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
+  /* If not already recovering from an error, report this error.  */
+  if (!yyerrstatus)
+    {
+      ++yynerrs;
+      yyerror (YY_("syntax error"));
+    }
+
+  if (yyerrstatus == 3)
+    {
+      /* If just tried and failed to reuse lookahead token after an
+         error, discard it.  */
+
+      if (yychar <= YYEOF)
+        {
+          /* Return failure if at end of input.  */
+          if (yychar == YYEOF)
+            YYABORT;
+        }
+      else
+        {
+          yydestruct ("Error: discarding",
+                      yytoken, &yylval);
+          yychar = YYEMPTY;
+        }
+    }
+
+  /* Else will try to reuse lookahead token after shifting the error
+     token.  */
+  goto yyerrlab1;
+
+
+/*---------------------------------------------------.
+| yyerrorlab -- error raised explicitly by YYERROR.  |
+`---------------------------------------------------*/
+yyerrorlab:
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
+
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYERROR.  */
+  YYPOPSTACK (yylen);
+  yylen = 0;
+  YY_STACK_PRINT (yyss, yyssp);
+  yystate = *yyssp;
+  goto yyerrlab1;
+
+
+/*-------------------------------------------------------------.
+| yyerrlab1 -- common code for both syntax error and YYERROR.  |
+`-------------------------------------------------------------*/
+yyerrlab1:
+  yyerrstatus = 3;      /* Each real token shifted decrements this.  */
+
+  /* Pop stack until we find a state that shifts the error token.  */
+  for (;;)
+    {
+      yyn = yypact[yystate];
+      if (!yypact_value_is_default (yyn))
+        {
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
+            {
+              yyn = yytable[yyn];
+              if (0 < yyn)
+                break;
+            }
+        }
+
+      /* Pop the current state because it cannot handle the error token.  */
+      if (yyssp == yyss)
+        YYABORT;
+
+
+      yydestruct ("Error: popping",
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp);
+      YYPOPSTACK (1);
+      yystate = *yyssp;
+      YY_STACK_PRINT (yyss, yyssp);
+    }
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+
+  /* Shift the error token.  */
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
+
+  yystate = yyn;
+  goto yynewstate;
+
+
+/*-------------------------------------.
+| yyacceptlab -- YYACCEPT comes here.  |
+`-------------------------------------*/
+yyacceptlab:
+  yyresult = 0;
+  goto yyreturnlab;
+
+
+/*-----------------------------------.
+| yyabortlab -- YYABORT comes here.  |
+`-----------------------------------*/
+yyabortlab:
+  yyresult = 1;
+  goto yyreturnlab;
+
+
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
+yyexhaustedlab:
+  yyerror (YY_("memory exhausted"));
+  yyresult = 2;
+  goto yyreturnlab;
+
+
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
+  if (yychar != YYEMPTY)
+    {
+      /* Make sure we have latest lookahead translation.  See comments at
+         user semantic actions for why this is necessary.  */
+      yytoken = YYTRANSLATE (yychar);
+      yydestruct ("Cleanup: discarding lookahead",
+                  yytoken, &yylval);
+    }
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYABORT or YYACCEPT.  */
+  YYPOPSTACK (yylen);
+  YY_STACK_PRINT (yyss, yyssp);
+  while (yyssp != yyss)
+    {
+      yydestruct ("Cleanup: popping",
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp);
+      YYPOPSTACK (1);
+    }
+#ifndef yyoverflow
+  if (yyss != yyssa)
+    YYSTACK_FREE (yyss);
+#endif
+
+  return yyresult;
+}
+
+#line 820 "gram.y"
+
+
+static void constrainwith(Type *t, char *str)
+{
+    size_t i;
+
+    for (i = 0; i < ncstrs; i++) {
+        if (!strcmp(cstrtab[i]->name, str)) {
+            setcstr(t, cstrtab[i]);
+            return;
+        }
+    }
+    fatal(t->line, "Constraint %s does not exist", str);
+}
+
+static Node *mkpseudodecl(Type *t)
+{
+    static int nextpseudoid;
+    char buf[128];
+
+    snprintf(buf, 128, ".pdecl%d", nextpseudoid++);
+    return mkdecl(-1, mkname(-1, buf), t);
+}
+
+static void installucons(Stab *st, Type *t)
+{
+    Type *b;
+    size_t i;
+
+    if (!t)
+        return;
+    b = tybase(t);
+    switch (b->type) {
+        case Tystruct:
+            for (i = 0; i < b->nmemb; i++)
+                installucons(st, b->sdecls[i]->decl.type);
+            break;
+        case Tyunion:
+            for (i = 0; i < b->nmemb; i++) {
+                b->udecls[i]->utype = t;
+                b->udecls[i]->id = i;
+                putucon(st, b->udecls[i]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void yyerror(const char *s)
+{
+    fprintf(stderr, "%s:%d: %s", filename, line, s);
+    if (curtok->str)
+        fprintf(stderr, " near \"%s\"", curtok->str);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+static Op binop(int tt)
+{
+    Op o;
+
+    o = Obad;
+    switch (tt) {
+        case Tplus:     o = Oadd;       break;
+        case Tminus:    o = Osub;       break;
+        case Tmul:      o = Omul;       break;
+        case Tdiv:      o = Odiv;       break;
+        case Tmod:      o = Omod;       break;
+        case Tasn:      o = Oasn;       break;
+        case Taddeq:    o = Oaddeq;     break;
+        case Tsubeq:    o = Osubeq;     break;
+        case Tmuleq:    o = Omuleq;     break;
+        case Tdiveq:    o = Odiveq;     break;
+        case Tmodeq:    o = Omodeq;     break;
+        case Tboreq:    o = Oboreq;     break;
+        case Tbxoreq:   o = Obxoreq;    break;
+        case Tbandeq:   o = Obandeq;    break;
+        case Tbsleq:    o = Obsleq;     break;
+        case Tbsreq:    o = Obsreq;     break;
+        case Tbor:      o = Obor;       break;
+        case Tbxor:     o = Obxor;      break;
+        case Tband:     o = Oband;      break;
+        case Tbsl:      o = Obsl;       break;
+        case Tbsr:      o = Obsr;       break;
+        case Teq:       o = Oeq;        break;
+        case Tgt:       o = Ogt;        break;
+        case Tlt:       o = Olt;        break;
+        case Tge:       o = Oge;        break;
+        case Tle:       o = Ole;        break;
+        case Tne:       o = One;        break;
+        case Tlor:      o = Olor;       break;
+        case Tland:     o = Oland;      break;
+        default:
+            die("Unimplemented binop\n");
+            break;
+    }
+    return o;
+}
+
@@ -0,0 +1,286 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison interface for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+#ifndef YY_YY_GRAM_H_INCLUDED
+# define YY_YY_GRAM_H_INCLUDED
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 0
+#endif
+#if YYDEBUG
+extern int yydebug;
+#endif
+
+/* Token kinds.  */
+#ifndef YYTOKENTYPE
+# define YYTOKENTYPE
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    Terror = 258,                  /* Terror  */
+    Tplus = 259,                   /* Tplus  */
+    Tminus = 260,                  /* Tminus  */
+    Tmul = 261,                    /* Tmul  */
+    Tdiv = 262,                    /* Tdiv  */
+    Tinc = 263,                    /* Tinc  */
+    Tdec = 264,                    /* Tdec  */
+    Tmod = 265,                    /* Tmod  */
+    Tasn = 266,                    /* Tasn  */
+    Taddeq = 267,                  /* Taddeq  */
+    Tsubeq = 268,                  /* Tsubeq  */
+    Tmuleq = 269,                  /* Tmuleq  */
+    Tdiveq = 270,                  /* Tdiveq  */
+    Tmodeq = 271,                  /* Tmodeq  */
+    Tboreq = 272,                  /* Tboreq  */
+    Tbxoreq = 273,                 /* Tbxoreq  */
+    Tbandeq = 274,                 /* Tbandeq  */
+    Tbsleq = 275,                  /* Tbsleq  */
+    Tbsreq = 276,                  /* Tbsreq  */
+    Tbor = 277,                    /* Tbor  */
+    Tbxor = 278,                   /* Tbxor  */
+    Tband = 279,                   /* Tband  */
+    Tbsl = 280,                    /* Tbsl  */
+    Tbsr = 281,                    /* Tbsr  */
+    Tbnot = 282,                   /* Tbnot  */
+    Teq = 283,                     /* Teq  */
+    Tgt = 284,                     /* Tgt  */
+    Tlt = 285,                     /* Tlt  */
+    Tge = 286,                     /* Tge  */
+    Tle = 287,                     /* Tle  */
+    Tne = 288,                     /* Tne  */
+    Tlor = 289,                    /* Tlor  */
+    Tland = 290,                   /* Tland  */
+    Tlnot = 291,                   /* Tlnot  */
+    Tobrace = 292,                 /* Tobrace  */
+    Tcbrace = 293,                 /* Tcbrace  */
+    Toparen = 294,                 /* Toparen  */
+    Tcparen = 295,                 /* Tcparen  */
+    Tosqbrac = 296,                /* Tosqbrac  */
+    Tcsqbrac = 297,                /* Tcsqbrac  */
+    Tat = 298,                     /* Tat  */
+    Ttick = 299,                   /* Ttick  */
+    Tderef = 300,                  /* Tderef  */
+    Ttype = 301,                   /* Ttype  */
+    Tfor = 302,                    /* Tfor  */
+    Tin = 303,                     /* Tin  */
+    Twhile = 304,                  /* Twhile  */
+    Tif = 305,                     /* Tif  */
+    Telse = 306,                   /* Telse  */
+    Telif = 307,                   /* Telif  */
+    Tmatch = 308,                  /* Tmatch  */
+    Tdefault = 309,                /* Tdefault  */
+    Tgoto = 310,                   /* Tgoto  */
+    Tbreak = 311,                  /* Tbreak  */
+    Tcontinue = 312,               /* Tcontinue  */
+    Tintlit = 313,                 /* Tintlit  */
+    Tstrlit = 314,                 /* Tstrlit  */
+    Tfloatlit = 315,               /* Tfloatlit  */
+    Tchrlit = 316,                 /* Tchrlit  */
+    Tboollit = 317,                /* Tboollit  */
+    Ttrait = 318,                  /* Ttrait  */
+    Timpl = 319,                   /* Timpl  */
+    Tstruct = 320,                 /* Tstruct  */
+    Tunion = 321,                  /* Tunion  */
+    Ttyparam = 322,                /* Ttyparam  */
+    Tattr = 323,                   /* Tattr  */
+    Tconst = 324,                  /* Tconst  */
+    Tvar = 325,                    /* Tvar  */
+    Tgeneric = 326,                /* Tgeneric  */
+    Textern = 327,                 /* Textern  */
+    Tcast = 328,                   /* Tcast  */
+    Texport = 329,                 /* Texport  */
+    Tprotect = 330,                /* Tprotect  */
+    Tellipsis = 331,               /* Tellipsis  */
+    Tendln = 332,                  /* Tendln  */
+    Tendblk = 333,                 /* Tendblk  */
+    Tcolon = 334,                  /* Tcolon  */
+    Twith = 335,                   /* Twith  */
+    Tdot = 336,                    /* Tdot  */
+    Tcomma = 337,                  /* Tcomma  */
+    Tret = 338,                    /* Tret  */
+    Tuse = 339,                    /* Tuse  */
+    Tpkg = 340,                    /* Tpkg  */
+    Tsizeof = 341,                 /* Tsizeof  */
+    Tident = 342,                  /* Tident  */
+    Teof = 343                     /* Teof  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
+#endif
+/* Token kinds.  */
+#define YYEMPTY -2
+#define YYEOF 0
+#define YYerror 256
+#define YYUNDEF 257
+#define Terror 258
+#define Tplus 259
+#define Tminus 260
+#define Tmul 261
+#define Tdiv 262
+#define Tinc 263
+#define Tdec 264
+#define Tmod 265
+#define Tasn 266
+#define Taddeq 267
+#define Tsubeq 268
+#define Tmuleq 269
+#define Tdiveq 270
+#define Tmodeq 271
+#define Tboreq 272
+#define Tbxoreq 273
+#define Tbandeq 274
+#define Tbsleq 275
+#define Tbsreq 276
+#define Tbor 277
+#define Tbxor 278
+#define Tband 279
+#define Tbsl 280
+#define Tbsr 281
+#define Tbnot 282
+#define Teq 283
+#define Tgt 284
+#define Tlt 285
+#define Tge 286
+#define Tle 287
+#define Tne 288
+#define Tlor 289
+#define Tland 290
+#define Tlnot 291
+#define Tobrace 292
+#define Tcbrace 293
+#define Toparen 294
+#define Tcparen 295
+#define Tosqbrac 296
+#define Tcsqbrac 297
+#define Tat 298
+#define Ttick 299
+#define Tderef 300
+#define Ttype 301
+#define Tfor 302
+#define Tin 303
+#define Twhile 304
+#define Tif 305
+#define Telse 306
+#define Telif 307
+#define Tmatch 308
+#define Tdefault 309
+#define Tgoto 310
+#define Tbreak 311
+#define Tcontinue 312
+#define Tintlit 313
+#define Tstrlit 314
+#define Tfloatlit 315
+#define Tchrlit 316
+#define Tboollit 317
+#define Ttrait 318
+#define Timpl 319
+#define Tstruct 320
+#define Tunion 321
+#define Ttyparam 322
+#define Tattr 323
+#define Tconst 324
+#define Tvar 325
+#define Tgeneric 326
+#define Textern 327
+#define Tcast 328
+#define Texport 329
+#define Tprotect 330
+#define Tellipsis 331
+#define Tendln 332
+#define Tendblk 333
+#define Tcolon 334
+#define Twith 335
+#define Tdot 336
+#define Tcomma 337
+#define Tret 338
+#define Tuse 339
+#define Tpkg 340
+#define Tsizeof 341
+#define Tident 342
+#define Teof 343
+
+/* Value type.  */
+#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
+union YYSTYPE
+{
+#line 160 "gram.y"
+
+    struct {
+        int line;
+        Node **nl;
+        size_t nn;
+    } nodelist;
+    struct {
+        int line;
+        Ucon **ucl;
+        size_t nucl;
+    } uconlist;
+    struct {
+        int line;
+        Type **types;
+        size_t ntypes;
+    } tylist;
+    struct { /* FIXME: unused */
+        int line;
+        char *name;
+        Type *type;
+        Type **params;
+        size_t nparams;
+    } tydef;
+    Node *node;
+    Tok  *tok;
+    Type *ty;
+    Ucon *ucon;
+
+#line 272 "gram.h"
+
+};
+typedef union YYSTYPE YYSTYPE;
+# define YYSTYPE_IS_TRIVIAL 1
+# define YYSTYPE_IS_DECLARED 1
+#endif
+
+
+extern YYSTYPE yylval;
+
+
+int yyparse (void);
+
+
+#endif /* !YY_YY_GRAM_H_INCLUDED  */
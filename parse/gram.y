@@ -99,6 +99,7 @@ static void constrainwith(Type *t, char *str);
 %token<tok> Tstruct  /* struct */
 %token<tok> Tunion   /* union */
 %token<tok> Ttyparam /* @typename */
+%token<tok> Tattr    /* $attribute */
 
 %token<tok> Tconst   /* const */
 %token<tok> Tvar     /* var */
@@ -236,6 +237,16 @@ decl    : Tvar decllist
                 $3.nl[i]->decl.isextern = 1;
              }
              $$ = $3;}
+        | Textern Tattr Tconst decllist
+            {size_t i;
+             if (strcmp($2->str, "stkcc"))
+                fatal($2->line, "Unknown attribute $%s", $2->str);
+             for (i = 0; i < $4.nn; i++) {
+                $4.nl[i]->decl.isconst = 1;
+                $4.nl[i]->decl.isextern = 1;
+                $4.nl[i]->decl.isstkcc = 1;
+             }
+             $$ = $4;}
         ;
 
 decllist: declbody
@@ -9,6 +9,16 @@
 
 #define Initsz 16
 
+/*
+ * Open addressing with Robin Hood probing: every key sits
+ * at most as far from its home slot as the keys it went
+ * past, so a lookup can stop as soon as it sees a key that
+ * is closer to home than it would be. Deletion shifts the
+ * following run back a slot, so there are no tombstones.
+ * The slots keep their key, value and hash together, and
+ * the hash is compared before calling 'cmp'.
+ */
+
 /* Creates a new empty hash table, using 'hash' as the
  * hash funciton, and 'cmp' to verify that there are no
  * hash collisions. */
@@ -21,10 +31,7 @@ Htab *mkht(ulong (*hash)(void *key), int (*cmp)(void *k1, void *k2))
     ht->sz = Initsz;
     ht->hash = hash;
     ht->cmp = cmp;
-    ht->keys = zalloc(Initsz*sizeof(void*));
-    ht->vals = zalloc(Initsz*sizeof(void*));
-    ht->hashes = zalloc(Initsz*sizeof(void*));
-    ht->dead = zalloc(Initsz*sizeof(char));
+    ht->slot = zalloc(Initsz*sizeof(Htslot));
 
     return ht;
 }
@@ -35,115 +42,123 @@ void htfree(Htab *ht)
 {
     if (!ht)
         return;
-    free(ht->keys);
-    free(ht->vals);
-    free(ht->hashes);
-    free(ht->dead);
+    free(ht->slot);
     free(ht);
 }
 
-/* Offsets the hash so that '0' can be
- * used as a 'no valid value */
+/* Spreads the hash over all the bits, since
+ * the low ones pick the slot, and offsets it
+ * so that '0' can mean an empty slot. */
 static ulong hash(Htab *ht, void *k)
 {
-    ulong h;
+    uint64_t h;
+
     h = ht->hash(k);
+    h *= 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 32;
     if (h == 0)
         return 1;
     else
         return h;
 }
 
+/* how far slot 'i', holding hash 'h', is from where 'h' wants to be */
+#define dist(ht, h, i) (((i) - (h)) & ((ht)->sz - 1))
+
+/*
+ * Puts a key that isn't in the table into slot 'i', which
+ * is 'd' slots from its home, moving whatever is there on
+ * to the next slot that's further from home than it is.
+ */
+static void place(Htab *ht, size_t i, size_t d, ulong h, void *k, void *v)
+{
+    Htslot *s, tmp, swap;
+
+    tmp.hash = h;
+    tmp.key = k;
+    tmp.val = v;
+    for (; ; d++) {
+        s = &ht->slot[i];
+        if (!s->hash) {
+            *s = tmp;
+            break;
+        }
+        /* the resident is closer to home than we are: take its place */
+        if (dist(ht, s->hash, i) < d) {
+            swap = *s;
+            *s = tmp;
+            tmp = swap;
+            d = dist(ht, tmp.hash, i);
+        }
+        i = (i + 1) & (ht->sz - 1);
+    }
+    ht->nelt++;
+}
+
 /* Resizes the hash table by copying all
  * the old keys into the right slots in a
  * new table. */
-static void grow(Htab *ht, int sz)
-{
-    void **oldk;
-    void **oldv;
-    ulong *oldh;
-    char *oldd;
-    int oldsz;
-    int i;
-
-    oldk = ht->keys;
-    oldv = ht->vals;
-    oldh = ht->hashes;
-    oldd = ht->dead;
+static void grow(Htab *ht, size_t sz)
+{
+    Htslot *old;
+    size_t i, oldsz;
+
+    old = ht->slot;
     oldsz = ht->sz;
 
     ht->nelt = 0;
     ht->sz = sz;
-    ht->keys = zalloc(sz*sizeof(void*));
-    ht->vals = zalloc(sz*sizeof(void*));
-    ht->hashes = zalloc(sz*sizeof(void*));
-    ht->dead = zalloc(sz*sizeof(void*));
-
+    ht->slot = zalloc(sz*sizeof(Htslot));
     for (i = 0; i < oldsz; i++)
-        if (oldh[i] && !oldd[i])
-            htput(ht, oldk[i], oldv[i]);
-    free(oldh);
-    free(oldk);
-    free(oldv);
-    free(oldd);
+        if (old[i].hash)
+            place(ht, old[i].hash & (sz - 1), 0, old[i].hash, old[i].key, old[i].val);
+    free(old);
 }
 
-/* Inserts 'k' into the hash table, possibly
- * killing any previous key that compares
- * as equal. */
-int htput(Htab *ht, void *k, void *v)
+/* Finds the slot holding 'k', or -1 */
+static ssize_t htidx(Htab *ht, void *k, ulong h)
 {
-    int i;
-    ulong h;
-    int di;
+    Htslot *s;
+    size_t i, d;
 
-    di = 0;
-    h = hash(ht, k);
     i = h & (ht->sz - 1);
-    while (ht->hashes[i] && !ht->dead[i]) {
-        /* second insertion overwrites first. nb, we shouldn't touch the
-         * keys for dead values */
-        if (ht->hashes[i] == h) {
-            if (ht->dead[i])
-                break;
-            else if (ht->cmp(ht->keys[i], k))
-                goto conflicted;
-        }
-        di++;
-        i = (h + di) & (ht->sz - 1);
+    for (d = 0; ; d++) {
+        s = &ht->slot[i];
+        if (!s->hash || dist(ht, s->hash, i) < d)
+            return -1;
+        if (s->hash == h && ht->cmp(s->key, k))
+            return i;
+        i = (i + 1) & (ht->sz - 1);
     }
-    ht->nelt++;
-conflicted:
-    ht->hashes[i] = h;
-    ht->keys[i] = k;
-    ht->vals[i] = v;
-    ht->dead[i] = 0;
-    if (ht->sz < ht->nelt*2)
-        grow(ht, ht->sz*2);
-    return 1;
 }
 
-/* Finds the index that we would insert
- * the key into */
-static ssize_t htidx(Htab *ht, void *k)
+/* Inserts 'k' into the hash table, possibly
+ * killing any previous key that compares
+ * as equal. */
+int htput(Htab *ht, void *k, void *v)
 {
-    ssize_t i;
+    Htslot *s;
+    size_t i, d;
     ulong h;
-    int di;
 
-    di = 0;
+    /* keep the table at most half full */
+    if (2*(ht->nelt + 1) > ht->sz)
+        grow(ht, ht->sz*2);
     h = hash(ht, k);
     i = h & (ht->sz - 1);
-    while (ht->hashes[i] && !ht->dead[i] && ht->hashes[i] != h) {
-searchmore:
-        di++;
-        i = (h + di) & (ht->sz - 1);
+    for (d = 0; ; d++) {
+        s = &ht->slot[i];
+        if (!s->hash || dist(ht, s->hash, i) < d)
+            break;
+        if (s->hash == h && ht->cmp(s->key, k)) {
+            s->key = k;
+            s->val = v;
+            return 1;
+        }
+        i = (i + 1) & (ht->sz - 1);
     }
-    if (!ht->hashes[i] || ht->dead[i]) 
-        return -1;
-    if (!ht->cmp(ht->keys[i], k))
-        goto searchmore; /* collision */
-    return i;
+    place(ht, i, d, h, k, v);
+    return 1;
 }
 
 /* Looks up a key, returning NULL if
@@ -155,28 +170,41 @@ void *htget(Htab *ht, void *k)
 {
     ssize_t i;
 
-    i = htidx(ht, k);
+    i = htidx(ht, k, hash(ht, k));
     if (i < 0)
         return NULL;
     else
-        return ht->vals[i];
+        return ht->slot[i].val;
 }
 
+/* Removes 'k', moving the keys after it
+ * back a slot where that brings them
+ * closer to home. */
 void htdel(Htab *ht, void *k)
 {
     ssize_t i;
+    size_t j;
 
-    i = htidx(ht, k);
+    i = htidx(ht, k, hash(ht, k));
     if (i < 0)
         return;
-    ht->dead[i] = 1;
+    for (j = (i + 1) & (ht->sz - 1); ht->slot[j].hash; j = (j + 1) & (ht->sz - 1)) {
+        if (dist(ht, ht->slot[j].hash, j) == 0)
+            break;
+        ht->slot[i] = ht->slot[j];
+        i = j;
+    }
+    ht->slot[i].hash = 0;
+    ht->slot[i].key = NULL;
+    ht->slot[i].val = NULL;
+    ht->nelt--;
 }
 
 
 /* Tests for 'k's presence in 'ht' */
 int hthas(Htab *ht, void *k)
 {
-    return htidx(ht, k) >= 0;
+    return htidx(ht, k, hash(ht, k)) >= 0;
 }
 
 /* Returns a list of all keys in the hash
@@ -192,12 +220,26 @@ void **htkeys(Htab *ht, size_t *nkeys)
     j = 0;
     k = xalloc(sizeof(void*)*ht->nelt);
     for (i = 0; i < ht->sz; i++)
-        if (ht->hashes[i] && !ht->dead[i])
-            k[j++] = ht->keys[i];
+        if (ht->slot[i].hash)
+            k[j++] = ht->slot[i].key;
     *nkeys = ht->nelt;
     return k;
 }
 
+/* Walks the keys without allocating, as in
+ *   for (i = 0; htiter(ht, &i, &k); i++)
+ * The table must not be changed during the walk. */
+int htiter(Htab *ht, size_t *i, void **k)
+{
+    for (; *i < ht->sz; (*i)++) {
+        if (ht->slot[*i].hash) {
+            *k = ht->slot[*i].key;
+            return 1;
+        }
+    }
+    return 0;
+}
+
 ulong strhash(void *_s)
 {
     char *s;
@@ -0,0 +1,289 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+
+#include "parse.h"
+
+/*
+ * Compares the hash table against the one it replaced,
+ * which is kept below as it was: parallel arrays, linear
+ * probing, and tombstones that are never reclaimed.
+ *
+ *   make htbench && ./htbench [nkeys]
+ */
+
+/* libparse wants these from whoever links it */
+Node *file;
+char debugopt[128];
+char **incpaths;
+size_t nincpaths;
+
+typedef struct Oldht Oldht;
+struct Oldht {
+    size_t nelt;
+    size_t sz;
+    ulong (*hash)(void *k);
+    int (*cmp)(void *a, void *b);
+    void **keys;
+    void **vals;
+    ulong *hashes;
+    char  *dead;
+};
+
+static Oldht *oldmkht(ulong (*hash)(void *key), int (*cmp)(void *k1, void *k2))
+{
+    Oldht *ht;
+
+    ht = xalloc(sizeof(Oldht));
+    ht->nelt = 0;
+    ht->sz = 16;
+    ht->hash = hash;
+    ht->cmp = cmp;
+    ht->keys = zalloc(16*sizeof(void*));
+    ht->vals = zalloc(16*sizeof(void*));
+    ht->hashes = zalloc(16*sizeof(void*));
+    ht->dead = zalloc(16*sizeof(char));
+    return ht;
+}
+
+static void oldhtfree(Oldht *ht)
+{
+    free(ht->keys);
+    free(ht->vals);
+    free(ht->hashes);
+    free(ht->dead);
+    free(ht);
+}
+
+static ulong oldhash(Oldht *ht, void *k)
+{
+    ulong h;
+
+    h = ht->hash(k);
+    return h ? h : 1;
+}
+
+static int oldhtput(Oldht *ht, void *k, void *v);
+
+static void oldgrow(Oldht *ht, int sz)
+{
+    void **oldk, **oldv;
+    ulong *oldh;
+    char *oldd;
+    int i, oldsz;
+
+    oldk = ht->keys;
+    oldv = ht->vals;
+    oldh = ht->hashes;
+    oldd = ht->dead;
+    oldsz = ht->sz;
+
+    ht->nelt = 0;
+    ht->sz = sz;
+    ht->keys = zalloc(sz*sizeof(void*));
+    ht->vals = zalloc(sz*sizeof(void*));
+    ht->hashes = zalloc(sz*sizeof(void*));
+    ht->dead = zalloc(sz*sizeof(void*));
+    for (i = 0; i < oldsz; i++)
+        if (oldh[i] && !oldd[i])
+            oldhtput(ht, oldk[i], oldv[i]);
+    free(oldh);
+    free(oldk);
+    free(oldv);
+    free(oldd);
+}
+
+static int oldhtput(Oldht *ht, void *k, void *v)
+{
+    int i, di;
+    ulong h;
+
+    di = 0;
+    h = oldhash(ht, k);
+    i = h & (ht->sz - 1);
+    while (ht->hashes[i] && !ht->dead[i]) {
+        if (ht->hashes[i] == h && ht->cmp(ht->keys[i], k))
+            goto conflicted;
+        di++;
+        i = (h + di) & (ht->sz - 1);
+    }
+    ht->nelt++;
+conflicted:
+    ht->hashes[i] = h;
+    ht->keys[i] = k;
+    ht->vals[i] = v;
+    ht->dead[i] = 0;
+    if (ht->sz < ht->nelt*2)
+        oldgrow(ht, ht->sz*2);
+    return 1;
+}
+
+static ssize_t oldhtidx(Oldht *ht, void *k)
+{
+    ssize_t i;
+    ulong h;
+    int di;
+
+    di = 0;
+    h = oldhash(ht, k);
+    i = h & (ht->sz - 1);
+    while (ht->hashes[i] && !ht->dead[i] && ht->hashes[i] != h) {
+searchmore:
+        di++;
+        i = (h + di) & (ht->sz - 1);
+    }
+    if (!ht->hashes[i] || ht->dead[i])
+        return -1;
+    if (!ht->cmp(ht->keys[i], k))
+        goto searchmore;
+    return i;
+}
+
+static void *oldhtget(Oldht *ht, void *k)
+{
+    ssize_t i;
+
+    i = oldhtidx(ht, k);
+    return i < 0 ? NULL : ht->vals[i];
+}
+
+static void oldhtdel(Oldht *ht, void *k)
+{
+    ssize_t i;
+
+    i = oldhtidx(ht, k);
+    if (i >= 0)
+        ht->dead[i] = 1;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+static void report(char *what, double oldns, double newns, size_t nops)
+{
+    printf("%-20s %8.1f %8.1f ns/op  %5.2fx\n", what, oldns/nops, newns/nops, oldns/newns);
+}
+
+/* fills, then looks up every key, then the same number of missing ones */
+static void bench(char *what, void **keys, void **missing, size_t n,
+                  ulong (*hash)(void *), int (*cmp)(void *, void *))
+{
+    double t, put[2], hit[2], miss[2];
+    size_t i, r, found;
+    Oldht *o;
+    Htab *h;
+
+    found = 0;
+    t = now();
+    o = oldmkht(hash, cmp);
+    for (i = 0; i < n; i++)
+        oldhtput(o, keys[i], keys[i]);
+    put[0] = now() - t;
+    t = now();
+    for (r = 0; r < 10; r++)
+        for (i = 0; i < n; i++)
+            found += oldhtget(o, keys[i]) != NULL;
+    hit[0] = (now() - t)/10;
+    t = now();
+    for (r = 0; r < 10; r++)
+        for (i = 0; i < n; i++)
+            found += oldhtget(o, missing[i]) != NULL;
+    miss[0] = (now() - t)/10;
+    oldhtfree(o);
+
+    t = now();
+    h = mkht(hash, cmp);
+    for (i = 0; i < n; i++)
+        htput(h, keys[i], keys[i]);
+    put[1] = now() - t;
+    t = now();
+    for (r = 0; r < 10; r++)
+        for (i = 0; i < n; i++)
+            found -= htget(h, keys[i]) != NULL;
+    hit[1] = (now() - t)/10;
+    t = now();
+    for (r = 0; r < 10; r++)
+        for (i = 0; i < n; i++)
+            found -= htget(h, missing[i]) != NULL;
+    miss[1] = (now() - t)/10;
+    htfree(h);
+
+    if (found != 0)
+        die("tables disagree on %s", what);
+    printf("%s:\n", what);
+    report("  insert", put[0], put[1], n);
+    report("  lookup hit", hit[0], hit[1], n);
+    report("  lookup miss", miss[0], miss[1], n);
+}
+
+/* a table of fixed size with keys coming and going, like a worklist */
+static void churn(void **keys, size_t n)
+{
+    double t, ns[2];
+    size_t i, live;
+    Oldht *o;
+    Htab *h;
+
+    live = n/8;
+    t = now();
+    o = oldmkht(ptrhash, ptreq);
+    for (i = 0; i < n; i++) {
+        oldhtput(o, keys[i], keys[i]);
+        if (i >= live)
+            oldhtdel(o, keys[i - live]);
+        oldhtget(o, keys[i/2]);
+    }
+    ns[0] = now() - t;
+    oldhtfree(o);
+
+    t = now();
+    h = mkht(ptrhash, ptreq);
+    for (i = 0; i < n; i++) {
+        htput(h, keys[i], keys[i]);
+        if (i >= live)
+            htdel(h, keys[i - live]);
+        htget(h, keys[i/2]);
+    }
+    ns[1] = now() - t;
+    htfree(h);
+
+    printf("put/del/get churn, %zd live:\n", live);
+    report("  per round", ns[0], ns[1], n);
+}
+
+int main(int argc, char **argv)
+{
+    void **skeys, **smiss, **pkeys, **pmiss;
+    char buf[32];
+    size_t i, n;
+
+    n = 100000;
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 0);
+    skeys = xalloc(n*sizeof(void*));
+    smiss = xalloc(n*sizeof(void*));
+    pkeys = xalloc(n*sizeof(void*));
+    pmiss = xalloc(n*sizeof(void*));
+    for (i = 0; i < n; i++) {
+        snprintf(buf, sizeof buf, "ident%zd", i);
+        skeys[i] = strdup(buf);
+        snprintf(buf, sizeof buf, "other%zd", i);
+        smiss[i] = strdup(buf);
+        pkeys[i] = xalloc(24);
+        pmiss[i] = xalloc(24);
+    }
+
+    printf("%zd keys                  old      new\n", n);
+    bench("string keys", skeys, smiss, n, strhash, streq);
+    bench("pointer keys", pkeys, pmiss, n, ptrhash, ptreq);
+    churn(pkeys, n);
+    return 0;
+}
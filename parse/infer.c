@@ -42,6 +42,13 @@ struct Inferstate {
     size_t nspecializations;
     Stab **specializationscope;
     size_t nspecializationscope;
+    /* union by rank for tyvars bound to tyvars, indexed by tid */
+    uint8_t *rank;
+    size_t nrank;
+    /* how far we walked the unification table, for -du */
+    size_t nsearch;
+    size_t nhops;
+    size_t maxhops;
 };
 
 static void infernode(Inferstate *st, Node *n, Type *ret, int *sawret);
@@ -289,35 +296,49 @@ static void tyresolve(Inferstate *st, Type *t)
     st->ingeneric--;
 }
 
-/* Look up the best type to date in the unification table, returning it */
+/*
+ * Look up the best type to date in the unification table,
+ * returning it. The table is a union-find forest; once the
+ * root is found, everything on the way there is pointed
+ * straight at it.
+ */
 static Type *tysearch(Inferstate *st, Type *t)
 {
-    Type *lu;
+    Type *lu, *root, *next;
+    size_t hops;
     Stab *ns;
 
     assert(t != NULL);
     lu = NULL;
+    hops = 0;
+    root = t;
     while (1) {
-        if (!tytab[t->tid] && t->type == Tyunres) {
+        if (!tytab[root->tid] && root->type == Tyunres) {
             ns = curstab();
-            if (t->name->name.ns) {
-                ns = getns_str(ns, t->name->name.ns);
+            if (root->name->name.ns) {
+                ns = getns_str(ns, root->name->name.ns);
             }
             if (!ns)
-                fatal(t->name->line, "Could not resolve namespace \"%s\"", t->name->name.ns);
-            if (!(lu = gettype(ns, t->name)))
-                fatal(t->name->line, "Could not resolve type %s", namestr(t->name));
-            tytab[t->tid] = lu;
+                fatal(root->name->line, "Could not resolve namespace \"%s\"", root->name->name.ns);
+            if (!(lu = gettype(ns, root->name)))
+                fatal(root->name->line, "Could not resolve type %s", namestr(root->name));
+            tytab[root->tid] = lu;
         }
 
-        if (!tytab[t->tid])
+        if (!tytab[root->tid])
             break;
-        /* compress paths: shift the link up one level */
-        if (tytab[tytab[t->tid]->tid])
-            tytab[t->tid] = tytab[tytab[t->tid]->tid];
-        t = tytab[t->tid];
+        root = tytab[root->tid];
+        hops++;
     }
-    return t;
+    while (t != root) {
+        next = tytab[t->tid];
+        tytab[t->tid] = root;
+        t = next;
+    }
+    st->nsearch++;
+    st->nhops += hops;
+    st->maxhops = max(st->maxhops, hops);
+    return root;
 }
 
 /* fixd the most accurate type mapping we have (ie,
@@ -596,6 +617,19 @@ static int tyrank(Type *t)
     return 2;
 }
 
+/* the union by rank rank of a tyvar */
+static uint8_t *tyvarrank(Inferstate *st, Type *t)
+{
+    size_t n;
+
+    if ((size_t)t->tid >= st->nrank) {
+        n = max(2*st->nrank, ntypes);
+        st->rank = zrealloc(st->rank, st->nrank, n);
+        st->nrank = n;
+    }
+    return &st->rank[t->tid];
+}
+
 static int hasparam(Type *t)
 {
     return t->type == Tyname && t->narg > 0;
@@ -647,6 +681,17 @@ static Type *unify(Inferstate *st, Node *ctx, Type *u, Type *v)
         b = t;
     }
 
+    /* two plain tyvars can go either way, so hang the shallower tree off the deeper */
+    if (tyrank(a) == 0 && tyrank(b) == 0) {
+        if (*tyvarrank(st, a) > *tyvarrank(st, b)) {
+            t = a;
+            a = b;
+            b = t;
+        }
+        if (*tyvarrank(st, a) == *tyvarrank(st, b))
+            (*tyvarrank(st, b))++;
+    }
+
     if (debugopt['u']) {
         from = tystr(a);
         to = tystr(b);
@@ -1255,9 +1300,9 @@ static void inferexpr(Inferstate *st, Node *n, Type *ret, int *sawret)
         case Olbl:      /* :lbl -> void* */
             infersub(st, n, ret, sawret, &isconst);
             settype(st, n, mktyptr(n->line, mktype(-1, Tyvoid)));
-        case Obad: case Ocjmp: case Oset:
+        case Obad: case Ocjmp: case Ojtab: case Oset:
         case Oslbase: case Osllen:
-        case Oblit: case Numops:
+        case Oblit: case Ophi: case Numops:
         case Otrunc: case Oswiden: case Ozwiden:
         case Oint2flt: case Oflt2int:
         case Ofadd: case Ofsub: case Ofmul: case Ofdiv: case Ofneg:
@@ -1445,9 +1490,9 @@ static Type *tyfix(Inferstate *st, Node *ctx, Type *orig)
     char buf[1024];
 
     if (!tyint)
-        tyint = mktype(-1, Tyint);
+        tyint = tyintern(mktype(-1, Tyint));
     if (!tyflt)
-        tyflt = mktype(-1, Tyfloat64);
+        tyflt = tyintern(mktype(-1, Tyfloat64));
 
     t = tysearch(st, orig);
     if (orig->type == Tyvar && hthas(st->delayed, orig)) {
@@ -1487,7 +1532,8 @@ static Type *tyfix(Inferstate *st, Node *ctx, Type *orig)
         fatal(t->line, "underconstrained type %s near %s", tyfmt(buf, 1024, t), ctxstr(st, ctx));
     }
 
-    return t;
+    /* its subtypes are fixed, so it's done changing */
+    return tyintern(t);
 }
 
 static void checkcast(Inferstate *st, Node *n)
@@ -1923,4 +1969,7 @@ void infer(Node *file)
     typesub(&st, file);
     specialize(&st, file);
     tagexports(file->file.exports);
+    if (debugopt['u'])
+        printf("%zu searches walked %zu links, at most %zu at once\n", st.nsearch, st.nhops, st.maxhops);
+    free(st.rank);
 }
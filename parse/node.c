@@ -20,7 +20,7 @@ Node *mknode(int line, Ntype nt)
 {
     Node *n;
 
-    n = zalloc(sizeof(Node));
+    n = azalloc(&lifetime, sizeof(Node));
     n->nid = maxnid++;
     n->type = nt;
     n->line = line;
@@ -31,6 +31,8 @@ Node *mkfile(char *name)
 {
     Node *n;
 
+    /* decl ids are only unique within a file */
+    lfree(&decls, &ndecls);
     n = mknode(-1, Nfile);
     n->file.name = strdup(name);
     return n;
@@ -208,7 +210,7 @@ Node *mklbl(int line, char *lbl)
     assert(lbl != NULL);
     n = mknode(line, Nlit);
     n->lit.littype = Llbl;
-    n->lit.lblval = strdup(lbl);
+    n->lit.lblval = intern(lbl);
     return mkexpr(line, Olit, n, NULL);
 }
 
@@ -267,7 +269,7 @@ Node *mkname(int line, char *name)
     Node *n;
 
     n = mknode(line, Nname);
-    n->name.name = strdup(name);
+    n->name.name = intern(name);
 
     return n;
 }
@@ -277,8 +279,8 @@ Node *mknsname(int line, char *ns, char *name)
     Node *n;
 
     n = mknode(line, Nname);
-    n->name.ns = strdup(ns);
-    n->name.name = strdup(name);
+    n->name.ns = intern(ns);
+    n->name.name = intern(name);
 
     return n;
 }
@@ -299,7 +301,7 @@ Ucon *mkucon(int line, Node *name, Type *ut, Type *et)
 {
     Ucon *uc;
 
-    uc = zalloc(sizeof(Ucon));
+    uc = azalloc(&lifetime, sizeof(Ucon));
     uc->line = line;
     uc->name = name;
     uc->utype = ut;
@@ -349,13 +351,13 @@ Type *nodetype(Node *n)
     return NULL;
 }
 
-/* name hashing */
+/* name hashing: names and namespaces are interned */
 ulong namehash(void *p)
 {
     Node *n;
 
     n = p;
-    return strhash(namestr(n)) ^ strhash(n->name.ns);
+    return ihash(n->name.name) ^ ihash(n->name.ns);
 }
 
 int nameeq(void *p1, void *p2)
@@ -363,15 +365,12 @@ int nameeq(void *p1, void *p2)
     Node *a, *b;
     a = p1;
     b = p2;
-    if (a == b)
-        return 1;
-
-    return streq(namestr(a), namestr(b)) && streq(a->name.ns, b->name.ns);
+    return a->name.name == b->name.name && a->name.ns == b->name.ns;
 }
 
 void setns(Node *n, char *ns)
 {
-    n->name.ns = strdup(ns);
+    n->name.ns = intern(ns);
 }
 
 Op exprop(Node *e)
@@ -8,11 +8,14 @@ typedef unsigned long long uvlong;
 
 typedef struct Bitset Bitset;
 typedef struct Htab Htab;
+typedef struct Htslot Htslot;
+typedef struct Arena Arena;
 
 typedef struct Tok Tok;
 typedef struct Node Node;
 typedef struct Ucon Ucon;
 typedef struct Stab Stab;
+typedef struct Usefile Usefile;
 
 typedef struct Type Type;
 typedef struct Cstr Cstr;
@@ -66,15 +69,26 @@ struct Bitset {
     size_t *chunks;
 };
 
+/* memory that's handed out by bumping a pointer, and released all at once */
+struct Arena {
+    char *p;        /* the next free byte in the current chunk */
+    char *end;
+    void **chunks;
+    size_t nchunks;
+};
+
+struct Htslot {
+    ulong hash;         /* 0 if the slot is empty */
+    void *key;
+    void *val;
+};
+
 struct Htab {
     size_t nelt;
     size_t sz;
     ulong (*hash)(void *k);
     int (*cmp)(void *a, void *b);
-    void **keys;
-    void **vals;
-    ulong *hashes;
-    char  *dead;
+    Htslot *slot;
 };
 
 struct Tok {
@@ -100,6 +114,10 @@ struct Stab {
     Htab *ns;
     Htab *ty;
     Htab *uc;
+
+    /* usefiles whose symbols are loaded when first looked up */
+    Usefile **lazy;
+    size_t nlazy;
 };
 
 struct Type {
@@ -256,6 +274,7 @@ struct Node {
             char  isgeneric;
             char  istrait;
             char  isextern;
+            char  isstkcc;
             char  ishidden;
         } decl;
 
@@ -301,6 +320,7 @@ extern size_t ncstrs;
 extern Node **decls;    /* decl id -> decl map */
 extern size_t ndecls;
 extern size_t maxnid;      /* the maximum node id generated so far */
+extern Arena lifetime;     /* for things that live until we exit */
 
 extern int ispureop[];
 
@@ -329,6 +349,7 @@ void htdel(Htab *ht, void *k);
 void *htget(Htab *ht, void *k);
 int hthas(Htab *ht, void *k);
 void **htkeys(Htab *ht, size_t *nkeys);
+int htiter(Htab *ht, size_t *i, void **k);
 /* useful key types */
 ulong strhash(void *key);
 int streq(void *a, void *b);
@@ -351,6 +372,12 @@ void  fatal(int line, char *fmt, ...) FATAL;
 char *strdupn(char *s, size_t len);
 char *strjoin(char *u, char *v);
 void *memdup(void *mem, size_t len);
+void *aalloc(Arena *a, size_t size);
+void *azalloc(Arena *a, size_t size);
+char *astrdup(Arena *a, char *s);
+void  afree(Arena *a);
+char *intern(char *s);
+ulong ihash(void *s);
 
 /* parsing etc */
 void tokinit(char *file);
@@ -406,6 +433,7 @@ int   hasparams(Type *t);
 
 /* type manipulation */
 Type *tybase(Type *t);
+Type *tyintern(Type *t);
 int hascstr(Type *t, Cstr *c);
 int cstreq(Type *t, Cstr **cstrs, size_t len);
 int setcstr(Type *t, Cstr *c);
@@ -466,6 +494,10 @@ Type *tyspecialize(Type *t, Htab *tymap);
 int  loaduse(FILE *f, Stab *into);
 void readuse(Node *use, Stab *into);
 void writeuse(FILE *fd, Node *file);
+int  rdlibdeps(FILE *f, char ***libs, size_t *nlibs);
+Node *lazydcl(Stab *st, Node *n);
+Type *lazytype(Stab *st, Node *n);
+Ucon *lazyucon(Stab *st, Node *n);
 void tagexports(Stab *st);
 
 /* typechecking/inference */
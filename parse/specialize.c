@@ -257,9 +257,8 @@ static Node *specializenode(Node *n, Htab *tsmap)
                 r->expr.args[i] = specializenode(n->expr.args[i], tsmap);
             break;
         case Nname:
-            if (n->name.ns)
-                r->name.ns = strdup(n->name.ns);
-            r->name.name = strdup(n->name.name);
+            r->name.ns = n->name.ns;
+            r->name.name = n->name.name;
             break;
         case Nlit:
             r->lit.littype = n->lit.littype;
@@ -55,19 +55,19 @@ void popstab(void)
  * we can update it after the fact. */
 static ulong nsnamehash(void *n)
 {
-    return strhash(namestr(n));
+    return ihash(namestr(n));
 }
 
 static int nsnameeq(void *a, void *b)
 {
-    return a == b || !strcmp(namestr(a), namestr(b));
+    return namestr(a) == namestr(b);
 }
 
 Stab *mkstab()
 {
     Stab *st;
 
-    st = zalloc(sizeof(Stab));
+    st = azalloc(&lifetime, sizeof(Stab));
     st->ns = mkht(strhash, streq);
     st->dcl = mkht(nsnamehash, nsnameeq);
     st->ty = mkht(nsnamehash, nsnameeq);
@@ -93,6 +93,8 @@ Node *getdcl(Stab *st, Node *n)
     orig = st;
     do {
         s = htget(st->dcl, n);
+        if (!s && st->nlazy)
+            s = lazydcl(st, n);
         if (s) {
             /* record that this is in the closure of this scope */
             if (!st->closure)
@@ -112,6 +114,8 @@ Type *gettype_l(Stab *st, Node *n)
 
     if ((t = htget(st->ty, n)))
         return t->type;
+    if (st->nlazy)
+        return lazytype(st, n);
     return NULL;
 }
 
@@ -119,10 +123,13 @@ Type *gettype_l(Stab *st, Node *n)
 Type *gettype(Stab *st, Node *n)
 {
     Tydefn *t;
+    Type *ty;
 
     do {
         if ((t = htget(st->ty, n)))
             return t->type;
+        if (st->nlazy && (ty = lazytype(st, n)))
+            return ty;
         st = st->super;
     } while (st);
     return NULL;
@@ -135,6 +142,8 @@ Ucon *getucon(Stab *st, Node *n)
     do {
         if ((uc = htget(st->uc, n)))
             return uc;
+        if (st->nlazy && (uc = lazyucon(st, n)))
+            return uc;
         st = st->super;
     } while (st);
     return NULL;
@@ -204,7 +213,7 @@ void puttype(Stab *st, Node *n, Type *t)
 
     if (gettype(st, n))
         fatal(n->line, "Type %s already defined", tystr(gettype(st, n)));
-    td = xalloc(sizeof(Tydefn));
+    td = aalloc(&lifetime, sizeof(Tydefn));
     td->line = n->line;
     td->name = n;
     td->type = t;
@@ -226,7 +235,7 @@ void putcstr(Stab *st, Node *n, Cstr *c)
 
     if (gettype(st, n))
         fatal(n->line, "Type %s already defined", namestr(n));
-    cd = xalloc(sizeof(Tydefn));
+    cd = aalloc(&lifetime, sizeof(Cstrdefn));
     cd->line = n->line;
     cd->name = n;
     cd->cstr = c;
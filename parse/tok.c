@@ -230,7 +230,7 @@ static Tok *kwident(void)
     if (!identstr(buf, sizeof buf))
         return NULL;
     t = mktok(kwd(buf));
-    t->str = strdup(buf);
+    t->str = intern(buf);
     return t;
 }
 
@@ -733,7 +733,22 @@ static Tok *typaram()
     if (!identstr(buf, 1024))
         return NULL;
     t = mktok(Ttyparam);
-    t->str = strdup(buf);
+    t->str = intern(buf);
+    return t;
+}
+
+static Tok *attr()
+{
+    Tok *t;
+    char buf[1024];
+
+    t = NULL;
+    if (!match('$'))
+        return NULL;
+    if (!identstr(buf, 1024))
+        return NULL;
+    t = mktok(Tattr);
+    t->str = intern(buf);
     return t;
 }
 
@@ -760,6 +775,8 @@ static Tok *toknext()
         t =  numlit();
     } else if (c == '@') {
         t = typaram();
+    } else if (c == '$') {
+        t = attr();
     } else {
         t = oper();
     }
@@ -20,24 +20,31 @@ struct Typename {
 Type **tytab = NULL;
 Type **types = NULL;
 size_t ntypes;
+static size_t tycap;    /* allocated size of tytab and types */
 Cstr **cstrtab;
 size_t ncstrs;
 
 /* Built in type constraints */
 static Cstr *tycstrs[Ntypes + 1][4];
+/* resolved types, shared between everything that is structurally the same */
+static Htab *tyconsed;
 
 Type *mktype(int line, Ty ty)
 {
     Type *t;
     int i;
 
-    t = zalloc(sizeof(Type));
+    t = azalloc(&lifetime, sizeof(Type));
     t->type = ty;
     t->tid = ntypes++;
     t->line = line;
-    tytab = xrealloc(tytab, ntypes*sizeof(Type*));
+    /* the tables are only grown here, so they can grow by doubling */
+    if (ntypes > tycap) {
+        tycap = tycap ? 2*tycap : 1024;
+        tytab = xrealloc(tytab, tycap*sizeof(Type*));
+        types = xrealloc(types, tycap*sizeof(Type*));
+    }
     tytab[t->tid] = NULL;
-    types = xrealloc(types, ntypes*sizeof(Type*));
     types[t->tid] = t;
     if (ty <= Tyvalist) /* the last builtin atomic type */
         t->vis = Visbuiltin;
@@ -104,7 +111,7 @@ Cstr *mkcstr(int line, char *name, Node **memb, size_t nmemb, Node **funcs, size
 {
     Cstr *c;
 
-    c = zalloc(sizeof(Cstr));
+    c = azalloc(&lifetime, sizeof(Cstr));
     c->name = strdup(name);
     c->memb = memb;
     c->nmemb = nmemb;
@@ -625,6 +632,68 @@ int tyeq(void *t1, void *t2)
     return 1;
 }
 
+/* types that are equal if their kind and subtypes are */
+static int isconsable(Type *t)
+{
+    switch (t->type) {
+        case Typtr: case Tyfunc: case Tyslice: case Tytuple:
+            return 1;
+        default:
+            return t->type > Tybad && t->type <= Tyvalist;
+    }
+}
+
+static ulong tyconshash(void *p)
+{
+    ulong hash;
+    size_t i;
+    Type *t;
+
+    t = p;
+    hash = inthash(t->type);
+    for (i = 0; i < t->nsub; i++)
+        hash = hash * 31 + inthash(t->sub[i]->tid);
+    return hash;
+}
+
+static int tyconseq(void *pa, void *pb)
+{
+    Type *a, *b;
+    size_t i;
+
+    a = pa;
+    b = pb;
+    if (a->type != b->type || a->nsub != b->nsub)
+        return 0;
+    for (i = 0; i < a->nsub; i++)
+        if (a->sub[i] != b->sub[i])
+            return 0;
+    return 1;
+}
+
+/*
+ * Returns the one shared copy of a fully resolved type.
+ * Subtypes are compared by identity, so interning from
+ * the leaves up leaves structurally equal types with
+ * the same Type, and comparing them is a pointer compare.
+ * Anything that may still be mutated must not be
+ * interned.
+ */
+Type *tyintern(Type *t)
+{
+    Type *u;
+
+    if (!isconsable(t))
+        return t;
+    if (!tyconsed)
+        tyconsed = mkht(tyconshash, tyconseq);
+    u = htget(tyconsed, t);
+    if (u)
+        return u;
+    htput(tyconsed, t, t);
+    return t;
+}
+
 void tyinit(Stab *st)
 {
     int i;
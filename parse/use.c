@@ -6,6 +6,7 @@
 #include <assert.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -21,14 +22,75 @@ static void pickle(Node *n, FILE *fd);
 static Node *unpickle(FILE *fd);
 
 /* type fixup list */
-static Htab *tydedup;   /* map from name -> type, contains all Tynames loaded ever */
+static Htab *tydedup;   /* map from name -> type, contains all Tynames loaded for this file */
+static Node *dedupfile; /* the file tydedup belongs to */
 static Htab *tidmap;    /* map from tid -> type */
 static Type ***typefixdest;  /* list of types we need to replace */
 static size_t ntypefixdest; /* size of replacement list */
 static intptr_t *typefixid;  /* list of types we need to replace */
 static size_t ntypefixid; /* size of replacement list */
+static Htab *tidout;    /* map from tid -> id in the usefile being written */
+static size_t ntidout;
+static int nolines;     /* write line numbers as 0 */
+static int lazyoff;     /* don't load lazily while putting loaded syms */
+static Htab *usecache;  /* map from path -> mapped usefile, shared by every file compiled */
 #define Builtinmask (1 << 30)
 
+/* A version 2 usefile, mapped into memory. The mapping
+ * and its indexes are shared by every file that uses it,
+ * but each one gets its own copy of the struct: what it
+ * loads goes into its own stab and tidmap. */
+struct Usefile {
+    byte *base;
+    size_t size;
+    struct stat sb; /* to tell if the file has changed since */
+    FILE *fd;       /* for unpickling records in place */
+    Stab *st;       /* where its symbols go once they're loaded */
+    Htab *tidmap;   /* map from tid -> type, for the types loaded so far */
+    byte *types;    /* record offsets, indexed by tid - 1 */
+    size_t ntypes;
+    byte *tynames;  /* (name, tid) pairs, sorted by name */
+    size_t ntynames;
+    byte *ucons;    /* (name, tid of the union) pairs */
+    size_t nucons;
+    byte *dcls;     /* (name, record offset) pairs */
+    size_t ndcls;
+};
+
+/* the header of a version 2 usefile, after the magic */
+enum {
+    Hversion,
+    Hpkg,
+    Hnlibs,
+    Hlibs,
+    Hntypes,
+    Htypes,
+    Hntynames,
+    Htynames,
+    Hnucons,
+    Hucons,
+    Hndcls,
+    Hdcls,
+    Nhdr,
+};
+#define Usemagic "MYRU"
+#define Useversion 2
+
+/* an entry in a usefile index, while it's being written */
+typedef struct Useent Useent;
+struct Useent {
+    char *name;
+    long str;   /* offset of the name in the string table */
+    long val;
+};
+
+/* Line numbers are only kept where they are needed, so
+ * that moving code around doesn't change the usefile. */
+static void wrline(FILE *fd, int line)
+{
+    wrint(fd, nolines ? 0 : line);
+}
+
 /* Outputs a symbol table to file in a way that can be
  * read back usefully. Only writes declarations, types
  * and sub-namespaces. Captured variables are ommitted. */
@@ -98,7 +160,7 @@ static Stab *rdstab(FILE *fd)
 
 static void wrucon(FILE *fd, Ucon *uc)
 {
-    wrint(fd, uc->line);
+    wrline(fd, uc->line);
     wrint(fd, uc->id);
     wrbool(fd, uc->synth);
     pickle(uc->name, fd);
@@ -135,8 +197,15 @@ static Ucon *rducon(FILE *fd, Type *ut)
  * the only cross-file inline is generics) */
 static void wrsym(FILE *fd, Node *val)
 {
+    int old;
+
+    /* only generic bodies are compiled by users of the usefile,
+     * so they are the only lines that need to survive edits */
+    old = nolines;
+    if (!val->decl.isgeneric)
+        nolines = 1;
     /* sym */
-    wrint(fd, val->line);
+    wrline(fd, val->line);
     pickle(val->decl.name, fd);
     wrtype(fd, val->decl.type);
 
@@ -144,10 +213,12 @@ static void wrsym(FILE *fd, Node *val)
     wrint(fd, val->decl.vis);
     wrbool(fd, val->decl.isconst);
     wrbool(fd, val->decl.isgeneric);
-    wrbool(fd, val->decl.isextern);
+    /* $stkcc rides along with extern, so older usefiles still read */
+    wrbyte(fd, val->decl.isextern | val->decl.isstkcc << 1);
 
     if (val->decl.isgeneric)
         pickle(val->decl.init, fd);
+    nolines = old;
 }
 
 static Node *rdsym(FILE *fd)
@@ -155,6 +226,7 @@ static Node *rdsym(FILE *fd)
     int line;
     Node *name;
     Node *n;
+    int f;
 
     line = rdint(fd);
     name = unpickle(fd);
@@ -165,7 +237,9 @@ static Node *rdsym(FILE *fd)
         n->decl.ishidden = 1;
     n->decl.isconst = rdbool(fd);
     n->decl.isgeneric = rdbool(fd);
-    n->decl.isextern = rdbool(fd);
+    f = rdbyte(fd);
+    n->decl.isextern = f & 1;
+    n->decl.isstkcc = (f >> 1) & 1;
 
 
     if (n->decl.isgeneric)
@@ -246,6 +320,24 @@ static void typickle(FILE *fd, Type *ty)
     }
 }
 
+/* Type ids are handed out in the order types are created,
+ * so any change to a file would shift them. Usefiles number
+ * types densely as they are written instead, so that their
+ * contents only change when the interface does. */
+static intptr_t outtid(Type *ty)
+{
+    intptr_t id;
+
+    if (!tidout)
+        return ty->tid;
+    id = (intptr_t)htget(tidout, (void*)(intptr_t)ty->tid);
+    if (!id) {
+        id = ++ntidout;
+        htput(tidout, (void*)(intptr_t)ty->tid, (void*)id);
+    }
+    return id;
+}
+
 static void wrtype(FILE *fd, Type *ty)
 {
     if (ty->tid >= Builtinmask)
@@ -253,7 +345,7 @@ static void wrtype(FILE *fd, Type *ty)
     if (ty->vis == Visbuiltin)
         wrint(fd, ty->type | Builtinmask);
     else
-        wrint(fd, ty->tid);
+        wrint(fd, outtid(ty));
 }
 
 static void rdtype(FILE *fd, Type **dest)
@@ -360,7 +452,7 @@ static void pickle(Node *n, FILE *fd)
         return;
     }
     wrbyte(fd, n->type);
-    wrint(fd, n->line);
+    wrline(fd, n->line);
     switch (n->type) {
         case Nfile:
             wrstr(fd, n->file.name);
@@ -470,6 +562,17 @@ static void pickle(Node *n, FILE *fd)
     }
 }
 
+/* reads a string that's compared by address once loaded */
+static char *rdistr(FILE *fd)
+{
+    char *s, *r;
+
+    s = rdstr(fd);
+    r = intern(s);
+    free(s);
+    return r;
+}
+
 /* Unpickles a node from a file. Minimal checking
  * is done. Specifically, no checks are done for
  * sane arities, a bad file can crash the compiler */
@@ -511,8 +614,8 @@ static Node *unpickle(FILE *fd)
             break;
         case Nname:
             if (rdbool(fd))
-                n->name.ns = rdstr(fd);
-            n->name.name = rdstr(fd);
+                n->name.ns = rdistr(fd);
+            n->name.name = rdistr(fd);
             break;
         case Nuse:
             n->use.islocal = rdbool(fd);
@@ -527,7 +630,7 @@ static Node *unpickle(FILE *fd)
                 case Lint:      n->lit.intval = rdint(fd);       break;
                 case Lflt:      n->lit.fltval = rdflt(fd);       break;
                 case Lstr:      n->lit.strval = rdstr(fd);       break;
-                case Llbl:      n->lit.lblval = rdstr(fd);       break;
+                case Llbl:      n->lit.lblval = rdistr(fd);      break;
                 case Lbool:     n->lit.boolval = rdbool(fd);     break;
                 case Lfunc:     n->lit.fnval = unpickle(fd);       break;
             }
@@ -665,13 +768,41 @@ static void fixmappings(Stab *st)
     lfree(&typefixid, &ntypefixid);
 }
 
-/* Usefile format:
+static void addlibdep(char *lib)
+{
+    size_t i;
+
+    for (i = 0; i < file->file.nlibdeps; i++)
+        if (!strcmp(file->file.libdeps[i], lib))
+            return;
+    lappend(&file->file.libdeps, &file->file.nlibdeps, lib);
+}
+
+/* if the package names match up, or the usefile has no declared
+ * package, then we simply add to the current stab. Otherwise,
+ * we add a new stab under the current one */
+static Stab *usestab(Stab *st, char *pkg)
+{
+    if (st->name) {
+        if (pkg && !strcmp(pkg, namestr(st->name)))
+            return st;
+        else
+            return findstab(st, pkg);
+    } else {
+        if (pkg)
+            return findstab(st, pkg);
+        else
+            return st;
+    }
+}
+
+/* Usefile format, version 1:
  *     U<pkgname>
  *     T<pickled-type>
  *     D<picled-decl>
  *     G<pickled-decl><pickled-initializer>
  */
-int loaduse(FILE *f, Stab *st)
+static int loadv1(FILE *f, Stab *st)
 {
     intptr_t tid;
     size_t i;
@@ -679,41 +810,15 @@ int loaduse(FILE *f, Stab *st)
     Node *dcl;
     Stab *s;
     Type *t;
-    char *lib;
     int c;
 
-    pushstab(file->file.globls);
-    if (!tydedup)
-        tydedup = mkht(namehash, nameeq);
-    if (fgetc(f) != 'U')
-        return 0;
     pkg = rdstr(f);
-    /* if the package names match up, or the usefile has no declared
-     * package, then we simply add to the current stab. Otherwise,
-     * we add a new stab under the current one */
-    if (st->name) {
-        if (pkg && !strcmp(pkg, namestr(st->name))) {
-            s = st;
-        } else {
-            s = findstab(st, pkg);
-        }
-    } else {
-        if (pkg) {
-            s = findstab(st, pkg);
-        } else {
-            s = st;
-        }
-    }
+    s = usestab(st, pkg);
     tidmap = mkht(ptrhash, ptreq);
     while ((c = fgetc(f)) != EOF) {
         switch(c) {
             case 'L':
-                lib = rdstr(f);
-                for (i = 0; i < file->file.nlibdeps; i++)
-                    if (!strcmp(file->file.libdeps[i], lib))
-                        goto foundlib;
-                lappend(&file->file.libdeps, &file->file.nlibdeps, lib);
-foundlib:
+                addlibdep(rdstr(f));
                 break;
             case 'G':
             case 'D':
@@ -744,92 +849,632 @@ foundlib:
     }
     fixmappings(s);
     htfree(tidmap);
+    return 1;
+}
+
+static long rdhdr(Usefile *u, size_t off)
+{
+    if (off + 4 > u->size)
+        die("Corrupt usefile");
+    return host32(u->base + off);
+}
+
+static char *usestr(Usefile *u, long off)
+{
+    if (off < 0 || (size_t)off >= u->size)
+        die("Corrupt usefile");
+    return (char*)u->base + off;
+}
+
+static byte *usetab(Usefile *u, long off, long n, size_t entsz)
+{
+    if (off < 0 || n < 0 || (size_t)off + n*entsz > u->size)
+        die("Corrupt usefile");
+    return u->base + off;
+}
+
+/* binary searches a sorted (name, value) index */
+static long findent(Usefile *u, byte *tab, size_t n, char *name)
+{
+    size_t lo, hi, mid;
+    int r;
+
+    lo = 0;
+    hi = n;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        r = strcmp(name, usestr(u, host32(tab + 8*mid)));
+        if (r == 0)
+            return host32(tab + 8*mid + 4);
+        else if (r < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return -1;
+}
+
+/* Gets the type with id 'tid' out of a usefile, reading
+ * it if needed. The types it refers to are left on the
+ * fixup list, for fixlazy() to fill in. */
+static Type *usetype(Usefile *u, intptr_t tid)
+{
+    Type *t;
+    long off;
+
+    if ((t = htget(u->tidmap, (void*)tid)))
+        return t;
+    if (tid < 1 || (size_t)tid > u->ntypes || (off = host32(u->types + 4*(tid - 1))) == -1)
+        die("Couldn't find type %d\n", (int)tid);
+    fseek(u->fd, off, SEEK_SET);
+    t = tyunpickle(u->fd);
+    htput(u->tidmap, (void*)tid, t);
+    if (t->type == Tyname && !t->issynth) {
+        /* puttype() would set this later, changing the name's hash */
+        if (!t->ishidden && u->st->name)
+            setns(t->name, namestr(u->st->name));
+        if (!hthas(tydedup, t->name))
+            htput(tydedup, t->name, t);
+    }
+    return t;
+}
+
+static Type *dedup(Type *t)
+{
+    if (t->type == Tyname && !t->issynth)
+        return htget(tydedup, t->name);
+    return t;
+}
+
+/* The lazy version of fixmappings(). Fills in the types
+ * referred to by what was read since 'start', reading
+ * any that haven't been yet. */
+static void fixlazy(Usefile *u, size_t start)
+{
+    size_t i;
+    Type *t, *old;
+
+    /* reading types can add more to fix up */
+    for (i = start; i < ntypefixdest; i++)
+        *typefixdest[i] = dedup(usetype(u, typefixid[i]));
+    for (i = start; i < ntypefixdest; i++) {
+        t = usetype(u, typefixid[i]);
+        old = dedup(t);
+        if (old != t && !tyeq(t, old))
+            fatal(-1, "Duplicate definition of type %s", tystr(old));
+    }
+    ntypefixdest = start;
+    ntypefixid = start;
+}
+
+static Node *loaddcl(Usefile *u, char *name)
+{
+    size_t start;
+    Node *dcl;
+    long off;
+
+    off = findent(u, u->dcls, u->ndcls, name);
+    if (off == -1)
+        return NULL;
+    start = ntypefixdest;
+    pushstab(file->file.globls);
+    fseek(u->fd, off, SEEK_SET);
+    dcl = rdsym(u->fd);
+    popstab();
+    fixlazy(u, start);
+    lazyoff++;
+    putdcl(u->st, dcl);
+    lazyoff--;
+    return dcl;
+}
+
+static Type *loadtype(Usefile *u, char *name)
+{
+    size_t start;
+    Type *t;
+    long tid;
+
+    tid = findent(u, u->tynames, u->ntynames, name);
+    if (tid == -1)
+        return NULL;
+    start = ntypefixdest;
+    t = dedup(usetype(u, tid));
+    fixlazy(u, start);
+    lazyoff++;
+    puttype(u->st, t->name, t);
+    lazyoff--;
+    return t;
+}
+
+static Ucon *loaducon(Usefile *u, char *name)
+{
+    size_t start, i;
+    Type *t;
+    long tid;
+
+    tid = findent(u, u->ucons, u->nucons, name);
+    if (tid == -1)
+        return NULL;
+    start = ntypefixdest;
+    t = usetype(u, tid);
+    fixlazy(u, start);
+    for (i = 0; i < t->nmemb; i++) {
+        if (!strcmp(namestr(t->udecls[i]->name), name)) {
+            lazyoff++;
+            putucon(u->st, t->udecls[i]);
+            lazyoff--;
+            return t->udecls[i];
+        }
+    }
+    die("Corrupt usefile: no constructor %s", name);
+    return NULL;
+}
+
+/* called by the stab lookups when they miss */
+Node *lazydcl(Stab *st, Node *n)
+{
+    Node *d;
+    size_t i;
+
+    if (lazyoff)
+        return NULL;
+    for (i = 0; i < st->nlazy; i++)
+        if ((d = loaddcl(st->lazy[i], namestr(n))))
+            return d;
+    return NULL;
+}
+
+Type *lazytype(Stab *st, Node *n)
+{
+    Type *t;
+    size_t i;
+
+    if (lazyoff)
+        return NULL;
+    for (i = 0; i < st->nlazy; i++)
+        if ((t = loadtype(st->lazy[i], namestr(n))))
+            return t;
+    return NULL;
+}
+
+Ucon *lazyucon(Stab *st, Node *n)
+{
+    Ucon *uc;
+    size_t i;
+
+    if (lazyoff)
+        return NULL;
+    for (i = 0; i < st->nlazy; i++)
+        if ((uc = loaducon(st->lazy[i], namestr(n))))
+            return uc;
+    return NULL;
+}
+
+/* Maps in a version 2 usefile, after its magic has been read. */
+static Usefile *mapuse(FILE *f)
+{
+    struct stat sb;
+    Usefile *u;
+    void *p;
+
+    if (fstat(fileno(f), &sb) == -1)
+        die("Could not stat usefile");
+    p = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+    if (p == MAP_FAILED)
+        die("Could not map usefile");
+    u = zalloc(sizeof(Usefile));
+    u->base = p;
+    u->size = sb.st_size;
+    u->sb = sb;
+    if (u->size < 4 + 4*Nhdr || memcmp(u->base, Usemagic, 4) != 0)
+        die("Corrupt usefile");
+    if (rdhdr(u, 4 + 4*Hversion) != Useversion)
+        die("Unsupported usefile version %ld", rdhdr(u, 4 + 4*Hversion));
+    u->fd = fmemopen(u->base, u->size, "r");
+    if (!u->fd)
+        die("Could not read usefile");
+    u->ntypes = rdhdr(u, 4 + 4*Hntypes);
+    u->types = usetab(u, rdhdr(u, 4 + 4*Htypes), u->ntypes, 4);
+    u->ntynames = rdhdr(u, 4 + 4*Hntynames);
+    u->tynames = usetab(u, rdhdr(u, 4 + 4*Htynames), u->ntynames, 8);
+    u->nucons = rdhdr(u, 4 + 4*Hnucons);
+    u->ucons = usetab(u, rdhdr(u, 4 + 4*Hucons), u->nucons, 8);
+    u->ndcls = rdhdr(u, 4 + 4*Hndcls);
+    u->dcls = usetab(u, rdhdr(u, 4 + 4*Hdcls), u->ndcls, 8);
+    return u;
+}
+
+/*
+ * Version 2 usefiles are indexed, so that only the
+ * symbols that get looked up need to be read. If 'lazy'
+ * is set, they are read as the stab lookups miss.
+ */
+static int loadv2(Usefile *img, Stab *st, int lazy)
+{
+    Usefile *u;
+    byte *libs;
+    size_t i, n;
+    long pkg;
+
+    u = xalloc(sizeof(Usefile));
+    *u = *img;
+    u->tidmap = mkht(ptrhash, ptreq);
+    pkg = rdhdr(u, 4 + 4*Hpkg);
+    u->st = usestab(st, pkg == -1 ? NULL : usestr(u, pkg));
+    n = rdhdr(u, 4 + 4*Hnlibs);
+    libs = usetab(u, rdhdr(u, 4 + 4*Hlibs), n, 4);
+    for (i = 0; i < n; i++)
+        addlibdep(strdup(usestr(u, host32(libs + 4*i))));
+
+    if (lazy) {
+        lappend(&u->st->lazy, &u->st->nlazy, u);
+        return 1;
+    }
+    for (i = 0; i < u->ntynames; i++)
+        if (!gettype(st, mkname(-1, usestr(u, host32(u->tynames + 8*i)))))
+            loadtype(u, usestr(u, host32(u->tynames + 8*i)));
+    for (i = 0; i < u->nucons; i++)
+        if (!getucon(u->st, mkname(-1, usestr(u, host32(u->ucons + 8*i)))))
+            loaducon(u, usestr(u, host32(u->ucons + 8*i)));
+    for (i = 0; i < u->ndcls; i++)
+        loaddcl(u, usestr(u, host32(u->dcls + 8*i)));
+    return 1;
+}
+
+/* Loads from 'img' if it's already mapped, or from 'f' */
+static int loadusefile(FILE *f, Usefile *img, Stab *st, int lazy)
+{
+    int c, ret;
+
+    /* types are only shared between the uses of one file */
+    if (!tydedup || dedupfile != file) {
+        if (tydedup)
+            htfree(tydedup);
+        tydedup = mkht(namehash, nameeq);
+        dedupfile = file;
+    }
+    pushstab(file->file.globls);
+    if (img)
+        ret = loadv2(img, st, lazy);
+    else if ((c = fgetc(f)) == 'U')
+        ret = loadv1(f, st);
+    else if (c == Usemagic[0])
+        ret = loadv2(mapuse(f), st, lazy);
+    else
+        ret = 0;
     popstab();
+    return ret;
+}
+
+/* loads everything in a usefile */
+int loaduse(FILE *f, Stab *st)
+{
+    return loadusefile(f, NULL, st, 0);
+}
+
+/* Reads the libraries a usefile depends on, and nothing else */
+int rdlibdeps(FILE *f, char ***libs, size_t *nlibs)
+{
+    Usefile *u;
+    byte *tab;
+    size_t i, n;
+
+    int c;
+
+    c = fgetc(f);
+    if (c == 'U') {
+        free(rdstr(f));
+        while (fgetc(f) == 'L')
+            lappend(libs, nlibs, rdstr(f));
+        return 1;
+    } else if (c == Usemagic[0]) {
+        u = mapuse(f);
+        n = rdhdr(u, 4 + 4*Hnlibs);
+        tab = usetab(u, rdhdr(u, 4 + 4*Hlibs), n, 4);
+        for (i = 0; i < n; i++)
+            lappend(libs, nlibs, strdup(usestr(u, host32(tab + 4*i))));
+        fclose(u->fd);
+        munmap(u->base, u->size);
+        free(u);
+        return 1;
+    }
+    return 0;
+}
+
+/* checks whether the file at 'path' is still the one we mapped */
+static int unchanged(Usefile *img, char *path)
+{
+    struct stat sb;
+
+    if (stat(path, &sb) == -1)
+        return 0;
+    if (sb.st_dev != img->sb.st_dev || sb.st_ino != img->sb.st_ino || sb.st_size != img->sb.st_size)
+        return 0;
+#ifdef __APPLE__
+    return sb.st_mtimespec.tv_sec == img->sb.st_mtimespec.tv_sec &&
+        sb.st_mtimespec.tv_nsec == img->sb.st_mtimespec.tv_nsec;
+#else
+    return sb.st_mtim.tv_sec == img->sb.st_mtim.tv_sec &&
+        sb.st_mtim.tv_nsec == img->sb.st_mtim.tv_nsec;
+#endif
+}
+
+/*
+ * Finds the usefile at 'path', mapping it in if that
+ * hasn't been done already. Mappings are kept by real
+ * path; if the file has been rewritten since, the old
+ * one is left to whoever is still using it. Old format
+ * usefiles can't be shared, so they are left open on
+ * 'fd' to be read the old way.
+ */
+static int openuse(char *path, Usefile **img, FILE **fd)
+{
+    char *key;
+
+    *img = NULL;
+    *fd = NULL;
+    if (!usecache)
+        usecache = mkht(strhash, streq);
+    key = realpath(path, NULL);
+    if (!key)
+        return 0;
+    /* a stale mapping is replaced below */
+    if ((*img = htget(usecache, key)) && unchanged(*img, key)) {
+        free(key);
+        return 1;
+    }
+    *img = NULL;
+    *fd = fopen(key, "r");
+    if (!*fd || fgetc(*fd) != Usemagic[0]) {
+        if (*fd)
+            rewind(*fd);
+        free(key);
+        return *fd != NULL;
+    }
+    *img = mapuse(*fd);
+    htput(usecache, key, *img);
+    fclose(*fd);
+    *fd = NULL;
     return 1;
 }
 
+/*
+ * Usefiles are mapped once per process, so when several
+ * files are compiled together, only the first one to use
+ * a library reads it in. Old format usefiles can't be
+ * read lazily, so they aren't shared.
+ */
 void readuse(Node *use, Stab *st)
 {
+    Usefile *img;
     size_t i;
     FILE *fd;
     char *p, *q;
+    int found;
 
+    found = 0;
     /* local (quoted) uses are always relative to the cwd */
-    fd = NULL;
     if (use->use.islocal) {
-        fd = fopen(use->use.name, "r");
+        found = openuse(use->use.name, &img, &fd);
     /* nonlocal (barename) uses are always searched on the include path */
     } else {
-        for (i = 0; i < nincpaths; i++) {
+        for (i = 0; i < nincpaths && !found; i++) {
             p = strjoin(incpaths[i], "/");
             q = strjoin(p, use->use.name);
-            fd = fopen(q, "r");
-            if (fd) {
-                free(p);
-                free(q);
-                break;
-            }
+            found = openuse(q, &img, &fd);
+            free(p);
+            free(q);
         }
     }
-    if (!fd)
+    if (!found)
         fatal(use->line, "Could not open %s", use->use.name);
 
-    if (!loaduse(fd, st))
+    if (!loadusefile(fd, img, st, 1))
         die("Could not load usefile %s", use->use.name);
+    if (fd)
+        fclose(fd);
+}
+
+static int namecmp(const void *a, const void *b)
+{
+    Node *x, *y;
+    int r;
+
+    x = *(Node**)a;
+    y = *(Node**)b;
+    if (x->name.ns && y->name.ns && (r = strcmp(x->name.ns, y->name.ns)) != 0)
+        return r;
+    else if (!x->name.ns != !y->name.ns)
+        return x->name.ns ? 1 : -1;
+    return strcmp(x->name.name, y->name.name);
+}
+
+static void addent(Useent ***ents, size_t *nents, char *name, long val)
+{
+    Useent *e;
+
+    e = zalloc(sizeof(Useent));
+    e->name = name;
+    e->val = val;
+    lappend(ents, nents, e);
 }
 
-/* Usefile format:
- * U<pkgname>
- * T<pickled-type>
- * D<picled-decl>
- * G<pickled-decl><pickled-initializer>
- * Z
+static int entcmp(const void *a, const void *b)
+{
+    return strcmp((*(Useent**)a)->name, (*(Useent**)b)->name);
+}
+
+/* appends 'str' to the string table, returning its offset in it */
+static long addstr(char **strs, size_t *nstrs, char *str)
+{
+    size_t off, len;
+
+    off = *nstrs;
+    len = strlen(str) + 1;
+    *strs = xrealloc(*strs, off + len);
+    memcpy(*strs + off, str, len);
+    *nstrs += len;
+    return off;
+}
+
+static void addnames(Useent **ents, size_t nents, char **strs, size_t *nstrs)
+{
+    size_t i;
+
+    qsort(ents, nents, sizeof(Useent*), entcmp);
+    for (i = 0; i < nents; i++)
+        ents[i]->str = addstr(strs, nstrs, ents[i]->name);
+}
+
+static void wrindex(FILE *f, Useent **ents, size_t nents, long stroff, long valoff)
+{
+    size_t i;
+
+    for (i = 0; i < nents; i++) {
+        wrint(f, stroff + ents[i]->str);
+        wrint(f, valoff + ents[i]->val);
+        free(ents[i]);
+    }
+    free(ents);
+}
+
+/* Usefile format, version 2. Integers are 32 bit big endian,
+ * and offsets are from the start of the file, so that it can
+ * be mapped and read in place:
+ *     MYRU <header> <libs> <types> <tynames> <ucons> <dcls>
+ *     <strings> <records>
+ * The header holds the version, the package name, and the
+ * size and offset of each table. 'libs' and the names in the
+ * indexes point into the strings. 'types' holds the offset of
+ * the record for each type id, or -1. 'tynames', 'ucons' and
+ * 'dcls' are (name, value) pairs sorted by name, mapping to a
+ * type id for the first two, and to the record of a pickled
+ * decl for the last.
  */
 void writeuse(FILE *f, Node *file)
 {
+    Useent **tynames, **ucons, **dcls;
+    size_t ntynames, nucons, ndcls;
+    char **libs, *strs, *data;
+    size_t nlibs, nstrs, ndata, ntyoff;
+    long hdr[Nhdr], *libstr;
+    intptr_t *tyoff;
+    long stroff, dataoff, pkg;
+    FILE *fd;
     Stab *st;
     void **k;
     Node *s, *u;
+    Type *t;
     size_t i, n;
+    long tid;
 
     assert(file->type == Nfile);
     st = file->file.exports;
+    tidout = mkht(ptrhash, ptreq);
+    ntidout = 0;
+    tynames = NULL;
+    ntynames = 0;
+    ucons = NULL;
+    nucons = 0;
+    dcls = NULL;
+    ndcls = 0;
+    libs = NULL;
+    nlibs = 0;
+    tyoff = NULL;
+    ntyoff = 0;
+    strs = NULL;
+    nstrs = 0;
 
-    /* usefile name */
-    wrbyte(f, 'U');
-    if (st->name)
-        wrstr(f, namestr(st->name));
-    else
-        wrstr(f, NULL);
-
-    /* library deps */
-    for (i = 0; i < file->file.nuses; i++) {
-        u = file->file.uses[i];
-        if (!u->use.islocal) {
-            wrbyte(f, 'L');
-            wrstr(f, u->use.name);
-        }
-    }
-    for (i = 0; i < file->file.nlibdeps; i++) {
-        wrbyte(f, 'L');
-        wrstr(f, file->file.libdeps[i]);
-    }
-
+    /* the records go first, so we know where they are */
+    data = NULL;
+    ndata = 0;
+    fd = open_memstream(&data, &ndata);
+    if (!fd)
+        die("Could not write usefile");
     for (i = 0; i < ntypes; i++) {
-        if (types[i]->vis == Visexport || types[i]->vis == Vishidden) {
-            wrbyte(f, 'T');
-            wrint(f, types[i]->tid);
-            typickle(f, types[i]);
+        t = types[i];
+        if (t->vis != Visexport && t->vis != Vishidden)
+            continue;
+        tid = outtid(t);
+        while (ntyoff < (size_t)tid)
+            lappend(&tyoff, &ntyoff, (void*)-1);
+        tyoff[tid - 1] = ftell(fd);
+        nolines = 1;
+        typickle(fd, t);
+        nolines = 0;
+        if (t->type == Tyname && !t->issynth && t->vis != Vishidden) {
+            addent(&tynames, &ntynames, namestr(t->name), tid);
+        } else if (t->type == Tyunion) {
+            for (n = 0; n < t->nmemb; n++)
+                if (!t->udecls[n]->synth)
+                    addent(&ucons, &nucons, namestr(t->udecls[n]->name), tid);
         }
     }
     k = htkeys(st->dcl, &n);
+    qsort(k, n, sizeof(Node*), namecmp);
     for (i = 0; i < n; i++) {
         s = getdcl(st, k[i]);
-        if (s && s->decl.isgeneric)
-            wrbyte(f, 'G');
-        else
-            wrbyte(f, 'D');
-        wrsym(f, s);
+        addent(&dcls, &ndcls, namestr(s->decl.name), ftell(fd));
+        wrsym(fd, s);
     }
     free(k);
+    if (fclose(fd) != 0)
+        die("Could not write usefile");
+    /* types that are referred to, but have no record */
+    while (ntyoff < ntidout)
+        lappend(&tyoff, &ntyoff, (void*)-1);
+
+    for (i = 0; i < file->file.nuses; i++) {
+        u = file->file.uses[i];
+        if (!u->use.islocal)
+            lappend(&libs, &nlibs, u->use.name);
+    }
+    for (i = 0; i < file->file.nlibdeps; i++)
+        lappend(&libs, &nlibs, file->file.libdeps[i]);
+
+    /* strings, in a fixed order, so the same interface gives the same file */
+    pkg = st->name ? addstr(&strs, &nstrs, namestr(st->name)) : -1;
+    libstr = xalloc(nlibs * sizeof(long) + 1);
+    for (i = 0; i < nlibs; i++)
+        libstr[i] = addstr(&strs, &nstrs, libs[i]);
+    addnames(tynames, ntynames, &strs, &nstrs);
+    addnames(ucons, nucons, &strs, &nstrs);
+    addnames(dcls, ndcls, &strs, &nstrs);
+
+    /* lay out the file */
+    hdr[Hversion] = Useversion;
+    hdr[Hnlibs] = nlibs;
+    hdr[Hlibs] = 4 + 4*Nhdr;
+    hdr[Hntypes] = ntyoff;
+    hdr[Htypes] = hdr[Hlibs] + 4*nlibs;
+    hdr[Hntynames] = ntynames;
+    hdr[Htynames] = hdr[Htypes] + 4*ntyoff;
+    hdr[Hnucons] = nucons;
+    hdr[Hucons] = hdr[Htynames] + 8*ntynames;
+    hdr[Hndcls] = ndcls;
+    hdr[Hdcls] = hdr[Hucons] + 8*nucons;
+    stroff = hdr[Hdcls] + 8*ndcls;
+    dataoff = stroff + nstrs;
+    hdr[Hpkg] = pkg == -1 ? -1 : stroff + pkg;
+
+    wrbuf(f, Usemagic, 4);
+    for (i = 0; i < Nhdr; i++)
+        wrint(f, hdr[i]);
+    for (i = 0; i < nlibs; i++)
+        wrint(f, stroff + libstr[i]);
+    for (i = 0; i < ntyoff; i++)
+        wrint(f, tyoff[i] == -1 ? -1 : dataoff + tyoff[i]);
+    wrindex(f, tynames, ntynames, stroff, 0);
+    wrindex(f, ucons, nucons, stroff, 0);
+    wrindex(f, dcls, ndcls, stroff, dataoff);
+    wrbuf(f, strs, nstrs);
+    wrbuf(f, data, ndata);
+
+    free(libstr);
+    free(strs);
+    free(data);
+    lfree(&libs, &nlibs);
+    lfree(&tyoff, &ntyoff);
+    htfree(tidout);
+    tidout = NULL;
 }
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <ctype.h>
 #include <string.h>
 #include <assert.h>
@@ -34,6 +35,108 @@ void *xalloc(size_t sz)
     return mem;
 }
 
+/*
+ * Nodes, types, instructions and the like are allocated
+ * by the million and never freed one at a time, so they
+ * come out of arenas instead of malloc. An arena is a
+ * list of chunks that objects are bump allocated from,
+ * all freed together. Anything that gets realloced or
+ * freed on its own, like the lists grown by lappend(),
+ * must still come from malloc.
+ */
+#define Chunksz (64*1024)
+#define Align 16        /* as much as malloc promises */
+
+Arena lifetime;
+
+void *aalloc(Arena *a, size_t sz)
+{
+    char *p;
+
+    sz = (sz + Align - 1) & ~(size_t)(Align - 1);
+    if (sz <= (size_t)(a->end - a->p)) {
+        p = a->p;
+        a->p += sz;
+        return p;
+    }
+    /* big objects get a chunk to themselves, so the current one isn't wasted */
+    if (sz > Chunksz/4) {
+        p = xalloc(sz);
+        lappend(&a->chunks, &a->nchunks, p);
+        return p;
+    }
+    p = xalloc(Chunksz);
+    lappend(&a->chunks, &a->nchunks, p);
+    a->p = p + sz;
+    a->end = p + Chunksz;
+    return p;
+}
+
+void *azalloc(Arena *a, size_t sz)
+{
+    return memset(aalloc(a, sz), 0, sz);
+}
+
+char *astrdup(Arena *a, char *s)
+{
+    size_t n;
+
+    n = strlen(s) + 1;
+    return memcpy(aalloc(a, n), s, n);
+}
+
+/* releases everything allocated from 'a' at once */
+void afree(Arena *a)
+{
+    size_t i;
+
+    for (i = 0; i < a->nchunks; i++)
+        free(a->chunks[i]);
+    lfree(&a->chunks, &a->nchunks);
+    a->p = NULL;
+    a->end = NULL;
+}
+
+/*
+ * Identifiers and labels are interned: each distinct string
+ * is kept once, just after its hash, so interned strings
+ * compare equal by address and hash without being walked.
+ */
+typedef struct Istr Istr;
+struct Istr {
+    ulong hash;
+    char str[];
+};
+
+static Htab *istrs;    /* string => the interned copy */
+
+char *intern(char *s)
+{
+    Istr *is;
+    char *r;
+    size_t n;
+
+    if (!istrs)
+        istrs = mkht(strhash, streq);
+    r = htget(istrs, s);
+    if (r)
+        return r;
+    n = strlen(s) + 1;
+    is = aalloc(&lifetime, sizeof(Istr) + n);
+    is->hash = strhash(s);
+    memcpy(is->str, s, n);
+    htput(istrs, is->str, is->str);
+    return is->str;
+}
+
+/* the same as strhash(), for interned strings only */
+ulong ihash(void *s)
+{
+    if (!s)
+        return 0;
+    return ((Istr*)((char*)s - offsetof(Istr, str)))->hash;
+}
+
 void *zrealloc(void *mem, size_t oldsz, size_t sz)
 {
     char *p;
@@ -7,6 +7,10 @@ export LD=ld
 ARGS=$*
 NFAILURES=0
 NPASSES=0
+# compiler flags to build the tests with, as in MCFLAGS=-O1
+for f in $MCFLAGS; do
+    MYRFLAGS="$MYRFLAGS -F$f"
+done
 
 function use {
     rm -f $1 $1.o $1.s $1.use
@@ -16,7 +20,7 @@ function use {
 
 function build {
     rm -f $1 $1.o $1.s $1.use
-    ../myrbuild/myrbuild -b $1 -C../6/6m -M../muse/muse -I../libstd $1.myr
+    ../myrbuild/myrbuild -b $1 $MYRFLAGS -C../6/6m -M../muse/muse -I../libstd $1.myr
 }
 
 function pass {
@@ -130,7 +134,8 @@ source tests
 
 echo "PASSED ($NPASSED): $PASSED"
 if [ -z "$NFAILED" ]; then
-    echo "SUCCESS"
+    echo "SUCCESS $MCFLAGS"
 else
-    echo "FAILURES ($NFAILED): $FAILED"
+    echo "FAILURES ($NFAILED) $MCFLAGS: $FAILED"
+    exit 1
 fi